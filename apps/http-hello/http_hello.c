@@ -80,17 +80,66 @@ static size_t build_http_response(uint8_t *buf, uint32_t client_ip_host) {
     return len;
 }
 
-static void send_tcp_packet(const device_entry_t *dev, uint8_t *reply_buffer,
+// Replies built in place in driver TX slots during one RX burst,
+// committed with a single netdev_tx_commit()
+typedef struct {
+    const device_entry_t *dev;
+    uint32_t caps;
+    net_tx_slot_t slots[HTTP_HELLO_TX_BATCH_SIZE];
+    size_t lengths[HTTP_HELLO_TX_BATCH_SIZE];
+    int count;
+} tx_batch_t;
+
+static void tx_batch_flush(tx_batch_t *batch) {
+    if (batch->count == 0) {
+        return;
+    }
+
+    int sent = netdev_tx_commit(batch->dev, batch->slots, batch->lengths, batch->count);
+    if (sent != batch->count) {
+        log_debug(http_log, "TX commit failed, dropped replies\n");
+    }
+    batch->count = 0;
+}
+
+// Return a driver TX slot for the next reply, or NULL if the TX ring is full
+static uint8_t *tx_batch_next(tx_batch_t *batch) {
+    if (batch->count == HTTP_HELLO_TX_BATCH_SIZE) {
+        tx_batch_flush(batch);
+    }
+
+    if (netdev_tx_alloc(batch->dev, &batch->slots[batch->count]) != 0) {
+        // Hand pending replies to the device and retry once
+        tx_batch_flush(batch);
+        if (netdev_tx_alloc(batch->dev, &batch->slots[batch->count]) != 0) {
+            log_debug(http_log, "TX ring full, dropped reply\n");
+            return NULL;
+        }
+    }
+
+    return batch->slots[batch->count].data;
+}
+
+static void tx_batch_push(tx_batch_t *batch, size_t length) {
+    batch->lengths[batch->count++] = length;
+}
+
+static void send_tcp_packet(tx_batch_t *batch,
                             const uint8_t *our_mac, const uint8_t *their_mac,
                             uint32_t src_ip_net, uint32_t dst_ip_net,
                             uint16_t src_port, uint16_t dst_port,
                             uint32_t seq, uint32_t ack,
                             uint8_t flags, uint16_t window,
                             const uint8_t *payload, uint16_t payload_len) {
+    uint8_t *reply_buffer = tx_batch_next(batch);
+    if (reply_buffer == NULL) {
+        return;
+    }
+
     // Ethernet header
     // Use volatile to prevent GCC -O3 from coalescing byte writes into
-    // unaligned 32-bit stores (reply_buffer is 2-byte aligned due to
-    // ETH_ALIGNMENT_OFFSET, causing Data Abort on ARM64 with SCTLR.A)
+    // unaligned 32-bit stores (TX slots are 2-byte aligned so the IP header
+    // is 4-byte aligned, causing Data Abort on ARM64 with SCTLR.A)
     volatile uint8_t *dst = reply_buffer;
     for (int i = 0; i < 6; i++) {
         dst[i] = their_mac[i];
@@ -113,12 +162,149 @@ static void send_tcp_packet(const device_entry_t *dev, uint8_t *reply_buffer,
         tcp_payload[i] = payload[i];
     }
 
-    // Build TCP header (computes checksum over header + payload)
-    tcp_build_header(tcp, src_port, dst_port, seq, ack, flags, window,
-                     src_ip_net, dst_ip_net, payload_len);
+    // Build TCP header: with checksum offload the device sums header + payload,
+    // otherwise compute the checksum here
+    if (batch->caps & NET_CAP_TX_CSUM) {
+        tcp_build_header_partial(tcp, src_port, dst_port, seq, ack, flags, window,
+                                 src_ip_net, dst_ip_net, payload_len);
+        net_tx_offload_t *offload = &batch->slots[batch->count].offload;
+        offload->csum_start = sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t);
+        offload->csum_offset = TCP_CHECKSUM_OFFSET;
+    } else {
+        tcp_build_header(tcp, src_port, dst_port, seq, ack, flags, window,
+                         src_ip_net, dst_ip_net, payload_len);
+    }
 
     size_t total_len = sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(tcp_hdr_t) + payload_len;
-    netdev_transmit(dev, reply_buffer, total_len);
+    tx_batch_push(batch, total_len);
+}
+
+// Stateless TCP: use a monotonic counter for SYN-ACK ISN, then derive
+// our seq from the client's ack_num in subsequent packets (the client
+// echoes back what it expects from us — no per-connection state needed).
+static uint32_t isn_counter = 1000;
+
+// Handle a single received frame, queueing any replies into batch
+static void handle_frame(tx_batch_t *batch, const uint8_t mac[6], const net_rx_frame_t *frame) {
+    const uint8_t *buffer = frame->data;
+    size_t received_length = frame->length;
+
+    if (received_length < sizeof(eth_hdr_t)) {
+        return;
+    }
+
+    const eth_hdr_t *eth = (const eth_hdr_t *)buffer;
+    uint16_t eth_type = ntohs_unaligned(&eth->type);
+
+    // Handle ARP requests — reply to any IP
+    if (eth_type == ETH_P_ARP) {
+        const arp_hdr_t *arp_req = (const arp_hdr_t *)(buffer + sizeof(eth_hdr_t));
+        uint16_t opcode = ntohs_unaligned(&arp_req->opcode);
+
+        if (opcode == ARP_OP_REQUEST) {
+            uint32_t target_ip = ntohl_unaligned(&arp_req->target_ip);
+            uint32_t sender_ip = ntohl_unaligned(&arp_req->sender_ip);
+            uint8_t *reply_buffer = tx_batch_next(batch);
+            if (reply_buffer != NULL) {
+                arp_build_reply(reply_buffer, mac, target_ip,
+                                arp_req->sender_mac, sender_ip);
+                tx_batch_push(batch, ARP_PACKET_SIZE);
+                log_debug(http_log, "Sent ARP reply\n");
+            }
+        }
+        return;
+    }
+
+    if (eth_type != ETH_P_IP) {
+        return;
+    }
+
+    if (received_length < sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(tcp_hdr_t)) {
+        return;
+    }
+
+    const ipv4_hdr_t *ip = (const ipv4_hdr_t *)(buffer + sizeof(eth_hdr_t));
+    if (ip->protocol != IPPROTO_TCP) {
+        return;
+    }
+
+    const tcp_hdr_t *tcp = (const tcp_hdr_t *)(buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
+    uint16_t dst_port = ntohs_unaligned(&tcp->dst_port);
+    if (dst_port != HTTP_HELLO_PORT) {
+        return;
+    }
+
+    // Frames are parsed in place in the driver RX buffer, which is only
+    // 2-byte aligned: read the addresses with unaligned-safe helpers
+    uint32_t src_ip_net = htonl(ntohl_unaligned(&ip->src_ip));
+    uint32_t dst_ip_net = htonl(ntohl_unaligned(&ip->dst_ip));
+    uint16_t src_port = ntohs_unaligned(&tcp->src_port);
+    uint32_t their_seq = ntohl_unaligned(&tcp->seq_num);
+    uint32_t their_ack = ntohl_unaligned(&tcp->ack_num);
+    uint8_t flags = tcp->flags;
+    uint8_t data_offset = (tcp->data_offset >> 4) * 4;
+    uint16_t ip_total_len = ntohs_unaligned(&ip->total_length);
+    if (ip_total_len > received_length - sizeof(eth_hdr_t) ||
+        ip_total_len < sizeof(ipv4_hdr_t) + data_offset || data_offset < sizeof(tcp_hdr_t)) {
+        return;
+    }
+    uint16_t tcp_payload_len = ip_total_len - sizeof(ipv4_hdr_t) - data_offset;
+
+    // Verify the TCP checksum unless the device already did
+    if (!(frame->flags & NET_RX_F_CSUM_VALID) &&
+        !tcp_verify_checksum(src_ip_net, dst_ip_net, (const uint8_t *)tcp, ip_total_len - sizeof(ipv4_hdr_t))) {
+        log_debug(http_log, "Bad TCP checksum, dropped\n");
+        return;
+    }
+
+    if (log_enabled(http_log, LOG_DEBUG)) {
+        ethernet_print(buffer, received_length, batch->dev->resource, 0);
+    }
+
+    // SYN → reply SYN+ACK with fresh ISN
+    if (flags & TCP_FLAG_SYN) {
+        log_debug(http_log, "SYN received\n");
+
+        uint32_t our_isn = isn_counter++;
+
+        send_tcp_packet(batch, mac, eth->src,
+                        dst_ip_net, src_ip_net,
+                        dst_port, src_port,
+                        our_isn, their_seq + 1,
+                        TCP_FLAG_SYN | TCP_FLAG_ACK, 65535,
+                        NULL, 0);
+
+        log_debug(http_log, "Sent SYN+ACK\n");
+    }
+
+    // Data arrived → reply with HTTP response (keep-alive, no FIN)
+    // Use their_ack as our seq (client tells us what it expects)
+    if (tcp_payload_len > 0) {
+        log_debug(http_log, "HTTP request received, sending response\n");
+
+        uint32_t client_ip = ntohl_unaligned(&ip->src_ip);
+        uint8_t http_buf[192];
+        size_t http_len = build_http_response(http_buf, client_ip);
+
+        send_tcp_packet(batch, mac, eth->src,
+                        dst_ip_net, src_ip_net,
+                        dst_port, src_port,
+                        their_ack, their_seq + tcp_payload_len,
+                        TCP_FLAG_PSH | TCP_FLAG_ACK, 65535,
+                        http_buf, http_len);
+
+        log_debug(http_log, "HTTP response sent\n");
+    }
+
+    // FIN → ACK it
+    if ((flags & TCP_FLAG_FIN) && !(flags & TCP_FLAG_SYN)) {
+        send_tcp_packet(batch, mac, eth->src,
+                        dst_ip_net, src_ip_net,
+                        dst_port, src_port,
+                        their_ack, their_seq + 1,
+                        TCP_FLAG_ACK, 65535,
+                        NULL, 0);
+    }
 }
 
 void app_http_hello(void) {
@@ -151,123 +337,28 @@ void app_http_hello(void) {
         puts("...\n");
     }
 
-    // Ethernet frame alignment
-    #define ETH_ALIGNMENT_OFFSET 2
-    uint8_t buffer_storage[HTTP_HELLO_BUFFER_SIZE + ETH_ALIGNMENT_OFFSET] __attribute__((aligned(4)));
-    uint8_t reply_buffer_storage[HTTP_HELLO_BUFFER_SIZE + ETH_ALIGNMENT_OFFSET] __attribute__((aligned(4)));
-    uint8_t *buffer = buffer_storage + ETH_ALIGNMENT_OFFSET;
-    uint8_t *reply_buffer = reply_buffer_storage + ETH_ALIGNMENT_OFFSET;
+    // Requests are parsed in the driver RX buffers and replies are built
+    // straight into driver TX slots: no frame is copied by the application
+    net_rx_frame_t frames[HTTP_HELLO_BURST_SIZE];
+    tx_batch_t batch = { .dev = &devices[0], .caps = netdev_get_caps(&devices[0]) };
 
-    // Stateless TCP: use a monotonic counter for SYN-ACK ISN, then derive
-    // our seq from the client's ack_num in subsequent packets (the client
-    // echoes back what it expects from us — no per-connection state needed).
-    static uint32_t isn_counter = 1000;
+    // Busy-poll while requests arrive, halt until the next one once idle
+    netdev_poll_t poll;
+    netdev_poll_init(&poll);
 
     while (1) {
-        size_t received_length = 0;
-        result = netdev_receive(&devices[0], buffer, HTTP_HELLO_BUFFER_SIZE, &received_length);
-
-        if (result != 0 || received_length == 0) {
+        // Parse frames in place in the driver RX buffers (no copy)
+        int count = netdev_rx_acquire(&devices[0], frames, HTTP_HELLO_BURST_SIZE);
+        netdev_poll_update(&devices[0], &poll, count);
+        if (count <= 0) {
             continue;
         }
 
-        if (received_length < sizeof(eth_hdr_t)) {
-            continue;
+        for (int i = 0; i < count; i++) {
+            handle_frame(&batch, mac, &frames[i]);
         }
 
-        const eth_hdr_t *eth = (const eth_hdr_t *)buffer;
-        uint16_t eth_type = ntohs_unaligned(&eth->type);
-
-        // Handle ARP requests — reply to any IP
-        if (eth_type == ETH_P_ARP) {
-            const arp_hdr_t *arp_req = (const arp_hdr_t *)(buffer + sizeof(eth_hdr_t));
-            uint16_t opcode = ntohs_unaligned(&arp_req->opcode);
-
-            if (opcode == ARP_OP_REQUEST) {
-                uint32_t target_ip = ntohl_unaligned(&arp_req->target_ip);
-                uint32_t sender_ip = ntohl_unaligned(&arp_req->sender_ip);
-                arp_build_reply(reply_buffer, mac, target_ip,
-                               arp_req->sender_mac, sender_ip);
-                netdev_transmit(&devices[0], reply_buffer, ARP_PACKET_SIZE);
-                log_debug(http_log, "Sent ARP reply\n");
-            }
-            continue;
-        }
-
-        if (eth_type != ETH_P_IP) {
-            continue;
-        }
-
-        if (received_length < sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(tcp_hdr_t)) {
-            continue;
-        }
-
-        const ipv4_hdr_t *ip = (const ipv4_hdr_t *)(buffer + sizeof(eth_hdr_t));
-        if (ip->protocol != IPPROTO_TCP) {
-            continue;
-        }
-
-        const tcp_hdr_t *tcp = (const tcp_hdr_t *)(buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
-        uint16_t dst_port = ntohs_unaligned(&tcp->dst_port);
-        if (dst_port != HTTP_HELLO_PORT) {
-            continue;
-        }
-
-        uint16_t src_port = ntohs_unaligned(&tcp->src_port);
-        uint32_t their_seq = ntohl_unaligned(&tcp->seq_num);
-        uint32_t their_ack = ntohl_unaligned(&tcp->ack_num);
-        uint8_t flags = tcp->flags;
-        uint8_t data_offset = (tcp->data_offset >> 4) * 4;
-        uint16_t ip_total_len = ntohs_unaligned(&ip->total_length);
-        uint16_t tcp_payload_len = ip_total_len - sizeof(ipv4_hdr_t) - data_offset;
-
-        if (log_enabled(http_log, LOG_DEBUG)) {
-            ethernet_print(buffer, received_length, devices[0].resource, 0);
-        }
-
-        // SYN → reply SYN+ACK with fresh ISN
-        if (flags & TCP_FLAG_SYN) {
-            log_debug(http_log, "SYN received\n");
-
-            uint32_t our_isn = isn_counter++;
-
-            send_tcp_packet(&devices[0], reply_buffer, mac, eth->src,
-                           ip->dst_ip, ip->src_ip,
-                           dst_port, src_port,
-                           our_isn, their_seq + 1,
-                           TCP_FLAG_SYN | TCP_FLAG_ACK, 65535,
-                           NULL, 0);
-
-            log_debug(http_log, "Sent SYN+ACK\n");
-        }
-
-        // Data arrived → reply with HTTP response (keep-alive, no FIN)
-        // Use their_ack as our seq (client tells us what it expects)
-        if (tcp_payload_len > 0) {
-            log_debug(http_log, "HTTP request received, sending response\n");
-
-            uint32_t client_ip = ntohl_unaligned(&ip->src_ip);
-            uint8_t http_buf[192];
-            size_t http_len = build_http_response(http_buf, client_ip);
-
-            send_tcp_packet(&devices[0], reply_buffer, mac, eth->src,
-                           ip->dst_ip, ip->src_ip,
-                           dst_port, src_port,
-                           their_ack, their_seq + tcp_payload_len,
-                           TCP_FLAG_PSH | TCP_FLAG_ACK, 65535,
-                           http_buf, http_len);
-
-            log_debug(http_log, "HTTP response sent\n");
-        }
-
-        // FIN → ACK it
-        if ((flags & TCP_FLAG_FIN) && !(flags & TCP_FLAG_SYN)) {
-            send_tcp_packet(&devices[0], reply_buffer, mac, eth->src,
-                           ip->dst_ip, ip->src_ip,
-                           dst_port, src_port,
-                           their_ack, their_seq + 1,
-                           TCP_FLAG_ACK, 65535,
-                           NULL, 0);
-        }
+        netdev_rx_release(&devices[0], frames, count);
+        tx_batch_flush(&batch);
     }
 }
@@ -2,7 +2,8 @@
 
 #include "../network/ipv4/ipv4.h"
 
-#define HTTP_HELLO_BUFFER_SIZE 2048
+#define HTTP_HELLO_BURST_SIZE 16
+#define HTTP_HELLO_TX_BATCH_SIZE 16
 #define HTTP_HELLO_PORT 80
 
 void app_http_hello(void);
@@ -1,10 +1,10 @@
 #!/bin/bash
 
 # Test HTTP Hello World application
-# Usage: ./apps/http-hello/http_hello.test.sh [-v] [--arch=riscv|amd64|arm64] [--netdev=e1000|rtl8139|virtio-net]
+# Usage: ./apps/http-hello/http_hello.test.sh [-v] [--arch=riscv|amd64|arm64] [--netdev=e1000|e1000e|igb|vmxnet3|rtl8139|virtio-net]
 #   -v: verbose mode (prints QEMU output)
 #   --arch=riscv|arm64|amd64: specify architecture (default: all, comma-separated supported)
-#   --netdev=e1000|rtl8139|virtio-net: specify network device (default: all, comma-separated supported)
+#   --netdev=e1000|e1000e|igb|vmxnet3|rtl8139|virtio-net: specify network device (default: all, comma-separated supported)
 #
 # Examples:
 #   ./apps/http-hello/http_hello.test.sh              # Run all architectures
@@ -0,0 +1,37 @@
+#include "netdev.h"
+#include "../../common/common.h"
+
+void app_mac_vmxnet3(void) {
+    const driver_t *driver = vmxnet3_get_driver();
+    if (!driver) {
+        puts("vmxnet3: Failed to get driver\n");
+        return;
+    }
+
+    // Contexts come from the driver's own pool, shared with netdev_acquire_all()
+    device_entry_t device;
+    if (netdev_acquire(driver, &device) != 0) {
+        puts("vmxnet3: No available device\n");
+        return;
+    }
+
+    resource_print_tag(device.resource);
+    puts(" Initializing...\n");
+
+    resource_print_tag(device.resource);
+    puts(" MAC: ");
+
+    uint8_t mac[6];
+    int result = netdev_get_mac(&device, mac);
+    if (result == 0) {
+        for (int i = 0; i < 6; i++) {
+            put_hex8(mac[i]);
+            if (i < 5) {
+                puts(":");
+            }
+        }
+    } else {
+        puts("(unavailable)");
+    }
+    puts("\n");
+}
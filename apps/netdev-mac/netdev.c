@@ -1,76 +1,94 @@
 #include "netdev.h"
 #include "../../common/common.h"
+#include "../../common/params.h"
+
+// Kernel command line parameter: empty polls before sleeping until the device interrupts
+#define NETDEV_POLL_BUDGET_PARAM "netdev.poll_budget"
+#define NETDEV_POLL_BUDGET_DEFAULT 4096
+
+// Build with -DNETDEV_SINGLE_DRIVER=<driver> (make NETDEV_DRIVER=<driver>)
+// to bind netdev to one driver: its <driver>_netdev_<op> entry points are
+// then called directly instead of through the netdev_ops_t table.
+#define NETDEV_PASTE(a, b) a##b
+#define NETDEV_NAME(driver, suffix) NETDEV_PASTE(driver, suffix)
+
+#ifdef NETDEV_SINGLE_DRIVER
+#define NETDEV_OP(device, op) NETDEV_NAME(NETDEV_SINGLE_DRIVER, _netdev_##op)
+#else
+#define NETDEV_OP(device, op) ((device)->ops->op)
+#endif
+
+// Network drivers tried by netdev_acquire_all(), in order
+static const driver_t *(*const netdev_drivers[])(void) = {
+#ifdef NETDEV_SINGLE_DRIVER
+    NETDEV_NAME(NETDEV_SINGLE_DRIVER, _get_driver),
+#else
+    rtl8139_get_driver,
+    virtio_net_get_driver,
+    e1000_get_driver,
+    e1000e_get_driver,
+    igb_get_driver,
+    vmxnet3_get_driver,
+#endif
+};
+
+#define NETDEV_DRIVER_COUNT (int)(sizeof(netdev_drivers) / sizeof(netdev_drivers[0]))
+
+// Contexts of each driver's pool already handed out, by netdev_drivers[] index
+static int context_index[NETDEV_DRIVER_COUNT];
+
+// Acquire the next available device of driver into the next free context of its pool
+static int netdev_acquire_next(int index, const driver_t *driver, device_entry_t *device) {
+    if (context_index[index] >= NETDEV_MAX_CONTEXTS) {
+        return -1;
+    }
+
+    const netdev_ops_t *ops = driver->netdev_ops;
+    void *context = (uint8_t *)ops->contexts + (size_t)context_index[index] * ops->context_size;
+    resource_t *resource = resource_acquire_available(driver, context);
+    if (resource == NULL) {
+        return -1;
+    }
+
+    device->resource = resource;
+    device->driver = driver;
+    device->ops = ops;
+    device->context = context;
+    device->queue = 0;
+    context_index[index]++;
 
-// Maximum number of network devices per driver type
-// Limited to 4 to reduce static memory usage while supporting typical VM configurations
-#define MAX_NETDEV_CONTEXTS_PER_DRIVER 4
+    return 0;
+}
 
 int netdev_acquire_all(device_entry_t *devices, int max_devices) {
     int device_count = 0;
 
-    while (device_count < max_devices) {
-        resource_t *resource = NULL;
-        const driver_t *driver = NULL;
-
-        // Try RTL8139
-        driver = rtl8139_get_driver();
-        if (driver != NULL) {
-            static rtl8139_t rtl8139_contexts[MAX_NETDEV_CONTEXTS_PER_DRIVER] = {0};
-            static int rtl8139_index = 0;
-            if (rtl8139_index < MAX_NETDEV_CONTEXTS_PER_DRIVER) {
-                resource = resource_acquire_available(driver, &rtl8139_contexts[rtl8139_index]);
-                if (resource != NULL) {
-                    devices[device_count].resource = resource;
-                    devices[device_count].driver = driver;
-                    devices[device_count].context = &rtl8139_contexts[rtl8139_index];
-                    rtl8139_index++;
-                    device_count++;
-                    continue;
-                }
-            }
+    for (int i = 0; i < NETDEV_DRIVER_COUNT && device_count < max_devices; i++) {
+        const driver_t *driver = netdev_drivers[i]();
+        if (driver == NULL || driver->netdev_ops == NULL) {
+            continue;
         }
 
-        // Try VirtIO-Net
-        driver = virtio_net_get_driver();
-        if (driver != NULL) {
-            static virtio_net_t virtio_net_contexts[MAX_NETDEV_CONTEXTS_PER_DRIVER] = {0};
-            static int virtio_net_index = 0;
-            if (virtio_net_index < MAX_NETDEV_CONTEXTS_PER_DRIVER) {
-                resource = resource_acquire_available(driver, &virtio_net_contexts[virtio_net_index]);
-                if (resource != NULL) {
-                    devices[device_count].resource = resource;
-                    devices[device_count].driver = driver;
-                    devices[device_count].context = &virtio_net_contexts[virtio_net_index];
-                    virtio_net_index++;
-                    device_count++;
-                    continue;
-                }
-            }
+        while (device_count < max_devices && netdev_acquire_next(i, driver, &devices[device_count]) == 0) {
+            device_count++;
         }
+    }
 
-        // Try E1000
-        driver = e1000_get_driver();
-        if (driver != NULL) {
-            static e1000_t e1000_contexts[MAX_NETDEV_CONTEXTS_PER_DRIVER] = {0};
-            static int e1000_index = 0;
-            if (e1000_index < MAX_NETDEV_CONTEXTS_PER_DRIVER) {
-                resource = resource_acquire_available(driver, &e1000_contexts[e1000_index]);
-                if (resource != NULL) {
-                    devices[device_count].resource = resource;
-                    devices[device_count].driver = driver;
-                    devices[device_count].context = &e1000_contexts[e1000_index];
-                    e1000_index++;
-                    device_count++;
-                    continue;
-                }
-            }
-        }
+    return device_count;
+}
 
-        // No more devices available
-        break;
+int netdev_acquire(const driver_t *driver, device_entry_t *device) {
+    if (driver == NULL || driver->netdev_ops == NULL || device == NULL) {
+        return -1;
     }
 
-    return device_count;
+    for (int i = 0; i < NETDEV_DRIVER_COUNT; i++) {
+        if (netdev_drivers[i]() == driver) {
+            return netdev_acquire_next(i, driver, device);
+        }
+    }
+
+    return -1;
 }
 
 int netdev_get_mac(const device_entry_t *device, uint8_t mac[6]) {
@@ -78,32 +96,91 @@ int netdev_get_mac(const device_entry_t *device, uint8_t mac[6]) {
         return -1;
     }
 
-    if (device->driver == rtl8139_get_driver()) {
-        return rtl8139_get_mac((rtl8139_t *)device->context, mac);
-    } else if (device->driver == virtio_net_get_driver()) {
-        return virtio_net_get_mac((virtio_net_t *)device->context, mac);
-    } else if (device->driver == e1000_get_driver()) {
-        return e1000_get_mac((e1000_t *)device->context, mac);
+    return NETDEV_OP(device, get_mac)(device->context, mac);
+}
+
+uint32_t netdev_get_caps(const device_entry_t *device) {
+    if (device == NULL) {
+        return 0;
     }
 
-    return -1;
+    return NETDEV_OP(device, get_caps)(device->context);
 }
 
-int netdev_transmit(const device_entry_t *device, const uint8_t *packet, size_t length) {
-    if (device == NULL || packet == NULL || length == 0) {
+int netdev_get_queue_count(const device_entry_t *device) {
+    if (device == NULL) {
+        return 0;
+    }
+
+    return NETDEV_OP(device, get_queue_count)(device->context);
+}
+
+int netdev_get_stats(const device_entry_t *device, net_stats_t *stats) {
+    if (device == NULL || stats == NULL) {
         return -1;
     }
 
-    // Dispatch to appropriate driver
-    if (device->driver == virtio_net_get_driver()) {
-        return virtio_net_transmit((virtio_net_t *)device->context, packet, length);
-    } else if (device->driver == e1000_get_driver()) {
-        return e1000_transmit((e1000_t *)device->context, packet, length);
-    } else if (device->driver == rtl8139_get_driver()) {
-        return rtl8139_transmit((rtl8139_t *)device->context, packet, length);
+    return NETDEV_OP(device, get_stats)(device->context, stats);
+}
+
+int netdev_get_queue(const device_entry_t *device, uint16_t queue, device_entry_t *queue_entry) {
+    if (device == NULL || queue_entry == NULL || queue >= netdev_get_queue_count(device)) {
+        return -1;
     }
 
-    return -1;
+    *queue_entry = *device;
+    queue_entry->queue = queue;
+
+    return 0;
+}
+
+int netdev_wait(const device_entry_t *device) {
+    if (device == NULL) {
+        return -1;
+    }
+
+    return NETDEV_OP(device, wait)(device->context, device->queue);
+}
+
+void netdev_poll_init(netdev_poll_t *poll) {
+    if (poll == NULL) {
+        return;
+    }
+
+    poll->budget = NETDEV_POLL_BUDGET_DEFAULT;
+    params_get_uint(NETDEV_POLL_BUDGET_PARAM, &poll->budget);
+    poll->empty_polls = 0;
+}
+
+void netdev_poll_update(const device_entry_t *device, netdev_poll_t *poll, int received) {
+    if (device == NULL || poll == NULL) {
+        return;
+    }
+
+    // Keep busy-polling while traffic flows
+    if (received > 0) {
+        poll->empty_polls = 0;
+        return;
+    }
+
+    if (poll->budget == 0 || ++poll->empty_polls < poll->budget) {
+        return;
+    }
+
+    // Idle for the whole budget: sleep until the next frame. A device that
+    // cannot interrupt is busy-polled from now on
+    poll->empty_polls = 0;
+    if (netdev_wait(device) != 0) {
+        poll->budget = 0;
+    }
+}
+
+int netdev_transmit(const device_entry_t *device, const uint8_t *packet, size_t length) {
+    if (device == NULL || packet == NULL || length == 0) {
+        return -1;
+    }
+
+    return NETDEV_OP(device, transmit)(device->context, device->queue, packet, length);
 }
 
 int netdev_receive(const device_entry_t *device, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
@@ -111,14 +188,65 @@ int netdev_receive(const device_entry_t *device, uint8_t *buffer, size_t buffer_
         return -1;
     }
 
-    // Dispatch to appropriate driver
-    if (device->driver == virtio_net_get_driver()) {
-        return virtio_net_receive((virtio_net_t *)device->context, buffer, buffer_size, received_length);
-    } else if (device->driver == e1000_get_driver()) {
-        return e1000_receive((e1000_t *)device->context, buffer, buffer_size, received_length);
-    } else if (device->driver == rtl8139_get_driver()) {
-        return rtl8139_receive((rtl8139_t *)device->context, buffer, buffer_size, received_length);
+    return NETDEV_OP(device, receive)(device->context, device->queue, buffer, buffer_size, received_length);
+}
+
+int netdev_receive_burst(const device_entry_t *device, uint8_t *const buffers[], size_t buffer_size,
+                         size_t lengths[], int max_packets) {
+    if (device == NULL || buffers == NULL || lengths == NULL || max_packets < 0) {
+        return -1;
     }
 
-    return -1;
+    return NETDEV_OP(device, receive_burst)(device->context, device->queue, buffers, buffer_size, lengths,
+                                            max_packets);
+}
+
+int netdev_transmit_burst(const device_entry_t *device, const uint8_t *const packets[], const size_t lengths[],
+                          int count) {
+    if (device == NULL || packets == NULL || lengths == NULL || count < 0) {
+        return -1;
+    }
+
+    return NETDEV_OP(device, transmit_burst)(device->context, device->queue, packets, lengths, count);
+}
+
+int netdev_rx_acquire(const device_entry_t *device, net_rx_frame_t frames[], int max_frames) {
+    if (device == NULL || frames == NULL || max_frames < 0) {
+        return -1;
+    }
+
+    return NETDEV_OP(device, rx_acquire)(device->context, device->queue, frames, max_frames);
+}
+
+int netdev_rx_release(const device_entry_t *device, const net_rx_frame_t frames[], int count) {
+    if (device == NULL || frames == NULL || count < 0) {
+        return -1;
+    }
+
+    return NETDEV_OP(device, rx_release)(device->context, device->queue, frames, count);
+}
+
+int netdev_tx_alloc(const device_entry_t *device, net_tx_slot_t *slot) {
+    if (device == NULL || slot == NULL) {
+        return -1;
+    }
+
+    return NETDEV_OP(device, tx_alloc)(device->context, device->queue, slot);
+}
+
+int netdev_tx_commit(const device_entry_t *device, const net_tx_slot_t slots[], const size_t lengths[], int count) {
+    if (device == NULL || slots == NULL || lengths == NULL || count < 0) {
+        return -1;
+    }
+
+    return NETDEV_OP(device, tx_commit)(device->context, device->queue, slots, lengths, count);
+}
+
+int netdev_tx_commit_sg(const device_entry_t *device, const net_tx_slot_t *slot, size_t length,
+                        const net_tx_frag_t frags[], int frag_count) {
+    if (device == NULL || slot == NULL || frag_count < 0 || (frag_count > 0 && frags == NULL)) {
+        return -1;
+    }
+
+    return NETDEV_OP(device, tx_commit_sg)(device->context, device->queue, slot, length, frags, frag_count);
 }
@@ -3,16 +3,45 @@
 #include "../../common/types.h"
 #include "../../drivers/virtio_net/virtio_net.h"
 #include "../../drivers/e1000/e1000.h"
+#include "../../drivers/e1000e/e1000e.h"
+#include "../../drivers/igb/igb.h"
+#include "../../drivers/vmxnet3/vmxnet3.h"
 #include "../../drivers/rtl8139/rtl8139.h"
 #include "../../kernel/resources/resources.h"
 
 typedef struct {
     resource_t *resource;
     const driver_t *driver;
+    const netdev_ops_t *ops;    // driver->netdev_ops, cached for the hot path
     void *context;
+    uint16_t queue;             // Queue pair this entry polls (0 unless from netdev_get_queue())
 } device_entry_t;
 
+// Adaptive polling state (see netdev_poll_update())
+typedef struct {
+    uint32_t budget;            // Empty polls before sleeping, 0 to busy-poll only
+    uint32_t empty_polls;       // Consecutive polls that returned no frames
+} netdev_poll_t;
+
 int netdev_acquire_all(device_entry_t *devices, int max_devices);
+int netdev_acquire(const driver_t *driver, device_entry_t *device);
 int netdev_get_mac(const device_entry_t *device, uint8_t mac[6]);
+uint32_t netdev_get_caps(const device_entry_t *device);
+int netdev_get_stats(const device_entry_t *device, net_stats_t *stats);
+int netdev_get_queue_count(const device_entry_t *device);
+int netdev_get_queue(const device_entry_t *device, uint16_t queue, device_entry_t *queue_entry);
+int netdev_wait(const device_entry_t *device);
+void netdev_poll_init(netdev_poll_t *poll);
+void netdev_poll_update(const device_entry_t *device, netdev_poll_t *poll, int received);
 int netdev_transmit(const device_entry_t *device, const uint8_t *packet, size_t length);
 int netdev_receive(const device_entry_t *device, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+int netdev_receive_burst(const device_entry_t *device, uint8_t *const buffers[], size_t buffer_size,
+                         size_t lengths[], int max_packets);
+int netdev_transmit_burst(const device_entry_t *device, const uint8_t *const packets[], const size_t lengths[],
+                          int count);
+int netdev_rx_acquire(const device_entry_t *device, net_rx_frame_t frames[], int max_frames);
+int netdev_rx_release(const device_entry_t *device, const net_rx_frame_t frames[], int count);
+int netdev_tx_alloc(const device_entry_t *device, net_tx_slot_t *slot);
+int netdev_tx_commit(const device_entry_t *device, const net_tx_slot_t slots[], const size_t lengths[], int count);
+int netdev_tx_commit_sg(const device_entry_t *device, const net_tx_slot_t *slot, size_t length,
+                        const net_tx_frag_t frags[], int frag_count);
@@ -4,5 +4,8 @@
 
 void app_mac_virtio_net(void);
 void app_mac_e1000(void);
+void app_mac_e1000e(void);
+void app_mac_igb(void);
+void app_mac_vmxnet3(void);
 void app_mac_rtl8139(void);
 void app_mac_all(void);
@@ -76,7 +76,8 @@ void tcp_print(const uint8_t *tcp_segment, size_t length, int leftpad) {
     puts("\n");
 }
 
-uint16_t tcp_checksum(uint32_t src_ip, uint32_t dst_ip, const uint8_t *tcp_segment, uint16_t tcp_length) {
+// Unfolded one's complement sum of the TCP pseudo-header (host byte order)
+static uint32_t tcp_pseudo_header_sum(uint32_t src_ip, uint32_t dst_ip, uint16_t tcp_length) {
     uint32_t sum = 0;
 
     // Pseudo-header: src_ip, dst_ip, zero+protocol, tcp_length (all in network byte order)
@@ -87,6 +88,12 @@ uint16_t tcp_checksum(uint32_t src_ip, uint32_t dst_ip, const uint8_t *tcp_segme
     sum += IPPROTO_TCP;
     sum += tcp_length;
 
+    return sum;
+}
+
+uint16_t tcp_checksum(uint32_t src_ip, uint32_t dst_ip, const uint8_t *tcp_segment, uint16_t tcp_length) {
+    uint32_t sum = tcp_pseudo_header_sum(src_ip, dst_ip, tcp_length);
+
     // Sum TCP header + payload in 16-bit words (byte-wise reads for alignment safety)
     uint16_t remaining = tcp_length;
     size_t offset = 0;
@@ -127,3 +134,35 @@ void tcp_build_header(tcp_hdr_t *header, uint16_t src_port, uint16_t dst_port,
     uint16_t cksum = tcp_checksum(src_ip, dst_ip, (const uint8_t *)header, tcp_length);
     header->checksum = cksum;
 }
+
+uint16_t tcp_pseudo_header_checksum(uint32_t src_ip, uint32_t dst_ip, uint16_t tcp_length) {
+    uint32_t sum = tcp_pseudo_header_sum(src_ip, dst_ip, tcp_length);
+
+    // Fold 32-bit sum to 16 bits (not inverted: the device adds the segment and inverts)
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    return htons((uint16_t)sum);
+}
+
+void tcp_build_header_partial(tcp_hdr_t *header, uint16_t src_port, uint16_t dst_port,
+                              uint32_t seq, uint32_t ack, uint8_t flags, uint16_t window,
+                              uint32_t src_ip, uint32_t dst_ip, uint16_t payload_length) {
+    write_htons_unaligned(&header->src_port, src_port);
+    write_htons_unaligned(&header->dst_port, dst_port);
+    write_htonl_unaligned(&header->seq_num, seq);
+    write_htonl_unaligned(&header->ack_num, ack);
+    header->data_offset = (5 << 4);  // 20 bytes, no options
+    header->flags = flags;
+    write_htons_unaligned(&header->window, window);
+    header->urgent_ptr = 0;
+
+    uint16_t tcp_length = sizeof(tcp_hdr_t) + payload_length;
+    header->checksum = tcp_pseudo_header_checksum(src_ip, dst_ip, tcp_length);
+}
+
+bool tcp_verify_checksum(uint32_t src_ip, uint32_t dst_ip, const uint8_t *tcp_segment, uint16_t tcp_length) {
+    // Summing a segment that includes a correct checksum yields 0xFFFF, which inverts to 0
+    return tcp_checksum(src_ip, dst_ip, tcp_segment, tcp_length) == 0;
+}
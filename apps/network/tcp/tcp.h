@@ -21,6 +21,9 @@ typedef struct {
     uint16_t urgent_ptr;
 } __attribute__((packed)) tcp_hdr_t;
 
+// Offset of the checksum field within the TCP header (for checksum offload)
+#define TCP_CHECKSUM_OFFSET 16
+
 /**
  * Print TCP segment header
  * @param tcp_segment Pointer to TCP segment data
@@ -56,3 +59,44 @@ uint16_t tcp_checksum(uint32_t src_ip, uint32_t dst_ip, const uint8_t *tcp_segme
 void tcp_build_header(tcp_hdr_t *header, uint16_t src_port, uint16_t dst_port,
                       uint32_t seq, uint32_t ack, uint8_t flags, uint16_t window,
                       uint32_t src_ip, uint32_t dst_ip, uint16_t payload_length);
+
+/**
+ * Calculate the folded, non-inverted TCP pseudo-header sum
+ * This is the value a device expects in the checksum field when it completes
+ * the checksum itself (partial checksum offload).
+ * @param src_ip Source IP address (network byte order)
+ * @param dst_ip Destination IP address (network byte order)
+ * @param tcp_length Total length of TCP header + payload in bytes
+ * @return Pseudo-header sum in network byte order
+ */
+uint16_t tcp_pseudo_header_checksum(uint32_t src_ip, uint32_t dst_ip, uint16_t tcp_length);
+
+/**
+ * Build TCP header for checksum offload
+ * Same as tcp_build_header(), but stores only the pseudo-header sum in the checksum
+ * field and leaves summing the segment to the device (csum_start = TCP header,
+ * csum_offset = TCP_CHECKSUM_OFFSET).
+ * @param header Pointer to TCP header structure to fill
+ * @param src_port Source port (host byte order)
+ * @param dst_port Destination port (host byte order)
+ * @param seq Sequence number (host byte order)
+ * @param ack Acknowledgment number (host byte order)
+ * @param flags TCP flags (TCP_FLAG_SYN, TCP_FLAG_ACK, etc.)
+ * @param window Window size (host byte order)
+ * @param src_ip Source IP address (network byte order)
+ * @param dst_ip Destination IP address (network byte order)
+ * @param payload_length Length of payload after TCP header
+ */
+void tcp_build_header_partial(tcp_hdr_t *header, uint16_t src_port, uint16_t dst_port,
+                              uint32_t seq, uint32_t ack, uint8_t flags, uint16_t window,
+                              uint32_t src_ip, uint32_t dst_ip, uint16_t payload_length);
+
+/**
+ * Verify TCP checksum of a received segment
+ * @param src_ip Source IP address (network byte order)
+ * @param dst_ip Destination IP address (network byte order)
+ * @param tcp_segment Pointer to TCP header + payload (contiguous)
+ * @param tcp_length Total length of TCP header + payload in bytes
+ * @return true if the checksum is correct
+ */
+bool tcp_verify_checksum(uint32_t src_ip, uint32_t dst_ip, const uint8_t *tcp_segment, uint16_t tcp_length);
@@ -13,6 +13,207 @@
 
 static log_tag_t *pktprint_log;
 
+// Handle a single received frame, return true if a request was answered
+static bool handle_frame(const device_entry_t *device, const uint8_t mac[6],
+                         const uint8_t *buffer, size_t length, uint8_t *reply_buffer) {
+    bool handled = false;
+
+    if (log_enabled(pktprint_log, LOG_INFO)) {
+        ethernet_print(buffer, length, device->resource, 0);
+    }
+
+    if (length >= sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(udp_hdr_t)) {
+        const eth_hdr_t *eth = (const eth_hdr_t *)buffer;
+        uint16_t eth_type = ntohs_unaligned(&eth->type);
+
+        if (eth_type == ETH_P_IP) {
+            const ipv4_hdr_t *ip = (const ipv4_hdr_t *)(buffer + sizeof(eth_hdr_t));
+
+            if (ip->protocol == IPPROTO_UDP) {
+                uint32_t dst_ip = ntohl_unaligned(&ip->dst_ip);
+
+                if (dst_ip == PACKET_PRINT_IP_ADDR) {
+                    const udp_hdr_t *udp = (const udp_hdr_t *)(buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
+                    uint16_t dst_port = ntohs_unaligned(&udp->dst_port);
+
+                    if (dst_port == PACKET_PRINT_UDP_PORT) {
+                        // Extract payload
+                        const uint8_t *payload = buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(udp_hdr_t);
+                        size_t payload_len = ntohs_unaligned(&udp->length) - sizeof(udp_hdr_t);
+
+                        if (log_enabled(pktprint_log, LOG_INFO)) {
+                            log_prefix(pktprint_log, LOG_INFO);
+                            puts("Received UDP payload: ");
+                            for (size_t i = 0; i < payload_len && i < PACKET_PRINT_MAX_PAYLOAD_DISPLAY; i++) {
+                                char c = payload[i];
+                                if (c >= 32 && c <= 126) {
+                                    putchar(c);
+                                } else {
+                                    putchar('.');
+                                }
+                            }
+                            puts("\n");
+                        }
+
+                        // Check if payload starts with "ping-"
+                        if (payload_len >= 6 &&
+                            payload[0] == 'p' && payload[1] == 'i' &&
+                            payload[2] == 'n' && payload[3] == 'g' &&
+                            payload[4] == '-') {
+
+                            // Parse the number after "ping-"
+                            int num = 0;
+                            for (size_t i = 5; i < payload_len && payload[i] >= '0' && payload[i] <= '9'; i++) {
+                                num = num * 10 + (payload[i] - '0');
+                            }
+
+                            // Build response: "pong-" + (num + 1)
+                            uint8_t reply_payload_buf[64];
+                            size_t response_len = 0;
+
+                            reply_payload_buf[response_len++] = 'p';
+                            reply_payload_buf[response_len++] = 'o';
+                            reply_payload_buf[response_len++] = 'n';
+                            reply_payload_buf[response_len++] = 'g';
+                            reply_payload_buf[response_len++] = '-';
+
+                            // Convert (num + 1) to ASCII digits
+                            int response_num = num + 1;
+                            char num_str[16];
+                            int num_len = 0;
+                            if (response_num == 0) {
+                                num_str[num_len++] = '0';
+                            } else {
+                                int temp = response_num;
+                                while (temp > 0) {
+                                    num_str[num_len++] = '0' + (temp % 10);
+                                    temp /= 10;
+                                }
+                                // Reverse the digits
+                                for (int i = 0; i < num_len / 2; i++) {
+                                    char tmp = num_str[i];
+                                    num_str[i] = num_str[num_len - 1 - i];
+                                    num_str[num_len - 1 - i] = tmp;
+                                }
+                            }
+                            for (int i = 0; i < num_len; i++) {
+                                reply_payload_buf[response_len++] = num_str[i];
+                            }
+
+                            // Build UDP echo reply
+                            eth_hdr_t *reply_eth = (eth_hdr_t *)reply_buffer;
+                            for (int i = 0; i < 6; i++) {
+                                reply_eth->dst[i] = eth->src[i];
+                                reply_eth->src[i] = mac[i];
+                            }
+                            reply_eth->type = htons(ETH_P_IP);
+
+                            // Build IPv4 header
+                            ipv4_hdr_t *reply_ip = (ipv4_hdr_t *)(reply_buffer + sizeof(eth_hdr_t));
+                            ipv4_build_header(reply_ip, ip->dst_ip, ip->src_ip, IPPROTO_UDP, sizeof(udp_hdr_t) + response_len, 64);
+
+                            // Build UDP header
+                            udp_hdr_t *reply_udp = (udp_hdr_t *)(reply_buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
+                            uint16_t src_port = ntohs_unaligned(&udp->dst_port);
+                            uint16_t dst_port = ntohs_unaligned(&udp->src_port);
+                            udp_build_header(reply_udp, src_port, dst_port, response_len);
+
+                            // Copy response payload
+                            uint8_t *reply_payload = reply_buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(udp_hdr_t);
+                            for (size_t i = 0; i < response_len; i++) {
+                                reply_payload[i] = reply_payload_buf[i];
+                            }
+
+                            size_t total_len = sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(udp_hdr_t) + response_len;
+
+                            int result = netdev_transmit(device, reply_buffer, total_len);
+                            if (result == 0) {
+                                log_info(pktprint_log, "Sent UDP echo reply\n");
+                                handled = true;
+                            }
+                        }
+                    }
+                }
+            } else if (ip->protocol == IPPROTO_TCP) {
+                if (length >= sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(tcp_hdr_t)) {
+                    uint32_t dst_ip = ntohl_unaligned(&ip->dst_ip);
+
+                    if (dst_ip == PACKET_PRINT_IP_ADDR) {
+                        const tcp_hdr_t *tcp = (const tcp_hdr_t *)(buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
+                        uint16_t dst_port = ntohs_unaligned(&tcp->dst_port);
+
+                        if (dst_port == PACKET_PRINT_IPV4_PORT) {
+                            log_info(pktprint_log, "TCP packet received\n");
+                            handled = true;
+                        }
+                    }
+                }
+            } else if (ip->protocol == IPPROTO_ICMP) {
+                if (length >= sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(icmp_hdr_t)) {
+                    uint32_t dst_ip = ntohl_unaligned(&ip->dst_ip);
+
+                    if (dst_ip == PACKET_PRINT_IP_ADDR) {
+                        const icmp_hdr_t *icmp = (const icmp_hdr_t *)(buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
+                        uint8_t type = 0;
+                        uint16_t id = 0;
+                        uint16_t sequence = 0;
+
+                        if (icmp_parse((const uint8_t *)icmp, sizeof(icmp_hdr_t), &type, 0, &id, &sequence)) {
+                            if (type == ICMP_ECHO_REQUEST) {
+                                eth_hdr_t *reply_eth = (eth_hdr_t *)reply_buffer;
+                                ipv4_hdr_t *reply_ip = (ipv4_hdr_t *)(reply_buffer + sizeof(eth_hdr_t));
+                                icmp_hdr_t *reply_icmp = (icmp_hdr_t *)(reply_buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
+                                size_t total_len = sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(icmp_hdr_t);
+
+                                // Build Ethernet header
+                                for (int i = 0; i < 6; i++) {
+                                    reply_eth->dst[i] = eth->src[i];
+                                    reply_eth->src[i] = mac[i];
+                                }
+                                reply_eth->type = htons(ETH_P_IP);
+
+                                // Build IPv4 header
+                                ipv4_build_header(reply_ip, ip->dst_ip, ip->src_ip, IPPROTO_ICMP, sizeof(icmp_hdr_t), 64);
+
+                                // Build ICMP header
+                                icmp_build_response(reply_icmp, id, sequence);
+
+                                int result = netdev_transmit(device, reply_buffer, total_len);
+                                if (result == 0) {
+                                    log_info(pktprint_log, "Sent ICMP echo reply\n");
+                                    handled = true;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        } else if (eth_type == ETH_P_ARP) {
+            // Handle ARP requests
+            const arp_hdr_t *arp_req = (const arp_hdr_t *)(buffer + sizeof(eth_hdr_t));
+            uint16_t opcode = ntohs_unaligned(&arp_req->opcode);
+            uint32_t target_ip = ntohl_unaligned(&arp_req->target_ip);
+
+            if (opcode == ARP_OP_REQUEST && target_ip == PACKET_PRINT_IP_ADDR) {
+                uint32_t sender_ip = ntohl_unaligned(&arp_req->sender_ip);
+
+                arp_build_reply(reply_buffer,
+                               mac,
+                               PACKET_PRINT_IP_ADDR,
+                               arp_req->sender_mac,
+                               sender_ip);
+
+                int result = netdev_transmit(device, reply_buffer, ARP_PACKET_SIZE);
+                if (result == 0) {
+                    log_debug(pktprint_log, "Sent ARP reply\n");
+                }
+            }
+        }
+    }
+
+    return handled;
+}
+
 void app_packet_print(void) {
     pktprint_log = log_register("packet-print", LOG_INFO);
     log_info(pktprint_log, "Starting packet-print application...\n");
@@ -48,210 +249,29 @@ void app_packet_print(void) {
     // the IPv4 header (which starts after Ethernet) will be 4-byte aligned.
     // This improves performance on architectures that require aligned access.
     #define ETH_ALIGNMENT_OFFSET 2
-    uint8_t buffer_storage[PACKET_PRINT_BUFFER_SIZE + ETH_ALIGNMENT_OFFSET] __attribute__((aligned(4)));
+    static uint8_t buffer_storage[PACKET_PRINT_BURST_SIZE][PACKET_PRINT_BUFFER_SIZE + ETH_ALIGNMENT_OFFSET]
+        __attribute__((aligned(4)));
     uint8_t reply_buffer_storage[PACKET_PRINT_BUFFER_SIZE + ETH_ALIGNMENT_OFFSET] __attribute__((aligned(4)));
-    uint8_t *buffer = buffer_storage + ETH_ALIGNMENT_OFFSET;
+    uint8_t *buffers[PACKET_PRINT_BURST_SIZE];
+    size_t lengths[PACKET_PRINT_BURST_SIZE];
+    for (int i = 0; i < PACKET_PRINT_BURST_SIZE; i++) {
+        buffers[i] = buffer_storage[i] + ETH_ALIGNMENT_OFFSET;
+    }
     uint8_t *reply_buffer = reply_buffer_storage + ETH_ALIGNMENT_OFFSET;
     bool handled_request = false;
+    netdev_poll_t poll;
+    netdev_poll_init(&poll);
 
     while (!handled_request) {
-        size_t received_length = 0;
-        result = netdev_receive(&devices[0], buffer, PACKET_PRINT_BUFFER_SIZE, &received_length);
-
-        if (result == 0 && received_length > 0) {
-            if (log_enabled(pktprint_log, LOG_INFO)) {
-                ethernet_print(buffer, received_length, devices[0].resource, 0);
-            }
-
-            if (received_length >= sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(udp_hdr_t)) {
-                const eth_hdr_t *eth = (const eth_hdr_t *)buffer;
-                uint16_t eth_type = ntohs_unaligned(&eth->type);
-
-                if (eth_type == ETH_P_IP) {
-                    const ipv4_hdr_t *ip = (const ipv4_hdr_t *)(buffer + sizeof(eth_hdr_t));
-
-                    if (ip->protocol == IPPROTO_UDP) {
-                        uint32_t dst_ip = ntohl_unaligned(&ip->dst_ip);
-
-                        if (dst_ip == PACKET_PRINT_IP_ADDR) {
-                            const udp_hdr_t *udp = (const udp_hdr_t *)(buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
-                            uint16_t dst_port = ntohs_unaligned(&udp->dst_port);
-
-                            if (dst_port == PACKET_PRINT_UDP_PORT) {
-                                // Extract payload
-                                const uint8_t *payload = buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(udp_hdr_t);
-                                size_t payload_len = ntohs_unaligned(&udp->length) - sizeof(udp_hdr_t);
-
-                                if (log_enabled(pktprint_log, LOG_INFO)) {
-                                    log_prefix(pktprint_log, LOG_INFO);
-                                    puts("Received UDP payload: ");
-                                    for (size_t i = 0; i < payload_len && i < PACKET_PRINT_MAX_PAYLOAD_DISPLAY; i++) {
-                                        char c = payload[i];
-                                        if (c >= 32 && c <= 126) {
-                                            putchar(c);
-                                        } else {
-                                            putchar('.');
-                                        }
-                                    }
-                                    puts("\n");
-                                }
-
-                                // Check if payload starts with "ping-"
-                                if (payload_len >= 6 &&
-                                    payload[0] == 'p' && payload[1] == 'i' &&
-                                    payload[2] == 'n' && payload[3] == 'g' &&
-                                    payload[4] == '-') {
-
-                                    // Parse the number after "ping-"
-                                    int num = 0;
-                                    for (size_t i = 5; i < payload_len && payload[i] >= '0' && payload[i] <= '9'; i++) {
-                                        num = num * 10 + (payload[i] - '0');
-                                    }
-
-                                    // Build response: "pong-" + (num + 1)
-                                    uint8_t reply_payload_buf[64];
-                                    size_t response_len = 0;
-
-                                    reply_payload_buf[response_len++] = 'p';
-                                    reply_payload_buf[response_len++] = 'o';
-                                    reply_payload_buf[response_len++] = 'n';
-                                    reply_payload_buf[response_len++] = 'g';
-                                    reply_payload_buf[response_len++] = '-';
-
-                                    // Convert (num + 1) to ASCII digits
-                                    int response_num = num + 1;
-                                    char num_str[16];
-                                    int num_len = 0;
-                                    if (response_num == 0) {
-                                        num_str[num_len++] = '0';
-                                    } else {
-                                        int temp = response_num;
-                                        while (temp > 0) {
-                                            num_str[num_len++] = '0' + (temp % 10);
-                                            temp /= 10;
-                                        }
-                                        // Reverse the digits
-                                        for (int i = 0; i < num_len / 2; i++) {
-                                            char tmp = num_str[i];
-                                            num_str[i] = num_str[num_len - 1 - i];
-                                            num_str[num_len - 1 - i] = tmp;
-                                        }
-                                    }
-                                    for (int i = 0; i < num_len; i++) {
-                                        reply_payload_buf[response_len++] = num_str[i];
-                                    }
-
-                                    // Build UDP echo reply
-                                    eth_hdr_t *reply_eth = (eth_hdr_t *)reply_buffer;
-                                    for (int i = 0; i < 6; i++) {
-                                        reply_eth->dst[i] = eth->src[i];
-                                        reply_eth->src[i] = mac[i];
-                                    }
-                                    reply_eth->type = htons(ETH_P_IP);
-
-                                    // Build IPv4 header
-                                    ipv4_hdr_t *reply_ip = (ipv4_hdr_t *)(reply_buffer + sizeof(eth_hdr_t));
-                                    ipv4_build_header(reply_ip, ip->dst_ip, ip->src_ip, IPPROTO_UDP, sizeof(udp_hdr_t) + response_len, 64);
-
-                                    // Build UDP header
-                                    udp_hdr_t *reply_udp = (udp_hdr_t *)(reply_buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
-                                    uint16_t src_port = ntohs_unaligned(&udp->dst_port);
-                                    uint16_t dst_port = ntohs_unaligned(&udp->src_port);
-                                    udp_build_header(reply_udp, src_port, dst_port, response_len);
-
-                                    // Copy response payload
-                                    uint8_t *reply_payload = reply_buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(udp_hdr_t);
-                                    for (size_t i = 0; i < response_len; i++) {
-                                        reply_payload[i] = reply_payload_buf[i];
-                                    }
-
-                                    size_t total_len = sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(udp_hdr_t) + response_len;
-
-                                    result = netdev_transmit(&devices[0], reply_buffer, total_len);
-                                    if (result == 0) {
-                                        log_info(pktprint_log, "Sent UDP echo reply\n");
-                                        handled_request = true;
-                                    }
-                                }
-                            }
-                        }
-                    } else if (ip->protocol == IPPROTO_TCP) {
-                        if (received_length >= sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(tcp_hdr_t)) {
-                            uint32_t dst_ip = ntohl_unaligned(&ip->dst_ip);
-
-                            if (dst_ip == PACKET_PRINT_IP_ADDR) {
-                                const tcp_hdr_t *tcp = (const tcp_hdr_t *)(buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
-                                uint16_t dst_port = ntohs_unaligned(&tcp->dst_port);
-
-                                if (dst_port == PACKET_PRINT_IPV4_PORT) {
-                                    log_info(pktprint_log, "TCP packet received\n");
-                                    handled_request = true;
-                                }
-                            }
-                        }
-                    } else if (ip->protocol == IPPROTO_ICMP) {
-                        if (received_length >= sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(icmp_hdr_t)) {
-                            uint32_t dst_ip = ntohl_unaligned(&ip->dst_ip);
-
-                            if (dst_ip == PACKET_PRINT_IP_ADDR) {
-                                const icmp_hdr_t *icmp = (const icmp_hdr_t *)(buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
-                                uint8_t type = 0;
-                                uint16_t id = 0;
-                                uint16_t sequence = 0;
-
-                                if (icmp_parse((const uint8_t *)icmp, sizeof(icmp_hdr_t), &type, 0, &id, &sequence)) {
-                                    if (type == ICMP_ECHO_REQUEST) {
-                                        eth_hdr_t *reply_eth = (eth_hdr_t *)reply_buffer;
-                                        ipv4_hdr_t *reply_ip = (ipv4_hdr_t *)(reply_buffer + sizeof(eth_hdr_t));
-                                        icmp_hdr_t *reply_icmp = (icmp_hdr_t *)(reply_buffer + sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t));
-                                        size_t total_len = sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) + sizeof(icmp_hdr_t);
-
-                                        // Build Ethernet header
-                                        for (int i = 0; i < 6; i++) {
-                                            reply_eth->dst[i] = eth->src[i];
-                                            reply_eth->src[i] = mac[i];
-                                        }
-                                        reply_eth->type = htons(ETH_P_IP);
-
-                                        // Build IPv4 header
-                                        ipv4_build_header(reply_ip, ip->dst_ip, ip->src_ip, IPPROTO_ICMP, sizeof(icmp_hdr_t), 64);
-
-                                        // Build ICMP header
-                                        icmp_build_response(reply_icmp, id, sequence);
-
-                                        result = netdev_transmit(&devices[0], reply_buffer, total_len);
-                                        if (result == 0) {
-                                            log_info(pktprint_log, "Sent ICMP echo reply\n");
-                                            handled_request = true;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                } else if (eth_type == ETH_P_ARP) {
-                    // Handle ARP requests
-                    const arp_hdr_t *arp_req = (const arp_hdr_t *)(buffer + sizeof(eth_hdr_t));
-                    uint16_t opcode = ntohs_unaligned(&arp_req->opcode);
-                    uint32_t target_ip = ntohl_unaligned(&arp_req->target_ip);
-
-                    if (opcode == ARP_OP_REQUEST && target_ip == PACKET_PRINT_IP_ADDR) {
-                        uint32_t sender_ip = ntohl_unaligned(&arp_req->sender_ip);
-
-                        arp_build_reply(reply_buffer,
-                                       mac,
-                                       PACKET_PRINT_IP_ADDR,
-                                       arp_req->sender_mac,
-                                       sender_ip);
-
-                        result = netdev_transmit(&devices[0], reply_buffer, ARP_PACKET_SIZE);
-                        if (result == 0) {
-                            log_debug(pktprint_log, "Sent ARP reply\n");
-                        }
-                    }
-                }
+        int count = netdev_receive_burst(&devices[0], buffers, PACKET_PRINT_BUFFER_SIZE, lengths,
+                                         PACKET_PRINT_BURST_SIZE);
+        netdev_poll_update(&devices[0], &poll, count);
+
+        // Finish the whole batch so frames already pulled off the ring are not lost
+        for (int i = 0; i < count; i++) {
+            if (lengths[i] > 0 && handle_frame(&devices[0], mac, buffers[i], lengths[i], reply_buffer)) {
+                handled_request = true;
             }
         }
     }
 }
-
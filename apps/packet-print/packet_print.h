@@ -3,6 +3,7 @@
 #include "../network/ipv4/ipv4.h"
 
 #define PACKET_PRINT_BUFFER_SIZE 2048
+#define PACKET_PRINT_BURST_SIZE 8
 #define PACKET_PRINT_IP_ADDR IPV4(10, 0, 2, 15)
 #define PACKET_PRINT_UDP_PORT 5000
 #define PACKET_PRINT_IPV4_PORT 8080
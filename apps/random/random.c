@@ -17,7 +17,7 @@ static struct {
     int next_device_index;                                 // Round-robin index for device selection
     bool initialized;                                      // Module initialized
 } random_state = {
-    .rng_contexts = {{0}},
+    .rng_contexts = {},
     .resources = {NULL},
     .device_count = 0,
     .next_device_index = 0,
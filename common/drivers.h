@@ -1,9 +1,11 @@
 #pragma once
 
 #include "types.h"
+#include "common.h"
 
-// Forward declaration
+// Forward declarations
 typedef struct device device_t;
+typedef struct netdev_ops netdev_ops_t;
 
 // Driver types
 typedef enum {
@@ -33,4 +35,138 @@ typedef struct driver {
     // Per-instance operations (called by resource manager)
     int (*init_context)(void *ctx, device_t *device);
     void (*deinit_context)(void *ctx);
+
+    // Network entry points (DRIVER_TYPE_NETWORK only, NULL otherwise)
+    const netdev_ops_t *netdev_ops;
 } driver_t;
+
+// ============================================================================
+// Network driver interface
+// ============================================================================
+
+// Network device capability flags
+#define NET_CAP_TX_CSUM         (1 << 0)    // Device completes TX checksums (net_tx_offload_t csum_*)
+#define NET_CAP_RX_CSUM         (1 << 1)    // Device validates RX checksums (NET_RX_F_CSUM_VALID)
+#define NET_CAP_TSO4            (1 << 2)    // Device segments IPv4/TCP super-frames (net_tx_offload_t gso_size)
+
+// Largest IPv4/TCP super-frame accepted for segmentation offload: Ethernet header + 64 KB IP datagram
+#define NET_TSO_MAX_FRAME_SIZE  (14 + 65535)
+
+// Transmit backpressure: returned instead of -1 when the TX ring is full. Nothing
+// was queued; retry once the device has completed earlier frames.
+#define NET_TX_AGAIN            (-2)
+
+// Received frame flags
+#define NET_RX_F_CSUM_VALID     (1 << 0)    // L4 checksum already verified by the device
+
+// Received frame lent by a network driver (zero-copy receive)
+// data points into driver-owned DMA memory and stays valid until the frame
+// is returned with the driver's rx_release. Frames are only guaranteed to be
+// 2-byte aligned, so multi-byte header fields must be read with the
+// *_unaligned helpers from byteorder.h.
+typedef struct {
+    const uint8_t *data;        // Start of the Ethernet frame
+    size_t length;              // Frame length in bytes
+    uint16_t slot;              // Driver ring slot, opaque to the caller
+    uint16_t flags;             // NET_RX_F_* flags
+} net_rx_frame_t;
+
+// Per-frame transmit offload request
+// csum_start == 0 means the frame is sent as-is. Otherwise the device computes
+// the one's complement checksum from csum_start to the end of the frame and
+// stores it at csum_start + csum_offset (which must hold the pseudo-header sum).
+// gso_size != 0 asks the device to cut an IPv4/TCP frame larger than the MTU
+// into segments of gso_size payload bytes; it requires the checksum request.
+typedef struct {
+    uint16_t csum_start;        // Offset of the L4 header from the frame start
+    uint16_t csum_offset;       // Offset of the checksum field within the L4 header
+    uint16_t gso_size;          // TCP MSS for segmentation offload, 0 for none
+} net_tx_offload_t;
+
+// Transmit slot handed out by a network driver (zero-copy transmit)
+// The caller writes the Ethernet frame straight into data, which points into
+// driver-owned DMA memory with any device header already reserved in front.
+// data is 2 bytes past a 4-byte boundary so the IPv4 header that follows the
+// 14-byte Ethernet header is 4-byte aligned.
+typedef struct {
+    uint8_t *data;              // Where the Ethernet frame is written
+    size_t capacity;            // Maximum frame length in bytes
+    uint16_t slot;              // Driver ring slot, opaque to the caller
+    net_tx_offload_t offload;   // Cleared by alloc, filled by the caller if needed
+} net_tx_slot_t;
+
+// Caller-owned buffer appended to a transmit slot (scatter-gather transmit)
+// The device reads it in place, so it must stay unchanged until the frame
+// has been sent (e.g. static or read-only response data).
+typedef struct {
+    const uint8_t *data;
+    size_t length;
+} net_tx_frag_t;
+
+// Device counters reported by a network driver's get_stats
+typedef struct {
+    uint64_t rx_packets;        // Frames received
+    uint64_t tx_packets;        // Frames transmitted
+    uint64_t rx_dropped;        // Frames lost for lack of receive buffers or discarded by the driver
+    uint64_t tx_dropped;        // Frames refused because the TX ring was full (0 if not counted)
+} net_stats_t;
+
+// Static device contexts each network driver keeps for netdev_acquire_all()
+#define NETDEV_MAX_CONTEXTS     4
+
+// RX/TX queue pairs a multiqueue driver sets up per device, capped by the
+// driver's own maximum. Their buffers are static, so only the pair the
+// network apps poll is allocated unless built with make NETDEV_QUEUES=<n>
+#ifndef NETDEV_QUEUES
+#define NETDEV_QUEUES           1
+#endif
+
+// Network driver operations, registered through driver_t.netdev_ops
+// Every entry takes the driver context as void * and a queue pair index,
+// which drivers with a single queue pair ignore. All entries are mandatory;
+// the return conventions are those of the driver functions they wrap.
+// Each driver also exports them as <driver>_netdev_<op> so a single-driver
+// build can call them directly (see netdev.c).
+struct netdev_ops {
+    void *contexts;             // Array of NETDEV_MAX_CONTEXTS device contexts
+    size_t context_size;        // Size of one context in bytes
+
+    int (*get_mac)(void *ctx, uint8_t mac[6]);
+    uint32_t (*get_caps)(void *ctx);
+    int (*get_queue_count)(void *ctx);
+    int (*get_stats)(void *ctx, net_stats_t *stats);
+    int (*wait)(void *ctx, uint16_t queue);
+    int (*transmit)(void *ctx, uint16_t queue, const uint8_t *packet, size_t length);
+    int (*receive)(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+    int (*receive_burst)(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                         size_t lengths[], int max_packets);
+    int (*transmit_burst)(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                          int count);
+    int (*rx_acquire)(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+    int (*rx_release)(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+    int (*tx_alloc)(void *ctx, uint16_t queue, net_tx_slot_t *slot);
+    int (*tx_commit)(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count);
+    int (*tx_commit_sg)(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                        const net_tx_frag_t frags[], int frag_count);
+};
+
+// Copy scatter-gather fragments behind the frame in a transmit slot, for
+// drivers that send each frame from a single buffer. Returns the total frame
+// length, or 0 if it does not fit (committing length 0 drops the frame).
+static inline size_t net_tx_linearize(const net_tx_slot_t *slot, size_t length,
+                                      const net_tx_frag_t frags[], int frag_count) {
+    size_t total = length;
+    for (int i = 0; i < frag_count; i++) {
+        total += frags[i].length;
+    }
+    if (slot->offload.gso_size != 0 || total > slot->capacity) {
+        return 0;
+    }
+
+    for (int i = 0; i < frag_count; i++) {
+        memcpy(slot->data + length, frags[i].data, frags[i].length);
+        length += frags[i].length;
+    }
+
+    return total;
+}
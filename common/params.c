@@ -0,0 +1,51 @@
+#include "params.h"
+#include "common.h"
+
+static const char *kernel_cmdline = NULL;
+
+void params_init(const char *cmdline) {
+    kernel_cmdline = cmdline;
+}
+
+const char *params_get(const char *key, size_t *value_len) {
+    if (!kernel_cmdline || !key) return NULL;
+
+    size_t key_len = strlen(key);
+    const char *found = NULL;
+    const char *pos = kernel_cmdline;
+    while (*pos) {
+        // Skip whitespace
+        while (*pos == ' ' || *pos == '\t') pos++;
+        if (!*pos) break;
+
+        // Later occurrences override earlier ones
+        if (strncmp(pos, key, key_len) == 0 && pos[key_len] == '=') {
+            found = pos + key_len + 1;
+        }
+
+        // Skip to next token
+        while (*pos && *pos != ' ' && *pos != '\t') pos++;
+    }
+
+    if (found && value_len) {
+        size_t len = 0;
+        while (found[len] && found[len] != ' ' && found[len] != '\t') len++;
+        *value_len = len;
+    }
+    return found;
+}
+
+bool params_get_uint(const char *key, uint32_t *value) {
+    size_t len;
+    const char *val = params_get(key, &len);
+    if (!val || !value || len == 0 || len > 9) return false;
+
+    uint32_t result = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (val[i] < '0' || val[i] > '9') return false;
+        result = result * 10 + (uint32_t)(val[i] - '0');
+    }
+
+    *value = result;
+    return true;
+}
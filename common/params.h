@@ -0,0 +1,15 @@
+#pragma once
+
+#include "types.h"
+
+// Remember the kernel command line so drivers can read their parameters.
+// The string must outlive the kernel (FDT memory, bootloader data, or a literal).
+void params_init(const char *cmdline);
+
+// Find "<key>=<value>" in the command line. Returns a pointer to the value
+// and stores its length in value_len, or NULL if the key is not present.
+const char *params_get(const char *key, size_t *value_len);
+
+// Read a decimal "<key>=<number>" parameter. Returns true and stores the
+// value on success, false if the key is missing or not a valid number.
+bool params_get_uint(const char *key, uint32_t *value);
@@ -0,0 +1,70 @@
+/*
+ * Kernel Command Line Test Suite (Freestanding)
+ */
+
+#include "../tests/test-kernel/test_kernel_common.h"
+#include "params.h"
+
+void test_no_cmdline(void) {
+    test_start("no command line");
+    uint32_t value = 7;
+    params_init(NULL);
+    test_assert_true(params_get("app", NULL) == NULL, "get returns NULL");
+    test_assert_true(!params_get_uint("app", &value), "get_uint fails");
+    test_assert_eq_uint32(value, 7, "value untouched");
+}
+
+void test_get_value(void) {
+    test_start("get value");
+    size_t len = 0;
+    params_init("app=http-hello log=debug");
+    const char *val = params_get("app", &len);
+    test_assert_true(val != NULL, "app found");
+    test_assert_eq_uint32(len, 10, "value length");
+    test_assert_mem_eq(val, "http-hello", 10, "value text");
+    val = params_get("log", &len);
+    test_assert_true(val != NULL && len == 5, "last token found");
+}
+
+void test_missing_key(void) {
+    test_start("missing key");
+    params_init("app=http-hello apps=x ap=y app");
+    test_assert_true(params_get("log", NULL) == NULL, "absent key not found");
+    test_assert_true(params_get("a", NULL) == NULL, "prefix of key not matched");
+    params_init("application=x");
+    test_assert_true(params_get("app", NULL) == NULL, "key prefix of token not matched");
+}
+
+void test_last_wins(void) {
+    test_start("last occurrence wins");
+    uint32_t value = 0;
+    params_init("virtio-net.queue_size=64\tapp=x  virtio-net.queue_size=128");
+    test_assert_true(params_get_uint("virtio-net.queue_size", &value), "found");
+    test_assert_eq_uint32(value, 128, "later value used");
+}
+
+void test_get_uint(void) {
+    test_start("get_uint");
+    uint32_t value = 0;
+    params_init("a=0 b=256 c=12x d= e=-1 f=1234567890 g=999999999");
+    test_assert_true(params_get_uint("a", &value) && value == 0, "zero");
+    test_assert_true(params_get_uint("b", &value) && value == 256, "256");
+    test_assert_true(!params_get_uint("c", &value), "trailing garbage rejected");
+    test_assert_true(!params_get_uint("d", &value), "empty value rejected");
+    test_assert_true(!params_get_uint("e", &value), "negative rejected");
+    test_assert_true(!params_get_uint("f", &value), "too many digits rejected");
+    test_assert_true(params_get_uint("g", &value) && value == 999999999, "nine digits");
+}
+
+// Entry point for tests
+void test_kernel_main(void) {
+    test_suite_start("Kernel Command Line");
+
+    test_no_cmdline();
+    test_get_value();
+    test_missing_key();
+    test_last_wins();
+    test_get_uint();
+
+    test_suite_end();
+}
@@ -1,15 +1,25 @@
 #include "e1000.h"
 #include "../../common/common.h"
 #include "../../common/log.h"
+#include "../../common/params.h"
+#include "../../kernel/devices/pci.h"
+#include "../../kernel/platform/platform.h"
+#include "../../apps/network/ethernet/ethernet.h"
+#include "../../apps/network/ipv4/ipv4.h"
 
 static log_tag_t *e1000_log;
 
-// ARM64 requires special handling for packed structures with -O3
-// GCC generates unaligned memory access instructions which can cause issues
-// TODO: remove
-#if defined(__aarch64__)
-#pragma GCC optimize ("O0")
-#endif
+// Kernel command line parameter limiting the ring size
+#define E1000_RING_SIZE_PARAM   "e1000.ring_size"
+
+// Kernel command line parameter capping interrupts per second (0: no throttling)
+#define E1000_IRQ_RATE_PARAM    "e1000.irq_rate"
+
+// Interrupt causes that end e1000_wait()
+#define E1000_WAKEUP_CAUSES     (E1000_ICR_RXT0 | E1000_ICR_TXDW)
+
+// Offset of the header checksum within the IPv4 header
+#define E1000_IPV4_CSUM_OFFSET  10
 
 // Intel 82540EM Vendor and Device IDs
 #define PCI_VENDOR_ID_INTEL     0x8086
@@ -36,6 +46,12 @@ static inline void e1000_write32(e1000_t *ctx, uint32_t offset, uint32_t value)
     *mmio = value;
 }
 
+// Move a ring tail pointer once the descriptors before it are visible to the NIC
+static inline void e1000_write_tail(e1000_t *ctx, uint32_t offset, uint32_t value) {
+    __sync_synchronize();
+    e1000_write32(ctx, offset, value);
+}
+
 // Helper function to read MAC from EEPROM or registers
 static void e1000_read_mac_address(e1000_t *ctx) {
     // For now, read from RAL/RAH registers
@@ -72,7 +88,27 @@ static int e1000_init_context(void *ctx, device_t *device) {
     e1000_t *e1000_ctx = (e1000_t *)ctx;
     e1000_ctx->mmio_base = device->reg_base;
     e1000_ctx->rx_current = 0;
+    e1000_ctx->rx_lent = 0;
+    e1000_ctx->rx_unreturned = 0;
     e1000_ctx->tx_current = 0;
+    e1000_ctx->tx_reserved = 0;
+    e1000_ctx->tx_clean = 0;
+    e1000_ctx->tx_inflight = 0;
+    e1000_ctx->tx_buffer_head = 0;
+    e1000_ctx->tx_csum_context = false;
+
+    // Use the largest rings unless lowered on the command line; TX completions
+    // are tracked per RS group, so the size is a whole number of groups
+    uint32_t ring_size = E1000_MAX_DESC;
+    if (params_get_uint(E1000_RING_SIZE_PARAM, &ring_size)) {
+        if (ring_size < E1000_MIN_DESC) {
+            ring_size = E1000_MIN_DESC;
+        } else if (ring_size > E1000_MAX_DESC) {
+            ring_size = E1000_MAX_DESC;
+        }
+        ring_size -= ring_size % E1000_TX_RS_INTERVAL;
+    }
+    e1000_ctx->ring_size = (uint16_t)ring_size;
 
     // Enable bus mastering and memory access in PCI command register (if needed)
     // This is typically done by the PCI enumeration code, but we ensure it here
@@ -89,7 +125,7 @@ static int e1000_init_context(void *ctx, device_t *device) {
     e1000_read_mac_address(e1000_ctx);
 
     // Initialize RX descriptors
-    for (int i = 0; i < E1000_NUM_RX_DESC; i++) {
+    for (int i = 0; i < e1000_ctx->ring_size; i++) {
         e1000_ctx->rx_descs[i].buffer_addr = (uintptr_t)e1000_ctx->rx_buffers[i];
         e1000_ctx->rx_descs[i].status = 0;
     }
@@ -97,28 +133,48 @@ static int e1000_init_context(void *ctx, device_t *device) {
     // Set up RX descriptor ring
     e1000_write32(e1000_ctx, E1000_RDBAL, (uint32_t)(uintptr_t)e1000_ctx->rx_descs);
     e1000_write32(e1000_ctx, E1000_RDBAH, (uint32_t)((uintptr_t)e1000_ctx->rx_descs >> 32));
-    e1000_write32(e1000_ctx, E1000_RDLEN, E1000_NUM_RX_DESC * sizeof(e1000_rx_desc_t));
+    e1000_write32(e1000_ctx, E1000_RDLEN, e1000_ctx->ring_size * sizeof(e1000_rx_desc_t));
     e1000_write32(e1000_ctx, E1000_RDH, 0);
-    e1000_write32(e1000_ctx, E1000_RDT, E1000_NUM_RX_DESC - 1);
+    e1000_write32(e1000_ctx, E1000_RDT, e1000_ctx->ring_size - 1);
 
-    // Clear any pending interrupts
+    // Mask every cause and clear any pending interrupts; e1000_wait() only
+    // unmasks RXT0/TXDW while the CPU sleeps
+    e1000_write32(e1000_ctx, E1000_IMC, 0xFFFFFFFF);
     e1000_read32(e1000_ctx, E1000_ICR);  // Read to clear
 
-    // Disable interrupts (we're polling)
-    e1000_write32(e1000_ctx, E1000_IMS, 0);
+    // Interrupts only wake e1000_wait(): MSI when the device offers it,
+    // otherwise its INTx line
+    uint64_t msi_address;
+    uint32_t msi_data;
+    e1000_ctx->irq_mode = E1000_IRQ_NONE;
+    if (device->compatible == NULL && platform_msi_get_message(&msi_address, &msi_data) == 0 &&
+        pci_msi_enable(device->bus, device->device_num, device->function, msi_address, msi_data) == 0) {
+        e1000_ctx->irq_mode = E1000_IRQ_MSI;
+    } else if (device->irq != 0 && platform_irq_enable(device->irq) == 0) {
+        e1000_ctx->irq_mode = E1000_IRQ_WIRED;
+    }
+
+    // Space interrupts at least 1/irq_rate seconds apart: under load the NIC
+    // coalesces frames into one interrupt instead of waking the CPU per frame
+    uint32_t irq_rate = E1000_IRQ_RATE_DEFAULT;
+    params_get_uint(E1000_IRQ_RATE_PARAM, &irq_rate);
+    uint32_t itr = irq_rate ? E1000_ITR_UNITS_PER_SEC / irq_rate : 0;
+    e1000_write32(e1000_ctx, E1000_ITR, itr > E1000_ITR_MAX ? E1000_ITR_MAX : itr);
 
     // Note: Must enable transmitter BEFORE receiver for proper operation
-    // Initialize TX descriptors first
-    for (int i = 0; i < E1000_NUM_TX_DESC; i++) {
-        e1000_ctx->tx_descs[i].buffer_addr = (uintptr_t)e1000_ctx->tx_buffers[i];
-        e1000_ctx->tx_descs[i].status = E1000_TXD_STAT_DD;
-        e1000_ctx->tx_descs[i].cmd = 0;
+    // Initialize TX descriptors first; buffers are attached when frames are queued
+    for (int i = 0; i < e1000_ctx->ring_size; i++) {
+        e1000_ctx->tx_descs[i].legacy.buffer_addr = 0;
+        e1000_ctx->tx_descs[i].legacy.status = 0;
+        e1000_ctx->tx_descs[i].legacy.cmd = 0;
+        e1000_ctx->tx_desc_buffer[i] = E1000_TX_NO_BUFFER;
+        e1000_ctx->tx_buffer_busy[i] = false;
     }
 
     // Set up TX descriptor ring
     e1000_write32(e1000_ctx, E1000_TDBAL, (uint32_t)(uintptr_t)e1000_ctx->tx_descs);
     e1000_write32(e1000_ctx, E1000_TDBAH, (uint32_t)((uintptr_t)e1000_ctx->tx_descs >> 32));
-    e1000_write32(e1000_ctx, E1000_TDLEN, E1000_NUM_TX_DESC * sizeof(e1000_tx_desc_t));
+    e1000_write32(e1000_ctx, E1000_TDLEN, e1000_ctx->ring_size * sizeof(e1000_tx_ring_desc_t));
     e1000_write32(e1000_ctx, E1000_TDH, 0);
     e1000_write32(e1000_ctx, E1000_TDT, 0);
 
@@ -126,11 +182,19 @@ static int e1000_init_context(void *ctx, device_t *device) {
     uint32_t tctl = E1000_TCTL_EN | E1000_TCTL_PSP;
     e1000_write32(e1000_ctx, E1000_TCTL, tctl);
 
+    // Validate TCP/UDP checksums of received frames (reported per descriptor)
+    e1000_write32(e1000_ctx, E1000_RXCSUM, E1000_RXCSUM_TUOFL);
+
     // Now enable receiver
     uint32_t rctl = E1000_RCTL_EN | E1000_RCTL_UPE | E1000_RCTL_MPE |
                     E1000_RCTL_BAM | E1000_RCTL_BSIZE_2K;
     e1000_write32(e1000_ctx, E1000_RCTL, rctl);
 
+    // Statistics start from zero: reading the registers clears them
+    e1000_read32(e1000_ctx, E1000_GPRC);
+    e1000_read32(e1000_ctx, E1000_GPTC);
+    e1000_read32(e1000_ctx, E1000_MPC);
+    e1000_ctx->stats = (net_stats_t){0};
     e1000_ctx->initialized = true;
     log_info(e1000_log, "Driver initialized successfully\n");
     return 0;
@@ -148,7 +212,8 @@ static const driver_t e1000_driver = {
     .type = DRIVER_TYPE_NETWORK,
     .id_table = e1000_id_table,
     .init_context = e1000_init_context,
-    .deinit_context = e1000_deinit_context
+    .deinit_context = e1000_deinit_context,
+    .netdev_ops = &e1000_netdev_ops
 };
 
 const driver_t* e1000_get_driver(void) {
@@ -171,61 +236,517 @@ int e1000_get_mac(e1000_t *ctx, uint8_t mac[6]) {
     return 0;
 }
 
-int e1000_receive(e1000_t *ctx, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
-    if (!ctx || !buffer || !received_length) {
+uint32_t e1000_get_caps(e1000_t *ctx) {
+    (void)ctx;
+
+    // Checksums and segmentation through TX context descriptors, RX checksum
+    // validation through RXCSUM
+    return NET_CAP_TX_CSUM | NET_CAP_RX_CSUM | NET_CAP_TSO4;
+}
+
+int e1000_get_stats(e1000_t *ctx, net_stats_t *stats) {
+    if (!ctx || !stats || !ctx->initialized) {
         return -1;
     }
 
-    if (!ctx->initialized) {
-        return -1;
+    ctx->stats.rx_packets += e1000_read32(ctx, E1000_GPRC);
+    ctx->stats.tx_packets += e1000_read32(ctx, E1000_GPTC);
+    ctx->stats.rx_dropped += e1000_read32(ctx, E1000_MPC);
+    *stats = ctx->stats;
+
+    return 0;
+}
+
+// NET_RX_F_* flags of a received frame: the NIC verified its TCP/UDP checksum
+// unless it reports the checksum as ignored or wrong
+static inline uint16_t e1000_rx_flags(const e1000_rx_desc_t *desc) {
+    if ((desc->status & (E1000_RXD_STAT_TCPCS | E1000_RXD_STAT_IXSM)) == E1000_RXD_STAT_TCPCS &&
+        (desc->errors & E1000_RXD_ERR_TCPE) == 0) {
+        return NET_RX_F_CSUM_VALID;
     }
+    return 0;
+}
 
+// Consume the descriptor at rx_current without updating the RX tail pointer
+// Returns 1 if a packet was copied, 0 if no packet is available, -1 if a packet was dropped
+static int e1000_rx_next(e1000_t *ctx, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
     // Check current RX descriptor
     e1000_rx_desc_t *desc = &ctx->rx_descs[ctx->rx_current];
 
     // Check if descriptor has been used (DD bit set)
     if ((desc->status & E1000_RXD_STAT_DD) == 0) {
         // No packet available
-        return -1;
+        return 0;
     }
 
-    // Check if this is end of packet
+    int result = 1;
+
+    // Read the rest of the descriptor only after seeing DD
+    __sync_synchronize();
+
+    // Get packet length
+    uint16_t pkt_len = desc->length;
+
     if ((desc->status & E1000_RXD_STAT_EOP) == 0) {
         // Multi-descriptor packet not supported
-        desc->status = 0;
-        ctx->rx_current = (ctx->rx_current + 1) % E1000_NUM_RX_DESC;
+        result = -1;
+    } else if (pkt_len > buffer_size) {
+        // Buffer is not large enough
+        result = -1;
+    } else {
+        // Copy packet data
+        for (size_t i = 0; i < pkt_len; i++) {
+            buffer[i] = ctx->rx_buffers[ctx->rx_current][i];
+        }
+        *received_length = pkt_len;
+    }
+
+    // Reset descriptor for reuse
+    desc->status = 0;
+
+    // Move to next descriptor
+    ctx->rx_current = (ctx->rx_current + 1) % ctx->ring_size;
+
+    return result;
+}
+
+// Index of the most recently consumed RX descriptor (new RX tail)
+static inline uint16_t e1000_rx_last(e1000_t *ctx) {
+    return (ctx->rx_current + ctx->ring_size - 1) % ctx->ring_size;
+}
+
+// Hand every consumed RX descriptor back to the NIC with one RDT write
+static void e1000_rx_return(e1000_t *ctx) {
+    e1000_write_tail(ctx, E1000_RDT, e1000_rx_last(ctx));
+    ctx->rx_unreturned = 0;
+}
+
+// Clear the device's interrupt causes, which drops its line or ends the MSI
+// request, then complete the interrupt at the controller
+static void e1000_irq_ack(e1000_t *ctx) {
+    e1000_read32(ctx, E1000_ICR);  // Read to clear
+    if (ctx->irq_mode == E1000_IRQ_WIRED) {
+        platform_irq_ack();
+    }
+}
+
+int e1000_wait(e1000_t *ctx) {
+    if (!ctx || !ctx->initialized || ctx->irq_mode == E1000_IRQ_NONE) {
         return -1;
     }
 
-    // Get packet length
-    uint16_t pkt_len = desc->length;
+    // The NIC can only receive into descriptors it owns
+    if (ctx->rx_unreturned > 0) {
+        e1000_rx_return(ctx);
+    }
+
+    // Drop a cause raised while polling (e.g. a TX write-back) so it cannot
+    // end the wait right away
+    e1000_irq_ack(ctx);
+
+    // Check the ring again after unmasking: a frame written back before the
+    // causes were cleared would not interrupt
+    e1000_write32(ctx, E1000_IMS, E1000_WAKEUP_CAUSES);
+    if (!(ctx->rx_descs[ctx->rx_current].status & E1000_RXD_STAT_DD)) {
+        platform_irq_wait();
+    }
+    e1000_write32(ctx, E1000_IMC, E1000_WAKEUP_CAUSES);
+    e1000_irq_ack(ctx);
+
+    return 0;
+}
+
+int e1000_receive(e1000_t *ctx, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    if (!ctx || !buffer || !received_length) {
+        return -1;
+    }
+
+    if (!ctx->initialized) {
+        return -1;
+    }
+
+    int result = e1000_rx_next(ctx, buffer, buffer_size, received_length);
+    if (result == 0) {
+        if (ctx->rx_unreturned != 0) {
+            e1000_rx_return(ctx);
+        }
+        return -1;
+    }
+
+    // Every RDT write traps under emulation: while more frames are waiting,
+    // defer it until a batch of descriptors has been consumed
+    ctx->rx_unreturned++;
+    bool drained = (ctx->rx_descs[ctx->rx_current].status & E1000_RXD_STAT_DD) == 0;
+    if (drained || ctx->rx_unreturned >= E1000_RX_TAIL_BATCH) {
+        e1000_rx_return(ctx);
+    }
+
+    return result > 0 ? 0 : -1;
+}
+
+int e1000_receive_burst(e1000_t *ctx, uint8_t *const buffers[], size_t buffer_size,
+                        size_t lengths[], int max_packets) {
+    if (!ctx || !buffers || !lengths || max_packets < 0) {
+        return -1;
+    }
+
+    if (!ctx->initialized) {
+        return -1;
+    }
+
+    int received = 0;
+    bool consumed = false;
+    while (received < max_packets) {
+        int result = e1000_rx_next(ctx, buffers[received], buffer_size, &lengths[received]);
+        if (result == 0) {
+            break;
+        }
+        consumed = true;
+        if (result > 0) {
+            received++;
+        }
+    }
+
+    // Return all consumed descriptors to the NIC with a single tail update
+    if (consumed || ctx->rx_unreturned != 0) {
+        e1000_rx_return(ctx);
+    }
+
+    return received;
+}
+
+int e1000_rx_acquire(e1000_t *ctx, net_rx_frame_t frames[], int max_frames) {
+    if (!ctx || !frames || max_frames < 0) {
+        return -1;
+    }
+
+    if (!ctx->initialized) {
+        return -1;
+    }
+
+    int acquired = 0;
+    while (acquired < max_frames) {
+        uint16_t slot = ctx->rx_current;
+        e1000_rx_desc_t *desc = &ctx->rx_descs[slot];
+
+        if ((desc->status & E1000_RXD_STAT_DD) == 0) {
+            break;
+        }
+
+        // Read the rest of the descriptor only after seeing DD
+        __sync_synchronize();
+
+        bool valid = (desc->status & E1000_RXD_STAT_EOP) != 0;
+        uint16_t pkt_len = desc->length;
+        uint16_t flags = e1000_rx_flags(desc);
 
-    // Check if buffer is large enough
-    if (pkt_len > buffer_size) {
         desc->status = 0;
-        ctx->rx_current = (ctx->rx_current + 1) % E1000_NUM_RX_DESC;
+        ctx->rx_current = (ctx->rx_current + 1) % ctx->ring_size;
+
+        if (!valid) {
+            // Multi-descriptor packet not supported; give it straight back
+            // unless lent frames are still outstanding (release covers it)
+            if (ctx->rx_lent == 0 && acquired == 0) {
+                e1000_rx_return(ctx);
+            }
+            continue;
+        }
+
+        frames[acquired].data = ctx->rx_buffers[slot];
+        frames[acquired].length = pkt_len;
+        frames[acquired].slot = slot;
+        frames[acquired].flags = flags;
+        acquired++;
+    }
+
+    ctx->rx_lent += acquired;
+    return acquired;
+}
+
+int e1000_rx_release(e1000_t *ctx, const net_rx_frame_t frames[], int count) {
+    if (!ctx || !frames || count < 0 || count > ctx->rx_lent) {
         return -1;
     }
 
-    // Copy packet data
-    for (size_t i = 0; i < pkt_len; i++) {
-        buffer[i] = ctx->rx_buffers[ctx->rx_current][i];
+    if (count == 0) {
+        return 0;
     }
 
-    *received_length = pkt_len;
+    ctx->rx_lent -= count;
 
-    // Reset descriptor for reuse
+    // Descriptors are returned in ring order, so the tail only needs to move
+    // to the last released slot (or past any dropped ones once nothing is lent)
+    if (ctx->rx_lent == 0) {
+        e1000_rx_return(ctx);
+    } else {
+        e1000_write_tail(ctx, E1000_RDT, frames[count - 1].slot);
+    }
+
+    return 0;
+}
+
+// Reclaim TX descriptors the NIC is done with
+// Only the last descriptor of each RS group gets its status written back, so
+// descriptors are freed a whole group at a time once that one reports DD. A
+// full ring always holds a complete group, since it spans several of them.
+static void e1000_tx_reclaim(e1000_t *ctx) {
+    while (ctx->tx_inflight >= E1000_TX_RS_INTERVAL) {
+        const e1000_tx_desc_t *last = &ctx->tx_descs[ctx->tx_clean + E1000_TX_RS_INTERVAL - 1].legacy;
+        if ((last->status & E1000_TXD_STAT_DD) == 0) {
+            break;
+        }
+
+        // Buffers of frames whose first descriptor is in the group are free again
+        for (uint16_t i = 0; i < E1000_TX_RS_INTERVAL; i++) {
+            uint16_t buffer = ctx->tx_desc_buffer[ctx->tx_clean + i];
+            if (buffer != E1000_TX_NO_BUFFER) {
+                ctx->tx_buffer_busy[buffer] = false;
+            }
+        }
+        ctx->tx_clean = (ctx->tx_clean + E1000_TX_RS_INTERVAL) % ctx->ring_size;
+        ctx->tx_inflight -= E1000_TX_RS_INTERVAL;
+    }
+}
+
+// Whether count more descriptors fit in the ring next to those in flight and
+// reserved; one descriptor stays unused since TDT == TDH means an empty ring
+static bool e1000_tx_has_room(e1000_t *ctx, uint32_t count) {
+    uint32_t used = ctx->tx_inflight + (uint32_t)ctx->tx_reserved * E1000_TX_SLOT_DESCS;
+    if (used + count <= ctx->ring_size - 1u) {
+        return true;
+    }
+    e1000_tx_reclaim(ctx);
+    used = ctx->tx_inflight + (uint32_t)ctx->tx_reserved * E1000_TX_SLOT_DESCS;
+    return used + count <= ctx->ring_size - 1u;
+}
+
+// Reserve the next TX buffer after any already handed out
+// Buffers are used round-robin; a reserved slot also holds descriptors for
+// its context and data descriptor
+static int e1000_tx_claim(e1000_t *ctx, net_tx_slot_t *slot) {
+    if (!e1000_tx_has_room(ctx, E1000_TX_SLOT_DESCS)) {
+        return -1;
+    }
+
+    uint16_t index = (ctx->tx_buffer_head + ctx->tx_reserved) % ctx->ring_size;
+    if (ctx->tx_buffer_busy[index]) {
+        return -1;
+    }
+    ctx->tx_buffer_busy[index] = true;
+
+    slot->data = &ctx->tx_buffers[index][E1000_TX_HEADROOM];
+    slot->capacity = E1000_TX_BUFFER_SIZE - E1000_TX_HEADROOM;
+    slot->slot = index;
+    slot->offload.csum_start = 0;
+    slot->offload.csum_offset = 0;
+    slot->offload.gso_size = 0;
+    ctx->tx_reserved++;
+
+    return 0;
+}
+
+// Take the descriptor at tx_current; buffer (or E1000_TX_NO_BUFFER) is
+// released when the descriptor is reclaimed
+// Returns the RS bit for the descriptor: set at the end of each RS group
+static uint8_t e1000_tx_take(e1000_t *ctx, uint16_t buffer) {
+    uint16_t index = ctx->tx_current;
+    ctx->tx_desc_buffer[index] = buffer;
+    ctx->tx_current = (index + 1) % ctx->ring_size;
+    ctx->tx_inflight++;
+    return ((index + 1) % E1000_TX_RS_INTERVAL == 0) ? E1000_TXD_CMD_RS : 0;
+}
+
+// Write one data descriptor at tx_current: a legacy descriptor for a plain
+// frame, an extended one (carrying popts) when offloads are requested
+static void e1000_tx_put_data(e1000_t *ctx, uint16_t buffer, uint64_t addr, uint32_t length,
+                              uint8_t cmd, uint8_t popts, bool extended) {
+    e1000_tx_ring_desc_t *entry = &ctx->tx_descs[ctx->tx_current];
+    uint8_t rs = e1000_tx_take(ctx, buffer);
+
+    if (!extended) {
+        e1000_tx_desc_t *desc = &entry->legacy;
+        desc->buffer_addr = addr;
+        desc->length = (uint16_t)length;
+        desc->cso = 0;
+        desc->cmd = cmd | rs;
+        desc->status = 0;
+        desc->css = 0;
+        desc->special = 0;
+        return;
+    }
+
+    e1000_tx_data_desc_t *data = &entry->data;
+    data->buffer_addr = addr;
+    data->length = (uint16_t)length;
+    data->length_dtyp = E1000_TXD_DTYP_D | ((length >> 16) & 0x0F);
+    data->dcmd = cmd | rs | E1000_TXD_CMD_DEXT;
+    data->status = 0;
+    data->popts = popts;
+    data->special = 0;
+}
+
+// Write a context descriptor at tx_current
+static void e1000_tx_put_context(e1000_t *ctx, const e1000_tx_context_desc_t *context) {
+    e1000_tx_context_desc_t *desc = &ctx->tx_descs[ctx->tx_current].context;
+    uint8_t rs = e1000_tx_take(ctx, E1000_TX_NO_BUFFER);
+
+    *desc = *context;
+    desc->tucmd |= rs | E1000_TXD_CMD_DEXT;
     desc->status = 0;
+}
 
-    // Update RX tail pointer to make descriptor available again
-    e1000_write32(ctx, E1000_RDT, ctx->rx_current);
+// Descriptors needed for a buffer of the given length
+static inline uint32_t e1000_tx_desc_count(size_t length) {
+    return (uint32_t)((length + E1000_TX_MAX_DATA_PER_DESC - 1) / E1000_TX_MAX_DATA_PER_DESC);
+}
 
-    // Move to next descriptor
-    ctx->rx_current = (ctx->rx_current + 1) % E1000_NUM_RX_DESC;
+// Hand the oldest reserved slot to the NIC, followed by one or more data
+// descriptors per caller-owned fragment (no TDT write)
+// Checksum and segmentation requests go into a context descriptor in front of
+// the frame. The NIC keeps the last context, so a checksum context is only
+// written when csum_start/csum_offset change; TSO carries per-frame lengths
+// and always needs a fresh one.
+// The slot is consumed: returns 0 once queued, -1 for an invalid request or
+// NET_TX_AGAIN when the ring has no room for the descriptors
+static int e1000_tx_publish(e1000_t *ctx, size_t length, const net_tx_offload_t *offload,
+                            const net_tx_frag_t frags[], int frag_count) {
+    uint16_t buffer = ctx->tx_buffer_head;
+    uint8_t *frame = &ctx->tx_buffers[buffer][E1000_TX_HEADROOM];
+    size_t capacity = E1000_TX_BUFFER_SIZE - E1000_TX_HEADROOM;
+    bool gso = offload && offload->gso_size != 0;
+    bool csum = offload && offload->csum_start != 0;
+
+    ctx->tx_buffer_head = (buffer + 1) % ctx->ring_size;
+    ctx->tx_reserved--;
+
+    // The context fields are 8 bits wide; segmentation needs the checksum
+    // request locating the TCP header, which must be complete in the slot
+    size_t frame_len = length;
+    size_t hdr_len = 0;
+    uint32_t descs = 1;
+    bool valid = length > 0 && length <= capacity && frag_count >= 0 && (frag_count == 0 || frags);
+    if (csum && ((size_t)offload->csum_start + offload->csum_offset + 2 > length ||
+                 offload->csum_start + offload->csum_offset > 0xFF)) {
+        valid = false;
+    }
+    if (valid && gso) {
+        if (!csum || offload->csum_start < sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) ||
+            (size_t)offload->csum_start + 12 >= length) {
+            valid = false;
+        } else {
+            hdr_len = offload->csum_start + (frame[offload->csum_start + 12] >> 4) * 4;
+            valid = hdr_len <= length && hdr_len <= 0xFF;
+        }
+    }
+    for (int i = 0; valid && i < frag_count; i++) {
+        if (!frags[i].data || frags[i].length == 0) {
+            valid = false;
+        }
+        frame_len += frags[i].length;
+        descs += e1000_tx_desc_count(frags[i].length);
+    }
+    if (!valid || frame_len > (gso ? NET_TSO_MAX_FRAME_SIZE : capacity)) {
+        ctx->tx_buffer_busy[buffer] = false;
+        return -1;
+    }
+
+    bool load_context = gso || (csum && !(ctx->tx_csum_context &&
+                                          ctx->tx_csum_start == offload->csum_start &&
+                                          ctx->tx_csum_offset == offload->csum_offset));
+    if (load_context) {
+        descs++;
+    }
+    if (!e1000_tx_has_room(ctx, descs)) {
+        ctx->tx_buffer_busy[buffer] = false;
+        return NET_TX_AGAIN;
+    }
+
+    e1000_tx_context_desc_t context = {0};
+    uint8_t popts = 0;
+    uint8_t cmd = E1000_TXD_CMD_IFCS;
+    if (csum) {
+        context.tucss = (uint8_t)offload->csum_start;
+        context.tucso = (uint8_t)(offload->csum_start + offload->csum_offset);
+        context.tucse = 0;
+        popts |= E1000_TXD_POPTS_TXSM;
+    }
+    if (gso) {
+        // The NIC adds each segment's length to the TCP pseudo-header sum and
+        // recomputes the IPv4 header checksum per segment, so strip the length
+        // the caller summed in and clear the IPv4 checksum
+        uint8_t *sum = frame + context.tucso;
+        uint32_t value = ((uint32_t)sum[0] << 8 | sum[1]) + (uint16_t)~(frame_len - offload->csum_start);
+        value = (value & 0xFFFF) + (value >> 16);
+        sum[0] = (uint8_t)(value >> 8);
+        sum[1] = (uint8_t)value;
+        frame[sizeof(eth_hdr_t) + E1000_IPV4_CSUM_OFFSET] = 0;
+        frame[sizeof(eth_hdr_t) + E1000_IPV4_CSUM_OFFSET + 1] = 0;
+
+        size_t paylen = frame_len - hdr_len;
+        context.ipcss = sizeof(eth_hdr_t);
+        context.ipcso = sizeof(eth_hdr_t) + E1000_IPV4_CSUM_OFFSET;
+        context.ipcse = offload->csum_start - 1;
+        context.paylen = (uint16_t)paylen;
+        context.paylen_dtyp = (paylen >> 16) & 0x0F;
+        context.tucmd = E1000_TXD_CMD_TSE | E1000_TXD_TUCMD_TCP | E1000_TXD_TUCMD_IP;
+        context.hdr_len = (uint8_t)hdr_len;
+        context.mss = offload->gso_size;
+        popts |= E1000_TXD_POPTS_IXSM;
+        cmd |= E1000_TXD_CMD_TSE;
+    }
+    if (load_context) {
+        e1000_tx_put_context(ctx, &context);
+        // A segmentation context replaces the checksum-only one
+        ctx->tx_csum_context = !gso;
+        ctx->tx_csum_start = offload->csum_start;
+        ctx->tx_csum_offset = offload->csum_offset;
+    }
+
+    // Slot data first, then the fragments in pieces of at most
+    // E1000_TX_MAX_DATA_PER_DESC bytes; EOP marks the last descriptor
+    e1000_tx_put_data(ctx, buffer, (uintptr_t)frame, (uint32_t)length,
+                      cmd | (frag_count == 0 ? E1000_TXD_CMD_EOP : 0), popts, csum);
+    for (int i = 0; i < frag_count; i++) {
+        size_t offset = 0;
+        while (offset < frags[i].length) {
+            size_t chunk = frags[i].length - offset;
+            if (chunk > E1000_TX_MAX_DATA_PER_DESC) {
+                chunk = E1000_TX_MAX_DATA_PER_DESC;
+            }
+            bool last = i + 1 == frag_count && offset + chunk == frags[i].length;
+            e1000_tx_put_data(ctx, E1000_TX_NO_BUFFER, (uintptr_t)(frags[i].data + offset), (uint32_t)chunk,
+                              cmd | (last ? E1000_TXD_CMD_EOP : 0), popts, csum);
+            offset += chunk;
+        }
+    }
 
     return 0;
 }
 
+// Copy one packet into the next TX buffer without updating the tail pointer
+static int e1000_tx_enqueue(e1000_t *ctx, const uint8_t *buffer, size_t length) {
+    if (!buffer || length > E1000_TX_BUFFER_SIZE - E1000_TX_HEADROOM) {
+        return -1;
+    }
+
+    // Frames already reserved for zero-copy go out first
+    if (ctx->tx_reserved != 0) {
+        return -1;
+    }
+
+    net_tx_slot_t slot;
+    if (e1000_tx_claim(ctx, &slot) != 0) {
+        return -1;
+    }
+
+    // Copy packet to TX buffer
+    for (size_t i = 0; i < length; i++) {
+        slot.data[i] = buffer[i];
+    }
+
+    return e1000_tx_publish(ctx, length, NULL, NULL, 0);
+}
+
 int e1000_transmit(e1000_t *ctx, const uint8_t *buffer, size_t length) {
     if (!ctx || !buffer) {
         return -1;
@@ -235,34 +756,191 @@ int e1000_transmit(e1000_t *ctx, const uint8_t *buffer, size_t length) {
         return -1;
     }
 
-    if (length > E1000_TX_BUFFER_SIZE) {
+    if (e1000_tx_enqueue(ctx, buffer, length) != 0) {
         return -1;
     }
 
-    // Get current TX descriptor
-    e1000_tx_desc_t *desc = &ctx->tx_descs[ctx->tx_current];
+    // Update tail pointer to trigger transmission
+    e1000_write_tail(ctx, E1000_TDT, ctx->tx_current);
+
+    return 0;
+}
 
-    // Wait for descriptor to be free
-    if ((desc->status & E1000_TXD_STAT_DD) == 0) {
+int e1000_transmit_burst(e1000_t *ctx, const uint8_t *const packets[], const size_t lengths[], int count) {
+    if (!ctx || !packets || !lengths || count < 0) {
         return -1;
     }
 
-    // Copy packet to TX buffer
-    for (size_t i = 0; i < length; i++) {
-        ctx->tx_buffers[ctx->tx_current][i] = buffer[i];
+    if (!ctx->initialized) {
+        return -1;
     }
 
-    // Set up descriptor
-    desc->length = length;
-    desc->cmd = E1000_TXD_CMD_EOP | E1000_TXD_CMD_RS;
-    desc->status = 0;
+    int sent = 0;
+    while (sent < count) {
+        if (e1000_tx_enqueue(ctx, packets[sent], lengths[sent]) != 0) {
+            break;
+        }
+        sent++;
+    }
 
-    // Move to next descriptor
-    uint16_t next_tx = (ctx->tx_current + 1) % E1000_NUM_TX_DESC;
-    ctx->tx_current = next_tx;
+    // Single tail update triggers transmission of the whole batch
+    if (sent > 0) {
+        e1000_write_tail(ctx, E1000_TDT, ctx->tx_current);
+    }
 
-    // Update tail pointer to trigger transmission
-    e1000_write32(ctx, E1000_TDT, next_tx);
+    return sent;
+}
+
+int e1000_tx_alloc(e1000_t *ctx, net_tx_slot_t *slot) {
+    if (!ctx || !slot) {
+        return -1;
+    }
+
+    if (!ctx->initialized) {
+        return -1;
+    }
+
+    return e1000_tx_claim(ctx, slot);
+}
+
+int e1000_tx_commit(e1000_t *ctx, const net_tx_slot_t slots[], const size_t lengths[], int count) {
+    if (!ctx || !slots || !lengths || count < 0 || count > ctx->tx_reserved) {
+        return -1;
+    }
+
+    if (!ctx->initialized) {
+        return -1;
+    }
+
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        // Slots come back in allocation order, which is buffer order
+        if (slots[i].slot != ctx->tx_buffer_head) {
+            break;
+        }
+        // Invalid frames are dropped; their slot is released either way
+        if (e1000_tx_publish(ctx, lengths[i], &slots[i].offload, NULL, 0) == 0) {
+            sent++;
+        }
+    }
+
+    // Single tail update triggers transmission of the whole batch
+    if (sent > 0) {
+        e1000_write_tail(ctx, E1000_TDT, ctx->tx_current);
+    }
+
+    return sent;
+}
+
+int e1000_tx_commit_sg(e1000_t *ctx, const net_tx_slot_t *slot, size_t length,
+                       const net_tx_frag_t frags[], int frag_count) {
+    if (!ctx || !slot || ctx->tx_reserved == 0 || !ctx->initialized) {
+        return -1;
+    }
+
+    if (slot->slot != ctx->tx_buffer_head) {
+        return -1;
+    }
+
+    int result = e1000_tx_publish(ctx, length, &slot->offload, frags, frag_count);
+    if (result != 0) {
+        return result;
+    }
+
+    e1000_write_tail(ctx, E1000_TDT, ctx->tx_current);
 
     return 0;
 }
+
+// netdev_ops_t entry points
+
+static e1000_t e1000_netdev_contexts[NETDEV_MAX_CONTEXTS];
+
+int e1000_netdev_get_mac(void *ctx, uint8_t mac[6]) {
+    return e1000_get_mac(ctx, mac);
+}
+
+uint32_t e1000_netdev_get_caps(void *ctx) {
+    return e1000_get_caps(ctx);
+}
+
+int e1000_netdev_get_queue_count(void *ctx) {
+    (void)ctx;
+    return 1;
+}
+
+int e1000_netdev_get_stats(void *ctx, net_stats_t *stats) {
+    return e1000_get_stats(ctx, stats);
+}
+
+int e1000_netdev_wait(void *ctx, uint16_t queue) {
+    (void)queue;
+    return e1000_wait(ctx);
+}
+
+int e1000_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length) {
+    (void)queue;
+    return e1000_transmit(ctx, packet, length);
+}
+
+int e1000_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    (void)queue;
+    return e1000_receive(ctx, buffer, buffer_size, received_length);
+}
+
+int e1000_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                               size_t lengths[], int max_packets) {
+    (void)queue;
+    return e1000_receive_burst(ctx, buffers, buffer_size, lengths, max_packets);
+}
+
+int e1000_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                                int count) {
+    (void)queue;
+    return e1000_transmit_burst(ctx, packets, lengths, count);
+}
+
+int e1000_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames) {
+    (void)queue;
+    return e1000_rx_acquire(ctx, frames, max_frames);
+}
+
+int e1000_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count) {
+    (void)queue;
+    return e1000_rx_release(ctx, frames, count);
+}
+
+int e1000_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot) {
+    (void)queue;
+    return e1000_tx_alloc(ctx, slot);
+}
+
+int e1000_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count) {
+    (void)queue;
+    return e1000_tx_commit(ctx, slots, lengths, count);
+}
+
+int e1000_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                              const net_tx_frag_t frags[], int frag_count) {
+    (void)queue;
+    return e1000_tx_commit_sg(ctx, slot, length, frags, frag_count);
+}
+
+const netdev_ops_t e1000_netdev_ops = {
+    .contexts = e1000_netdev_contexts,
+    .context_size = sizeof(e1000_t),
+    .get_mac = e1000_netdev_get_mac,
+    .get_caps = e1000_netdev_get_caps,
+    .get_queue_count = e1000_netdev_get_queue_count,
+    .get_stats = e1000_netdev_get_stats,
+    .wait = e1000_netdev_wait,
+    .transmit = e1000_netdev_transmit,
+    .receive = e1000_netdev_receive,
+    .receive_burst = e1000_netdev_receive_burst,
+    .transmit_burst = e1000_netdev_transmit_burst,
+    .rx_acquire = e1000_netdev_rx_acquire,
+    .rx_release = e1000_netdev_rx_release,
+    .tx_alloc = e1000_netdev_tx_alloc,
+    .tx_commit = e1000_netdev_tx_commit,
+    .tx_commit_sg = e1000_netdev_tx_commit_sg
+};
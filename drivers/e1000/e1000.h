@@ -3,6 +3,7 @@
 #include "../../common/types.h"
 #include "../../common/drivers.h"
 #include "../../kernel/devices/devices.h"
+#include "e1000_desc.h"
 
 // Intel 82540EM Vendor and Device IDs
 #define PCI_VENDOR_ID_INTEL     0x8086
@@ -14,7 +15,9 @@
 #define E1000_EECD      0x00010  // EEPROM/Flash Control
 #define E1000_EERD      0x00014  // EEPROM Read
 #define E1000_ICR       0x000C0  // Interrupt Cause Read
+#define E1000_ITR       0x000C4  // Interrupt Throttling
 #define E1000_IMS       0x000D0  // Interrupt Mask Set
+#define E1000_IMC       0x000D8  // Interrupt Mask Clear
 #define E1000_RCTL      0x00100  // Receive Control
 #define E1000_TCTL      0x00400  // Transmit Control
 #define E1000_RDBAL     0x02800  // RX Descriptor Base Low
@@ -27,6 +30,10 @@
 #define E1000_TDLEN     0x03808  // TX Descriptor Length
 #define E1000_TDH       0x03810  // TX Descriptor Head
 #define E1000_TDT       0x03818  // TX Descriptor Tail
+#define E1000_MPC       0x04010  // Missed Packets Count (clear on read)
+#define E1000_GPRC      0x04074  // Good Packets Received Count (clear on read)
+#define E1000_GPTC      0x04080  // Good Packets Transmitted Count (clear on read)
+#define E1000_RXCSUM    0x05000  // Receive Checksum Control
 #define E1000_RAL       0x05400  // Receive Address Low
 #define E1000_RAH       0x05404  // Receive Address High
 
@@ -38,6 +45,16 @@
 // Status Register Bits
 #define E1000_STATUS_LU     (1 << 1)   // Link Up
 
+// Interrupt Cause Bits (ICR, IMS, IMC)
+#define E1000_ICR_TXDW      (1 << 0)   // TX Descriptor Written Back
+#define E1000_ICR_RXT0      (1 << 7)   // RX Timer (frame received)
+
+// Interrupt throttling: ITR counts in 256 ns units, 16 bits wide
+#define E1000_ITR_UNITS_PER_SEC 3906250
+#define E1000_ITR_MAX       0xFFFF
+// Default ceiling on interrupts per second (e1000.irq_rate)
+#define E1000_IRQ_RATE_DEFAULT 8000
+
 // Receive Control Register Bits
 #define E1000_RCTL_EN       (1 << 1)   // Receive Enable
 #define E1000_RCTL_UPE      (1 << 3)   // Unicast Promiscuous Enable
@@ -45,6 +62,9 @@
 #define E1000_RCTL_BAM      (1 << 15)  // Broadcast Accept Mode
 #define E1000_RCTL_BSIZE_2K (0 << 16)  // Buffer Size 2048 bytes
 
+// Receive Checksum Control Register Bits
+#define E1000_RXCSUM_TUOFL  (1 << 9)   // TCP/UDP Checksum Offload Enable
+
 // Transmit Control Register Bits
 #define E1000_TCTL_EN       (1 << 1)   // Transmit Enable
 #define E1000_TCTL_PSP      (1 << 3)   // Pad Short Packets
@@ -52,44 +72,58 @@
 // RX Descriptor Status Bits
 #define E1000_RXD_STAT_DD   (1 << 0)   // Descriptor Done
 #define E1000_RXD_STAT_EOP  (1 << 1)   // End of Packet
+#define E1000_RXD_STAT_IXSM (1 << 2)   // Ignore Checksum Indication
+#define E1000_RXD_STAT_TCPCS (1 << 5)  // TCP/UDP Checksum Calculated
+
+// RX Descriptor Error Bits
+#define E1000_RXD_ERR_TCPE  (1 << 5)   // TCP/UDP Checksum Error
 
-// TX Descriptor Command Bits
+// TX Descriptor Command Bits (legacy cmd, data descriptor DCMD and context TUCMD)
 #define E1000_TXD_CMD_EOP   (1 << 0)   // End of Packet
+#define E1000_TXD_CMD_IFCS  (1 << 1)   // Insert FCS
+#define E1000_TXD_CMD_TSE   (1 << 2)   // TCP Segmentation Enable (extended descriptors)
 #define E1000_TXD_CMD_RS    (1 << 3)   // Report Status
+#define E1000_TXD_CMD_DEXT  (1 << 5)   // Extended descriptor (context or data)
+
+// TX Context Descriptor TUCMD Bits
+#define E1000_TXD_TUCMD_TCP (1 << 0)   // Segments are TCP
+#define E1000_TXD_TUCMD_IP  (1 << 1)   // Segments are IPv4
+
+// TX Data Descriptor Type (in the length_dtyp byte) and Packet Options
+#define E1000_TXD_DTYP_D    (1 << 4)   // Data descriptor
+#define E1000_TXD_POPTS_IXSM (1 << 0)  // Insert IPv4 header checksum
+#define E1000_TXD_POPTS_TXSM (1 << 1)  // Insert TCP/UDP checksum
 
 // TX Descriptor Status Bits
 #define E1000_TXD_STAT_DD   (1 << 0)   // Descriptor Done
 
-// Number of RX/TX descriptors
-#define E1000_NUM_RX_DESC   8
-#define E1000_NUM_TX_DESC   8
+// RX/TX ring size: E1000_MAX_DESC descriptors per ring unless lowered with
+// e1000.ring_size; always a multiple of E1000_TX_RS_INTERVAL
+#define E1000_MAX_DESC      256
+#define E1000_MIN_DESC      32
+// Only every E1000_TX_RS_INTERVAL-th TX descriptor asks for a status write-back
+#define E1000_TX_RS_INTERVAL 16
+// Consumed RX descriptors handed back with one RDT write while frames keep arriving
+#define E1000_RX_TAIL_BATCH 32
+// Descriptors held for each reserved TX slot: a context and a data descriptor
+#define E1000_TX_SLOT_DESCS 2
+// Largest buffer a single TX data descriptor carries; longer fragments are split
+#define E1000_TX_MAX_DATA_PER_DESC 4096
+// Marks a TX descriptor that does not own a driver TX buffer
+#define E1000_TX_NO_BUFFER  0xFFFF
 #define E1000_RX_BUFFER_SIZE 2048
 #define E1000_TX_BUFFER_SIZE 2048
+// Frames start 2 bytes into each TX buffer so the IP header is 4-byte aligned
+#define E1000_TX_HEADROOM   2
 
 /**
- * E1000 RX Descriptor
- */
-typedef struct {
-    uint64_t buffer_addr;
-    uint16_t length;
-    uint16_t checksum;
-    uint8_t  status;
-    uint8_t  errors;
-    uint16_t special;
-} __attribute__((packed)) e1000_rx_desc_t;
-
-/**
- * E1000 TX Descriptor
+ * How the device wakes a CPU halted in e1000_wait()
  */
-typedef struct {
-    uint64_t buffer_addr;
-    uint16_t length;
-    uint8_t  cso;
-    uint8_t  cmd;
-    uint8_t  status;
-    uint8_t  css;
-    uint16_t special;
-} __attribute__((packed)) e1000_tx_desc_t;
+typedef enum {
+    E1000_IRQ_NONE = 0,         // No usable interrupt, callers keep polling
+    E1000_IRQ_MSI = 1,          // PCI MSI (AMD64, when the device has the capability)
+    E1000_IRQ_WIRED = 2         // INTx through the I/O APIC, GIC or PLIC
+} e1000_irq_t;
 
 /**
  * E1000 device context
@@ -98,12 +132,26 @@ typedef struct {
     uint64_t mmio_base;
     bool initialized;
     uint8_t mac_addr[6];
-    e1000_rx_desc_t rx_descs[E1000_NUM_RX_DESC] __attribute__((aligned(16)));
-    uint8_t rx_buffers[E1000_NUM_RX_DESC][E1000_RX_BUFFER_SIZE] __attribute__((aligned(16)));
+    uint16_t ring_size;     // Descriptors in use per ring (RX and TX)
+    e1000_irq_t irq_mode;   // Wakeup interrupt used by e1000_wait()
+    net_stats_t stats;      // Totals of the clear-on-read statistics registers
+    e1000_rx_desc_t rx_descs[E1000_MAX_DESC] __attribute__((aligned(16)));
+    uint8_t rx_buffers[E1000_MAX_DESC][E1000_RX_BUFFER_SIZE] __attribute__((aligned(16)));
     uint16_t rx_current;
-    e1000_tx_desc_t tx_descs[E1000_NUM_TX_DESC] __attribute__((aligned(16)));
-    uint8_t tx_buffers[E1000_NUM_TX_DESC][E1000_TX_BUFFER_SIZE] __attribute__((aligned(16)));
-    uint16_t tx_current;
+    uint16_t rx_lent;       // RX descriptors lent out by e1000_rx_acquire()
+    uint16_t rx_unreturned; // RX descriptors consumed by e1000_receive() but not yet given back
+    e1000_tx_ring_desc_t tx_descs[E1000_MAX_DESC] __attribute__((aligned(16)));
+    uint8_t tx_buffers[E1000_MAX_DESC][E1000_TX_BUFFER_SIZE] __attribute__((aligned(16)));
+    uint16_t tx_current;    // Next TX descriptor to fill
+    uint16_t tx_clean;      // Oldest TX descriptor not yet reclaimed (start of an RS group)
+    uint16_t tx_inflight;   // TX descriptors handed to the NIC and not yet reclaimed
+    uint16_t tx_desc_buffer[E1000_MAX_DESC];    // TX buffer freed with each descriptor
+    uint16_t tx_buffer_head; // Oldest reserved TX buffer (next to be committed)
+    uint16_t tx_reserved;   // TX buffers handed out by e1000_tx_alloc(), not yet committed
+    bool tx_buffer_busy[E1000_MAX_DESC];        // TX buffer reserved or queued
+    bool tx_csum_context;   // The NIC holds a checksum context for tx_csum_start/offset
+    uint16_t tx_csum_start;
+    uint16_t tx_csum_offset;
 } __attribute__((aligned(16))) e1000_t;
 
 /**
@@ -120,8 +168,25 @@ const driver_t* e1000_get_driver(void);
  */
 int e1000_get_mac(e1000_t *ctx, uint8_t mac[6]);
 
+/**
+ * Get offload capabilities of e1000 device
+ * @param ctx Device context from driver initialization
+ * @return NET_CAP_* flags
+ */
+uint32_t e1000_get_caps(e1000_t *ctx);
+
+/**
+ * Get packet counters of e1000 device
+ * @param ctx Device context from driver initialization
+ * @param stats Receives the totals since initialization
+ * @return 0 on success, -1 on error
+ */
+int e1000_get_stats(e1000_t *ctx, net_stats_t *stats);
+
 /**
  * Receive a packet from e1000 device
+ * Consumed descriptors are handed back once the ring is drained or
+ * E1000_RX_TAIL_BATCH of them have built up, not after every packet.
  * @param ctx Device context from driver initialization
  * @param buffer Buffer to store received packet
  * @param buffer_size Size of the buffer
@@ -138,3 +203,122 @@ int e1000_receive(e1000_t *ctx, uint8_t *buffer, size_t buffer_size, size_t *rec
  * @return 0 on success, -1 on error
  */
 int e1000_transmit(e1000_t *ctx, const uint8_t *buffer, size_t length);
+
+/**
+ * Receive up to max_packets packets from e1000 device
+ * Drains completed RX descriptors and updates the RX tail pointer once.
+ * @param ctx Device context from driver initialization
+ * @param buffers Array of max_packets receive buffers
+ * @param buffer_size Size of each receive buffer
+ * @param lengths Array receiving the length of each packet
+ * @param max_packets Maximum number of packets to receive
+ * @return Number of packets received (0 if none available), -1 on error
+ */
+int e1000_receive_burst(e1000_t *ctx, uint8_t *const buffers[], size_t buffer_size,
+                        size_t lengths[], int max_packets);
+
+/**
+ * Transmit up to count packets to e1000 device
+ * Fills consecutive TX descriptors and updates the TX tail pointer once.
+ * @param ctx Device context from driver initialization
+ * @param packets Array of packet pointers
+ * @param lengths Array of packet lengths in bytes
+ * @param count Number of packets
+ * @return Number of packets queued (may be less than count if the ring is full), -1 on error
+ */
+int e1000_transmit_burst(e1000_t *ctx, const uint8_t *const packets[], const size_t lengths[], int count);
+
+/**
+ * Borrow received frames from e1000 device without copying
+ * Frames point into the driver RX buffers and must be returned with
+ * e1000_rx_release() in the order they were acquired.
+ * @param ctx Device context from driver initialization
+ * @param frames Array receiving up to max_frames frame descriptors
+ * @param max_frames Maximum number of frames to acquire
+ * @return Number of frames acquired (0 if none available), -1 on error
+ */
+int e1000_rx_acquire(e1000_t *ctx, net_rx_frame_t frames[], int max_frames);
+
+/**
+ * Return borrowed frames to e1000 device
+ * Hands the descriptors back to the NIC with a single RX tail update.
+ * @param ctx Device context from driver initialization
+ * @param frames Frames previously returned by e1000_rx_acquire()
+ * @param count Number of frames
+ * @return 0 on success, -1 on error
+ */
+int e1000_rx_release(e1000_t *ctx, const net_rx_frame_t frames[], int count);
+
+/**
+ * Halt the CPU until e1000 device receives frames
+ * Unmasks the RX (RXT0) and TX write-back (TXDW) causes, re-checks the RX ring
+ * and halts until the device interrupts, then masks the causes again so polling
+ * stays cheap. Interrupts are throttled by ITR (e1000.irq_rate).
+ * @param ctx Device context from driver initialization
+ * @return 0 once frames may be available, -1 if the device cannot interrupt
+ *         (the caller keeps polling)
+ */
+int e1000_wait(e1000_t *ctx);
+
+/**
+ * Reserve a TX buffer so a frame can be built in place (zero-copy transmit)
+ * @param ctx Device context from driver initialization
+ * @param slot Filled with the writable frame area
+ * @return 0 on success, -1 if no TX descriptor is free
+ */
+int e1000_tx_alloc(e1000_t *ctx, net_tx_slot_t *slot);
+
+/**
+ * Transmit frames built in slots from e1000_tx_alloc()
+ * Slots must be committed in the order they were allocated. Checksum and
+ * segmentation requests in slot offload are passed to the NIC in a context
+ * descriptor. Updates the TX tail pointer once.
+ * @param ctx Device context from driver initialization
+ * @param slots Slots returned by e1000_tx_alloc()
+ * @param lengths Frame length written into each slot
+ * @param count Number of slots
+ * @return Number of frames queued (invalid frames are dropped, stops at the first out-of-order slot), -1 on error
+ */
+int e1000_tx_commit(e1000_t *ctx, const net_tx_slot_t slots[], const size_t lengths[], int count);
+
+/**
+ * Transmit one frame built from a slot followed by caller-owned fragments
+ * The slot holds the first length bytes (at least the headers); each fragment
+ * is read in place through its own data descriptors. With
+ * slot->offload.gso_size set the frame may be up to NET_TSO_MAX_FRAME_SIZE
+ * bytes and is segmented by the NIC. Updates the TX tail pointer once. The
+ * slot is consumed even on failure.
+ * @param ctx Device context from driver initialization
+ * @param slot Oldest slot returned by e1000_tx_alloc() and not yet committed
+ * @param length Number of bytes written into the slot
+ * @param frags Fragments appended after the slot data
+ * @param frag_count Number of fragments
+ * @return 0 on success, NET_TX_AGAIN if the ring has no room for the fragments,
+ *         -1 on error (invalid frame or offload request)
+ */
+int e1000_tx_commit_sg(e1000_t *ctx, const net_tx_slot_t *slot, size_t length,
+                       const net_tx_frag_t frags[], int frag_count);
+
+/**
+ * netdev_ops_t entry points, registered as e1000_get_driver()->netdev_ops
+ * They wrap the functions above with a void * context and a queue
+ * index, which e1000 ignores.
+ */
+extern const netdev_ops_t e1000_netdev_ops;
+int e1000_netdev_get_mac(void *ctx, uint8_t mac[6]);
+uint32_t e1000_netdev_get_caps(void *ctx);
+int e1000_netdev_get_queue_count(void *ctx);
+int e1000_netdev_get_stats(void *ctx, net_stats_t *stats);
+int e1000_netdev_wait(void *ctx, uint16_t queue);
+int e1000_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length);
+int e1000_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+int e1000_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                               size_t lengths[], int max_packets);
+int e1000_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                                int count);
+int e1000_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+int e1000_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+int e1000_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot);
+int e1000_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count);
+int e1000_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                              const net_tx_frag_t frags[], int frag_count);
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../../common/types.h"
+
+// Descriptor layouts shared with the NIC. Every field sits at a multiple of
+// its own size, so the structs need no packing: the compiler knows each field
+// is naturally aligned and never has to emit an unaligned access (which faults
+// on arm64 while the MMU is off). status is the only field the NIC writes back
+// that is polled, so it is read through volatile; the other written-back fields
+// are read after a barrier once DD is set.
+
+/**
+ * E1000 RX Descriptor
+ */
+typedef struct {
+    uint64_t buffer_addr;
+    uint16_t length;
+    uint16_t checksum;
+    volatile uint8_t status;
+    uint8_t  errors;
+    uint16_t special;
+} e1000_rx_desc_t;
+
+/**
+ * E1000 TX Descriptor (legacy format)
+ */
+typedef struct {
+    uint64_t buffer_addr;
+    uint16_t length;
+    uint8_t  cso;
+    uint8_t  cmd;
+    volatile uint8_t status;
+    uint8_t  css;
+    uint16_t special;
+} e1000_tx_desc_t;
+
+/**
+ * E1000 TX Context Descriptor (offload parameters for the data descriptors that follow)
+ */
+typedef struct {
+    uint8_t  ipcss;         // IPv4 header start
+    uint8_t  ipcso;         // IPv4 header checksum location
+    uint16_t ipcse;         // IPv4 header end (inclusive)
+    uint8_t  tucss;         // TCP/UDP checksum start
+    uint8_t  tucso;         // TCP/UDP checksum location
+    uint16_t tucse;         // TCP/UDP checksum end (0: end of frame)
+    uint16_t paylen;        // TSO payload length bits 15:0
+    uint8_t  paylen_dtyp;   // TSO payload length bits 19:16 (descriptor type 0: context)
+    uint8_t  tucmd;
+    volatile uint8_t status;
+    uint8_t  hdr_len;       // TSO: header bytes repeated in every segment
+    uint16_t mss;           // TSO: payload bytes per segment
+} e1000_tx_context_desc_t;
+
+/**
+ * E1000 TX Data Descriptor (extended format, uses the loaded context)
+ */
+typedef struct {
+    uint64_t buffer_addr;
+    uint16_t length;        // Buffer length bits 15:0
+    uint8_t  length_dtyp;   // Buffer length bits 19:16, E1000_TXD_DTYP_D
+    uint8_t  dcmd;
+    volatile uint8_t status;
+    uint8_t  popts;
+    uint16_t special;
+} e1000_tx_data_desc_t;
+
+/**
+ * One TX ring entry, holding any of the three TX descriptor formats
+ * Entries are accessed through the member of the format being written, so
+ * the formats never alias through unrelated pointer types.
+ */
+typedef union {
+    e1000_tx_desc_t legacy;
+    e1000_tx_context_desc_t context;
+    e1000_tx_data_desc_t data;
+} e1000_tx_ring_desc_t;
+
+static_assert(sizeof(e1000_rx_desc_t) == 16, "RX descriptor must be 16 bytes");
+static_assert(sizeof(e1000_tx_desc_t) == 16, "TX descriptor must be 16 bytes");
+static_assert(sizeof(e1000_tx_context_desc_t) == 16, "TX context descriptor must be 16 bytes");
+static_assert(sizeof(e1000_tx_data_desc_t) == 16, "TX data descriptor must be 16 bytes");
+static_assert(sizeof(e1000_tx_ring_desc_t) == 16, "TX ring entry must be 16 bytes");
+static_assert(__builtin_offsetof(e1000_rx_desc_t, status) == 12, "RX status at byte 12");
+static_assert(__builtin_offsetof(e1000_tx_desc_t, status) == 12, "TX status at byte 12");
+static_assert(__builtin_offsetof(e1000_tx_context_desc_t, status) == 12, "TX context status at byte 12");
+static_assert(__builtin_offsetof(e1000_tx_data_desc_t, status) == 12, "TX data status at byte 12");
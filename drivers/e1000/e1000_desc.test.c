@@ -0,0 +1,133 @@
+/*
+ * E1000 Descriptor Layout Test Suite (Freestanding)
+ */
+
+#include "../../tests/test-kernel/test_kernel_common.h"
+#include "e1000_desc.h"
+
+// A field is naturally aligned when its offset is a multiple of its size
+#define FIELD_IS_NATURAL(type, field) \
+    (__builtin_offsetof(type, field) % sizeof(((type *)0)->field) == 0)
+
+void test_alignment(void) {
+    test_start("type alignment");
+    // A packed struct has alignment 1, which makes every wider field access
+    // potentially unaligned; naturally aligned structs keep their widest field's
+    test_assert_eq_uint32(_Alignof(e1000_rx_desc_t), 8, "RX descriptor");
+    test_assert_eq_uint32(_Alignof(e1000_tx_desc_t), 8, "TX descriptor");
+    test_assert_eq_uint32(_Alignof(e1000_tx_context_desc_t), 2, "TX context descriptor");
+    test_assert_eq_uint32(_Alignof(e1000_tx_data_desc_t), 8, "TX data descriptor");
+    test_assert_eq_uint32(_Alignof(e1000_tx_ring_desc_t), 8, "TX ring entry");
+}
+
+void test_field_alignment(void) {
+    test_start("field alignment");
+    test_assert_true(FIELD_IS_NATURAL(e1000_rx_desc_t, buffer_addr), "rx.buffer_addr");
+    test_assert_true(FIELD_IS_NATURAL(e1000_rx_desc_t, length), "rx.length");
+    test_assert_true(FIELD_IS_NATURAL(e1000_rx_desc_t, checksum), "rx.checksum");
+    test_assert_true(FIELD_IS_NATURAL(e1000_rx_desc_t, special), "rx.special");
+    test_assert_true(FIELD_IS_NATURAL(e1000_tx_desc_t, buffer_addr), "tx.buffer_addr");
+    test_assert_true(FIELD_IS_NATURAL(e1000_tx_desc_t, length), "tx.length");
+    test_assert_true(FIELD_IS_NATURAL(e1000_tx_desc_t, special), "tx.special");
+    test_assert_true(FIELD_IS_NATURAL(e1000_tx_context_desc_t, ipcse), "context.ipcse");
+    test_assert_true(FIELD_IS_NATURAL(e1000_tx_context_desc_t, tucse), "context.tucse");
+    test_assert_true(FIELD_IS_NATURAL(e1000_tx_context_desc_t, paylen), "context.paylen");
+    test_assert_true(FIELD_IS_NATURAL(e1000_tx_context_desc_t, mss), "context.mss");
+    test_assert_true(FIELD_IS_NATURAL(e1000_tx_data_desc_t, buffer_addr), "data.buffer_addr");
+    test_assert_true(FIELD_IS_NATURAL(e1000_tx_data_desc_t, length), "data.length");
+    test_assert_true(FIELD_IS_NATURAL(e1000_tx_data_desc_t, special), "data.special");
+}
+
+void test_rx_layout(void) {
+    test_start("RX write-back layout");
+    // Descriptor as the NIC writes it back (little-endian)
+    static const uint8_t image[16] = {
+        0x00, 0x10, 0x20, 0x30, 0x00, 0x00, 0x00, 0x00,    // buffer address
+        0xEA, 0x05,                                         // length 1514
+        0x34, 0x12,                                         // checksum
+        0x23,                                               // status DD|EOP|TCPCS
+        0x20,                                               // errors TCPE
+        0x00, 0x00                                          // special
+    };
+    e1000_rx_desc_t desc;
+    uint8_t *bytes = (uint8_t *)&desc;
+    for (int i = 0; i < 16; i++) {
+        bytes[i] = image[i];
+    }
+
+    test_assert_true(desc.buffer_addr == 0x30201000, "buffer_addr");
+    test_assert_eq_uint16(desc.length, 1514, "length");
+    test_assert_eq_uint16(desc.checksum, 0x1234, "checksum");
+    test_assert_eq_uint32(desc.status, 0x23, "status");
+    test_assert_eq_uint32(desc.errors, 0x20, "errors");
+}
+
+void test_tx_context_layout(void) {
+    test_start("TX context layout");
+    static const uint8_t expected[16] = {
+        14, 24, 33, 0,                                      // ipcss, ipcso, ipcse
+        34, 50, 0, 0,                                       // tucss, tucso, tucse
+        0x30, 0x75, 0x01,                                   // paylen 0x17530
+        0x27,                                               // tucmd TCP|IP|TSE|DEXT
+        0x00,                                               // status
+        54,                                                 // hdr_len
+        0xB4, 0x05                                          // mss 1460
+    };
+    e1000_tx_ring_desc_t entry = {0};
+    e1000_tx_context_desc_t *context = &entry.context;
+    context->ipcss = 14;
+    context->ipcso = 24;
+    context->ipcse = 33;
+    context->tucss = 34;
+    context->tucso = 50;
+    context->tucse = 0;
+    context->paylen = 0x7530;
+    context->paylen_dtyp = 0x01;
+    context->tucmd = 0x27;
+    context->status = 0;
+    context->hdr_len = 54;
+    context->mss = 1460;
+
+    test_assert_mem_eq(&entry, expected, sizeof(expected), "context bytes");
+}
+
+void test_tx_data_layout(void) {
+    test_start("TX data layout");
+    static const uint8_t expected[16] = {
+        0x00, 0x20, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00,    // buffer address
+        0x00, 0x10,                                         // length 4096
+        0x10,                                               // DTYP_D
+        0x29,                                               // dcmd EOP|RS|DEXT
+        0x00,                                               // status
+        0x02,                                               // popts TXSM
+        0x00, 0x00                                          // special
+    };
+    e1000_tx_ring_desc_t entry = {0};
+    e1000_tx_data_desc_t *data = &entry.data;
+    data->buffer_addr = 0x40002000;
+    data->length = 4096;
+    data->length_dtyp = 0x10;
+    data->dcmd = 0x29;
+    data->status = 0;
+    data->popts = 0x02;
+    data->special = 0;
+
+    test_assert_mem_eq(&entry, expected, sizeof(expected), "data bytes");
+
+    // The NIC reports completion in the same byte for every format
+    entry.data.status = 0x01;
+    test_assert_eq_uint32(entry.legacy.status, 0x01, "status shared with legacy format");
+}
+
+// Entry point for tests
+void test_kernel_main(void) {
+    test_suite_start("E1000 Descriptors");
+
+    test_alignment();
+    test_field_alignment();
+    test_rx_layout();
+    test_tx_context_layout();
+    test_tx_data_layout();
+
+    test_suite_end();
+}
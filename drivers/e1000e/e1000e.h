@@ -0,0 +1,371 @@
+#pragma once
+
+#include "../../common/types.h"
+#include "../../common/drivers.h"
+#include "../../kernel/devices/devices.h"
+#include "../e1000/e1000_desc.h"
+
+// Intel 82574L Vendor and Device IDs
+#define PCI_VENDOR_ID_INTEL     0x8086
+#define E1000E_DEVICE_ID_82574L 0x10D3
+
+// E1000E MMIO Register Offsets
+#define E1000E_CTRL         0x00000  // Device Control
+#define E1000E_STATUS       0x00008  // Device Status
+#define E1000E_CTRL_EXT     0x00018  // Extended Device Control
+#define E1000E_ICR          0x000C0  // Interrupt Cause Read (write 1 to clear)
+#define E1000E_ITR          0x000C4  // Interrupt Throttling (MSI and INTx)
+#define E1000E_IMS          0x000D0  // Interrupt Mask Set
+#define E1000E_IMC          0x000D8  // Interrupt Mask Clear
+#define E1000E_IVAR         0x000E4  // Interrupt Vector Allocation (MSI-X)
+#define E1000E_EITR(n)      (0x000E8 + 4 * (n))  // Per-vector Interrupt Throttling (MSI-X)
+#define E1000E_RCTL         0x00100  // Receive Control
+#define E1000E_TCTL         0x00400  // Transmit Control
+#define E1000E_RDBAL(q)     (0x02800 + 0x100 * (q))  // RX Descriptor Base Low
+#define E1000E_RDBAH(q)     (0x02804 + 0x100 * (q))  // RX Descriptor Base High
+#define E1000E_RDLEN(q)     (0x02808 + 0x100 * (q))  // RX Descriptor Length
+#define E1000E_RDH(q)       (0x02810 + 0x100 * (q))  // RX Descriptor Head
+#define E1000E_RDT(q)       (0x02818 + 0x100 * (q))  // RX Descriptor Tail
+#define E1000E_TDBAL(q)     (0x03800 + 0x100 * (q))  // TX Descriptor Base Low
+#define E1000E_TDBAH(q)     (0x03804 + 0x100 * (q))  // TX Descriptor Base High
+#define E1000E_TDLEN(q)     (0x03808 + 0x100 * (q))  // TX Descriptor Length
+#define E1000E_TDH(q)       (0x03810 + 0x100 * (q))  // TX Descriptor Head
+#define E1000E_TDT(q)       (0x03818 + 0x100 * (q))  // TX Descriptor Tail
+#define E1000E_MPC          0x04010  // Missed Packets Count (clear on read)
+#define E1000E_GPRC         0x04074  // Good Packets Received Count (clear on read)
+#define E1000E_GPTC         0x04080  // Good Packets Transmitted Count (clear on read)
+#define E1000E_RXCSUM       0x05000  // Receive Checksum Control
+#define E1000E_RFCTL        0x05008  // Receive Filter Control
+#define E1000E_RAL          0x05400  // Receive Address Low
+#define E1000E_RAH          0x05404  // Receive Address High
+#define E1000E_MRQC         0x05818  // Multiple Receive Queues Command
+#define E1000E_RETA         0x05C00  // RSS Redirection Table (128 one-byte entries)
+#define E1000E_RSSRK        0x05C80  // RSS Random Key (40 bytes)
+
+// Control Register Bits
+#define E1000E_CTRL_SLU     (1 << 6)   // Set Link Up
+#define E1000E_CTRL_RST     (1 << 26)  // Device Reset
+
+// Extended Control Register Bits
+#define E1000E_CTRL_EXT_PBA_CLR (1u << 31)  // Clear the MSI-X pending bit when its cause is cleared
+
+// Interrupt Cause Bits (ICR, IMS, IMC)
+// Without MSI-X every queue reports TXDW/RXT0; with MSI-X each queue has its own cause
+#define E1000E_ICR_TXDW     (1 << 0)   // TX Descriptor Written Back
+#define E1000E_ICR_RXT0     (1 << 7)   // RX Timer (frame received)
+#define E1000E_ICR_RXQ(q)   (1 << (20 + (q)))  // RX queue q (MSI-X)
+#define E1000E_ICR_TXQ(q)   (1 << (22 + (q)))  // TX queue q (MSI-X)
+
+// IVAR: a 4-bit field per cause holding a valid bit and the MSI-X table entry
+#define E1000E_IVAR_VALID   0x8
+#define E1000E_IVAR_RXQ(q, vector)  ((uint32_t)(E1000E_IVAR_VALID | (vector)) << (4 * (q)))
+#define E1000E_IVAR_TXQ(q, vector)  ((uint32_t)(E1000E_IVAR_VALID | (vector)) << (8 + 4 * (q)))
+
+// Interrupt throttling: ITR and EITR count in 256 ns units, 16 bits wide
+#define E1000E_ITR_UNITS_PER_SEC 3906250
+#define E1000E_ITR_MAX      0xFFFF
+// Default ceiling on interrupts per second (e1000e.irq_rate)
+#define E1000E_IRQ_RATE_DEFAULT 8000
+
+// Receive Control Register Bits
+#define E1000E_RCTL_EN      (1 << 1)   // Receive Enable
+#define E1000E_RCTL_UPE     (1 << 3)   // Unicast Promiscuous Enable
+#define E1000E_RCTL_MPE     (1 << 4)   // Multicast Promiscuous Enable
+#define E1000E_RCTL_BAM     (1 << 15)  // Broadcast Accept Mode
+#define E1000E_RCTL_BSIZE_2K (0 << 16) // Buffer Size 2048 bytes
+
+// Receive Checksum Control Register Bits
+#define E1000E_RXCSUM_TUOFL (1 << 9)   // TCP/UDP Checksum Offload Enable
+#define E1000E_RXCSUM_PCSD  (1 << 13)  // Write back the RSS hash instead of the packet checksum
+
+// Receive Filter Control Register Bits
+#define E1000E_RFCTL_EXTEN  (1 << 15)  // Extended RX descriptors
+
+// Multiple Receive Queues Command: RSS and the fields it hashes
+#define E1000E_MRQC_RSS_ENABLE      (1 << 0)
+#define E1000E_MRQC_RSS_TCP_IPV4    (1 << 16)  // Addresses and ports of IPv4/TCP
+#define E1000E_MRQC_RSS_IPV4        (1 << 17)  // Addresses of other IPv4 packets
+// RETA entry bit selecting queue 1
+#define E1000E_RETA_QUEUE1  0x80
+#define E1000E_RETA_ENTRIES 128
+#define E1000E_RSS_KEY_SIZE 40
+
+// Transmit Control Register Bits
+#define E1000E_TCTL_EN      (1 << 1)   // Transmit Enable
+#define E1000E_TCTL_PSP     (1 << 3)   // Pad Short Packets
+
+// Extended RX Descriptor Status and Error Bits (status_error)
+#define E1000E_RXD_STAT_DD   (1 << 0)   // Descriptor Done
+#define E1000E_RXD_STAT_EOP  (1 << 1)   // End of Packet
+#define E1000E_RXD_STAT_IXSM (1 << 2)   // Ignore Checksum Indication
+#define E1000E_RXD_STAT_TCPCS (1 << 5)  // TCP/UDP Checksum Calculated
+#define E1000E_RXD_ERR_TCPE  (1u << 29) // TCP/UDP Checksum Error
+
+// TX Descriptor Command Bits (legacy cmd, data descriptor DCMD and context TUCMD)
+#define E1000E_TXD_CMD_EOP  (1 << 0)   // End of Packet
+#define E1000E_TXD_CMD_IFCS (1 << 1)   // Insert FCS
+#define E1000E_TXD_CMD_RS   (1 << 3)   // Report Status
+#define E1000E_TXD_CMD_DEXT (1 << 5)   // Extended descriptor (context or data)
+#define E1000E_TXD_DTYP_D   (1 << 4)   // Data descriptor
+#define E1000E_TXD_POPTS_TXSM (1 << 1) // Insert TCP/UDP checksum
+#define E1000E_TXD_STAT_DD  (1 << 0)   // Descriptor Done
+
+// RX/TX queue pairs, spread by RSS; each has its own MSI-X vectors
+#define E1000E_MAX_QUEUES   2
+#define E1000E_NUM_QUEUES   (NETDEV_QUEUES < E1000E_MAX_QUEUES ? NETDEV_QUEUES : E1000E_MAX_QUEUES)
+// Descriptors per ring; two pairs hold as many buffers as one e1000 ring
+#define E1000E_RING_SIZE    128
+// Only every E1000E_TX_RS_INTERVAL-th TX descriptor asks for a status write-back
+#define E1000E_TX_RS_INTERVAL 16
+// Consumed RX descriptors handed back with one RDT write while frames keep arriving
+#define E1000E_RX_TAIL_BATCH 32
+// Descriptors held for each reserved TX slot: a context and a data descriptor
+#define E1000E_TX_SLOT_DESCS 2
+// Marks a TX descriptor that does not own a driver TX buffer
+#define E1000E_TX_NO_BUFFER 0xFFFF
+#define E1000E_RX_BUFFER_SIZE 2048
+#define E1000E_TX_BUFFER_SIZE 2048
+// Frames start 2 bytes into each TX buffer so the IP header is 4-byte aligned
+#define E1000E_TX_HEADROOM  2
+
+/**
+ * E1000E extended RX descriptor
+ * The driver hands buffers over in the read format; the NIC overwrites the
+ * whole descriptor in the write-back format, so the buffer address is written
+ * again every time a descriptor is returned.
+ */
+typedef union {
+    struct {
+        uint64_t buffer_addr;
+        uint64_t reserved;      // Cleared with the buffer, so DD reads as 0
+    } read;
+    struct {
+        uint32_t mrq;           // RSS type and queue
+        uint32_t rss_hash;
+        volatile uint32_t status_error;
+        uint16_t length;
+        uint16_t vlan;
+    } wb;
+} e1000e_rx_desc_t;
+
+static_assert(sizeof(e1000e_rx_desc_t) == 16, "Extended RX descriptor must be 16 bytes");
+static_assert(__builtin_offsetof(e1000e_rx_desc_t, wb.status_error) == 8, "RX status at byte 8");
+
+/**
+ * How the device wakes a CPU halted in e1000e_wait()
+ */
+typedef enum {
+    E1000E_IRQ_NONE = 0,        // No usable interrupt, callers keep polling
+    E1000E_IRQ_MSIX = 1,        // PCI MSI-X, one vector per RX and TX queue (AMD64)
+    E1000E_IRQ_MSI = 2,         // PCI MSI shared by all queues (AMD64)
+    E1000E_IRQ_WIRED = 3        // INTx through the I/O APIC, GIC or PLIC
+} e1000e_irq_t;
+
+/**
+ * One RX/TX queue pair
+ */
+typedef struct {
+    e1000e_rx_desc_t rx_descs[E1000E_RING_SIZE] __attribute__((aligned(16)));
+    uint8_t rx_buffers[E1000E_RING_SIZE][E1000E_RX_BUFFER_SIZE] __attribute__((aligned(16)));
+    e1000_tx_ring_desc_t tx_descs[E1000E_RING_SIZE] __attribute__((aligned(16)));
+    uint8_t tx_buffers[E1000E_RING_SIZE][E1000E_TX_BUFFER_SIZE] __attribute__((aligned(16)));
+    uint16_t index;         // Queue number, selects the RDT/TDT registers
+    uint32_t irq_causes;    // ICR bits that end e1000e_wait() on this queue
+    uint16_t rx_current;
+    uint16_t rx_lent;       // RX descriptors lent out by e1000e_rx_acquire()
+    uint16_t rx_unreturned; // RX descriptors consumed by e1000e_receive() but not yet given back
+    uint16_t tx_current;    // Next TX descriptor to fill
+    uint16_t tx_clean;      // Oldest TX descriptor not yet reclaimed (start of an RS group)
+    uint16_t tx_inflight;   // TX descriptors handed to the NIC and not yet reclaimed
+    uint16_t tx_desc_buffer[E1000E_RING_SIZE];  // TX buffer freed with each descriptor
+    uint16_t tx_buffer_head; // Oldest reserved TX buffer (next to be committed)
+    uint16_t tx_reserved;   // TX buffers handed out by e1000e_tx_alloc(), not yet committed
+    bool tx_buffer_busy[E1000E_RING_SIZE];      // TX buffer reserved or queued
+    bool tx_csum_context;   // The queue holds a checksum context for tx_csum_start/offset
+    uint16_t tx_csum_start;
+    uint16_t tx_csum_offset;
+} __attribute__((aligned(16))) e1000e_queue_t;
+
+/**
+ * E1000E device context
+ */
+typedef struct {
+    uint64_t mmio_base;
+    bool initialized;
+    uint8_t mac_addr[6];
+    e1000e_irq_t irq_mode;  // Wakeup interrupt used by e1000e_wait()
+    uint16_t num_queues;    // Queue pairs RSS spreads flows over (e1000e.queues)
+    net_stats_t stats;      // Totals of the clear-on-read statistics registers
+    e1000e_queue_t queues[E1000E_NUM_QUEUES];
+} __attribute__((aligned(16))) e1000e_t;
+
+/**
+ * Get e1000e driver descriptor
+ * @return Pointer to driver descriptor
+ */
+const driver_t* e1000e_get_driver(void);
+
+/**
+ * Get MAC address from e1000e device
+ * @param ctx Device context from driver initialization
+ * @param mac Buffer to store 6-byte MAC address
+ * @return 0 on success, -1 on error
+ */
+int e1000e_get_mac(e1000e_t *ctx, uint8_t mac[6]);
+
+/**
+ * Get offload capabilities of e1000e device
+ * @param ctx Device context from driver initialization
+ * @return NET_CAP_* flags
+ */
+uint32_t e1000e_get_caps(e1000e_t *ctx);
+
+/**
+ * Get number of RX/TX queue pairs of e1000e device
+ * RSS spreads received flows over the pairs; each pair is polled on its own.
+ * One unless more are requested with e1000e.queues.
+ * @param ctx Device context from driver initialization
+ * @return Number of queue pairs
+ */
+int e1000e_get_queue_count(e1000e_t *ctx);
+
+/**
+ * Get packet counters of e1000e device
+ * @param ctx Device context from driver initialization
+ * @param stats Receives the totals since initialization
+ * @return 0 on success, -1 on error
+ */
+int e1000e_get_stats(e1000e_t *ctx, net_stats_t *stats);
+
+/**
+ * Receive a packet from e1000e device
+ * Consumed descriptors are handed back once the ring is drained or
+ * E1000E_RX_TAIL_BATCH of them have built up, not after every packet.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param buffer Buffer to store received packet
+ * @param buffer_size Size of the buffer
+ * @param received_length Pointer to store received packet length
+ * @return 0 on success, -1 on error
+ */
+int e1000e_receive(e1000e_t *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+
+/**
+ * Transmit a packet to e1000e device
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param buffer Buffer containing packet to transmit
+ * @param length Length of packet to transmit
+ * @return 0 on success, -1 on error
+ */
+int e1000e_transmit(e1000e_t *ctx, uint16_t queue, const uint8_t *buffer, size_t length);
+
+/**
+ * Receive up to max_packets packets from e1000e device
+ * Drains completed RX descriptors and updates the RX tail pointer once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param buffers Array of max_packets receive buffers
+ * @param buffer_size Size of each receive buffer
+ * @param lengths Array receiving the length of each packet
+ * @param max_packets Maximum number of packets to receive
+ * @return Number of packets received (0 if none available), -1 on error
+ */
+int e1000e_receive_burst(e1000e_t *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                         size_t lengths[], int max_packets);
+
+/**
+ * Transmit up to count packets to e1000e device
+ * Fills consecutive TX descriptors and updates the TX tail pointer once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param packets Array of packet pointers
+ * @param lengths Array of packet lengths in bytes
+ * @param count Number of packets
+ * @return Number of packets queued (may be less than count if the ring is full), -1 on error
+ */
+int e1000e_transmit_burst(e1000e_t *ctx, uint16_t queue, const uint8_t *const packets[],
+                          const size_t lengths[], int count);
+
+/**
+ * Borrow received frames from e1000e device without copying
+ * Frames point into the driver RX buffers and must be returned with
+ * e1000e_rx_release() in the order they were acquired.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param frames Array receiving up to max_frames frame descriptors
+ * @param max_frames Maximum number of frames to acquire
+ * @return Number of frames acquired (0 if none available), -1 on error
+ */
+int e1000e_rx_acquire(e1000e_t *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+
+/**
+ * Return borrowed frames to e1000e device
+ * Hands the descriptors back to the NIC with a single RX tail update.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param frames Frames previously returned by e1000e_rx_acquire()
+ * @param count Number of frames
+ * @return 0 on success, -1 on error
+ */
+int e1000e_rx_release(e1000e_t *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+
+/**
+ * Halt the CPU until a queue pair of e1000e device receives frames
+ * Unmasks only this pair's RX and TX causes (its own MSI-X vectors), re-checks
+ * the RX ring and halts until the device interrupts, then masks them again.
+ * Interrupts are throttled by ITR/EITR (e1000e.irq_rate).
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @return 0 once frames may be available, -1 if the device cannot interrupt
+ *         (the caller keeps polling)
+ */
+int e1000e_wait(e1000e_t *ctx, uint16_t queue);
+
+/**
+ * Reserve a TX buffer so a frame can be built in place (zero-copy transmit)
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param slot Filled with the writable frame area
+ * @return 0 on success, -1 if no TX descriptor is free
+ */
+int e1000e_tx_alloc(e1000e_t *ctx, uint16_t queue, net_tx_slot_t *slot);
+
+/**
+ * Transmit frames built in slots from e1000e_tx_alloc()
+ * Slots must be committed in the order they were allocated. Checksum requests
+ * in slot offload are passed to the NIC in a context descriptor. Updates the
+ * TX tail pointer once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param slots Slots returned by e1000e_tx_alloc()
+ * @param lengths Frame length written into each slot
+ * @param count Number of slots
+ * @return Number of frames queued (invalid frames are dropped, stops at the first out-of-order slot), -1 on error
+ */
+int e1000e_tx_commit(e1000e_t *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[],
+                     int count);
+
+/**
+ * netdev_ops_t entry points, registered as e1000e_get_driver()->netdev_ops
+ * They wrap the functions above with a void * context and a queue
+ * index.
+ */
+extern const netdev_ops_t e1000e_netdev_ops;
+int e1000e_netdev_get_mac(void *ctx, uint8_t mac[6]);
+uint32_t e1000e_netdev_get_caps(void *ctx);
+int e1000e_netdev_get_queue_count(void *ctx);
+int e1000e_netdev_get_stats(void *ctx, net_stats_t *stats);
+int e1000e_netdev_wait(void *ctx, uint16_t queue);
+int e1000e_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length);
+int e1000e_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+int e1000e_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                                size_t lengths[], int max_packets);
+int e1000e_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                                 int count);
+int e1000e_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+int e1000e_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+int e1000e_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot);
+int e1000e_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count);
+int e1000e_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                               const net_tx_frag_t frags[], int frag_count);
@@ -0,0 +1,961 @@
+#include "igb.h"
+#include "../../common/common.h"
+#include "../../common/log.h"
+#include "../../common/params.h"
+#include "../../kernel/devices/pci.h"
+#include "../../kernel/platform/platform.h"
+#include "../../apps/network/ethernet/ethernet.h"
+#include "../../apps/network/ipv4/ipv4.h"
+
+static log_tag_t *igb_log;
+
+// Kernel command line parameter capping interrupts per second (0: no throttling)
+#define IGB_IRQ_RATE_PARAM      "igb.irq_rate"
+// Kernel command line parameter: queue pairs that receive traffic. Defaults to
+// one, since the network apps only poll queue 0
+#define IGB_QUEUES_PARAM        "igb.queues"
+
+// Interrupt causes that end igb_wait() without MSI-X
+#define IGB_WAKEUP_CAUSES       (IGB_ICR_RXDW | IGB_ICR_TXDW)
+
+// Offset of the header checksum within the IPv4 header
+#define IGB_IPV4_CSUM_OFFSET    10
+
+// Offset of the checksum within the TCP and UDP headers
+#define IGB_TCP_CSUM_OFFSET     16
+#define IGB_UDP_CSUM_OFFSET     6
+
+// Polls of CTRL.RST before giving up on the reset
+#define IGB_RESET_POLLS         100000
+
+// Device ID table for matching
+static const device_id_t igb_id_table[] = {
+    { NULL, PCI_VENDOR_ID_INTEL, IGB_DEVICE_ID_82576, "Intel 82576 Gigabit Ethernet" },
+    { NULL, 0, 0, NULL } // Terminator
+};
+
+// Microsoft's RSS verification key, so hashes can be checked against
+// published test vectors
+static const uint8_t igb_rss_key[IGB_RSS_KEY_SIZE] = {
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+    0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+    0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+    0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+    0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa
+};
+
+// MMIO register access helpers
+static inline uint32_t igb_read32(igb_t *ctx, uint32_t offset) {
+    volatile uint32_t *mmio = (volatile uint32_t *)(uintptr_t)(ctx->mmio_base + offset);
+    return *mmio;
+}
+
+static inline void igb_write32(igb_t *ctx, uint32_t offset, uint32_t value) {
+    volatile uint32_t *mmio = (volatile uint32_t *)(uintptr_t)(ctx->mmio_base + offset);
+    *mmio = value;
+}
+
+// Move a ring tail pointer once the descriptors before it are visible to the NIC
+static inline void igb_write_tail(igb_t *ctx, uint32_t offset, uint32_t value) {
+    __sync_synchronize();
+    igb_write32(ctx, offset, value);
+}
+
+// Hand an RX descriptor (back) to the NIC in the read format; the write-back
+// overwrote the buffer address
+static inline void igb_rx_arm(igb_queue_t *q, uint16_t index) {
+    q->rx_descs[index].read.pkt_addr = (uintptr_t)q->rx_buffers[index];
+    q->rx_descs[index].read.hdr_addr = 0;
+}
+
+static inline bool igb_rx_done(const igb_queue_t *q) {
+    return (q->rx_descs[q->rx_current].wb.status_error & IGB_RXD_STAT_DD) != 0;
+}
+
+// Read the MAC address the NIC loaded from its EEPROM into RAL/RAH
+static void igb_read_mac_address(igb_t *ctx) {
+    uint32_t ral = igb_read32(ctx, IGB_RAL);
+    uint32_t rah = igb_read32(ctx, IGB_RAH);
+
+    ctx->mac_addr[0] = (ral >> 0) & 0xFF;
+    ctx->mac_addr[1] = (ral >> 8) & 0xFF;
+    ctx->mac_addr[2] = (ral >> 16) & 0xFF;
+    ctx->mac_addr[3] = (ral >> 24) & 0xFF;
+    ctx->mac_addr[4] = (rah >> 0) & 0xFF;
+    ctx->mac_addr[5] = (rah >> 8) & 0xFF;
+}
+
+// Set up and enable the rings of one queue pair
+static void igb_queue_init(igb_t *ctx, uint16_t index) {
+    igb_queue_t *q = &ctx->queues[index];
+    q->index = index;
+    q->rx_current = 0;
+    q->rx_lent = 0;
+    q->rx_unreturned = 0;
+    q->tx_current = 0;
+    q->tx_clean = 0;
+    q->tx_inflight = 0;
+    q->tx_since_rs = 0;
+    q->tx_rs_head = 0;
+    q->tx_rs_count = 0;
+    q->tx_buffer_head = 0;
+    q->tx_reserved = 0;
+    q->tx_csum_context = false;
+
+    for (uint16_t i = 0; i < IGB_RING_SIZE; i++) {
+        igb_rx_arm(q, i);
+    }
+    igb_write32(ctx, IGB_RDBAL(index), (uint32_t)(uintptr_t)q->rx_descs);
+    igb_write32(ctx, IGB_RDBAH(index), (uint32_t)((uintptr_t)q->rx_descs >> 32));
+    igb_write32(ctx, IGB_RDLEN(index), IGB_RING_SIZE * sizeof(igb_rx_desc_t));
+    igb_write32(ctx, IGB_SRRCTL(index), (IGB_RX_BUFFER_SIZE >> IGB_SRRCTL_BSIZEPKT_SHIFT) |
+                                        IGB_SRRCTL_DESCTYPE_ADV_ONEBUF | IGB_SRRCTL_DROP_EN);
+    igb_write32(ctx, IGB_RDH(index), 0);
+    igb_write32(ctx, IGB_RDT(index), IGB_RING_SIZE - 1);
+    igb_write32(ctx, IGB_RXDCTL(index), IGB_RXDCTL_ENABLE);
+
+    // Buffers are attached to TX descriptors when frames are queued
+    for (uint16_t i = 0; i < IGB_RING_SIZE; i++) {
+        q->tx_descs[i].read.buffer_addr = 0;
+        q->tx_descs[i].read.cmd_type_len = 0;
+        q->tx_descs[i].read.olinfo_status = 0;
+        q->tx_desc_buffer[i] = IGB_TX_NO_BUFFER;
+        q->tx_buffer_busy[i] = false;
+    }
+    igb_write32(ctx, IGB_TDBAL(index), (uint32_t)(uintptr_t)q->tx_descs);
+    igb_write32(ctx, IGB_TDBAH(index), (uint32_t)((uintptr_t)q->tx_descs >> 32));
+    igb_write32(ctx, IGB_TDLEN(index), IGB_RING_SIZE * sizeof(igb_tx_desc_t));
+    igb_write32(ctx, IGB_TDH(index), 0);
+    igb_write32(ctx, IGB_TDT(index), 0);
+    igb_write32(ctx, IGB_TXDCTL(index), IGB_TXDCTL_ENABLE);
+}
+
+// Spread received flows over the queue pairs: the NIC hashes IPv4 addresses
+// (and TCP/UDP ports) with the Toeplitz key and looks the low 7 bits of the
+// hash up in RETA, whose entries hold the queue number
+static void igb_rss_init(igb_t *ctx) {
+    for (int i = 0; i < IGB_RSS_KEY_SIZE; i += 4) {
+        uint32_t word = (uint32_t)igb_rss_key[i] | (uint32_t)igb_rss_key[i + 1] << 8 |
+                        (uint32_t)igb_rss_key[i + 2] << 16 | (uint32_t)igb_rss_key[i + 3] << 24;
+        igb_write32(ctx, IGB_RSSRK + i, word);
+    }
+
+    // Round-robin over the queues, four one-byte entries per register
+    for (int i = 0; i < IGB_RETA_ENTRIES; i += 4) {
+        uint32_t word = 0;
+        for (int j = 0; j < 4; j++) {
+            word |= (uint32_t)((i + j) % ctx->num_queues) << (8 * j);
+        }
+        igb_write32(ctx, IGB_RETA + i, word);
+    }
+
+    igb_write32(ctx, IGB_MRQC, IGB_MRQC_ENABLE_RSS_MQ | IGB_MRQC_RSS_TCP_IPV4 |
+                               IGB_MRQC_RSS_IPV4 | IGB_MRQC_RSS_UDP_IPV4);
+}
+
+// Give each queue pair its own MSI-X vector; all vectors carry the wakeup
+// message, so the vector split only decides which causes are unmasked
+static int igb_msix_init(igb_t *ctx, device_t *device) {
+    uint64_t msi_address;
+    uint32_t msi_data;
+
+    if (device->compatible != NULL || platform_msi_get_message(&msi_address, &msi_data) != 0) {
+        return -1;
+    }
+    if (pci_msix_enable(device->bus, device->device_num, device->function, IGB_NUM_QUEUES,
+                        msi_address, msi_data, NULL) != 0) {
+        return -1;
+    }
+
+    // IVAR register n covers queues n and n + 8
+    for (uint16_t i = 0; i < IGB_NUM_QUEUES; i++) {
+        uint32_t ivar = igb_read32(ctx, IGB_IVAR(i & 0x7));
+        ivar &= ~((0xFFu << IGB_IVAR_RX_SHIFT(i)) | (0xFFu << IGB_IVAR_TX_SHIFT(i)));
+        ivar |= (uint32_t)(IGB_IVAR_VALID | i) << IGB_IVAR_RX_SHIFT(i);
+        ivar |= (uint32_t)(IGB_IVAR_VALID | i) << IGB_IVAR_TX_SHIFT(i);
+        igb_write32(ctx, IGB_IVAR(i & 0x7), ivar);
+    }
+    igb_write32(ctx, IGB_GPIE, IGB_GPIE_NSICR | IGB_GPIE_MSIX_MODE | IGB_GPIE_PBA);
+    return 0;
+}
+
+// Lifecycle hooks
+static int igb_init_context(void *ctx, device_t *device) {
+    if (!ctx || !device || device->reg_base == 0) {
+        return -1;
+    }
+
+    if (!igb_log) igb_log = log_register("igb", LOG_INFO);
+
+    igb_t *igb_ctx = (igb_t *)ctx;
+    igb_ctx->mmio_base = device->reg_base;
+
+    // Start from a clean device: the reset clears queue and interrupt state
+    // left by firmware and reloads the MAC address
+    igb_write32(igb_ctx, IGB_IMC, 0xFFFFFFFF);
+    igb_write32(igb_ctx, IGB_EIMC, 0xFFFFFFFF);
+    igb_write32(igb_ctx, IGB_CTRL, igb_read32(igb_ctx, IGB_CTRL) | IGB_CTRL_RST);
+    for (int i = 0; i < IGB_RESET_POLLS; i++) {
+        if ((igb_read32(igb_ctx, IGB_CTRL) & IGB_CTRL_RST) == 0) {
+            break;
+        }
+    }
+    igb_write32(igb_ctx, IGB_IMC, 0xFFFFFFFF);
+    igb_write32(igb_ctx, IGB_EIMC, 0xFFFFFFFF);
+    igb_write32(igb_ctx, IGB_EICR, 0xFFFFFFFF);
+    igb_write32(igb_ctx, IGB_GPIE, IGB_GPIE_NSICR);
+    igb_read32(igb_ctx, IGB_ICR);  // Read to clear
+
+    // Set link up
+    igb_write32(igb_ctx, IGB_CTRL, igb_read32(igb_ctx, IGB_CTRL) | IGB_CTRL_SLU);
+
+    igb_read_mac_address(igb_ctx);
+
+    // Interrupts only wake igb_wait(): a vector per queue pair with MSI-X,
+    // otherwise all pairs share RXDW/TXDW on MSI or the INTx line
+    uint64_t msi_address;
+    uint32_t msi_data;
+    igb_ctx->irq_mode = IGB_IRQ_NONE;
+    if (igb_msix_init(igb_ctx, device) == 0) {
+        igb_ctx->irq_mode = IGB_IRQ_MSIX;
+    } else if (device->compatible == NULL && platform_msi_get_message(&msi_address, &msi_data) == 0 &&
+               pci_msi_enable(device->bus, device->device_num, device->function, msi_address, msi_data) == 0) {
+        igb_ctx->irq_mode = IGB_IRQ_MSI;
+    } else if (device->irq != 0 && platform_irq_enable(device->irq) == 0) {
+        igb_ctx->irq_mode = IGB_IRQ_WIRED;
+    }
+
+    // Space interrupts at least 1/irq_rate seconds apart per vector; without
+    // MSI-X, EITR 0 throttles the shared interrupt
+    uint32_t irq_rate = IGB_IRQ_RATE_DEFAULT;
+    params_get_uint(IGB_IRQ_RATE_PARAM, &irq_rate);
+    uint32_t eitr = irq_rate ? IGB_EITR_UNITS_PER_SEC / irq_rate : 0;
+    if (eitr > IGB_EITR_INTERVAL_MASK) {
+        eitr = IGB_EITR_INTERVAL_MASK;
+    }
+    for (int i = 0; i < IGB_NUM_QUEUES; i++) {
+        igb_write32(igb_ctx, IGB_EITR(i), eitr & IGB_EITR_INTERVAL_MASK);
+    }
+
+    for (uint16_t i = 0; i < IGB_NUM_QUEUES; i++) {
+        igb_queue_init(igb_ctx, i);
+    }
+
+    igb_write32(igb_ctx, IGB_TCTL, IGB_TCTL_EN | IGB_TCTL_PSP);
+
+    // PCSD puts the RSS hash where the packet checksum would go; TUOFL still
+    // reports TCP/UDP validation
+    igb_write32(igb_ctx, IGB_RXCSUM, IGB_RXCSUM_TUOFL | IGB_RXCSUM_PCSD);
+    uint32_t num_queues = 1;
+    params_get_uint(IGB_QUEUES_PARAM, &num_queues);
+    if (num_queues < 1) {
+        num_queues = 1;
+    } else if (num_queues > IGB_NUM_QUEUES) {
+        num_queues = IGB_NUM_QUEUES;
+    }
+    igb_ctx->num_queues = (uint16_t)num_queues;
+    if (igb_ctx->num_queues > 1) {
+        igb_rss_init(igb_ctx);
+    }
+
+    uint32_t rctl = IGB_RCTL_EN | IGB_RCTL_UPE | IGB_RCTL_MPE | IGB_RCTL_BAM;
+    igb_write32(igb_ctx, IGB_RCTL, rctl);
+
+    // The reset cleared the statistics registers
+    igb_ctx->stats = (net_stats_t){0};
+    igb_ctx->initialized = true;
+    log_info(igb_log, "Driver initialized successfully\n");
+    return 0;
+}
+
+static void igb_deinit_context(void *ctx) {
+    // TODO: Deinitialize IGB device context
+    (void)ctx;
+}
+
+// Driver descriptor
+static const driver_t igb_driver = {
+    .name = "igb",
+    .version = "0.1.0",
+    .type = DRIVER_TYPE_NETWORK,
+    .id_table = igb_id_table,
+    .init_context = igb_init_context,
+    .deinit_context = igb_deinit_context,
+    .netdev_ops = &igb_netdev_ops
+};
+
+const driver_t* igb_get_driver(void) {
+    return &igb_driver;
+}
+
+// Queue pair for a public call, NULL if the device or queue is not usable
+static inline igb_queue_t *igb_queue(igb_t *ctx, uint16_t queue) {
+    if (!ctx || !ctx->initialized || queue >= ctx->num_queues) {
+        return NULL;
+    }
+    return &ctx->queues[queue];
+}
+
+int igb_get_mac(igb_t *ctx, uint8_t mac[6]) {
+    if (!ctx || !mac || !ctx->initialized) {
+        return -1;
+    }
+
+    for (int i = 0; i < 6; i++) {
+        mac[i] = ctx->mac_addr[i];
+    }
+
+    return 0;
+}
+
+uint32_t igb_get_caps(igb_t *ctx) {
+    (void)ctx;
+
+    // Checksums and segmentation through TX context descriptors, RX checksum
+    // validation through RXCSUM
+    return NET_CAP_TX_CSUM | NET_CAP_RX_CSUM | NET_CAP_TSO4;
+}
+
+int igb_get_queue_count(igb_t *ctx) {
+    if (!ctx || !ctx->initialized) {
+        return 1;
+    }
+    return ctx->num_queues;
+}
+
+int igb_get_stats(igb_t *ctx, net_stats_t *stats) {
+    if (!ctx || !stats || !ctx->initialized) {
+        return -1;
+    }
+
+    ctx->stats.rx_packets += igb_read32(ctx, IGB_GPRC);
+    ctx->stats.tx_packets += igb_read32(ctx, IGB_GPTC);
+    ctx->stats.rx_dropped += igb_read32(ctx, IGB_MPC);
+    *stats = ctx->stats;
+
+    return 0;
+}
+
+// NET_RX_F_* flags of a received frame: the NIC verified its TCP/UDP checksum
+// unless it reports the checksum as ignored or wrong
+static inline uint16_t igb_rx_flags(uint32_t status_error) {
+    if ((status_error & (IGB_RXD_STAT_TCPCS | IGB_RXD_STAT_UDPCS)) != 0 &&
+        (status_error & (IGB_RXD_STAT_IXSM | IGB_RXD_ERR_TCPE)) == 0) {
+        return NET_RX_F_CSUM_VALID;
+    }
+    return 0;
+}
+
+// Consume the descriptor at rx_current without updating the RX tail pointer
+// Returns 1 if a packet was copied, 0 if no packet is available, -1 if a packet was dropped
+static int igb_rx_next(igb_queue_t *q, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    if (!igb_rx_done(q)) {
+        return 0;
+    }
+
+    // Read the rest of the descriptor only after seeing DD
+    __sync_synchronize();
+
+    const igb_rx_desc_t *desc = &q->rx_descs[q->rx_current];
+    uint16_t pkt_len = desc->wb.length;
+    int result = 1;
+
+    if ((desc->wb.status_error & IGB_RXD_STAT_EOP) == 0 || pkt_len > buffer_size) {
+        // Multi-descriptor packet not supported, or buffer too small
+        result = -1;
+    } else {
+        for (size_t i = 0; i < pkt_len; i++) {
+            buffer[i] = q->rx_buffers[q->rx_current][i];
+        }
+        *received_length = pkt_len;
+    }
+
+    igb_rx_arm(q, q->rx_current);
+    q->rx_current = (q->rx_current + 1) % IGB_RING_SIZE;
+
+    return result;
+}
+
+// Hand every consumed RX descriptor back to the NIC with one RDT write
+static void igb_rx_return(igb_t *ctx, igb_queue_t *q) {
+    igb_write_tail(ctx, IGB_RDT(q->index), (q->rx_current + IGB_RING_SIZE - 1) % IGB_RING_SIZE);
+    q->rx_unreturned = 0;
+}
+
+// Clear the queue's interrupt cause, which ends the message request or drops
+// the line, then complete the interrupt at the controller
+static void igb_irq_ack(igb_t *ctx, const igb_queue_t *q) {
+    if (ctx->irq_mode == IGB_IRQ_MSIX) {
+        igb_write32(ctx, IGB_EICR, 1u << q->index);
+        return;
+    }
+    igb_read32(ctx, IGB_ICR);  // Read to clear
+    if (ctx->irq_mode == IGB_IRQ_WIRED) {
+        platform_irq_ack();
+    }
+}
+
+int igb_wait(igb_t *ctx, uint16_t queue) {
+    igb_queue_t *q = igb_queue(ctx, queue);
+    if (!q || ctx->irq_mode == IGB_IRQ_NONE) {
+        return -1;
+    }
+
+    // The NIC can only receive into descriptors it owns
+    if (q->rx_unreturned > 0) {
+        igb_rx_return(ctx, q);
+    }
+
+    // Drop a cause raised while polling so it cannot end the wait right away
+    igb_irq_ack(ctx, q);
+
+    // Check the ring again after unmasking: a frame written back before the
+    // cause was cleared would not interrupt
+    uint32_t mask_set = ctx->irq_mode == IGB_IRQ_MSIX ? IGB_EIMS : IGB_IMS;
+    uint32_t mask_clear = ctx->irq_mode == IGB_IRQ_MSIX ? IGB_EIMC : IGB_IMC;
+    uint32_t causes = ctx->irq_mode == IGB_IRQ_MSIX ? 1u << q->index : IGB_WAKEUP_CAUSES;
+    igb_write32(ctx, mask_set, causes);
+    if (!igb_rx_done(q)) {
+        platform_irq_wait();
+    }
+    igb_write32(ctx, mask_clear, causes);
+    igb_irq_ack(ctx, q);
+
+    return 0;
+}
+
+int igb_receive(igb_t *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    igb_queue_t *q = igb_queue(ctx, queue);
+    if (!q || !buffer || !received_length) {
+        return -1;
+    }
+
+    int result = igb_rx_next(q, buffer, buffer_size, received_length);
+    if (result == 0) {
+        if (q->rx_unreturned != 0) {
+            igb_rx_return(ctx, q);
+        }
+        return -1;
+    }
+
+    // Defer the trapping RDT write while more frames are waiting
+    q->rx_unreturned++;
+    if (!igb_rx_done(q) || q->rx_unreturned >= IGB_RX_TAIL_BATCH) {
+        igb_rx_return(ctx, q);
+    }
+
+    return result > 0 ? 0 : -1;
+}
+
+int igb_receive_burst(igb_t *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                      size_t lengths[], int max_packets) {
+    igb_queue_t *q = igb_queue(ctx, queue);
+    if (!q || !buffers || !lengths || max_packets < 0) {
+        return -1;
+    }
+
+    int received = 0;
+    bool consumed = false;
+    while (received < max_packets) {
+        int result = igb_rx_next(q, buffers[received], buffer_size, &lengths[received]);
+        if (result == 0) {
+            break;
+        }
+        consumed = true;
+        if (result > 0) {
+            received++;
+        }
+    }
+
+    // Return all consumed descriptors to the NIC with a single tail update
+    if (consumed || q->rx_unreturned != 0) {
+        igb_rx_return(ctx, q);
+    }
+
+    return received;
+}
+
+int igb_rx_acquire(igb_t *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames) {
+    igb_queue_t *q = igb_queue(ctx, queue);
+    if (!q || !frames || max_frames < 0) {
+        return -1;
+    }
+
+    int acquired = 0;
+    while (acquired < max_frames && igb_rx_done(q)) {
+        uint16_t slot = q->rx_current;
+
+        // Read the rest of the descriptor only after seeing DD
+        __sync_synchronize();
+
+        uint32_t status_error = q->rx_descs[slot].wb.status_error;
+        uint16_t pkt_len = q->rx_descs[slot].wb.length;
+
+        // The NIC does not own the descriptor again until the tail passes
+        // it, so it can be re-armed while the frame is lent
+        igb_rx_arm(q, slot);
+        q->rx_current = (q->rx_current + 1) % IGB_RING_SIZE;
+
+        if ((status_error & IGB_RXD_STAT_EOP) == 0) {
+            // Multi-descriptor packet not supported; give it straight back
+            // unless lent frames are still outstanding (release covers it)
+            if (q->rx_lent == 0 && acquired == 0) {
+                igb_rx_return(ctx, q);
+            }
+            continue;
+        }
+
+        frames[acquired].data = q->rx_buffers[slot];
+        frames[acquired].length = pkt_len;
+        frames[acquired].slot = slot;
+        frames[acquired].flags = igb_rx_flags(status_error);
+        acquired++;
+    }
+
+    q->rx_lent += acquired;
+    return acquired;
+}
+
+int igb_rx_release(igb_t *ctx, uint16_t queue, const net_rx_frame_t frames[], int count) {
+    igb_queue_t *q = igb_queue(ctx, queue);
+    if (!q || !frames || count < 0 || count > q->rx_lent) {
+        return -1;
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    q->rx_lent -= count;
+
+    // Descriptors are returned in ring order, so the tail only needs to move
+    // to the last released slot (or past any dropped ones once nothing is lent)
+    if (q->rx_lent == 0) {
+        igb_rx_return(ctx, q);
+    } else {
+        igb_write_tail(ctx, IGB_RDT(q->index), frames[count - 1].slot);
+    }
+
+    return 0;
+}
+
+// Reclaim TX descriptors the NIC is done with
+// Context descriptors never report status, so RS is only set on end-of-packet
+// data descriptors; once one reports DD, it and everything before it is free.
+static void igb_tx_reclaim(igb_queue_t *q) {
+    while (q->tx_rs_count > 0) {
+        uint16_t last = q->tx_rs_desc[q->tx_rs_head];
+        if ((q->tx_descs[last].wb.status & IGB_TXD_STAT_DD) == 0) {
+            break;
+        }
+
+        // Buffers of frames whose first descriptor is in the range are free again
+        uint16_t count = (uint16_t)((last + IGB_RING_SIZE - q->tx_clean) % IGB_RING_SIZE + 1);
+        for (uint16_t i = 0; i < count; i++) {
+            uint16_t buffer = q->tx_desc_buffer[(q->tx_clean + i) % IGB_RING_SIZE];
+            if (buffer != IGB_TX_NO_BUFFER) {
+                q->tx_buffer_busy[buffer] = false;
+            }
+        }
+        q->tx_clean = (last + 1) % IGB_RING_SIZE;
+        q->tx_inflight -= count;
+        q->tx_rs_head = (q->tx_rs_head + 1) % IGB_RING_SIZE;
+        q->tx_rs_count--;
+    }
+}
+
+// Whether count more descriptors fit in the ring next to those in flight and
+// reserved; one descriptor stays unused since TDT == TDH means an empty ring
+static bool igb_tx_has_room(igb_queue_t *q, uint32_t count) {
+    uint32_t used = q->tx_inflight + (uint32_t)q->tx_reserved * IGB_TX_SLOT_DESCS;
+    if (used + count <= IGB_RING_SIZE - 1u) {
+        return true;
+    }
+    igb_tx_reclaim(q);
+    used = q->tx_inflight + (uint32_t)q->tx_reserved * IGB_TX_SLOT_DESCS;
+    return used + count <= IGB_RING_SIZE - 1u;
+}
+
+// Reserve the next TX buffer after any already handed out
+static int igb_tx_claim(igb_queue_t *q, net_tx_slot_t *slot) {
+    if (!igb_tx_has_room(q, IGB_TX_SLOT_DESCS)) {
+        return -1;
+    }
+
+    uint16_t index = (q->tx_buffer_head + q->tx_reserved) % IGB_RING_SIZE;
+    if (q->tx_buffer_busy[index]) {
+        return -1;
+    }
+    q->tx_buffer_busy[index] = true;
+
+    slot->data = &q->tx_buffers[index][IGB_TX_HEADROOM];
+    slot->capacity = IGB_TX_BUFFER_SIZE - IGB_TX_HEADROOM;
+    slot->slot = index;
+    slot->offload.csum_start = 0;
+    slot->offload.csum_offset = 0;
+    slot->offload.gso_size = 0;
+    q->tx_reserved++;
+
+    return 0;
+}
+
+// Take the descriptor at tx_current; buffer (or IGB_TX_NO_BUFFER) is released
+// when the descriptor is reclaimed
+static igb_tx_desc_t *igb_tx_take(igb_queue_t *q, uint16_t buffer) {
+    uint16_t index = q->tx_current;
+    q->tx_desc_buffer[index] = buffer;
+    q->tx_current = (index + 1) % IGB_RING_SIZE;
+    q->tx_inflight++;
+    q->tx_since_rs++;
+    return &q->tx_descs[index];
+}
+
+// Write one data descriptor at tx_current; the last one of a frame asks for a
+// status write-back once IGB_TX_RS_INTERVAL descriptors went out without one
+static void igb_tx_put_data(igb_queue_t *q, uint16_t buffer, uint64_t addr, uint32_t length,
+                            uint32_t cmd, uint32_t olinfo, bool last) {
+    uint16_t index = q->tx_current;
+    igb_tx_desc_t *desc = igb_tx_take(q, buffer);
+
+    cmd |= IGB_TXD_DTYP_DATA | IGB_TXD_CMD_DEXT | IGB_TXD_CMD_IFCS | length;
+    if (last) {
+        cmd |= IGB_TXD_CMD_EOP;
+        if (q->tx_since_rs >= IGB_TX_RS_INTERVAL) {
+            cmd |= IGB_TXD_CMD_RS;
+            q->tx_rs_desc[(q->tx_rs_head + q->tx_rs_count) % IGB_RING_SIZE] = index;
+            q->tx_rs_count++;
+            q->tx_since_rs = 0;
+        }
+    }
+    desc->read.buffer_addr = addr;
+    desc->read.cmd_type_len = cmd;
+    desc->read.olinfo_status = olinfo;
+}
+
+// Descriptors needed for a buffer of the given length
+static inline uint32_t igb_tx_desc_count(size_t length) {
+    return (uint32_t)((length + IGB_TX_MAX_DATA_PER_DESC - 1) / IGB_TX_MAX_DATA_PER_DESC);
+}
+
+// Hand the oldest reserved slot to the NIC, followed by one or more data
+// descriptors per caller-owned fragment (no TDT write)
+// Checksum and segmentation requests go into a context descriptor in front of
+// the frame. The queue keeps the last context, so a checksum context is only
+// written when csum_start/csum_offset change; TSO carries per-frame lengths
+// and always needs a fresh one.
+// The slot is consumed: returns 0 once queued, -1 for an invalid request or
+// NET_TX_AGAIN when the ring has no room for the descriptors
+static int igb_tx_publish(igb_queue_t *q, size_t length, const net_tx_offload_t *offload,
+                          const net_tx_frag_t frags[], int frag_count) {
+    uint16_t buffer = q->tx_buffer_head;
+    uint8_t *frame = &q->tx_buffers[buffer][IGB_TX_HEADROOM];
+    size_t capacity = IGB_TX_BUFFER_SIZE - IGB_TX_HEADROOM;
+    bool gso = offload && offload->gso_size != 0;
+    bool csum = offload && offload->csum_start != 0;
+
+    q->tx_buffer_head = (buffer + 1) % IGB_RING_SIZE;
+    q->tx_reserved--;
+
+    // The context names the L4 protocol instead of a checksum offset, and the
+    // IP header length field is 9 bits wide
+    size_t frame_len = length;
+    size_t hdr_len = 0;
+    uint32_t descs = 1;
+    bool valid = length > 0 && length <= capacity && frag_count >= 0 && (frag_count == 0 || frags);
+    if (csum && ((size_t)offload->csum_start + offload->csum_offset + 2 > length ||
+                 offload->csum_start < sizeof(eth_hdr_t) || offload->csum_start - sizeof(eth_hdr_t) > 0x1FF ||
+                 (offload->csum_offset != IGB_TCP_CSUM_OFFSET && offload->csum_offset != IGB_UDP_CSUM_OFFSET))) {
+        valid = false;
+    }
+    if (valid && gso) {
+        if (!csum || offload->csum_offset != IGB_TCP_CSUM_OFFSET ||
+            offload->csum_start < sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) ||
+            (size_t)offload->csum_start + 12 >= length) {
+            valid = false;
+        } else {
+            hdr_len = offload->csum_start + (frame[offload->csum_start + 12] >> 4) * 4;
+            valid = hdr_len <= length;
+        }
+    }
+    for (int i = 0; valid && i < frag_count; i++) {
+        if (!frags[i].data || frags[i].length == 0) {
+            valid = false;
+        }
+        frame_len += frags[i].length;
+        descs += igb_tx_desc_count(frags[i].length);
+    }
+    if (!valid || frame_len > (gso ? NET_TSO_MAX_FRAME_SIZE : capacity)) {
+        q->tx_buffer_busy[buffer] = false;
+        return -1;
+    }
+
+    bool load_context = gso || (csum && !(q->tx_csum_context &&
+                                          q->tx_csum_start == offload->csum_start &&
+                                          q->tx_csum_offset == offload->csum_offset));
+    if (load_context) {
+        descs++;
+    }
+    if (!igb_tx_has_room(q, descs)) {
+        q->tx_buffer_busy[buffer] = false;
+        return NET_TX_AGAIN;
+    }
+
+    uint32_t cmd = 0;
+    uint32_t olinfo = (uint32_t)(gso ? frame_len - hdr_len : frame_len) << IGB_TXD_PAYLEN_SHIFT;
+    if (csum) {
+        olinfo |= IGB_TXD_POPTS_TXSM;
+    }
+    if (gso) {
+        // The NIC adds each segment's length to the TCP pseudo-header sum and
+        // recomputes the IPv4 header checksum per segment, so strip the length
+        // the caller summed in and clear the IPv4 checksum
+        uint8_t *sum = frame + offload->csum_start + offload->csum_offset;
+        uint32_t value = ((uint32_t)sum[0] << 8 | sum[1]) + (uint16_t)~(frame_len - offload->csum_start);
+        value = (value & 0xFFFF) + (value >> 16);
+        sum[0] = (uint8_t)(value >> 8);
+        sum[1] = (uint8_t)value;
+        frame[sizeof(eth_hdr_t) + IGB_IPV4_CSUM_OFFSET] = 0;
+        frame[sizeof(eth_hdr_t) + IGB_IPV4_CSUM_OFFSET + 1] = 0;
+        olinfo |= IGB_TXD_POPTS_IXSM;
+        cmd |= IGB_TXD_CMD_TSE;
+    }
+    if (load_context) {
+        igb_tx_desc_t *desc = igb_tx_take(q, IGB_TX_NO_BUFFER);
+        uint16_t ethertype = (uint16_t)(frame[12] << 8 | frame[13]);
+        uint32_t tucmd = IGB_TXD_DTYP_CTXT | IGB_TXD_CMD_DEXT;
+        if (ethertype == ETH_P_IP) {
+            tucmd |= IGB_TXD_TUCMD_IPV4;
+        }
+        if (offload->csum_offset == IGB_TCP_CSUM_OFFSET) {
+            tucmd |= IGB_TXD_TUCMD_L4T_TCP;
+        }
+        desc->context.vlan_macip_lens = (uint32_t)(offload->csum_start - sizeof(eth_hdr_t)) |
+                                        (uint32_t)sizeof(eth_hdr_t) << IGB_TXD_MACLEN_SHIFT;
+        desc->context.seqnum_seed = 0;
+        desc->context.type_tucmd_mlhl = tucmd;
+        desc->context.mss_l4len_idx = gso ? ((uint32_t)offload->gso_size << IGB_TXD_MSS_SHIFT |
+                                             (uint32_t)(hdr_len - offload->csum_start) << IGB_TXD_L4LEN_SHIFT) : 0;
+        // A segmentation context replaces the checksum-only one
+        q->tx_csum_context = !gso;
+        q->tx_csum_start = offload->csum_start;
+        q->tx_csum_offset = offload->csum_offset;
+    }
+
+    // Slot data first, then the fragments in pieces of at most
+    // IGB_TX_MAX_DATA_PER_DESC bytes; EOP marks the last descriptor
+    igb_tx_put_data(q, buffer, (uintptr_t)frame, (uint32_t)length, cmd, olinfo, frag_count == 0);
+    for (int i = 0; i < frag_count; i++) {
+        size_t offset = 0;
+        while (offset < frags[i].length) {
+            size_t chunk = frags[i].length - offset;
+            if (chunk > IGB_TX_MAX_DATA_PER_DESC) {
+                chunk = IGB_TX_MAX_DATA_PER_DESC;
+            }
+            bool last = i + 1 == frag_count && offset + chunk == frags[i].length;
+            igb_tx_put_data(q, IGB_TX_NO_BUFFER, (uintptr_t)(frags[i].data + offset), (uint32_t)chunk,
+                            cmd, olinfo, last);
+            offset += chunk;
+        }
+    }
+
+    return 0;
+}
+
+// Copy one packet into the next TX buffer without updating the tail pointer
+static int igb_tx_enqueue(igb_queue_t *q, const uint8_t *buffer, size_t length) {
+    if (!buffer || length > IGB_TX_BUFFER_SIZE - IGB_TX_HEADROOM) {
+        return -1;
+    }
+
+    // Frames already reserved for zero-copy go out first
+    if (q->tx_reserved != 0) {
+        return -1;
+    }
+
+    net_tx_slot_t slot;
+    if (igb_tx_claim(q, &slot) != 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        slot.data[i] = buffer[i];
+    }
+
+    return igb_tx_publish(q, length, NULL, NULL, 0);
+}
+
+int igb_transmit(igb_t *ctx, uint16_t queue, const uint8_t *buffer, size_t length) {
+    igb_queue_t *q = igb_queue(ctx, queue);
+    if (!q || !buffer) {
+        return -1;
+    }
+
+    if (igb_tx_enqueue(q, buffer, length) != 0) {
+        return -1;
+    }
+
+    igb_write_tail(ctx, IGB_TDT(q->index), q->tx_current);
+
+    return 0;
+}
+
+int igb_transmit_burst(igb_t *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                       int count) {
+    igb_queue_t *q = igb_queue(ctx, queue);
+    if (!q || !packets || !lengths || count < 0) {
+        return -1;
+    }
+
+    int sent = 0;
+    while (sent < count) {
+        if (igb_tx_enqueue(q, packets[sent], lengths[sent]) != 0) {
+            break;
+        }
+        sent++;
+    }
+
+    // Single tail update triggers transmission of the whole batch
+    if (sent > 0) {
+        igb_write_tail(ctx, IGB_TDT(q->index), q->tx_current);
+    }
+
+    return sent;
+}
+
+int igb_tx_alloc(igb_t *ctx, uint16_t queue, net_tx_slot_t *slot) {
+    igb_queue_t *q = igb_queue(ctx, queue);
+    if (!q || !slot) {
+        return -1;
+    }
+
+    return igb_tx_claim(q, slot);
+}
+
+int igb_tx_commit(igb_t *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count) {
+    igb_queue_t *q = igb_queue(ctx, queue);
+    if (!q || !slots || !lengths || count < 0 || count > q->tx_reserved) {
+        return -1;
+    }
+
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        // Slots come back in allocation order, which is buffer order
+        if (slots[i].slot != q->tx_buffer_head) {
+            break;
+        }
+        // Invalid frames are dropped; their slot is released either way
+        if (igb_tx_publish(q, lengths[i], &slots[i].offload, NULL, 0) == 0) {
+            sent++;
+        }
+    }
+
+    // Single tail update triggers transmission of the whole batch
+    if (sent > 0) {
+        igb_write_tail(ctx, IGB_TDT(q->index), q->tx_current);
+    }
+
+    return sent;
+}
+
+int igb_tx_commit_sg(igb_t *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                     const net_tx_frag_t frags[], int frag_count) {
+    igb_queue_t *q = igb_queue(ctx, queue);
+    if (!q || !slot || q->tx_reserved == 0) {
+        return -1;
+    }
+
+    if (slot->slot != q->tx_buffer_head) {
+        return -1;
+    }
+
+    int result = igb_tx_publish(q, length, &slot->offload, frags, frag_count);
+    if (result != 0) {
+        return result;
+    }
+
+    igb_write_tail(ctx, IGB_TDT(q->index), q->tx_current);
+
+    return 0;
+}
+
+// netdev_ops_t entry points
+
+static igb_t igb_netdev_contexts[NETDEV_MAX_CONTEXTS];
+
+int igb_netdev_get_mac(void *ctx, uint8_t mac[6]) {
+    return igb_get_mac(ctx, mac);
+}
+
+uint32_t igb_netdev_get_caps(void *ctx) {
+    return igb_get_caps(ctx);
+}
+
+int igb_netdev_get_queue_count(void *ctx) {
+    return igb_get_queue_count(ctx);
+}
+
+int igb_netdev_get_stats(void *ctx, net_stats_t *stats) {
+    return igb_get_stats(ctx, stats);
+}
+
+int igb_netdev_wait(void *ctx, uint16_t queue) {
+    return igb_wait(ctx, queue);
+}
+
+int igb_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length) {
+    return igb_transmit(ctx, queue, packet, length);
+}
+
+int igb_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    return igb_receive(ctx, queue, buffer, buffer_size, received_length);
+}
+
+int igb_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                             size_t lengths[], int max_packets) {
+    return igb_receive_burst(ctx, queue, buffers, buffer_size, lengths, max_packets);
+}
+
+int igb_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                              int count) {
+    return igb_transmit_burst(ctx, queue, packets, lengths, count);
+}
+
+int igb_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames) {
+    return igb_rx_acquire(ctx, queue, frames, max_frames);
+}
+
+int igb_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count) {
+    return igb_rx_release(ctx, queue, frames, count);
+}
+
+int igb_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot) {
+    return igb_tx_alloc(ctx, queue, slot);
+}
+
+int igb_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count) {
+    return igb_tx_commit(ctx, queue, slots, lengths, count);
+}
+
+int igb_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                            const net_tx_frag_t frags[], int frag_count) {
+    return igb_tx_commit_sg(ctx, queue, slot, length, frags, frag_count);
+}
+
+const netdev_ops_t igb_netdev_ops = {
+    .contexts = igb_netdev_contexts,
+    .context_size = sizeof(igb_t),
+    .get_mac = igb_netdev_get_mac,
+    .get_caps = igb_netdev_get_caps,
+    .get_queue_count = igb_netdev_get_queue_count,
+    .get_stats = igb_netdev_get_stats,
+    .wait = igb_netdev_wait,
+    .transmit = igb_netdev_transmit,
+    .receive = igb_netdev_receive,
+    .receive_burst = igb_netdev_receive_burst,
+    .transmit_burst = igb_netdev_transmit_burst,
+    .rx_acquire = igb_netdev_rx_acquire,
+    .rx_release = igb_netdev_rx_release,
+    .tx_alloc = igb_netdev_tx_alloc,
+    .tx_commit = igb_netdev_tx_commit,
+    .tx_commit_sg = igb_netdev_tx_commit_sg
+};
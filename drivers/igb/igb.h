@@ -0,0 +1,440 @@
+#pragma once
+
+#include "../../common/types.h"
+#include "../../common/drivers.h"
+#include "../../kernel/devices/devices.h"
+
+// Intel 82576 Vendor and Device IDs
+#define PCI_VENDOR_ID_INTEL     0x8086
+#define IGB_DEVICE_ID_82576     0x10C9
+
+// IGB MMIO Register Offsets
+#define IGB_CTRL            0x00000  // Device Control
+#define IGB_STATUS          0x00008  // Device Status
+#define IGB_ICR             0x000C0  // Interrupt Cause Read (MSI and INTx)
+#define IGB_IMS             0x000D0  // Interrupt Mask Set
+#define IGB_IMC             0x000D8  // Interrupt Mask Clear
+#define IGB_RCTL            0x00100  // Receive Control
+#define IGB_TCTL            0x00400  // Transmit Control
+#define IGB_GPIE            0x01514  // General Purpose Interrupt Enable
+#define IGB_EIMS            0x01524  // Extended Interrupt Mask Set
+#define IGB_EIMC            0x01528  // Extended Interrupt Mask Clear
+#define IGB_EICR            0x01580  // Extended Interrupt Cause (write 1 to clear)
+#define IGB_EITR(n)         (0x01680 + 4 * (n))  // Per-vector Interrupt Throttling
+#define IGB_IVAR(n)         (0x01700 + 4 * (n))  // Interrupt Vector Allocation, queues n and n + 8
+#define IGB_MPC             0x04010  // Missed Packets Count (clear on read)
+#define IGB_GPRC            0x04074  // Good Packets Received Count (clear on read)
+#define IGB_GPTC            0x04080  // Good Packets Transmitted Count (clear on read)
+#define IGB_RXCSUM          0x05000  // Receive Checksum Control
+#define IGB_RAL             0x05400  // Receive Address Low
+#define IGB_RAH             0x05404  // Receive Address High
+#define IGB_MRQC            0x05818  // Multiple Receive Queues Command
+#define IGB_RETA            0x05C00  // RSS Redirection Table (128 one-byte entries)
+#define IGB_RSSRK           0x05C80  // RSS Random Key (40 bytes)
+#define IGB_RDBAL(q)        (0x0C000 + 0x40 * (q))  // RX Descriptor Base Low
+#define IGB_RDBAH(q)        (0x0C004 + 0x40 * (q))  // RX Descriptor Base High
+#define IGB_RDLEN(q)        (0x0C008 + 0x40 * (q))  // RX Descriptor Length
+#define IGB_SRRCTL(q)       (0x0C00C + 0x40 * (q))  // Split and Replication RX Control
+#define IGB_RDH(q)          (0x0C010 + 0x40 * (q))  // RX Descriptor Head
+#define IGB_RDT(q)          (0x0C018 + 0x40 * (q))  // RX Descriptor Tail
+#define IGB_RXDCTL(q)       (0x0C028 + 0x40 * (q))  // RX Descriptor Control
+#define IGB_TDBAL(q)        (0x0E000 + 0x40 * (q))  // TX Descriptor Base Low
+#define IGB_TDBAH(q)        (0x0E004 + 0x40 * (q))  // TX Descriptor Base High
+#define IGB_TDLEN(q)        (0x0E008 + 0x40 * (q))  // TX Descriptor Length
+#define IGB_TDH(q)          (0x0E010 + 0x40 * (q))  // TX Descriptor Head
+#define IGB_TDT(q)          (0x0E018 + 0x40 * (q))  // TX Descriptor Tail
+#define IGB_TXDCTL(q)       (0x0E028 + 0x40 * (q))  // TX Descriptor Control
+
+// Control Register Bits
+#define IGB_CTRL_SLU        (1 << 6)   // Set Link Up
+#define IGB_CTRL_RST        (1 << 26)  // Device Reset
+
+// Interrupt Cause Bits (ICR, IMS, IMC) without MSI-X, shared by all queues
+#define IGB_ICR_TXDW        (1 << 0)   // TX Descriptor Written Back
+#define IGB_ICR_RXDW        (1 << 7)   // RX Descriptor Written Back
+
+// General Purpose Interrupt Enable Bits
+#define IGB_GPIE_NSICR      (1 << 0)   // Clear ICR on every read
+#define IGB_GPIE_MSIX_MODE  (1 << 4)   // Queue causes go to EICR bits chosen by IVAR
+#define IGB_GPIE_PBA        (1u << 31) // MSI-X pending bits follow EICR
+
+// IVAR: one byte per queue direction holding a valid bit and the MSI-X vector
+#define IGB_IVAR_VALID      0x80
+#define IGB_IVAR_RX_SHIFT(q) (((q) & 0x8) << 1)
+#define IGB_IVAR_TX_SHIFT(q) (IGB_IVAR_RX_SHIFT(q) + 8)
+
+// Interrupt throttling: EITR interval field (bits 14:2) counts in 0.25 us units
+#define IGB_EITR_UNITS_PER_SEC 4000000
+#define IGB_EITR_INTERVAL_MASK 0x7FFC
+// Default ceiling on interrupts per second and vector (igb.irq_rate)
+#define IGB_IRQ_RATE_DEFAULT 8000
+
+// Receive Control Register Bits
+#define IGB_RCTL_EN         (1 << 1)   // Receive Enable
+#define IGB_RCTL_UPE        (1 << 3)   // Unicast Promiscuous Enable
+#define IGB_RCTL_MPE        (1 << 4)   // Multicast Promiscuous Enable
+#define IGB_RCTL_BAM        (1 << 15)  // Broadcast Accept Mode
+
+// Split and Replication RX Control Bits
+#define IGB_SRRCTL_BSIZEPKT_SHIFT 10   // Packet buffer size in 1 KB units (bits 6:0)
+#define IGB_SRRCTL_DESCTYPE_ADV_ONEBUF (1 << 25)  // Advanced descriptors, one buffer
+#define IGB_SRRCTL_DROP_EN  (1u << 31) // Drop frames when the queue has no descriptors
+
+// RX/TX Descriptor Control Bits
+#define IGB_RXDCTL_ENABLE   (1 << 25)
+#define IGB_TXDCTL_ENABLE   (1 << 25)
+
+// Receive Checksum Control Register Bits
+#define IGB_RXCSUM_TUOFL    (1 << 9)   // TCP/UDP Checksum Offload Enable
+#define IGB_RXCSUM_PCSD     (1 << 13)  // Write back the RSS hash instead of the packet checksum
+
+// Multiple Receive Queues Command: RSS across queues (no VMDq pools) and the fields it hashes
+#define IGB_MRQC_ENABLE_RSS_MQ  0x2
+#define IGB_MRQC_RSS_TCP_IPV4   (1 << 16)  // Addresses and ports of IPv4/TCP
+#define IGB_MRQC_RSS_IPV4       (1 << 17)  // Addresses of other IPv4 packets
+#define IGB_MRQC_RSS_UDP_IPV4   (1 << 22)  // Addresses and ports of IPv4/UDP
+#define IGB_RETA_ENTRIES    128
+#define IGB_RSS_KEY_SIZE    40
+
+// Transmit Control Register Bits
+#define IGB_TCTL_EN         (1 << 1)   // Transmit Enable
+#define IGB_TCTL_PSP        (1 << 3)   // Pad Short Packets
+
+// Advanced RX Descriptor Status and Error Bits (status_error)
+#define IGB_RXD_STAT_DD     (1 << 0)   // Descriptor Done
+#define IGB_RXD_STAT_EOP    (1 << 1)   // End of Packet
+#define IGB_RXD_STAT_IXSM   (1 << 2)   // Ignore Checksum Indication
+#define IGB_RXD_STAT_UDPCS  (1 << 4)   // UDP Checksum Calculated
+#define IGB_RXD_STAT_TCPCS  (1 << 5)   // TCP Checksum Calculated
+#define IGB_RXD_ERR_TCPE    (1u << 29) // TCP/UDP Checksum Error
+
+// Advanced TX Data Descriptor cmd_type_len Bits
+#define IGB_TXD_DTYP_DATA   (0x3 << 20)
+#define IGB_TXD_DTYP_CTXT   (0x2 << 20)
+#define IGB_TXD_CMD_EOP     (1 << 24)  // End of Packet
+#define IGB_TXD_CMD_IFCS    (1 << 25)  // Insert FCS
+#define IGB_TXD_CMD_RS      (1 << 27)  // Report Status
+#define IGB_TXD_CMD_DEXT    (1 << 29)  // Advanced descriptor
+#define IGB_TXD_CMD_TSE     (1u << 31) // TCP Segmentation Enable
+
+// Advanced TX Data Descriptor olinfo_status Fields
+#define IGB_TXD_POPTS_IXSM  (1 << 8)   // Insert IPv4 header checksum
+#define IGB_TXD_POPTS_TXSM  (1 << 9)   // Insert TCP/UDP checksum
+#define IGB_TXD_PAYLEN_SHIFT 14
+#define IGB_TXD_STAT_DD     (1 << 0)   // Descriptor Done (write-back)
+
+// Advanced TX Context Descriptor Fields
+#define IGB_TXD_MACLEN_SHIFT 9         // vlan_macip_lens: MAC header length above the IP header length
+#define IGB_TXD_TUCMD_IPV4  (1 << 10)  // type_tucmd_mlhl: IPv4 packet
+#define IGB_TXD_TUCMD_L4T_TCP (1 << 11) // type_tucmd_mlhl: TCP (UDP when clear)
+#define IGB_TXD_L4LEN_SHIFT 8          // mss_l4len_idx: TCP header length
+#define IGB_TXD_MSS_SHIFT   16         // mss_l4len_idx: payload bytes per segment
+
+// RX/TX queue pairs, spread by RSS; each has its own MSI-X vector
+#define IGB_MAX_QUEUES      4
+#define IGB_NUM_QUEUES      (NETDEV_QUEUES < IGB_MAX_QUEUES ? NETDEV_QUEUES : IGB_MAX_QUEUES)
+// Descriptors per ring
+#define IGB_RING_SIZE       128
+// A TX status write-back is requested once at least this many descriptors
+// have been queued since the last one, on the next end-of-packet descriptor
+#define IGB_TX_RS_INTERVAL  16
+// Consumed RX descriptors handed back with one RDT write while frames keep arriving
+#define IGB_RX_TAIL_BATCH   32
+// Descriptors held for each reserved TX slot: a context and a data descriptor
+#define IGB_TX_SLOT_DESCS   2
+// Largest buffer a single TX data descriptor carries; longer fragments are split
+#define IGB_TX_MAX_DATA_PER_DESC 32768
+// Marks a TX descriptor that does not own a driver TX buffer
+#define IGB_TX_NO_BUFFER    0xFFFF
+#define IGB_RX_BUFFER_SIZE  2048
+#define IGB_TX_BUFFER_SIZE  2048
+// Frames start 2 bytes into each TX buffer so the IP header is 4-byte aligned
+#define IGB_TX_HEADROOM     2
+
+/**
+ * IGB advanced RX descriptor
+ * Handed to the NIC in the read format and overwritten in the write-back
+ * format, so the buffer address is written again whenever it is returned.
+ */
+typedef union {
+    struct {
+        uint64_t pkt_addr;
+        uint64_t hdr_addr;      // Cleared with the buffer, so DD reads as 0
+    } read;
+    struct {
+        uint16_t pkt_info;      // RSS and packet type
+        uint16_t hdr_info;      // Header length with header split
+        uint32_t rss_hash;
+        volatile uint32_t status_error;
+        uint16_t length;
+        uint16_t vlan;
+    } wb;
+} igb_rx_desc_t;
+
+/**
+ * IGB advanced TX descriptor: a data descriptor as queued, its status
+ * write-back, or a context descriptor carrying offload parameters
+ */
+typedef union {
+    struct {
+        uint64_t buffer_addr;
+        uint32_t cmd_type_len;
+        uint32_t olinfo_status;
+    } read;
+    struct {
+        uint64_t reserved;
+        uint32_t nxtseq_seed;
+        volatile uint32_t status;
+    } wb;
+    struct {
+        uint32_t vlan_macip_lens;
+        uint32_t seqnum_seed;
+        uint32_t type_tucmd_mlhl;
+        uint32_t mss_l4len_idx;
+    } context;
+} igb_tx_desc_t;
+
+static_assert(sizeof(igb_rx_desc_t) == 16, "Advanced RX descriptor must be 16 bytes");
+static_assert(sizeof(igb_tx_desc_t) == 16, "Advanced TX descriptor must be 16 bytes");
+static_assert(__builtin_offsetof(igb_rx_desc_t, wb.status_error) == 8, "RX status at byte 8");
+static_assert(__builtin_offsetof(igb_tx_desc_t, wb.status) == 12, "TX status at byte 12");
+
+/**
+ * How the device wakes a CPU halted in igb_wait()
+ */
+typedef enum {
+    IGB_IRQ_NONE = 0,           // No usable interrupt, callers keep polling
+    IGB_IRQ_MSIX = 1,           // PCI MSI-X, one vector per queue pair (AMD64)
+    IGB_IRQ_MSI = 2,            // PCI MSI shared by all queues (AMD64)
+    IGB_IRQ_WIRED = 3           // INTx through the I/O APIC, GIC or PLIC
+} igb_irq_t;
+
+/**
+ * One RX/TX queue pair
+ */
+typedef struct {
+    igb_rx_desc_t rx_descs[IGB_RING_SIZE] __attribute__((aligned(128)));
+    uint8_t rx_buffers[IGB_RING_SIZE][IGB_RX_BUFFER_SIZE] __attribute__((aligned(16)));
+    igb_tx_desc_t tx_descs[IGB_RING_SIZE] __attribute__((aligned(128)));
+    uint8_t tx_buffers[IGB_RING_SIZE][IGB_TX_BUFFER_SIZE] __attribute__((aligned(16)));
+    uint16_t index;         // Queue number, selects the ring registers
+    uint16_t rx_current;
+    uint16_t rx_lent;       // RX descriptors lent out by igb_rx_acquire()
+    uint16_t rx_unreturned; // RX descriptors consumed by igb_receive() but not yet given back
+    uint16_t tx_current;    // Next TX descriptor to fill
+    uint16_t tx_clean;      // Oldest TX descriptor not yet reclaimed
+    uint16_t tx_inflight;   // TX descriptors handed to the NIC and not yet reclaimed
+    uint16_t tx_since_rs;   // Descriptors queued since the last one with RS
+    uint16_t tx_rs_desc[IGB_RING_SIZE];         // Descriptors with RS, oldest at tx_rs_head
+    uint16_t tx_rs_head;
+    uint16_t tx_rs_count;
+    uint16_t tx_desc_buffer[IGB_RING_SIZE];     // TX buffer freed with each descriptor
+    uint16_t tx_buffer_head; // Oldest reserved TX buffer (next to be committed)
+    uint16_t tx_reserved;   // TX buffers handed out by igb_tx_alloc(), not yet committed
+    bool tx_buffer_busy[IGB_RING_SIZE];         // TX buffer reserved or queued
+    bool tx_csum_context;   // The queue holds a checksum context for tx_csum_start/offset
+    uint16_t tx_csum_start;
+    uint16_t tx_csum_offset;
+} __attribute__((aligned(16))) igb_queue_t;
+
+/**
+ * IGB device context
+ */
+typedef struct {
+    uint64_t mmio_base;
+    bool initialized;
+    uint8_t mac_addr[6];
+    igb_irq_t irq_mode;     // Wakeup interrupt used by igb_wait()
+    uint16_t num_queues;    // Queue pairs RSS spreads flows over (igb.queues)
+    net_stats_t stats;      // Totals of the clear-on-read statistics registers
+    igb_queue_t queues[IGB_NUM_QUEUES];
+} __attribute__((aligned(16))) igb_t;
+
+/**
+ * Get igb driver descriptor
+ * @return Pointer to driver descriptor
+ */
+const driver_t* igb_get_driver(void);
+
+/**
+ * Get MAC address from igb device
+ * @param ctx Device context from driver initialization
+ * @param mac Buffer to store 6-byte MAC address
+ * @return 0 on success, -1 on error
+ */
+int igb_get_mac(igb_t *ctx, uint8_t mac[6]);
+
+/**
+ * Get offload capabilities of igb device
+ * @param ctx Device context from driver initialization
+ * @return NET_CAP_* flags
+ */
+uint32_t igb_get_caps(igb_t *ctx);
+
+/**
+ * Get number of RX/TX queue pairs of igb device
+ * RSS spreads received flows over the pairs; each pair is polled on its own.
+ * One unless more are requested with igb.queues.
+ * @param ctx Device context from driver initialization
+ * @return Number of queue pairs
+ */
+int igb_get_queue_count(igb_t *ctx);
+
+/**
+ * Get packet counters of igb device
+ * @param ctx Device context from driver initialization
+ * @param stats Receives the totals since initialization
+ * @return 0 on success, -1 on error
+ */
+int igb_get_stats(igb_t *ctx, net_stats_t *stats);
+
+/**
+ * Receive a packet from igb device
+ * Consumed descriptors are handed back once the ring is drained or
+ * IGB_RX_TAIL_BATCH of them have built up, not after every packet.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param buffer Buffer to store received packet
+ * @param buffer_size Size of the buffer
+ * @param received_length Pointer to store received packet length
+ * @return 0 on success, -1 on error
+ */
+int igb_receive(igb_t *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+
+/**
+ * Transmit a packet to igb device
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param buffer Buffer containing packet to transmit
+ * @param length Length of packet to transmit
+ * @return 0 on success, -1 on error
+ */
+int igb_transmit(igb_t *ctx, uint16_t queue, const uint8_t *buffer, size_t length);
+
+/**
+ * Receive up to max_packets packets from igb device
+ * Drains completed RX descriptors and updates the RX tail pointer once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param buffers Array of max_packets receive buffers
+ * @param buffer_size Size of each receive buffer
+ * @param lengths Array receiving the length of each packet
+ * @param max_packets Maximum number of packets to receive
+ * @return Number of packets received (0 if none available), -1 on error
+ */
+int igb_receive_burst(igb_t *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                      size_t lengths[], int max_packets);
+
+/**
+ * Transmit up to count packets to igb device
+ * Fills consecutive TX descriptors and updates the TX tail pointer once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param packets Array of packet pointers
+ * @param lengths Array of packet lengths in bytes
+ * @param count Number of packets
+ * @return Number of packets queued (may be less than count if the ring is full), -1 on error
+ */
+int igb_transmit_burst(igb_t *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                       int count);
+
+/**
+ * Borrow received frames from igb device without copying
+ * Frames point into the driver RX buffers and must be returned with
+ * igb_rx_release() in the order they were acquired.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param frames Array receiving up to max_frames frame descriptors
+ * @param max_frames Maximum number of frames to acquire
+ * @return Number of frames acquired (0 if none available), -1 on error
+ */
+int igb_rx_acquire(igb_t *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+
+/**
+ * Return borrowed frames to igb device
+ * Hands the descriptors back to the NIC with a single RX tail update.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param frames Frames previously returned by igb_rx_acquire()
+ * @param count Number of frames
+ * @return 0 on success, -1 on error
+ */
+int igb_rx_release(igb_t *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+
+/**
+ * Halt the CPU until a queue pair of igb device receives frames
+ * Unmasks only this pair's MSI-X vector (or the shared RX/TX causes without
+ * MSI-X), re-checks the RX ring and halts until the device interrupts, then
+ * masks it again. Interrupts are throttled by EITR (igb.irq_rate).
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @return 0 once frames may be available, -1 if the device cannot interrupt
+ *         (the caller keeps polling)
+ */
+int igb_wait(igb_t *ctx, uint16_t queue);
+
+/**
+ * Reserve a TX buffer so a frame can be built in place (zero-copy transmit)
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param slot Filled with the writable frame area
+ * @return 0 on success, -1 if no TX descriptor is free
+ */
+int igb_tx_alloc(igb_t *ctx, uint16_t queue, net_tx_slot_t *slot);
+
+/**
+ * Transmit frames built in slots from igb_tx_alloc()
+ * Slots must be committed in the order they were allocated. Checksum and
+ * segmentation requests in slot offload are passed to the NIC in a context
+ * descriptor. Updates the TX tail pointer once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param slots Slots returned by igb_tx_alloc()
+ * @param lengths Frame length written into each slot
+ * @param count Number of slots
+ * @return Number of frames queued (invalid frames are dropped, stops at the first out-of-order slot), -1 on error
+ */
+int igb_tx_commit(igb_t *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count);
+
+/**
+ * Transmit one frame built from a slot followed by caller-owned fragments
+ * The slot holds the first length bytes (at least the headers); each fragment
+ * is read in place through its own data descriptors. With
+ * slot->offload.gso_size set the frame may be up to NET_TSO_MAX_FRAME_SIZE
+ * bytes and is segmented by the NIC. Updates the TX tail pointer once. The
+ * slot is consumed even on failure.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param slot Oldest slot returned by igb_tx_alloc() and not yet committed
+ * @param length Number of bytes written into the slot
+ * @param frags Fragments appended after the slot data
+ * @param frag_count Number of fragments
+ * @return 0 on success, NET_TX_AGAIN if the ring has no room for the fragments,
+ *         -1 on error (invalid frame or offload request)
+ */
+int igb_tx_commit_sg(igb_t *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                     const net_tx_frag_t frags[], int frag_count);
+
+/**
+ * netdev_ops_t entry points, registered as igb_get_driver()->netdev_ops
+ * They wrap the functions above with a void * context and a queue
+ * index.
+ */
+extern const netdev_ops_t igb_netdev_ops;
+int igb_netdev_get_mac(void *ctx, uint8_t mac[6]);
+uint32_t igb_netdev_get_caps(void *ctx);
+int igb_netdev_get_queue_count(void *ctx);
+int igb_netdev_get_stats(void *ctx, net_stats_t *stats);
+int igb_netdev_wait(void *ctx, uint16_t queue);
+int igb_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length);
+int igb_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+int igb_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                             size_t lengths[], int max_packets);
+int igb_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                              int count);
+int igb_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+int igb_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+int igb_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot);
+int igb_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count);
+int igb_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                            const net_tx_frag_t frags[], int frag_count);
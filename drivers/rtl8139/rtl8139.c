@@ -115,6 +115,10 @@ static int rtl8139_init_context(void *ctx, device_t *device) {
     rtl8139_t *rtl_ctx = (rtl8139_t *)ctx;
     rtl_ctx->mmio_base = device->reg_base;
     rtl_ctx->tx_current = 0;
+    rtl_ctx->tx_clean = 0;
+    rtl_ctx->tx_inflight = 0;
+    rtl_ctx->tx_reserved = 0;
+    rtl_ctx->rx_offset = 0;
     rtl_ctx->use_mmio = (device->reg_base >= 0x10000);
 
 #if defined(__x86_64__) || defined(__i386__)
@@ -140,7 +144,7 @@ static int rtl8139_init_context(void *ctx, device_t *device) {
     rtl8139_write8(rtl_ctx, RTL8139_CMD, RTL8139_CMD_RE | RTL8139_CMD_TE);
 
     uint32_t rcr = RTL8139_RCR_AAP | RTL8139_RCR_APM | RTL8139_RCR_AM |
-                   RTL8139_RCR_AB | RTL8139_RCR_WRAP | RTL8139_RCR_RBLEN_8K |
+                   RTL8139_RCR_AB | RTL8139_RCR_WRAP | RTL8139_RCR_RBLEN |
                    (4 << 13) | (4 << 8);
     rtl8139_write32(rtl_ctx, RTL8139_RCR, rcr);
 
@@ -148,13 +152,19 @@ static int rtl8139_init_context(void *ctx, device_t *device) {
     rtl8139_write32(rtl_ctx, RTL8139_TCR, tcr);
 
     rtl8139_write32(rtl_ctx, RTL8139_RXBUF, (uint32_t)(uintptr_t)rtl_ctx->rx_buffer);
+
+    // Each TX descriptor owns one buffer for good
+    for (int i = 0; i < RTL8139_TX_DESCS; i++) {
+        rtl8139_write32(rtl_ctx, RTL8139_TXADDR0 + (i * 4), (uint32_t)(uintptr_t)rtl_ctx->tx_buffers[i]);
+    }
     rtl8139_write16(rtl_ctx, RTL8139_CAPR, 0xFFF0);
-    rtl8139_write32(rtl_ctx, 0x4C, 0);
+    rtl8139_write32(rtl_ctx, RTL8139_MPC, 0);
 
     rtl8139_write8(rtl_ctx, RTL8139_CMD, RTL8139_CMD_RE | RTL8139_CMD_TE);
     rtl8139_write16(rtl_ctx, RTL8139_ISR, 0xFFFF);
     rtl8139_write16(rtl_ctx, RTL8139_IMR, RTL8139_INT_RXOK | RTL8139_INT_RXERR);
 
+    rtl_ctx->stats = (net_stats_t){0};
     rtl_ctx->initialized = true;
     log_info(rtl_log, "Driver initialized successfully\n");
     return 0;
@@ -170,7 +180,8 @@ static const driver_t rtl8139_driver = {
     .type = DRIVER_TYPE_NETWORK,
     .id_table = rtl8139_id_table,
     .init_context = rtl8139_init_context,
-    .deinit_context = rtl8139_deinit_context
+    .deinit_context = rtl8139_deinit_context,
+    .netdev_ops = &rtl8139_netdev_ops
 };
 
 const driver_t* rtl8139_get_driver(void) {
@@ -193,61 +204,394 @@ int rtl8139_get_mac(rtl8139_t *ctx, uint8_t mac[6]) {
     return 0;
 }
 
+uint32_t rtl8139_get_caps(rtl8139_t *ctx) {
+    (void)ctx;
+
+    // No offloads supported yet
+    return 0;
+}
+
+int rtl8139_get_stats(rtl8139_t *ctx, net_stats_t *stats) {
+    if (!ctx || !stats || !ctx->initialized) {
+        return -1;
+    }
+
+    // MPC counts frames lost to a full RX ring; writing it clears it
+    ctx->stats.rx_dropped += rtl8139_read32(ctx, RTL8139_MPC) & 0xFFFFFF;
+    rtl8139_write32(ctx, RTL8139_MPC, 0);
+
+    *stats = ctx->stats;
+    return 0;
+}
+
+// Read the next packet from the RX ring and advance CAPR
+// Returns 1 if a packet was copied, 0 if no packet is available, -1 if a packet was dropped
+// Ring offset of the header following a frame of packet_length bytes (which
+// includes the CRC); headers are dword aligned
+static inline uint16_t rtl8139_rx_advance(uint16_t offset, uint32_t packet_length) {
+    return (uint16_t)(((offset + packet_length + 4 + 3) & ~3u) % RTL8139_RX_RING_SIZE);
+}
+
+// Copy every complete frame between the software read position and CBR
+// CBR is read and CAPR written once per call; frames too large for the
+// caller's buffers are dropped. Returns the number of frames copied.
+static int rtl8139_rx_batch(rtl8139_t *ctx, uint8_t *const buffers[], size_t buffer_size,
+                            size_t lengths[], int max_packets) {
+    uint16_t write_offset = rtl8139_read16(ctx, RTL8139_CBR) % RTL8139_RX_RING_SIZE;
+    uint16_t offset = ctx->rx_offset;
+
+    int received = 0;
+    while (received < max_packets && offset != write_offset) {
+        uint16_t packet_status = *(volatile uint16_t *)(ctx->rx_buffer + offset);
+        uint16_t packet_length = *(volatile uint16_t *)(ctx->rx_buffer + offset + 2);
+
+        if ((packet_status & 0x01) == 0 || packet_length < 4 || packet_length > RTL8139_RX_MAX_FRAME) {
+            break;
+        }
+
+        size_t frame_length = packet_length - 4;
+        if (frame_length <= buffer_size) {
+            memcpy(buffers[received], (const uint8_t *)(uintptr_t)(ctx->rx_buffer + offset + 4), frame_length);
+            lengths[received] = frame_length;
+            received++;
+        } else {
+            ctx->stats.rx_dropped++;
+        }
+
+        offset = rtl8139_rx_advance(offset, packet_length);
+    }
+
+    if (offset != ctx->rx_offset) {
+        ctx->rx_offset = offset;
+        rtl8139_write16(ctx, RTL8139_CAPR, (uint16_t)(offset - 16));
+
+        uint16_t isr = rtl8139_read16(ctx, RTL8139_ISR);
+        if (isr != 0) {
+            rtl8139_write16(ctx, RTL8139_ISR, isr);
+        }
+    }
+
+    ctx->stats.rx_packets += received;
+    return received;
+}
+
 int rtl8139_receive(rtl8139_t *ctx, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
     if (!ctx || !buffer || !received_length || !ctx->initialized) {
         return -1;
     }
 
-    if ((rtl8139_read8(ctx, RTL8139_CMD) & RTL8139_CMD_BUFE) != 0) {
+    return rtl8139_rx_batch(ctx, &buffer, buffer_size, received_length, 1) > 0 ? 0 : -1;
+}
+
+int rtl8139_receive_burst(rtl8139_t *ctx, uint8_t *const buffers[], size_t buffer_size,
+                          size_t lengths[], int max_packets) {
+    if (!ctx || !buffers || !lengths || max_packets < 0 || !ctx->initialized) {
         return -1;
     }
 
-    uint16_t offset = (rtl8139_read16(ctx, RTL8139_CAPR) + 16) % 8192;
+    return rtl8139_rx_batch(ctx, buffers, buffer_size, lengths, max_packets);
+}
 
-    for (volatile int i = 0; i < 1000; i++);
+int rtl8139_rx_acquire(rtl8139_t *ctx, net_rx_frame_t frames[], int max_frames) {
+    if (!ctx || !frames || max_frames < 0 || !ctx->initialized) {
+        return -1;
+    }
 
-    uint16_t packet_status = *(uint16_t *)(ctx->rx_buffer + offset);
-    uint16_t packet_length = *(uint16_t *)(ctx->rx_buffer + offset + 2);
+    // CBR is the NIC write position; everything between rx_offset and CBR
+    // is complete packets (WRAP keeps each packet contiguous past the ring end)
+    uint16_t write_offset = rtl8139_read16(ctx, RTL8139_CBR) % RTL8139_RX_RING_SIZE;
 
-    if ((packet_status & 0x01) == 0 || packet_length < 4) {
-        return -1;
+    int acquired = 0;
+    while (acquired < max_frames && ctx->rx_offset != write_offset) {
+        uint16_t offset = ctx->rx_offset;
+        uint16_t packet_status = *(volatile uint16_t *)(ctx->rx_buffer + offset);
+        uint16_t packet_length = *(volatile uint16_t *)(ctx->rx_buffer + offset + 2);
+
+        if ((packet_status & 0x01) == 0 || packet_length < 4 || packet_length > RTL8139_RX_MAX_FRAME) {
+            break;
+        }
+
+        frames[acquired].data = (const uint8_t *)(uintptr_t)(ctx->rx_buffer + offset + 4);
+        frames[acquired].length = packet_length - 4;
+        frames[acquired].slot = offset;
+        frames[acquired].flags = 0;
+        acquired++;
+
+        ctx->rx_offset = rtl8139_rx_advance(offset, packet_length);
     }
 
-    uint16_t isr = rtl8139_read16(ctx, RTL8139_ISR);
-    if (isr != 0) {
-        rtl8139_write16(ctx, RTL8139_ISR, isr);
+    if (acquired > 0) {
+        ctx->stats.rx_packets += acquired;
+        uint16_t isr = rtl8139_read16(ctx, RTL8139_ISR);
+        if (isr != 0) {
+            rtl8139_write16(ctx, RTL8139_ISR, isr);
+        }
     }
 
-    packet_length -= 4;
-    if (packet_length > buffer_size) {
+    return acquired;
+}
+
+int rtl8139_rx_release(rtl8139_t *ctx, const net_rx_frame_t frames[], int count) {
+    if (!ctx || !frames || count < 0 || !ctx->initialized) {
         return -1;
     }
 
-    for (size_t i = 0; i < packet_length; i++) {
-        buffer[i] = ctx->rx_buffer[(offset + 4 + i) % 8192];
+    if (count == 0) {
+        return 0;
     }
 
-    *received_length = packet_length;
-    offset = ((offset + packet_length + 4 + 3) & ~3) % 8192;
+    // Frames are released in ring order: move CAPR past the last one
+    const net_rx_frame_t *last = &frames[count - 1];
+    uint16_t offset = rtl8139_rx_advance((uint16_t)last->slot, last->length + 4);
     rtl8139_write16(ctx, RTL8139_CAPR, (uint16_t)(offset - 16));
 
     return 0;
 }
 
-int rtl8139_transmit(rtl8139_t *ctx, const uint8_t *buffer, size_t length) {
-    if (!ctx || !buffer || !ctx->initialized || length > 2048 || length < 1) {
-        return -1;
+// Retire TX descriptors whose frame the NIC has finished with, oldest first
+// A descriptor is only reused once TSD reports the transmission done (TOK) or
+// failed (underrun, abort); OWN alone only means the frame reached the FIFO.
+static void rtl8139_tx_reclaim(rtl8139_t *ctx) {
+    while (ctx->tx_inflight > 0) {
+        uint32_t status = rtl8139_read32(ctx, RTL8139_TXSTATUS0 + (ctx->tx_clean * 4));
+        if ((status & (RTL8139_TSD_TOK | RTL8139_TSD_TUN | RTL8139_TSD_TABT)) == 0) {
+            break;
+        }
+        ctx->tx_clean = (ctx->tx_clean + 1) % RTL8139_TX_DESCS;
+        ctx->tx_inflight--;
     }
+}
 
+// Whether a TX descriptor is free next to those in flight and reserved
+static bool rtl8139_tx_has_room(rtl8139_t *ctx) {
+    if (ctx->tx_inflight + ctx->tx_reserved < RTL8139_TX_DESCS) {
+        return true;
+    }
+    rtl8139_tx_reclaim(ctx);
+    return ctx->tx_inflight + ctx->tx_reserved < RTL8139_TX_DESCS;
+}
+
+// Start the frame in the buffer of descriptor tx_current; writing the length
+// to TSD clears OWN and hands the buffer to the NIC
+static void rtl8139_tx_start(rtl8139_t *ctx, size_t length) {
     uint8_t descriptor = ctx->tx_current;
 
+    __sync_synchronize();
+    rtl8139_write32(ctx, RTL8139_TXSTATUS0 + (descriptor * 4), (uint32_t)length);
+
+    ctx->tx_current = (descriptor + 1) % RTL8139_TX_DESCS;
+    ctx->tx_inflight++;
+}
+
+// Copy one frame into the next descriptor and start it
+// Returns 0 if started, -1 if the frame is invalid, NET_TX_AGAIN if no
+// descriptor is free
+static int rtl8139_tx_send(rtl8139_t *ctx, const uint8_t *buffer, size_t length) {
+    if (!buffer || length > RTL8139_TX_BUFFER_SIZE || length < 1) {
+        return -1;
+    }
+
+    // Frames already reserved for zero-copy go out first
+    if (ctx->tx_reserved != 0 || !rtl8139_tx_has_room(ctx)) {
+        return NET_TX_AGAIN;
+    }
+
+    uint8_t *tx_buffer = ctx->tx_buffers[ctx->tx_current];
     for (size_t i = 0; i < length; i++) {
-        ctx->tx_buffer[i] = buffer[i];
+        tx_buffer[i] = buffer[i];
     }
 
-    rtl8139_write32(ctx, RTL8139_TXADDR0 + (descriptor * 4), (uint32_t)(uintptr_t)ctx->tx_buffer);
-    rtl8139_write32(ctx, RTL8139_TXSTATUS0 + (descriptor * 4), (uint32_t)length);
+    rtl8139_tx_start(ctx, length);
+    return 0;
+}
+
+int rtl8139_transmit(rtl8139_t *ctx, const uint8_t *buffer, size_t length) {
+    if (!ctx || !ctx->initialized) {
+        return -1;
+    }
+
+    int result = rtl8139_tx_send(ctx, buffer, length);
+    if (result == NET_TX_AGAIN) {
+        ctx->stats.tx_dropped++;
+        return -1;
+    }
+    if (result == 0) {
+        ctx->stats.tx_packets++;
+    }
+    return result;
+}
+
+int rtl8139_transmit_burst(rtl8139_t *ctx, const uint8_t *const packets[], const size_t lengths[], int count) {
+    if (!ctx || !packets || !lengths || count < 0 || !ctx->initialized) {
+        return -1;
+    }
+
+    int sent = 0;
+    while (sent < count) {
+        int result = rtl8139_tx_send(ctx, packets[sent], lengths[sent]);
+        if (result == NET_TX_AGAIN) {
+            ctx->stats.tx_dropped += (uint64_t)(count - sent);
+        }
+        if (result != 0) {
+            break;
+        }
+        sent++;
+    }
+
+    ctx->stats.tx_packets += sent;
+    return sent;
+}
+
+int rtl8139_tx_alloc(rtl8139_t *ctx, net_tx_slot_t *slot) {
+    if (!ctx || !slot || !ctx->initialized) {
+        return -1;
+    }
+
+    if (!rtl8139_tx_has_room(ctx)) {
+        ctx->stats.tx_dropped++;
+        return -1;
+    }
+
+    uint8_t descriptor = (ctx->tx_current + ctx->tx_reserved) % RTL8139_TX_DESCS;
+    ctx->tx_reserved++;
+
+    slot->data = ctx->tx_buffers[descriptor] + RTL8139_TX_HEADROOM;
+    slot->capacity = RTL8139_TX_BUFFER_SIZE - RTL8139_TX_HEADROOM;
+    slot->slot = descriptor;
+    slot->offload.csum_start = 0;
+    slot->offload.csum_offset = 0;
+    slot->offload.gso_size = 0;
 
-    ctx->tx_current = (ctx->tx_current + 1) % 4;
     return 0;
 }
+
+int rtl8139_tx_commit(rtl8139_t *ctx, const net_tx_slot_t slots[], const size_t lengths[], int count) {
+    if (!ctx || !slots || !lengths || count < 0 || count > ctx->tx_reserved || !ctx->initialized) {
+        return -1;
+    }
+
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        // Slots come back in allocation order, which is descriptor order
+        if (slots[i].slot != ctx->tx_current) {
+            break;
+        }
+        // Descriptors are used strictly in turn, so an invalid frame cannot
+        // be skipped: it is dropped together with every later reservation
+        size_t length = lengths[i];
+        if (length < 1 || length > RTL8139_TX_BUFFER_SIZE - RTL8139_TX_HEADROOM) {
+            ctx->tx_reserved = 0;
+            break;
+        }
+        ctx->tx_reserved--;
+
+        // TSAD must be dword aligned: move the frame down over the headroom
+        uint8_t *tx_buffer = ctx->tx_buffers[ctx->tx_current];
+        for (size_t j = 0; j < length; j++) {
+            tx_buffer[j] = tx_buffer[j + RTL8139_TX_HEADROOM];
+        }
+        rtl8139_tx_start(ctx, length);
+        sent++;
+    }
+
+    ctx->stats.tx_packets += sent;
+    return sent;
+}
+
+// netdev_ops_t entry points
+
+static rtl8139_t rtl8139_netdev_contexts[NETDEV_MAX_CONTEXTS];
+
+int rtl8139_netdev_get_mac(void *ctx, uint8_t mac[6]) {
+    return rtl8139_get_mac(ctx, mac);
+}
+
+uint32_t rtl8139_netdev_get_caps(void *ctx) {
+    return rtl8139_get_caps(ctx);
+}
+
+int rtl8139_netdev_get_queue_count(void *ctx) {
+    (void)ctx;
+    return 1;
+}
+
+int rtl8139_netdev_get_stats(void *ctx, net_stats_t *stats) {
+    return rtl8139_get_stats(ctx, stats);
+}
+
+int rtl8139_netdev_wait(void *ctx, uint16_t queue) {
+    (void)ctx;
+    (void)queue;
+
+    // No interrupt support: callers keep polling
+    return -1;
+}
+
+int rtl8139_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length) {
+    (void)queue;
+    return rtl8139_transmit(ctx, packet, length);
+}
+
+int rtl8139_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    (void)queue;
+    return rtl8139_receive(ctx, buffer, buffer_size, received_length);
+}
+
+int rtl8139_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                                 size_t lengths[], int max_packets) {
+    (void)queue;
+    return rtl8139_receive_burst(ctx, buffers, buffer_size, lengths, max_packets);
+}
+
+int rtl8139_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                                  int count) {
+    (void)queue;
+    return rtl8139_transmit_burst(ctx, packets, lengths, count);
+}
+
+int rtl8139_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames) {
+    (void)queue;
+    return rtl8139_rx_acquire(ctx, frames, max_frames);
+}
+
+int rtl8139_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count) {
+    (void)queue;
+    return rtl8139_rx_release(ctx, frames, count);
+}
+
+int rtl8139_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot) {
+    (void)queue;
+    return rtl8139_tx_alloc(ctx, slot);
+}
+
+int rtl8139_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count) {
+    (void)queue;
+    return rtl8139_tx_commit(ctx, slots, lengths, count);
+}
+
+int rtl8139_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                                const net_tx_frag_t frags[], int frag_count) {
+    (void)queue;
+    // No scatter-gather support: copy the fragments behind the slot data
+    size_t total = net_tx_linearize(slot, length, frags, frag_count);
+    return rtl8139_tx_commit(ctx, slot, &total, 1) == 1 ? 0 : -1;
+}
+
+const netdev_ops_t rtl8139_netdev_ops = {
+    .contexts = rtl8139_netdev_contexts,
+    .context_size = sizeof(rtl8139_t),
+    .get_mac = rtl8139_netdev_get_mac,
+    .get_caps = rtl8139_netdev_get_caps,
+    .get_queue_count = rtl8139_netdev_get_queue_count,
+    .get_stats = rtl8139_netdev_get_stats,
+    .wait = rtl8139_netdev_wait,
+    .transmit = rtl8139_netdev_transmit,
+    .receive = rtl8139_netdev_receive,
+    .receive_burst = rtl8139_netdev_receive_burst,
+    .transmit_burst = rtl8139_netdev_transmit_burst,
+    .rx_acquire = rtl8139_netdev_rx_acquire,
+    .rx_release = rtl8139_netdev_rx_release,
+    .tx_alloc = rtl8139_netdev_tx_alloc,
+    .tx_commit = rtl8139_netdev_tx_commit,
+    .tx_commit_sg = rtl8139_netdev_tx_commit_sg
+};
@@ -21,6 +21,7 @@
 #define RTL8139_ISR             0x3E    // Interrupt Status Register
 #define RTL8139_TCR             0x40    // Transmit Configuration
 #define RTL8139_RCR             0x44    // Receive Configuration
+#define RTL8139_MPC             0x4C    // Missed Packet Counter (24 bits)
 #define RTL8139_CONFIG1         0x52    // Configuration Register 1
 
 // Command Register Bits
@@ -57,10 +58,27 @@
 
 // Transmit Status Register Bits
 #define RTL8139_TSD_OWN         (1 << 13) // DMA operation completed
+#define RTL8139_TSD_TUN         (1 << 14) // Transmit FIFO Underrun
 #define RTL8139_TSD_TOK         (1 << 15) // Transmit OK
+#define RTL8139_TSD_TABT        (1u << 30) // Transmit Abort
 
-// RX Buffer size (8KB + 16 bytes for wrap + 1.5KB for overflow)
-#define RTL8139_RX_BUFFER_SIZE  (8192 + 16 + 1536)
+// Number of hardware TX descriptors (TSD/TSAD register pairs)
+#define RTL8139_TX_DESCS        4
+#define RTL8139_TX_BUFFER_SIZE  2048
+// Frames built via rtl8139_tx_alloc() start 2 bytes into their buffer so the
+// IP header is 4-byte aligned
+#define RTL8139_TX_HEADROOM     2
+
+// RX ring length selected by RCR RBLEN; with WRAP set the NIC writes a frame
+// past the ring end instead of wrapping it, so every frame is contiguous
+#define RTL8139_RX_RING_SIZE    32768
+#define RTL8139_RCR_RBLEN       RTL8139_RCR_RBLEN_32K
+
+// RX Buffer size (ring + 16 bytes for wrap + 1.5KB for overflow)
+#define RTL8139_RX_BUFFER_SIZE  (RTL8139_RX_RING_SIZE + 16 + 1536)
+
+// Largest frame the NIC stores in the ring, including the trailing CRC
+#define RTL8139_RX_MAX_FRAME    1536
 
 /**
  * RTL8139 device context
@@ -70,10 +88,15 @@ typedef struct {
     bool initialized;
     bool use_mmio;
     uint8_t mac_addr[6];
-    uint16_t rx_offset;
+    uint16_t rx_offset;     // Software read position in the RX ring
     volatile uint8_t rx_buffer[RTL8139_RX_BUFFER_SIZE] __attribute__((aligned(16)));
-    uint8_t tx_current;
-    uint8_t tx_buffer[2048] __attribute__((aligned(8)));
+    // One buffer per TX descriptor; TSAD must be dword aligned
+    uint8_t tx_buffers[RTL8139_TX_DESCS][RTL8139_TX_BUFFER_SIZE] __attribute__((aligned(16)));
+    uint8_t tx_current;     // Next TX descriptor to start (after any reserved)
+    uint8_t tx_clean;       // Oldest TX descriptor not yet completed
+    uint8_t tx_inflight;    // TX descriptors started and not yet completed
+    uint8_t tx_reserved;    // TX descriptors handed out by rtl8139_tx_alloc(), not yet committed
+    net_stats_t stats;      // Software counters plus the missed packets read from MPC
 } __attribute__((aligned(16))) rtl8139_t;
 
 /**
@@ -90,6 +113,21 @@ const driver_t* rtl8139_get_driver(void);
  */
 int rtl8139_get_mac(rtl8139_t *ctx, uint8_t mac[6]);
 
+/**
+ * Get offload capabilities of rtl8139 device
+ * @param ctx Device context from driver initialization
+ * @return NET_CAP_* flags
+ */
+uint32_t rtl8139_get_caps(rtl8139_t *ctx);
+
+/**
+ * Get packet counters of rtl8139 device
+ * @param ctx Device context from driver initialization
+ * @param stats Receives the totals since initialization
+ * @return 0 on success, -1 on error
+ */
+int rtl8139_get_stats(rtl8139_t *ctx, net_stats_t *stats);
+
 /**
  * Receive a packet from rtl8139 device
  * @param ctx Device context from driver initialization
@@ -102,9 +140,104 @@ int rtl8139_receive(rtl8139_t *ctx, uint8_t *buffer, size_t buffer_size, size_t
 
 /**
  * Transmit a packet using rtl8139 device
+ * The frame is copied into the next free TX descriptor's buffer; up to
+ * RTL8139_TX_DESCS frames are in flight at once.
  * @param ctx Device context from driver initialization
  * @param buffer Buffer containing packet to transmit
  * @param length Length of the packet
  * @return 0 on success, -1 on error
  */
 int rtl8139_transmit(rtl8139_t *ctx, const uint8_t *buffer, size_t length);
+
+/**
+ * Receive up to max_packets packets from rtl8139 device
+ * Pending frames are copied in one pass over the RX ring with a single
+ * CBR read and CAPR update; frames larger than buffer_size are dropped.
+ * @param ctx Device context from driver initialization
+ * @param buffers Array of max_packets receive buffers
+ * @param buffer_size Size of each receive buffer
+ * @param lengths Array receiving the length of each packet
+ * @param max_packets Maximum number of packets to receive
+ * @return Number of packets received (0 if none available), -1 on error
+ */
+int rtl8139_receive_burst(rtl8139_t *ctx, uint8_t *const buffers[], size_t buffer_size,
+                          size_t lengths[], int max_packets);
+
+/**
+ * Transmit up to count packets using rtl8139 device
+ * Fills every free TX descriptor without waiting for earlier frames, so at
+ * most RTL8139_TX_DESCS packets go out per call.
+ * @param ctx Device context from driver initialization
+ * @param packets Array of packet pointers
+ * @param lengths Array of packet lengths in bytes
+ * @param count Number of packets
+ * @return Number of packets sent (may be less than count), -1 on error
+ */
+int rtl8139_transmit_burst(rtl8139_t *ctx, const uint8_t *const packets[], const size_t lengths[], int count);
+
+/**
+ * Borrow received frames from rtl8139 device without copying
+ * Frames point into the RX ring buffer and must be returned with
+ * rtl8139_rx_release() in the order they were acquired.
+ * @param ctx Device context from driver initialization
+ * @param frames Array receiving up to max_frames frame descriptors
+ * @param max_frames Maximum number of frames to acquire
+ * @return Number of frames acquired (0 if none available), -1 on error
+ */
+int rtl8139_rx_acquire(rtl8139_t *ctx, net_rx_frame_t frames[], int max_frames);
+
+/**
+ * Return borrowed frames to rtl8139 device
+ * Advances CAPR past the last released frame.
+ * @param ctx Device context from driver initialization
+ * @param frames Frames previously returned by rtl8139_rx_acquire()
+ * @param count Number of frames
+ * @return 0 on success, -1 on error
+ */
+int rtl8139_rx_release(rtl8139_t *ctx, const net_rx_frame_t frames[], int count);
+
+/**
+ * Reserve a TX buffer so a frame can be built in place
+ * The frame is built 2 bytes into a TX descriptor's buffer and moved to its
+ * start on commit, because the NIC requires dword-aligned TX buffers.
+ * @param ctx Device context from driver initialization
+ * @param slot Filled with the writable frame area
+ * @return 0 on success, -1 if no TX descriptor is free
+ */
+int rtl8139_tx_alloc(rtl8139_t *ctx, net_tx_slot_t *slot);
+
+/**
+ * Transmit frames built in slots from rtl8139_tx_alloc()
+ * Slots must be committed in the order they were allocated. An invalid
+ * length drops that frame and releases every slot still reserved.
+ * @param ctx Device context from driver initialization
+ * @param slots Slots returned by rtl8139_tx_alloc()
+ * @param lengths Frame length written into each slot
+ * @param count Number of slots
+ * @return Number of frames sent (stops at the first out-of-order slot), -1 on error
+ */
+int rtl8139_tx_commit(rtl8139_t *ctx, const net_tx_slot_t slots[], const size_t lengths[], int count);
+
+/**
+ * netdev_ops_t entry points, registered as rtl8139_get_driver()->netdev_ops
+ * They wrap the functions above with a void * context and a queue
+ * index, which rtl8139 ignores.
+ */
+extern const netdev_ops_t rtl8139_netdev_ops;
+int rtl8139_netdev_get_mac(void *ctx, uint8_t mac[6]);
+uint32_t rtl8139_netdev_get_caps(void *ctx);
+int rtl8139_netdev_get_queue_count(void *ctx);
+int rtl8139_netdev_get_stats(void *ctx, net_stats_t *stats);
+int rtl8139_netdev_wait(void *ctx, uint16_t queue);
+int rtl8139_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length);
+int rtl8139_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+int rtl8139_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                                 size_t lengths[], int max_packets);
+int rtl8139_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                                  int count);
+int rtl8139_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+int rtl8139_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+int rtl8139_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot);
+int rtl8139_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count);
+int rtl8139_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                                const net_tx_frag_t frags[], int frag_count);
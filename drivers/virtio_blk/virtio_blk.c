@@ -1,4 +1,9 @@
 #include "virtio_blk.h"
+#include "../../kernel/devices/virtio_mmio.h"
+#include "../../common/common.h"
+
+// Polls for a request to complete before giving up on the device
+#define VIRTIO_BLK_TIMEOUT         10000000
 
 // Device ID table for matching
 static const device_id_t virtio_blk_id_table[] = {
@@ -8,15 +13,116 @@ static const device_id_t virtio_blk_id_table[] = {
 
 // Lifecycle hooks
 static int virtio_blk_init_context(void *ctx, device_t *device) {
-    // TODO: Initialize VirtIO block device context
-    (void)ctx;
-    (void)device;
+    if (!ctx || !device) {
+        return -1;
+    }
+
+    virtio_blk_device_t *blk = (virtio_blk_device_t *)ctx;
+    memset(blk, 0, sizeof(*blk));
+    virtio_dev_t *dev = &blk->dev;
+
+    // The device ID table only lists the legacy device
+    virtio_dev_init(dev, device, false);
+    virtio_dev_reset(dev);
+
+    // No device features are needed; MMIO version 2 devices still expect VERSION_1
+    if (virtio_dev_set_features(dev, virtio_dev_get_features(dev) & VIRTIO_F_VERSION_1) != 0) {
+        return -1;
+    }
+
+    if (virtq_setup(dev, &blk->queue, blk->ring_mem, 0, VIRTIO_BLK_QUEUE_SIZE, VIRTQ_MAX_SIZE) != 0) {
+        virtio_dev_set_status(dev, VIRTIO_STATUS_FAILED);
+        return -1;
+    }
+
+    blk->capacity = virtio_dev_config_read32(dev, VIRTIO_BLK_CONFIG_CAPACITY) |
+                    (uint64_t)virtio_dev_config_read32(dev, VIRTIO_BLK_CONFIG_CAPACITY + 4) << 32;
+
+    if (virtio_dev_driver_ok(dev) != 0) {
+        return -1;
+    }
+
+    // Requests are polled to completion
+    virtq_set_interrupt(dev, &blk->queue, false);
+
+    blk->initialized = 1;
     return 0;
 }
 
 static void virtio_blk_deinit_context(void *ctx) {
-    // TODO: Deinitialize VirtIO block device context
-    (void)ctx;
+    if (!ctx) {
+        return;
+    }
+
+    virtio_blk_device_t *blk = (virtio_blk_device_t *)ctx;
+    if (blk->initialized) {
+        virtio_dev_set_status(&blk->dev, 0);
+        blk->initialized = 0;
+    }
+}
+
+// Submit one request on the request queue and wait for the device to answer
+// The request is the header, the data and a device-written status byte
+// Returns 0 if the device completed it with VIRTIO_BLK_S_OK, -1 otherwise
+static int virtio_blk_request(virtio_blk_device_t *blk, uint32_t type, uint64_t sector,
+                              void *buffer, uint32_t count) {
+    if (!blk || !buffer || count == 0 || !blk->initialized) {
+        return -1;
+    }
+
+    // The data descriptor length is 32 bits
+    if (sector >= blk->capacity || count > blk->capacity - sector ||
+        count > 0xFFFFFFFFu / VIRTIO_BLK_SECTOR_SIZE) {
+        return -1;
+    }
+
+    virtqueue_t *vring = &blk->queue;
+    if (vring->size < 3) {
+        return -1;
+    }
+
+    blk->req_hdr.type = type;
+    blk->req_hdr.reserved = 0;
+    blk->req_hdr.sector = sector;
+    blk->req_status = 0xFF;
+
+    // Only one request is ever in flight, so descriptors 0-2 are reused
+    vring->desc[0].addr = (uint64_t)&blk->req_hdr;
+    vring->desc[0].len = sizeof(blk->req_hdr);
+    vring->desc[0].flags = VRING_DESC_F_NEXT;
+    vring->desc[0].next = 1;
+    vring->desc[1].addr = (uint64_t)buffer;
+    vring->desc[1].len = count * VIRTIO_BLK_SECTOR_SIZE;
+    vring->desc[1].flags = VRING_DESC_F_NEXT | (type == VIRTIO_BLK_T_IN ? VRING_DESC_F_WRITE : 0);
+    vring->desc[1].next = 2;
+    vring->desc[2].addr = (uint64_t)&blk->req_status;
+    vring->desc[2].len = 1;
+    vring->desc[2].flags = VRING_DESC_F_WRITE;
+    vring->desc[2].next = 0;
+
+    virtq_push(vring, 0);
+    virtq_notify(&blk->dev, vring);
+
+    uint32_t id, len;
+    for (int i = 0; i < VIRTIO_BLK_TIMEOUT; i++) {
+        if (virtq_pop(vring, &id, &len) == 0) {
+            __sync_synchronize();
+            return (blk->req_status == VIRTIO_BLK_S_OK) ? 0 : -1;
+        }
+    }
+
+    // The device still owns the descriptors and the buffer: stop using it
+    blk->initialized = 0;
+    return -1;
+}
+
+int virtio_blk_read(virtio_blk_device_t *blk, uint64_t sector, void *buffer, uint32_t count) {
+    return virtio_blk_request(blk, VIRTIO_BLK_T_IN, sector, buffer, count);
+}
+
+int virtio_blk_write(virtio_blk_device_t *blk, uint64_t sector, const void *buffer, uint32_t count) {
+    // The device only reads the buffer of an OUT request
+    return virtio_blk_request(blk, VIRTIO_BLK_T_OUT, sector, (void *)(uintptr_t)buffer, count);
 }
 
 // Driver descriptor
@@ -3,16 +3,42 @@
 #include "../../common/types.h"
 #include "../../common/drivers.h"
 #include "../../kernel/devices/devices.h"
+#include "../../kernel/devices/virtqueue.h"
 
 // VirtIO Vendor and Device IDs
 #define VIRTIO_VENDOR_ID           0x1AF4
 #define VIRTIO_BLK_DEVICE_ID       0x1001
 
+// Request queue size the driver asks for (legacy PCI devices impose their own,
+// up to VIRTQ_MAX_SIZE)
+#define VIRTIO_BLK_QUEUE_SIZE      16
+
+// Device-specific configuration space offsets
+#define VIRTIO_BLK_CONFIG_CAPACITY 0    // u64, in 512-byte sectors
+
+#define VIRTIO_BLK_SECTOR_SIZE     512
+
+// Request types and status values
+#define VIRTIO_BLK_T_IN            0    // Read sectors
+#define VIRTIO_BLK_T_OUT           1    // Write sectors
+#define VIRTIO_BLK_S_OK            0
+
+// Request header, followed by the data and a device-written status byte
+typedef struct {
+    uint32_t type;              // VIRTIO_BLK_T_*
+    uint32_t reserved;
+    uint64_t sector;            // First 512-byte sector
+} __attribute__((packed)) virtio_blk_req_hdr_t;
+
 // VirtIO Block Device Structure
 typedef struct {
-    device_t device;
-    uint64_t io_base;
+    virtio_dev_t dev;           // Transport registers (MMIO or legacy PCI)
     int initialized;
+    uint64_t capacity;          // Device size in 512-byte sectors
+    uint8_t ring_mem[VIRTQ_RING_MEM_SIZE(VIRTQ_MAX_SIZE)] __attribute__((aligned(4096)));
+    virtqueue_t queue;          // Request queue (queue 0)
+    virtio_blk_req_hdr_t req_hdr;   // Header of the request in flight
+    volatile uint8_t req_status;    // Status the device writes back
 } virtio_blk_device_t;
 
 /**
@@ -20,3 +46,25 @@ typedef struct {
  * @return Pointer to driver descriptor
  */
 const driver_t* virtio_blk_get_driver(void);
+
+/**
+ * Read sectors from virtio-blk device
+ * Waits for the device to complete the request.
+ * @param blk Initialized device
+ * @param sector First 512-byte sector
+ * @param buffer Receives count * VIRTIO_BLK_SECTOR_SIZE bytes
+ * @param count Number of sectors
+ * @return 0 on success, -1 on error
+ */
+int virtio_blk_read(virtio_blk_device_t *blk, uint64_t sector, void *buffer, uint32_t count);
+
+/**
+ * Write sectors to virtio-blk device
+ * Waits for the device to complete the request.
+ * @param blk Initialized device
+ * @param sector First 512-byte sector
+ * @param buffer Holds count * VIRTIO_BLK_SECTOR_SIZE bytes
+ * @param count Number of sectors
+ * @return 0 on success, -1 on error
+ */
+int virtio_blk_write(virtio_blk_device_t *blk, uint64_t sector, const void *buffer, uint32_t count);
@@ -2,33 +2,43 @@
 #include "../../kernel/devices/virtio_mmio.h"
 #include "../../common/common.h"
 #include "../../common/log.h"
+#include "../../common/params.h"
+#include "../../kernel/platform/platform.h"
 #include "../../apps/network/ethernet/ethernet.h"
 
 static log_tag_t *vnet_log;
 
-// Helper macros to access the correct queue based on transport
-#define GET_RX_DESC(ctx, idx) ((ctx)->transport == VIRTIO_NET_TRANSPORT_PCI ? \
-    &(ctx)->pci_rx_queue.desc[idx] : &(ctx)->mmio_rx_queue.desc[idx])
-#define GET_TX_DESC(ctx, idx) ((ctx)->transport == VIRTIO_NET_TRANSPORT_PCI ? \
-    &(ctx)->pci_tx_queue.desc[idx] : &(ctx)->mmio_tx_queue.desc[idx])
-#define GET_RX_AVAIL(ctx) ((ctx)->transport == VIRTIO_NET_TRANSPORT_PCI ? \
-    &(ctx)->pci_rx_queue.avail : (void*)&(ctx)->mmio_rx_queue.avail)
-#define GET_TX_AVAIL(ctx) ((ctx)->transport == VIRTIO_NET_TRANSPORT_PCI ? \
-    &(ctx)->pci_tx_queue.avail : (void*)&(ctx)->mmio_tx_queue.avail)
-#define GET_RX_USED(ctx) ((ctx)->transport == VIRTIO_NET_TRANSPORT_PCI ? \
-    &(ctx)->pci_rx_queue.used : (void*)&(ctx)->mmio_rx_queue.used)
-#define GET_TX_USED(ctx) ((ctx)->transport == VIRTIO_NET_TRANSPORT_PCI ? \
-    &(ctx)->pci_tx_queue.used : (void*)&(ctx)->mmio_tx_queue.used)
-
 // VirtIO Vendor and Device IDs
 #define VIRTIO_VENDOR_ID                0x1AF4
 #define VIRTIO_NET_SUBSYSTEM_DEVICE_ID  0x0001
 #define VIRTIO_NET_DEVICE_ID_TRANSITIONAL 0x1000
 #define VIRTIO_NET_DEVICE_ID_MODERN     0x1041
 
+// Features the driver accepts when offered by the device
+#define VIRTIO_NET_DRIVER_FEATURES      (VIRTIO_NET_F_CSUM | VIRTIO_NET_F_GUEST_CSUM | \
+                                         VIRTIO_NET_F_HOST_TSO4 | VIRTIO_NET_F_MRG_RXBUF | \
+                                         VIRTIO_RING_F_EVENT_IDX | VIRTIO_F_VERSION_1 | \
+                                         VIRTIO_F_RING_PACKED | VIRTIO_NET_F_CTRL_VQ | VIRTIO_NET_F_MQ | \
+                                         VIRTIO_NET_F_RSS | VIRTIO_RING_F_INDIRECT_DESC)
+
+// Kernel command line parameter limiting the ring size
+#define VIRTIO_NET_QUEUE_SIZE_PARAM     "virtio-net.queue_size"
+
+// Kernel command line parameter limiting the number of queue pairs
+#define VIRTIO_NET_QUEUE_PAIRS_PARAM    "virtio-net.queue_pairs"
+
+// Control commands are polled for completion at most this many times
+#define VIRTIO_NET_CTRL_TIMEOUT         10000000
+
+// Default Toeplitz hash key (the well-known key used by most NIC drivers)
+static const uint8_t virtio_net_rss_key[VIRTIO_NET_RSS_KEY_SIZE] = {
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2, 0x41, 0x67,
+    0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0, 0xd0, 0xca, 0x2b, 0xcb,
+    0xae, 0x7b, 0x30, 0xb4, 0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30,
+    0xf2, 0x0c, 0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa
+};
+
 // VirtIO-Net device-specific configuration space offsets
-#define VIRTIO_MMIO_CONFIG              0x100
-#define VIRTIO_PCI_CONFIG               0x14
 #define VIRTIO_NET_CONFIG_MAC           0
 
 // Device ID table for matching
@@ -44,164 +54,166 @@ static const device_id_t virtio_net_id_table[] = {
 
 typedef virtio_net_t virtio_net_ctx_t;
 
-// Transport-agnostic register access helpers
-static inline uint32_t virtio_read32(virtio_net_t *ctx, uint16_t offset) {
-#if defined(__x86_64__) || defined(__i386__)
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        return io_inl((uint16_t)ctx->io_base + offset);
-    }
-#endif
-    return mmio_read32(ctx->io_base + offset);
-}
-
-static inline uint16_t virtio_read16(virtio_net_t *ctx, uint16_t offset) {
-#if defined(__x86_64__) || defined(__i386__)
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        return io_inw((uint16_t)ctx->io_base + offset);
-    }
-#endif
-    return (uint16_t)mmio_read32(ctx->io_base + offset);
-}
-
-static inline uint8_t virtio_read8(virtio_net_t *ctx, uint16_t offset) {
-#if defined(__x86_64__) || defined(__i386__)
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        return io_inb((uint16_t)ctx->io_base + offset);
+// Pick the offered features the driver accepts
+// TSO needs the device to fill in checksums, so HOST_TSO4 is dropped without CSUM
+static uint64_t virtio_net_select_features(uint64_t device_features) {
+    uint64_t features = device_features & VIRTIO_NET_DRIVER_FEATURES;
+    if (!(features & VIRTIO_NET_F_CSUM)) {
+        features &= ~VIRTIO_NET_F_HOST_TSO4;
     }
-#endif
-    return (uint8_t)mmio_read32(ctx->io_base + offset);
-}
-
-static inline void virtio_write32(virtio_net_t *ctx, uint16_t offset, uint32_t value) {
-#if defined(__x86_64__) || defined(__i386__)
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        io_outl((uint16_t)ctx->io_base + offset, value);
-        return;
+    // The packed layout only exists for VirtIO 1.0 devices
+    if (!(features & VIRTIO_F_VERSION_1)) {
+        features &= ~VIRTIO_F_RING_PACKED;
     }
-#endif
-    mmio_write32(ctx->io_base + offset, value);
-}
-
-static inline void virtio_write16(virtio_net_t *ctx, uint16_t offset, uint16_t value) {
-#if defined(__x86_64__) || defined(__i386__)
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        io_outw((uint16_t)ctx->io_base + offset, value);
-        return;
+    // Queue pairs are configured through the control queue, which has no other use here
+    if (!(features & VIRTIO_NET_F_CTRL_VQ) || !(features & VIRTIO_NET_F_MQ)) {
+        features &= ~(VIRTIO_NET_F_CTRL_VQ | VIRTIO_NET_F_MQ | VIRTIO_NET_F_RSS);
     }
-#endif
-    mmio_write32(ctx->io_base + offset, value);
+    return features;
 }
 
-static inline void virtio_write8(virtio_net_t *ctx, uint16_t offset, uint8_t value) {
-#if defined(__x86_64__) || defined(__i386__)
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        io_outb((uint16_t)ctx->io_base + offset, value);
-        return;
-    }
-#endif
-    mmio_write32(ctx->io_base + offset, value);
+// Store a little-endian 16-bit value into a command buffer
+static void virtio_net_put16(uint8_t *ptr, uint16_t value) {
+    ptr[0] = (uint8_t)value;
+    ptr[1] = (uint8_t)(value >> 8);
 }
 
-static int virtio_net_init_virtqueue(virtio_net_t *ctx, uint16_t queue_index) {
-#if defined(__x86_64__) || defined(__i386__)
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        // PCI legacy virtio uses different register offsets
-        virtio_write16(ctx, VIRTIO_PCI_QUEUE_SEL, queue_index);
-
-        // Read max queue size
-        uint32_t max_queue_size = virtio_read16(ctx, VIRTIO_PCI_QUEUE_NUM);
-        if (max_queue_size == 0 || max_queue_size < VIRTIO_NET_QUEUE_SIZE) {
-            return -1;
-        }
-
-        // For PCI legacy, use the full queue structure sized for max_queue_size
-        // Zero out the appropriate queue
-        void *queue_ptr;
-        if (queue_index == 0) {
-            memset(&ctx->pci_rx_queue, 0, sizeof(virtio_net_queue_pci_t));
-            queue_ptr = &ctx->pci_rx_queue;
-        } else {
-            memset(&ctx->pci_tx_queue, 0, sizeof(virtio_net_queue_pci_t));
-            queue_ptr = &ctx->pci_tx_queue;
-        }
-
-        uint64_t queue_addr = (uint64_t)queue_ptr;
-        uint32_t queue_pfn = queue_addr >> 12;
-
-        if (log_enabled(vnet_log, LOG_DEBUG)) {
-            log_prefix(vnet_log, LOG_DEBUG);
-            puts("Queue addr: 0x");
-            put_hex64(queue_addr);
-            puts(" PFN: 0x");
-            put_hex32(queue_pfn);
-            puts("\n");
-        }
-
-        virtio_write32(ctx, VIRTIO_PCI_QUEUE_PFN, queue_pfn);
-
-        uint32_t readback_pfn = virtio_read32(ctx, VIRTIO_PCI_QUEUE_PFN);
-        if (readback_pfn != queue_pfn) {
-            if (log_enabled(vnet_log, LOG_ERROR)) {
-                log_prefix(vnet_log, LOG_ERROR);
-                puts("PFN mismatch! Expected: 0x");
-                put_hex32(queue_pfn);
-                puts(" Got: 0x");
-                put_hex32(readback_pfn);
-                puts("\n");
-            }
-            return -1;
+// Hand every RX buffer of a queue pair to the device
+// Apply alignment offset for ARM64 to ensure IP header 4-byte alignment
+static void virtio_net_rx_fill(virtio_net_t *ctx, virtio_net_queue_pair_t *qp) {
+    if (qp->rx_vring.packed) {
+        for (uint16_t i = 0; i < ctx->queue_size; i++) {
+            uint16_t flags;
+            uint16_t pos = virtq_packed_fill(&qp->rx_vring, (uint64_t)&qp->rx_buffers[i][ctx->buf_offset],
+                                             VIRTIO_NET_MAX_PACKET_SIZE - ctx->buf_offset,
+                                             i, VRING_DESC_F_WRITE, true, &flags);
+            virtq_packed_publish(&qp->rx_vring, pos, flags, 1);
         }
-
-        return 0;
-    }
-#endif
-
-    // MMIO transport
-    if (queue_index == 0) {
-        memset(&ctx->mmio_rx_queue, 0, sizeof(virtio_net_queue_t));
+        qp->rx_vring.kicked_idx = qp->rx_vring.avail_idx;
     } else {
-        memset(&ctx->mmio_tx_queue, 0, sizeof(virtio_net_queue_t));
+        for (uint16_t i = 0; i < ctx->queue_size; i++) {
+            virtq_desc_t *desc = &qp->rx_vring.desc[i];
+            desc->addr = (uint64_t)&qp->rx_buffers[i][ctx->buf_offset];
+            desc->len = VIRTIO_NET_MAX_PACKET_SIZE - ctx->buf_offset;
+            desc->flags = VRING_DESC_F_WRITE;
+            desc->next = 0;
+            qp->rx_vring.avail->ring[i] = i;
+        }
+        qp->rx_vring.avail->idx = ctx->queue_size;
+        qp->rx_vring.kicked_idx = ctx->queue_size;
     }
 
-    virtio_write16(ctx, VIRTIO_MMIO_QUEUE_SEL, queue_index);
+    // We poll both queues, so ask the device not to interrupt us
+    virtq_set_interrupt(&ctx->dev, &qp->rx_vring, false);
+    virtq_set_interrupt(&ctx->dev, &qp->tx_vring, false);
+}
 
-    uint32_t queue_size = virtio_read32(ctx, VIRTIO_MMIO_QUEUE_NUM_MAX);
-    if (queue_size == 0 || queue_size < VIRTIO_NET_QUEUE_SIZE) {
+// Send a command on the control queue and wait for the device to answer
+// The command is a header, the command data and a device-written ack byte
+// Returns 0 if the device acknowledged with VIRTIO_NET_OK, -1 otherwise
+static int virtio_net_ctrl_cmd(virtio_net_t *ctx, uint8_t class, uint8_t command,
+                               const uint8_t *data, size_t length) {
+    virtqueue_t *vring = &ctx->ctrl_vring;
+    if (vring->size < 4 || sizeof(virtio_net_ctrl_hdr_t) + length + 1 > VIRTIO_NET_CTRL_BUF_SIZE) {
         return -1;
     }
 
-    virtio_write32(ctx, VIRTIO_MMIO_QUEUE_NUM, VIRTIO_NET_QUEUE_SIZE);
-    virtio_write32(ctx, VIRTIO_MMIO_QUEUE_ALIGN, 4096);
+    virtio_net_ctrl_hdr_t *hdr = (virtio_net_ctrl_hdr_t *)ctx->ctrl_buf;
+    hdr->class = class;
+    hdr->command = command;
+    memcpy(ctx->ctrl_buf + sizeof(*hdr), data, length);
+    volatile uint8_t *ack = ctx->ctrl_buf + sizeof(*hdr) + length;
+    *ack = 0xFF;
+
+    uint64_t hdr_addr = (uint64_t)ctx->ctrl_buf;
+    uint64_t data_addr = hdr_addr + sizeof(*hdr);
+    uint64_t ack_addr = data_addr + length;
+
+    if (vring->packed) {
+        uint16_t head_flags, flags;
+        uint16_t head = virtq_packed_fill(vring, hdr_addr, sizeof(*hdr), 0, VRING_DESC_F_NEXT, true, &head_flags);
+        virtq_packed_fill(vring, data_addr, length, 0, VRING_DESC_F_NEXT, false, &flags);
+        virtq_packed_fill(vring, ack_addr, 1, 0, VRING_DESC_F_WRITE, false, &flags);
+        virtq_packed_publish(vring, head, head_flags, 3);
+    } else {
+        // Only one command is ever in flight, so descriptors 0-2 are reused
+        vring->desc[0].addr = hdr_addr;
+        vring->desc[0].len = sizeof(*hdr);
+        vring->desc[0].flags = VRING_DESC_F_NEXT;
+        vring->desc[0].next = 1;
+        vring->desc[1].addr = data_addr;
+        vring->desc[1].len = length;
+        vring->desc[1].flags = VRING_DESC_F_NEXT;
+        vring->desc[1].next = 2;
+        vring->desc[2].addr = ack_addr;
+        vring->desc[2].len = 1;
+        vring->desc[2].flags = VRING_DESC_F_WRITE;
+        vring->desc[2].next = 0;
+
+        virtq_push(vring, 0);
+    }
 
-    void *queue_ptr = (queue_index == 0) ? (void*)&ctx->mmio_rx_queue : (void*)&ctx->mmio_tx_queue;
-    uint64_t queue_addr = (uint64_t)queue_ptr;
-    uint32_t queue_pfn = queue_addr >> 12;
+    virtq_notify(&ctx->dev, vring);
 
-    if (log_enabled(vnet_log, LOG_DEBUG)) {
-        log_prefix(vnet_log, LOG_DEBUG);
-        puts("Queue addr: 0x");
-        put_hex64(queue_addr);
-        puts(" PFN: 0x");
-        put_hex32(queue_pfn);
-        puts("\n");
+    for (int i = 0; i < VIRTIO_NET_CTRL_TIMEOUT; i++) {
+        if (virtq_has_used(vring)) {
+            if (vring->packed) {
+                virtq_packed_consume(vring, 3);
+            }
+            vring->last_used++;
+            __sync_synchronize();
+            return (*ack == VIRTIO_NET_OK) ? 0 : -1;
+        }
     }
 
-    virtio_write32(ctx, VIRTIO_MMIO_QUEUE_PFN, queue_pfn);
+    // The device still owns the descriptors: stop using the control queue
+    log_error(vnet_log, "Control command timed out\n");
+    vring->size = 0;
+    return -1;
+}
 
-    uint32_t readback_pfn = virtio_read32(ctx, VIRTIO_MMIO_QUEUE_PFN);
-    if (readback_pfn != queue_pfn) {
-        if (log_enabled(vnet_log, LOG_ERROR)) {
-            log_prefix(vnet_log, LOG_ERROR);
-            puts("PFN mismatch! Expected: 0x");
-            put_hex32(queue_pfn);
-            puts(" Got: 0x");
-            put_hex32(readback_pfn);
-            puts("\n");
+// Spread received flows over the queue pairs in use: program an RSS
+// indirection table and hash key when the device supports RSS, otherwise
+// enable the device's automatic flow steering over the pairs
+static int virtio_net_setup_mq(virtio_net_t *ctx) {
+    if (ctx->dev.features & VIRTIO_NET_F_RSS) {
+        uint32_t hash_types = virtio_dev_config_read32(&ctx->dev, VIRTIO_NET_CONFIG_HASH_TYPES) &
+            (VIRTIO_NET_RSS_HASH_TYPE_IPV4 | VIRTIO_NET_RSS_HASH_TYPE_TCPV4 | VIRTIO_NET_RSS_HASH_TYPE_UDPV4);
+        uint8_t key_size = virtio_dev_config_read8(&ctx->dev, VIRTIO_NET_CONFIG_RSS_MAX_KEY_SIZE);
+        if (key_size > VIRTIO_NET_RSS_KEY_SIZE) {
+            key_size = VIRTIO_NET_RSS_KEY_SIZE;
+        }
+        uint16_t max_table_len = virtio_dev_config_read16(&ctx->dev, VIRTIO_NET_CONFIG_RSS_MAX_TABLE_LEN);
+        uint16_t table_len = virtq_pow2_floor(max_table_len < VIRTIO_NET_RSS_TABLE_SIZE ?
+                                                   max_table_len : VIRTIO_NET_RSS_TABLE_SIZE);
+
+        if (hash_types != 0 && table_len != 0) {
+            // hash_types, indirection_table_mask, unclassified_queue,
+            // indirection_table[], max_tx_vq, hash_key_length, hash_key_data[]
+            uint8_t config[8 + 2 * VIRTIO_NET_RSS_TABLE_SIZE + 3 + VIRTIO_NET_RSS_KEY_SIZE];
+            virtio_net_put16(&config[0], (uint16_t)hash_types);
+            virtio_net_put16(&config[2], (uint16_t)(hash_types >> 16));
+            virtio_net_put16(&config[4], table_len - 1);
+            virtio_net_put16(&config[6], 0);
+            size_t pos = 8;
+            for (uint16_t i = 0; i < table_len; i++, pos += 2) {
+                virtio_net_put16(&config[pos], i % ctx->num_queue_pairs);
+            }
+            virtio_net_put16(&config[pos], ctx->num_queue_pairs);
+            config[pos + 2] = key_size;
+            memcpy(&config[pos + 3], virtio_net_rss_key, key_size);
+
+            if (virtio_net_ctrl_cmd(ctx, VIRTIO_NET_CTRL_MQ, VIRTIO_NET_CTRL_MQ_RSS_CONFIG,
+                                    config, pos + 3 + key_size) == 0) {
+                log_debug(vnet_log, "RSS configured\n");
+                return 0;
+            }
         }
-        return -1;
     }
 
-    return 0;
+    uint8_t pairs[2];
+    virtio_net_put16(pairs, ctx->num_queue_pairs);
+    return virtio_net_ctrl_cmd(ctx, VIRTIO_NET_CTRL_MQ, VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET, pairs, sizeof(pairs));
 }
 
 static int virtio_net_init_context(void *ctx, device_t *device) {
@@ -214,179 +226,165 @@ static int virtio_net_init_context(void *ctx, device_t *device) {
     virtio_net_t *net_ctx = (virtio_net_t *)ctx;
     memset(net_ctx, 0, sizeof(virtio_net_t));
 
-    net_ctx->io_base = device->reg_base;
-    net_ctx->transport = (net_ctx->io_base < 0x10000) ? VIRTIO_NET_TRANSPORT_PCI : VIRTIO_NET_TRANSPORT_MMIO;
-
-#if defined(__x86_64__) || defined(__i386__)
-    if (net_ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        // PCI legacy virtio initialization
-        // Reset device
-        virtio_write8(net_ctx, VIRTIO_PCI_STATUS, 0);
-
-        // Set ACKNOWLEDGE status
-        virtio_write8(net_ctx, VIRTIO_PCI_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+    // PCI devices exposing the VirtIO 1.0 capabilities use the modern transport:
+    // memory-mapped registers, per-queue MMIO doorbells and 64-bit ring addresses
+    virtio_dev_t *dev = &net_ctx->dev;
+    virtio_dev_init(dev, device, true);
+
+    // Interrupts only wake virtio_net_wait(): MSI-X on PCI, the device tree
+    // interrupt line on MMIO. Enabled before the legacy device configuration is
+    // read, since MSI-X moves it
+    if (device->compatible == NULL) {
+        if (virtio_dev_enable_msix(dev, device) == 0) {
+            net_ctx->irq_mode = VIRTIO_NET_IRQ_MSIX;
+        }
+    } else if (device->irq != 0 && platform_irq_enable(device->irq) == 0) {
+        net_ctx->irq_mode = VIRTIO_NET_IRQ_WIRED;
+    }
 
-        // Set DRIVER status
-        virtio_write8(net_ctx, VIRTIO_PCI_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+    virtio_dev_reset(dev);
 
-        // Read device features and set driver features (accept no special features)
-        (void)virtio_read32(net_ctx, VIRTIO_PCI_DEVICE_FEATURES);
-        virtio_write32(net_ctx, VIRTIO_PCI_DRIVER_FEATURES, 0);
+    // Accept the offered features we support; the modern transport only
+    // drives VirtIO 1.0 devices
+    uint64_t driver_features = virtio_net_select_features(virtio_dev_get_features(dev));
+    if (virtio_is_modern(dev) && !(driver_features & VIRTIO_F_VERSION_1)) {
+        log_error(vnet_log, "Device does not offer VERSION_1\n");
+        virtio_dev_set_status(dev, VIRTIO_STATUS_FAILED);
+        return -1;
+    }
+    if (virtio_dev_set_features(dev, driver_features) != 0) {
+        return -1;
+    }
 
-        // Set FEATURES_OK
-        virtio_write8(net_ctx, VIRTIO_PCI_STATUS,
-                      VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_FEATURES_OK);
+    // The header gains num_buffers with MRG_RXBUF or VERSION_1 (12 bytes instead
+    // of 10); offset the buffers so the IP header after it stays 4-byte aligned
+    net_ctx->hdr_len = (dev->features & (VIRTIO_NET_F_MRG_RXBUF | VIRTIO_F_VERSION_1)) ?
+        sizeof(virtio_net_hdr_mrg_rxbuf_t) : sizeof(virtio_net_hdr_t);
+    net_ctx->buf_offset = (4 - (net_ctx->hdr_len + sizeof(eth_hdr_t)) % 4) % 4;
+
+    // Use rings as large as the device allows unless lowered on the command line
+    uint32_t requested_size = VIRTIO_NET_MAX_QUEUE_SIZE;
+    if (params_get_uint(VIRTIO_NET_QUEUE_SIZE_PARAM, &requested_size)) {
+        if (requested_size < VIRTIO_NET_MIN_QUEUE_SIZE) {
+            requested_size = VIRTIO_NET_MIN_QUEUE_SIZE;
+        } else if (requested_size > VIRTIO_NET_MAX_QUEUE_SIZE) {
+            requested_size = VIRTIO_NET_MAX_QUEUE_SIZE;
+        }
+    }
 
-        // Verify FEATURES_OK
-        uint8_t status = virtio_read8(net_ctx, VIRTIO_PCI_STATUS);
-        if (!(status & VIRTIO_STATUS_FEATURES_OK)) {
-            virtio_write8(net_ctx, VIRTIO_PCI_STATUS, VIRTIO_STATUS_FAILED);
+    // One queue pair unless more are asked for on the command line: the
+    // network apps only poll pair 0, so flows steered elsewhere would be lost.
+    // More pairs (MQ) are for callers that poll each netdev_get_queue() entry
+    uint16_t device_pairs = 1;
+    if (dev->features & VIRTIO_NET_F_MQ) {
+        device_pairs = virtio_dev_config_read16(dev, VIRTIO_NET_CONFIG_MAX_QUEUE_PAIRS);
+        if (device_pairs < 1) {
+            device_pairs = 1;
+        }
+    }
+    uint32_t max_pairs = device_pairs < VIRTIO_NET_MAX_QUEUE_PAIRS ? device_pairs : VIRTIO_NET_MAX_QUEUE_PAIRS;
+    uint32_t num_pairs = 1;
+    if (params_get_uint(VIRTIO_NET_QUEUE_PAIRS_PARAM, &num_pairs)) {
+        if (num_pairs < 1) {
+            num_pairs = 1;
+        } else if (num_pairs > max_pairs) {
+            num_pairs = max_pairs;
+        }
+    }
+    net_ctx->num_queue_pairs = (uint16_t)num_pairs;
+
+    // Initialize RX (queue 2n) and TX (queue 2n+1) of every pair
+    uint16_t queue_size = virtq_pow2_floor(requested_size < VIRTIO_NET_MAX_BUFFERS ?
+                                           requested_size : VIRTIO_NET_MAX_BUFFERS);
+    for (uint16_t i = 0; i < net_ctx->num_queue_pairs; i++) {
+        virtio_net_queue_pair_t *qp = &net_ctx->queue_pairs[i];
+
+        if (virtq_setup(dev, &qp->rx_vring, qp->rx_ring_mem, 2 * i, requested_size,
+                        VIRTIO_NET_MAX_QUEUE_SIZE) != 0) {
+            log_error(vnet_log, "RX queue init failed\n");
+            virtio_dev_set_status(dev, VIRTIO_STATUS_FAILED);
             return -1;
         }
-    } else
-#endif
-    {
-        // MMIO transport initialization
-        // Reset device
-        virtio_write8(net_ctx, VIRTIO_MMIO_STATUS, 0);
-
-        // Set ACKNOWLEDGE status
-        virtio_write8(net_ctx, VIRTIO_MMIO_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
-
-        // Set DRIVER status
-        virtio_write8(net_ctx, VIRTIO_MMIO_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
-
-        // Read device features and set driver features (accept no special features)
-        (void)virtio_read32(net_ctx, VIRTIO_MMIO_DEVICE_FEATURES);
-        virtio_write32(net_ctx, VIRTIO_MMIO_DRIVER_FEATURES, 0);
-
-        // Set FEATURES_OK
-        virtio_write8(net_ctx, VIRTIO_MMIO_STATUS,
-                      VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_FEATURES_OK);
-
-        // Verify FEATURES_OK
-        uint8_t status = virtio_read8(net_ctx, VIRTIO_MMIO_STATUS);
-        if (!(status & VIRTIO_STATUS_FEATURES_OK)) {
-            virtio_write8(net_ctx, VIRTIO_MMIO_STATUS, VIRTIO_STATUS_FAILED);
+        if (virtq_setup(dev, &qp->tx_vring, qp->tx_ring_mem, 2 * i + 1, requested_size,
+                        VIRTIO_NET_MAX_QUEUE_SIZE) != 0) {
+            log_error(vnet_log, "TX queue init failed\n");
+            virtio_dev_set_status(dev, VIRTIO_STATUS_FAILED);
             return -1;
         }
 
-        // Set guest page size
-        virtio_write32(net_ctx, VIRTIO_MMIO_GUEST_PAGE_SIZE, 4096);
+        // Post as many buffers as all rings can hold, at most VIRTIO_NET_MAX_BUFFERS
+        if (qp->rx_vring.size < queue_size) {
+            queue_size = qp->rx_vring.size;
+        }
+        if (qp->tx_vring.size < queue_size) {
+            queue_size = qp->tx_vring.size;
+        }
     }
+    net_ctx->queue_size = queue_size;
 
-    // Initialize RX queue (queue 0)
-    log_debug(vnet_log, "Initializing RX queue...\n");
-    if (virtio_net_init_virtqueue(net_ctx, 0) != 0) {
-        log_error(vnet_log, "RX queue init failed\n");
-#if defined(__x86_64__) || defined(__i386__)
-        if (net_ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-            virtio_write8(net_ctx, VIRTIO_PCI_STATUS, VIRTIO_STATUS_FAILED);
-        } else
-#endif
-        {
-            virtio_write8(net_ctx, VIRTIO_MMIO_STATUS, VIRTIO_STATUS_FAILED);
-        }
-        return -1;
+    // TX buffers are handed out per descriptor, one buffer per posted descriptor
+    for (uint16_t i = 0; i < net_ctx->num_queue_pairs; i++) {
+        virtq_desc_init(&net_ctx->queue_pairs[i].tx_vring, queue_size);
     }
-    log_debug(vnet_log, "RX queue initialized\n");
 
-    // Initialize TX queue (queue 1)
-    log_debug(vnet_log, "Initializing TX queue...\n");
-    if (virtio_net_init_virtqueue(net_ctx, 1) != 0) {
-        log_error(vnet_log, "TX queue init failed\n");
-#if defined(__x86_64__) || defined(__i386__)
-        if (net_ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-            virtio_write8(net_ctx, VIRTIO_PCI_STATUS, VIRTIO_STATUS_FAILED);
-        } else
-#endif
-        {
-            virtio_write8(net_ctx, VIRTIO_MMIO_STATUS, VIRTIO_STATUS_FAILED);
+    // The control queue follows all of the device's queue pairs; without it
+    // only the first pair receives traffic
+    if (dev->features & VIRTIO_NET_F_CTRL_VQ) {
+        if (virtq_setup(dev, &net_ctx->ctrl_vring, net_ctx->ctrl_ring_mem, 2 * device_pairs,
+                        VIRTIO_NET_CTRL_QUEUE_SIZE, VIRTIO_NET_CTRL_QUEUE_SIZE) != 0) {
+            log_error(vnet_log, "Control queue init failed\n");
+            memset(&net_ctx->ctrl_vring, 0, sizeof(net_ctx->ctrl_vring));
+            net_ctx->num_queue_pairs = 1;
         }
-        return -1;
     }
-    log_debug(vnet_log, "TX queue initialized\n");
-
-    // Pre-populate RX queue with buffer descriptors
-    // Apply alignment offset for ARM64 to ensure IP header 4-byte alignment
-    for (uint16_t i = 0; i < VIRTIO_NET_QUEUE_SIZE; i++) {
-        virtio_net_desc_t *desc = GET_RX_DESC(net_ctx, i);
-        desc->addr = (uint64_t)&net_ctx->rx_buffers[i][VIRTIO_NET_RX_BUFFER_OFFSET];
-        desc->len = VIRTIO_NET_MAX_PACKET_SIZE - VIRTIO_NET_RX_BUFFER_OFFSET;
-        desc->flags = VRING_DESC_F_WRITE;
-        desc->next = 0;
 
-        // Access avail ring through helper
-        if (net_ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-            uint16_t avail_idx = net_ctx->pci_rx_queue.avail.idx % VIRTIO_NET_MAX_QUEUE_SIZE;
-            net_ctx->pci_rx_queue.avail.ring[avail_idx] = i;
-            net_ctx->pci_rx_queue.avail.idx++;
-        } else {
-            uint16_t avail_idx = net_ctx->mmio_rx_queue.avail.idx % VIRTIO_NET_QUEUE_SIZE;
-            net_ctx->mmio_rx_queue.avail.ring[avail_idx] = i;
-            net_ctx->mmio_rx_queue.avail.idx++;
-        }
-        net_ctx->rx_desc_in_use[i] = true;
+    // A device without a free MSI-X vector for every queue cannot wake us
+    if (net_ctx->irq_mode == VIRTIO_NET_IRQ_MSIX && dev->msix_rejected) {
+        log_info(vnet_log, "MSI-X vector rejected, polling only\n");
+        net_ctx->irq_mode = VIRTIO_NET_IRQ_NONE;
     }
 
-    uint16_t rx_avail_idx = (net_ctx->transport == VIRTIO_NET_TRANSPORT_PCI) ?
-        net_ctx->pci_rx_queue.avail.idx : net_ctx->mmio_rx_queue.avail.idx;
+    // Pre-populate RX queues with buffer descriptors
+    for (uint16_t i = 0; i < net_ctx->num_queue_pairs; i++) {
+        virtio_net_rx_fill(net_ctx, &net_ctx->queue_pairs[i]);
+    }
     if (log_enabled(vnet_log, LOG_DEBUG)) {
         log_prefix(vnet_log, LOG_DEBUG);
-        puts("RX buffers populated, avail.idx=");
-        put_hex16(rx_avail_idx);
+        puts("RX buffers populated, queue size=");
+        put_hex16(queue_size);
+        puts(" queue pairs=");
+        put_hex16(net_ctx->num_queue_pairs);
         puts("\n");
     }
 
     __sync_synchronize();
 
-#if defined(__x86_64__) || defined(__i386__)
-    if (net_ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        // PCI: Set DRIVER_OK (no FEATURES_OK in legacy)
-        virtio_write8(net_ctx, VIRTIO_PCI_STATUS,
-                      VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
-
-        // Verify DRIVER_OK
-        uint8_t status = virtio_read8(net_ctx, VIRTIO_PCI_STATUS);
-        if (!(status & VIRTIO_STATUS_DRIVER_OK)) {
-            return -1;
-        }
-
-        // For PCI legacy, don't notify RX queue initially
-        // The device will start using RX buffers automatically once DRIVER_OK is set
-    } else
-#endif
-    {
-        // MMIO: Set DRIVER_OK
-        virtio_write8(net_ctx, VIRTIO_MMIO_STATUS,
-                      VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER |
-                      VIRTIO_STATUS_FEATURES_OK | VIRTIO_STATUS_DRIVER_OK);
+    if (virtio_dev_driver_ok(dev) != 0) {
+        return -1;
+    }
 
-        // Verify DRIVER_OK
-        uint8_t status = virtio_read8(net_ctx, VIRTIO_MMIO_STATUS);
-        if (!(status & VIRTIO_STATUS_DRIVER_OK)) {
-            return -1;
+    // Notify device about RX buffers
+    // For PCI legacy, don't notify RX queues initially: the device will start
+    // using RX buffers automatically once DRIVER_OK is set
+    if (!virtio_is_legacy_pci(dev)) {
+        for (uint16_t i = 0; i < net_ctx->num_queue_pairs; i++) {
+            virtq_notify(dev, &net_ctx->queue_pairs[i].rx_vring);
         }
+    }
 
-        // Notify device about RX buffers (kick RX queue - queue 0)
-        virtio_write32(net_ctx, VIRTIO_MMIO_QUEUE_NOTIFY, 0);
+    // Steer flows across the pairs; the device keeps using the first pair
+    // until told otherwise
+    if (net_ctx->num_queue_pairs > 1 && virtio_net_setup_mq(net_ctx) != 0) {
+        log_error(vnet_log, "Multiqueue setup failed, using one queue pair\n");
+        net_ctx->num_queue_pairs = 1;
     }
 
     // Read MAC address from device config
-    uint64_t mac_offset = (net_ctx->transport == VIRTIO_NET_TRANSPORT_PCI) ? VIRTIO_PCI_CONFIG : VIRTIO_MMIO_CONFIG;
-
     for (int i = 0; i < 6; i++) {
-#if defined(__x86_64__) || defined(__i386__)
-        if (net_ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-            net_ctx->mac_addr[i] = io_inb((uint16_t)net_ctx->io_base + mac_offset + i);
-        } else {
-            net_ctx->mac_addr[i] = *(volatile uint8_t *)(uintptr_t)(net_ctx->io_base + mac_offset + i);
-        }
-#elif defined(__riscv) || defined(__aarch64__)
-        net_ctx->mac_addr[i] = *(volatile uint8_t *)(uintptr_t)(net_ctx->io_base + mac_offset + i);
-#endif
+        net_ctx->mac_addr[i] = virtio_dev_config_read8(dev, VIRTIO_NET_CONFIG_MAC + i);
     }
 
+    net_ctx->stats = (net_stats_t){0};
     net_ctx->initialized = true;
 
     log_info(vnet_log, "Driver initialized successfully\n");
@@ -401,14 +399,7 @@ static void virtio_net_deinit_context(void *ctx) {
 
     virtio_net_t *net_ctx = (virtio_net_t *)ctx;
     if (net_ctx->initialized) {
-#if defined(__x86_64__) || defined(__i386__)
-        if (net_ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-            virtio_write8(net_ctx, VIRTIO_PCI_STATUS, 0);
-        } else
-#endif
-        {
-            virtio_write8(net_ctx, VIRTIO_MMIO_STATUS, 0);
-        }
+        virtio_dev_set_status(&net_ctx->dev, 0);
         net_ctx->initialized = false;
     }
 }
@@ -419,7 +410,8 @@ static const driver_t virtio_net_driver = {
     .type = DRIVER_TYPE_NETWORK,
     .id_table = virtio_net_id_table,
     .init_context = virtio_net_init_context,
-    .deinit_context = virtio_net_deinit_context
+    .deinit_context = virtio_net_deinit_context,
+    .netdev_ops = &virtio_net_netdev_ops
 };
 
 const driver_t* virtio_net_get_driver(void) {
@@ -438,210 +430,802 @@ int virtio_net_get_mac(virtio_net_t *ctx, uint8_t mac[6]) {
     return 0;
 }
 
-int virtio_net_receive(virtio_net_t *ctx, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
-    if (!ctx || !buffer || !received_length || !ctx->initialized) {
+uint32_t virtio_net_get_caps(virtio_net_t *ctx) {
+    if (!ctx || !ctx->initialized) {
+        return 0;
+    }
+
+    uint32_t caps = 0;
+    if (ctx->dev.features & VIRTIO_NET_F_CSUM) {
+        caps |= NET_CAP_TX_CSUM;
+    }
+    if (ctx->dev.features & VIRTIO_NET_F_GUEST_CSUM) {
+        caps |= NET_CAP_RX_CSUM;
+    }
+    if (ctx->dev.features & VIRTIO_NET_F_HOST_TSO4) {
+        caps |= NET_CAP_TSO4;
+    }
+
+    return caps;
+}
+
+int virtio_net_get_queue_count(virtio_net_t *ctx) {
+    if (!ctx || !ctx->initialized) {
+        return 0;
+    }
+
+    return ctx->num_queue_pairs;
+}
+
+int virtio_net_get_stats(virtio_net_t *ctx, net_stats_t *stats) {
+    if (!ctx || !stats || !ctx->initialized) {
         return -1;
     }
 
-    // Check if there are used buffers in the RX queue
-    uint16_t last_used = ctx->rx_last_used_idx;
-    __sync_synchronize();
+    *stats = ctx->stats;
 
-    uint16_t used_ring_idx;
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        used_ring_idx = ctx->pci_rx_queue.used.idx;
-    } else {
-        used_ring_idx = ctx->mmio_rx_queue.used.idx;
+    return 0;
+}
+
+// Queue pair addressed by a data path call, NULL if the index is out of range
+static virtio_net_queue_pair_t *virtio_net_get_queue_pair(virtio_net_t *ctx, uint16_t queue) {
+    if (queue >= ctx->num_queue_pairs) {
+        return NULL;
+    }
+    return &ctx->queue_pairs[queue];
+}
+
+// Acknowledge a wired interrupt at the device and the interrupt controller so
+// the line drops; MSI-X messages need no acknowledge
+static void virtio_net_irq_ack(virtio_net_t *ctx) {
+    if (ctx->irq_mode != VIRTIO_NET_IRQ_WIRED) {
+        return;
+    }
+
+    uint32_t status = virtio_read32(&ctx->dev, VIRTIO_MMIO_INTERRUPT_STATUS);
+    if (status != 0) {
+        virtio_write32(&ctx->dev, VIRTIO_MMIO_INTERRUPT_ACK, status);
+    }
+    platform_irq_ack();
+}
+
+int virtio_net_wait(virtio_net_t *ctx, uint16_t queue) {
+    if (!ctx || !ctx->initialized || ctx->irq_mode == VIRTIO_NET_IRQ_NONE) {
+        return -1;
+    }
+
+    virtio_net_queue_pair_t *qp = virtio_net_get_queue_pair(ctx, queue);
+    if (!qp) {
+        return -1;
+    }
+
+    // Drop a stale interrupt (e.g. a TX used_event crossing) so it cannot end
+    // the wait right away
+    virtio_net_irq_ack(ctx);
+
+    // Check the ring again after enabling the interrupt: a frame used before
+    // the device saw the change does not interrupt
+    virtq_set_interrupt(&ctx->dev, &qp->rx_vring, true);
+    if (!virtq_has_used(&qp->rx_vring)) {
+        platform_irq_wait();
+    }
+    virtq_set_interrupt(&ctx->dev, &qp->rx_vring, false);
+    virtio_net_irq_ack(ctx);
+
+    return 0;
+}
+
+// Pop the next completed RX descriptor from the used ring
+// Returns 0 and fills desc_id/packet_len on success, -1 if the ring is empty
+static int virtio_net_rx_pop(virtio_net_queue_pair_t *qp, uint32_t *desc_id, uint32_t *packet_len) {
+    return virtq_pop(&qp->rx_vring, desc_id, packet_len);
+}
+
+// Re-add descriptor to available ring (caller is responsible for the kick)
+static void virtio_net_rx_post(virtio_net_t *ctx, virtio_net_queue_pair_t *qp, uint32_t desc_id) {
+    virtqueue_t *vring = &qp->rx_vring;
+    if (vring->packed) {
+        // A packed ring has no fixed buffer-to-descriptor mapping: describe the buffer again
+        uint16_t flags;
+        uint16_t pos = virtq_packed_fill(vring, (uint64_t)&qp->rx_buffers[desc_id][ctx->buf_offset],
+                                         VIRTIO_NET_MAX_PACKET_SIZE - ctx->buf_offset,
+                                         (uint16_t)desc_id, VRING_DESC_F_WRITE, true, &flags);
+        virtq_packed_publish(vring, pos, flags, 1);
+        return;
+    }
+    virtq_push(vring, (uint16_t)desc_id);
+}
+
+// Number of RX buffers holding the frame that starts in desc_id (MRG_RXBUF)
+static uint16_t virtio_net_rx_num_buffers(virtio_net_t *ctx, virtio_net_queue_pair_t *qp, uint32_t desc_id) {
+    if (!(ctx->dev.features & VIRTIO_NET_F_MRG_RXBUF)) {
+        return 1;
+    }
+
+    const virtio_net_hdr_mrg_rxbuf_t *hdr =
+        (const virtio_net_hdr_mrg_rxbuf_t *)(qp->rx_buffers[desc_id] + ctx->buf_offset);
+    return hdr->num_buffers > 1 ? hdr->num_buffers : 1;
+}
+
+// Pop the remaining buffers of a merged frame and hand them straight back to the device
+static void virtio_net_rx_skip(virtio_net_t *ctx, virtio_net_queue_pair_t *qp, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t desc_id, packet_len;
+        if (virtio_net_rx_pop(qp, &desc_id, &packet_len) != 0) {
+            break;
+        }
+        if (desc_id < ctx->queue_size) {
+            virtio_net_rx_post(ctx, qp, desc_id);
+            qp->rx_vring.unkicked++;
+        }
+    }
+}
+
+// Copy one popped RX frame into the caller's buffer
+// With MRG_RXBUF the frame may continue in further used buffers, which carry
+// data only: those are popped, copied and reposted here (the caller reposts
+// the first one)
+// Returns 0 on success, -1 if the frame is malformed or does not fit
+static int virtio_net_rx_copy(virtio_net_t *ctx, virtio_net_queue_pair_t *qp, uint32_t desc_id, uint32_t packet_len,
+                              uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    size_t buffer_len = VIRTIO_NET_MAX_PACKET_SIZE - ctx->buf_offset;
+    if (packet_len < ctx->hdr_len || packet_len > buffer_len) {
+        return -1;
+    }
+
+    uint16_t num_buffers = virtio_net_rx_num_buffers(ctx, qp, desc_id);
+
+    // Copy packet data (skip header, apply alignment offset)
+    size_t data_len = packet_len - ctx->hdr_len;
+    bool fits = data_len <= buffer_size;
+    if (fits) {
+        memcpy(buffer, qp->rx_buffers[desc_id] + ctx->buf_offset + ctx->hdr_len, data_len);
     }
 
-    static int debug_count = 0;
-    if (debug_count < 5) {
-        if (log_enabled(vnet_log, LOG_DEBUG)) {
-            log_prefix(vnet_log, LOG_DEBUG);
-            puts("RX check: last_used=");
-            put_hex16(last_used);
-            puts(" used_idx=");
-            put_hex16(used_ring_idx);
-            puts("\n");
+    for (uint16_t i = 1; i < num_buffers; i++) {
+        uint32_t next_id, next_len;
+        if (virtio_net_rx_pop(qp, &next_id, &next_len) != 0) {
+            return -1;
+        }
+        if (next_id >= ctx->queue_size) {
+            fits = false;
+            continue;
+        }
+
+        if (fits && next_len <= buffer_len && data_len + next_len <= buffer_size) {
+            memcpy(buffer + data_len, qp->rx_buffers[next_id] + ctx->buf_offset, next_len);
+            data_len += next_len;
+        } else {
+            fits = false;
         }
-        debug_count++;
+
+        virtio_net_rx_post(ctx, qp, next_id);
+        qp->rx_vring.unkicked++;
     }
 
-    if (used_ring_idx == last_used) {
+    if (!fits) {
+        return -1;
+    }
+
+    *received_length = data_len;
+
+    return 0;
+}
+
+int virtio_net_receive(virtio_net_t *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    if (!ctx || !buffer || !received_length || !ctx->initialized) {
+        return -1;
+    }
+
+    virtio_net_queue_pair_t *qp = virtio_net_get_queue_pair(ctx, queue);
+    if (!qp) {
         return -1;
     }
 
-    // Get the used descriptor
     uint32_t desc_id, packet_len;
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        uint16_t used_idx = last_used % VIRTIO_NET_MAX_QUEUE_SIZE;
-        desc_id = ctx->pci_rx_queue.used.ring[used_idx].id;
-        packet_len = ctx->pci_rx_queue.used.ring[used_idx].len;
+    if (virtio_net_rx_pop(qp, &desc_id, &packet_len) != 0) {
+        return -1;
+    }
+
+    if (desc_id >= ctx->queue_size) {
+        return -1;
+    }
+
+    int result = virtio_net_rx_copy(ctx, qp, desc_id, packet_len, buffer, buffer_size, received_length);
+    if (result == 0) {
+        ctx->stats.rx_packets++;
     } else {
-        uint16_t used_idx = last_used % VIRTIO_NET_QUEUE_SIZE;
-        desc_id = ctx->mmio_rx_queue.used.ring[used_idx].id;
-        packet_len = ctx->mmio_rx_queue.used.ring[used_idx].len;
+        ctx->stats.rx_dropped++;
     }
-    __sync_synchronize();
 
-    if (desc_id >= VIRTIO_NET_QUEUE_SIZE) {
-        ctx->rx_last_used_idx++;
+    // Re-add descriptor to available ring for next packet
+    virtio_net_rx_post(ctx, qp, desc_id);
+    qp->rx_vring.unkicked++;
+
+    // Refill in batches: only check for a kick once half the ring was
+    // reposted or the used ring is drained (about to go idle)
+    if (qp->rx_vring.unkicked >= ctx->queue_size / 2 || !virtq_has_used(&qp->rx_vring)) {
+        virtq_kick(&ctx->dev, &qp->rx_vring);
+    }
+
+    return result;
+}
+
+int virtio_net_receive_burst(virtio_net_t *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                             size_t lengths[], int max_packets) {
+    if (!ctx || !buffers || !lengths || max_packets < 0 || !ctx->initialized) {
         return -1;
     }
 
-    if (packet_len == 0 || packet_len > VIRTIO_NET_MAX_PACKET_SIZE) {
-        ctx->rx_last_used_idx++;
+    virtio_net_queue_pair_t *qp = virtio_net_get_queue_pair(ctx, queue);
+    if (!qp) {
         return -1;
     }
 
-    // VirtIO-Net legacy header is 10 bytes, skip it
-    size_t hdr_len = sizeof(virtio_net_hdr_t);
-    if (packet_len < hdr_len) {
-        ctx->rx_last_used_idx++;
+    int received = 0;
+    int reposted = 0;
+    while (received < max_packets) {
+        uint32_t desc_id, packet_len;
+        if (virtio_net_rx_pop(qp, &desc_id, &packet_len) != 0) {
+            break;
+        }
+
+        if (desc_id >= ctx->queue_size) {
+            continue;
+        }
+
+        if (virtio_net_rx_copy(ctx, qp, desc_id, packet_len, buffers[received], buffer_size, &lengths[received]) == 0) {
+            received++;
+        } else {
+            ctx->stats.rx_dropped++;
+        }
+
+        virtio_net_rx_post(ctx, qp, desc_id);
+        reposted++;
+    }
+
+    // One kick for the whole batch of reposted descriptors
+    if (reposted > 0) {
+        virtq_kick(&ctx->dev, &qp->rx_vring);
+    }
+
+    ctx->stats.rx_packets += (uint64_t)received;
+    return received;
+}
+
+int virtio_net_rx_acquire(virtio_net_t *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames) {
+    if (!ctx || !frames || max_frames < 0 || !ctx->initialized) {
         return -1;
     }
 
-    size_t data_len = packet_len - hdr_len;
-    if (data_len > buffer_size) {
-        ctx->rx_last_used_idx++;
+    virtio_net_queue_pair_t *qp = virtio_net_get_queue_pair(ctx, queue);
+    if (!qp) {
         return -1;
     }
 
-    // Copy packet data (skip header, apply alignment offset)
-    const uint8_t *rx_data = ctx->rx_buffers[desc_id] + VIRTIO_NET_RX_BUFFER_OFFSET + hdr_len;
+    int acquired = 0;
+    bool reposted = false;
+    while (acquired < max_frames) {
+        uint32_t desc_id, packet_len;
+        if (virtio_net_rx_pop(qp, &desc_id, &packet_len) != 0) {
+            break;
+        }
 
-    memcpy(buffer, rx_data, data_len);
-    *received_length = data_len;
+        if (desc_id >= ctx->queue_size) {
+            continue;
+        }
+
+        // Malformed frames are handed straight back to the device
+        if (packet_len <= ctx->hdr_len || packet_len > (size_t)VIRTIO_NET_MAX_PACKET_SIZE - ctx->buf_offset) {
+            virtio_net_rx_post(ctx, qp, desc_id);
+            reposted = true;
+            ctx->stats.rx_dropped++;
+            continue;
+        }
 
-    // Update last used index
-    ctx->rx_last_used_idx++;
+        // A frame merged from several buffers cannot be lent as one contiguous block
+        uint16_t num_buffers = virtio_net_rx_num_buffers(ctx, qp, desc_id);
+        if (num_buffers > 1) {
+            log_debug(vnet_log, "Dropped merged RX frame (zero-copy receive)\n");
+            virtio_net_rx_skip(ctx, qp, num_buffers - 1);
+            virtio_net_rx_post(ctx, qp, desc_id);
+            reposted = true;
+            ctx->stats.rx_dropped++;
+            continue;
+        }
 
-    // Re-add descriptor to available ring for next packet
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        uint16_t avail_idx = ctx->pci_rx_queue.avail.idx % VIRTIO_NET_MAX_QUEUE_SIZE;
-        ctx->pci_rx_queue.avail.ring[avail_idx] = desc_id;
-        __sync_synchronize();
-        ctx->pci_rx_queue.avail.idx++;
-        __sync_synchronize();
-    } else {
-        uint16_t avail_idx = ctx->mmio_rx_queue.avail.idx % VIRTIO_NET_QUEUE_SIZE;
-        ctx->mmio_rx_queue.avail.ring[avail_idx] = desc_id;
-        __sync_synchronize();
-        ctx->mmio_rx_queue.avail.idx++;
-        __sync_synchronize();
+        const uint8_t *rx_buffer = qp->rx_buffers[desc_id] + ctx->buf_offset;
+        const virtio_net_hdr_t *hdr = (const virtio_net_hdr_t *)rx_buffer;
+
+        frames[acquired].data = rx_buffer + ctx->hdr_len;
+        frames[acquired].length = packet_len - ctx->hdr_len;
+        frames[acquired].slot = (uint16_t)desc_id;
+        frames[acquired].flags = 0;
+        // A partial checksum (NEEDS_CSUM) comes from the host itself and is trusted as well
+        if (hdr->flags & (VIRTIO_NET_HDR_F_DATA_VALID | VIRTIO_NET_HDR_F_NEEDS_CSUM)) {
+            frames[acquired].flags |= NET_RX_F_CSUM_VALID;
+        }
+        acquired++;
     }
 
-    // Notify device (kick RX queue - queue 0)
-#if defined(__x86_64__) || defined(__i386__)
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        virtio_write16(ctx, VIRTIO_PCI_QUEUE_SEL, 0);
-        virtio_write16(ctx, VIRTIO_PCI_QUEUE_NOTIFY, 0);
-    } else
-#endif
-    {
-        virtio_write32(ctx, VIRTIO_MMIO_QUEUE_NOTIFY, 0);
+    if (reposted) {
+        virtq_kick(&ctx->dev, &qp->rx_vring);
+    }
+
+    ctx->stats.rx_packets += (uint64_t)acquired;
+    return acquired;
+}
+
+int virtio_net_rx_release(virtio_net_t *ctx, uint16_t queue, const net_rx_frame_t frames[], int count) {
+    if (!ctx || !frames || count < 0 || !ctx->initialized) {
+        return -1;
+    }
+
+    virtio_net_queue_pair_t *qp = virtio_net_get_queue_pair(ctx, queue);
+    if (!qp) {
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (frames[i].slot < ctx->queue_size) {
+            virtio_net_rx_post(ctx, qp, frames[i].slot);
+        }
+    }
+
+    // One kick for all returned descriptors
+    if (count > 0) {
+        virtq_kick(&ctx->dev, &qp->rx_vring);
     }
 
     return 0;
 }
 
 // Reclaim completed TX descriptors from the used ring
-static void virtio_net_reclaim_tx(virtio_net_t *ctx) {
-    uint16_t used_idx;
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        used_idx = ctx->pci_tx_queue.used.idx;
-    } else {
-        used_idx = ctx->mmio_tx_queue.used.idx;
+static void virtio_net_reclaim_tx(virtio_net_t *ctx, virtio_net_queue_pair_t *qp) {
+    virtqueue_t *vring = &qp->tx_vring;
+    if (vring->packed) {
+        // The device writes one used descriptor per chain and skips the rest of it
+        while (virtq_packed_has_used(vring)) {
+            __sync_synchronize();
+            uint16_t id = vring->packed_desc[vring->next_used].id;
+            uint16_t chain_len = 1;
+            if (id < ctx->queue_size) {
+                chain_len = qp->tx_chain_len[id] ? qp->tx_chain_len[id] : 1;
+                virtq_desc_free(vring, id);
+            }
+            virtq_packed_consume(vring, chain_len);
+            vring->last_used++;
+        }
+        return;
     }
 
-    while (ctx->tx_last_used_idx != used_idx) {
-        uint32_t desc_id;
-        if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-            uint16_t ring_idx = ctx->tx_last_used_idx % VIRTIO_NET_MAX_QUEUE_SIZE;
-            desc_id = ctx->pci_tx_queue.used.ring[ring_idx].id;
-        } else {
-            uint16_t ring_idx = ctx->tx_last_used_idx % VIRTIO_NET_QUEUE_SIZE;
-            desc_id = ctx->mmio_tx_queue.used.ring[ring_idx].id;
+    // Free the head and every descriptor chained behind it (fragments)
+    uint32_t desc_id, len;
+    while (virtq_pop(vring, &desc_id, &len) == 0) {
+        virtq_desc_free_chain(vring, (uint16_t)desc_id);
+    }
+}
+
+// Claim a free TX descriptor and return where its frame goes (behind the VirtIO header)
+// Returns NET_TX_AGAIN while every descriptor is still owned by the device
+static int virtio_net_tx_claim(virtio_net_t *ctx, virtio_net_queue_pair_t *qp, net_tx_slot_t *slot) {
+    int desc_idx = virtq_desc_alloc(&qp->tx_vring);
+    if (desc_idx < 0) {
+        return NET_TX_AGAIN;
+    }
+
+    // Apply alignment offset for ARM64 to ensure consistent buffer layout
+    uint8_t *tx_buffer = qp->tx_buffers[desc_idx] + ctx->buf_offset;
+    slot->data = tx_buffer + ctx->hdr_len;
+    slot->capacity = VIRTIO_NET_MAX_PACKET_SIZE - ctx->buf_offset - ctx->hdr_len;
+    slot->slot = (uint16_t)desc_idx;
+    slot->offload.csum_start = 0;
+    slot->offload.csum_offset = 0;
+    slot->offload.gso_size = 0;
+
+    return 0;
+}
+
+// Fill in the VirtIO header and put a claimed descriptor, followed by one
+// chained descriptor per fragment, on the TX available ring
+// The claimed descriptor is released on failure (NET_TX_AGAIN if the ring has no
+// room for the chain); the caller is responsible for the kick
+static int virtio_net_tx_publish(virtio_net_t *ctx, virtio_net_queue_pair_t *qp, uint16_t desc_idx, size_t length,
+                                 const net_tx_offload_t *offload,
+                                 const net_tx_frag_t frags[], int frag_count) {
+    virtqueue_t *vring = &qp->tx_vring;
+    if (!virtq_desc_in_use(vring, desc_idx)) {
+        return -1;
+    }
+
+    uint8_t *tx_buffer = qp->tx_buffers[desc_idx] + ctx->buf_offset;
+    size_t capacity = VIRTIO_NET_MAX_PACKET_SIZE - ctx->buf_offset - ctx->hdr_len;
+    bool gso = offload && offload->gso_size != 0;
+    bool csum = offload && offload->csum_start != 0;
+
+    // Segmentation needs the negotiated feature and a checksum request locating
+    // the TCP header, whose data offset (byte 12) must lie in the slot
+    size_t frame_len = length;
+    bool valid = length > 0 && length <= capacity && frag_count >= 0 && (frag_count == 0 || frags);
+    if (gso && (!(ctx->dev.features & VIRTIO_NET_F_HOST_TSO4) || !csum || (size_t)offload->csum_start + 12 >= length)) {
+        valid = false;
+    }
+    for (int i = 0; valid && i < frag_count; i++) {
+        if (!frags[i].data || frags[i].length == 0) {
+            valid = false;
         }
-        if (desc_id < VIRTIO_NET_QUEUE_SIZE) {
-            ctx->tx_desc_in_use[desc_id] = false;
+        frame_len += frags[i].length;
+    }
+    if (!valid || frame_len > (gso ? NET_TSO_MAX_FRAME_SIZE : capacity)) {
+        virtq_desc_free(vring, desc_idx);
+        return -1;
+    }
+
+    // With INDIRECT_DESC the fragments go into the buffer's own descriptor table
+    // and the frame takes a single ring descriptor
+    bool indirect = frag_count > 0 && (ctx->dev.features & VIRTIO_RING_F_INDIRECT_DESC) &&
+                    frag_count < VIRTIO_NET_MAX_INDIRECT_DESC;
+    int ring_frags = indirect ? 0 : frag_count;
+
+    // A packed chain takes consecutive ring positions rather than free descriptors
+    if (vring->packed && vring->num_free < 1 + ring_frags) {
+        virtq_desc_free(vring, desc_idx);
+        return NET_TX_AGAIN;
+    }
+
+    // Claim one extra descriptor per fragment
+    uint16_t chain[VIRTIO_NET_MAX_QUEUE_SIZE];
+    int chained = 0;
+    while (!vring->packed && chained < ring_frags) {
+        int id = virtq_desc_alloc(vring);
+        if (id < 0) {
+            for (int i = 0; i < chained; i++) {
+                virtq_desc_free(vring, chain[i]);
+            }
+            virtq_desc_free(vring, desc_idx);
+            return NET_TX_AGAIN;
         }
-        ctx->tx_last_used_idx++;
+        chain[chained++] = (uint16_t)id;
+    }
+
+    // num_buffers (MRG_RXBUF) is zero on transmit
+    virtio_net_hdr_t *hdr = (virtio_net_hdr_t *)tx_buffer;
+    memset(hdr, 0, ctx->hdr_len);
+
+    // Let the device complete the L4 checksum
+    if (csum && (ctx->dev.features & VIRTIO_NET_F_CSUM)) {
+        hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        hdr->csum_start = offload->csum_start;
+        hdr->csum_offset = offload->csum_offset;
+    }
+
+    // Let the device cut the frame into MSS-sized TCP segments; hdr_len covers
+    // the Ethernet, IPv4 and TCP headers replicated into every segment
+    if (gso) {
+        const uint8_t *tcp = tx_buffer + ctx->hdr_len + offload->csum_start;
+        hdr->gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+        hdr->gso_size = offload->gso_size;
+        hdr->hdr_len = offload->csum_start + (tcp[12] >> 4) * 4;
+    }
+
+    if (indirect) {
+        // Table entries use the descriptor format of the ring; a split table is
+        // chained through next, a packed one is read in order
+        virtq_indirect_desc_t *table = qp->tx_indirect[desc_idx];
+        uint32_t table_len = (uint32_t)(1 + frag_count) * sizeof(virtq_indirect_desc_t);
+        for (int i = 0; i <= frag_count; i++) {
+            uint64_t addr = (i == 0) ? (uint64_t)tx_buffer : (uint64_t)(uintptr_t)frags[i - 1].data;
+            uint32_t len = (i == 0) ? ctx->hdr_len + length : frags[i - 1].length;
+            if (vring->packed) {
+                table[i].packed.addr = addr;
+                table[i].packed.len = len;
+                table[i].packed.id = 0;
+                table[i].packed.flags = 0;
+            } else {
+                table[i].split.addr = addr;
+                table[i].split.len = len;
+                table[i].split.flags = (i < frag_count) ? VRING_DESC_F_NEXT : 0;
+                table[i].split.next = (uint16_t)(i + 1);
+            }
+        }
+
+        if (vring->packed) {
+            uint16_t head_flags;
+            uint16_t head = virtq_packed_fill(vring, (uint64_t)table, table_len, desc_idx,
+                                              VRING_DESC_F_INDIRECT, true, &head_flags);
+            qp->tx_chain_len[desc_idx] = 1;
+            virtq_packed_publish(vring, head, head_flags, 1);
+            return 0;
+        }
+
+        virtq_desc_t *desc = &vring->desc[desc_idx];
+        desc->addr = (uint64_t)table;
+        desc->len = table_len;
+        desc->flags = VRING_DESC_F_INDIRECT;
+        desc->next = 0;
+    } else if (vring->packed) {
+        uint16_t head_flags, flags;
+        uint16_t head = virtq_packed_fill(vring, (uint64_t)tx_buffer, ctx->hdr_len + length, desc_idx,
+                                          frag_count > 0 ? VRING_DESC_F_NEXT : 0, true, &head_flags);
+        for (int i = 0; i < frag_count; i++) {
+            virtq_packed_fill(vring, (uint64_t)(uintptr_t)frags[i].data, frags[i].length, desc_idx,
+                              i + 1 < frag_count ? VRING_DESC_F_NEXT : 0, false, &flags);
+        }
+        qp->tx_chain_len[desc_idx] = (uint16_t)(1 + frag_count);
+        virtq_packed_publish(vring, head, head_flags, (uint16_t)(1 + frag_count));
+        return 0;
+    } else {
+        // Setup descriptor chain: VirtIO header + slot data, then the fragments
+        virtq_desc_t *desc = &vring->desc[desc_idx];
+        desc->addr = (uint64_t)tx_buffer;
+        desc->len = ctx->hdr_len + length;
+        desc->flags = 0;
+        desc->next = 0;
+        for (int i = 0; i < frag_count; i++) {
+            desc->flags = VRING_DESC_F_NEXT;
+            desc->next = chain[i];
+            desc = &vring->desc[chain[i]];
+            desc->addr = (uint64_t)(uintptr_t)frags[i].data;
+            desc->len = frags[i].length;
+            desc->flags = 0;
+            desc->next = 0;
+        }
+    }
+
+    // Add to available ring
+    virtq_push(vring, desc_idx);
+
+    return 0;
+}
+
+// Count a frame the TX ring had no room for; successful sends are counted by
+// the callers, which know how many frames went out
+static void virtio_net_count_tx_result(virtio_net_t *ctx, int result) {
+    if (result == NET_TX_AGAIN) {
+        ctx->stats.tx_dropped++;
     }
 }
 
-int virtio_net_transmit(virtio_net_t *ctx, const uint8_t *packet, size_t length) {
+// Place one packet on the TX available ring without notifying the device
+static int virtio_net_tx_enqueue(virtio_net_t *ctx, virtio_net_queue_pair_t *qp, const uint8_t *packet, size_t length) {
+    if (!packet || length == 0) {
+        return -1;
+    }
+
+    net_tx_slot_t slot;
+    int result = virtio_net_tx_claim(ctx, qp, &slot);
+    if (result != 0) {
+        return result;
+    }
+
+    if (length > slot.capacity) {
+        virtq_desc_free(&qp->tx_vring, slot.slot);
+        return -1;
+    }
+
+    // Copy packet after header
+    for (size_t i = 0; i < length; i++) {
+        slot.data[i] = packet[i];
+    }
+
+    return virtio_net_tx_publish(ctx, qp, slot.slot, length, NULL, NULL, 0);
+}
+
+int virtio_net_transmit(virtio_net_t *ctx, uint16_t queue, const uint8_t *packet, size_t length) {
     if (!ctx || !packet || length == 0 || length > VIRTIO_NET_MAX_PACKET_SIZE || !ctx->initialized) {
         return -1;
     }
 
+    virtio_net_queue_pair_t *qp = virtio_net_get_queue_pair(ctx, queue);
+    if (!qp) {
+        return -1;
+    }
+
     // Reclaim any completed TX descriptors before looking for a free one
     __sync_synchronize();
-    virtio_net_reclaim_tx(ctx);
-
-    // Find free TX descriptor
-    uint16_t desc_idx = 0;
-    bool found = false;
-    for (uint16_t i = 0; i < VIRTIO_NET_QUEUE_SIZE; i++) {
-        if (!ctx->tx_desc_in_use[i]) {
-            desc_idx = i;
-            found = true;
+    virtio_net_reclaim_tx(ctx, qp);
+
+    // A full ring is reported rather than dropped so the caller can retry
+    int result = virtio_net_tx_enqueue(ctx, qp, packet, length);
+    if (result != 0) {
+        virtio_net_count_tx_result(ctx, result);
+        return result;
+    }
+
+    // Notify device (kick TX queue - queue 1)
+    virtq_kick(&ctx->dev, &qp->tx_vring);
+    ctx->stats.tx_packets++;
+
+    // Fire-and-forget: descriptor will be reclaimed on next transmit call
+    return 0;
+}
+
+int virtio_net_transmit_burst(virtio_net_t *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[], int count) {
+    if (!ctx || !packets || !lengths || count < 0 || !ctx->initialized) {
+        return -1;
+    }
+
+    virtio_net_queue_pair_t *qp = virtio_net_get_queue_pair(ctx, queue);
+    if (!qp) {
+        return -1;
+    }
+
+    __sync_synchronize();
+    virtio_net_reclaim_tx(ctx, qp);
+
+    int sent = 0;
+    while (sent < count) {
+        int result = virtio_net_tx_enqueue(ctx, qp, packets[sent], lengths[sent]);
+        if (result != 0) {
+            // The rest of the batch is refused along with this frame
+            if (result == NET_TX_AGAIN) {
+                ctx->stats.tx_dropped += (uint64_t)(count - sent);
+            }
             break;
         }
+        sent++;
+    }
+
+    // One kick for the whole batch
+    if (sent > 0) {
+        virtq_kick(&ctx->dev, &qp->tx_vring);
     }
 
-    if (!found) {
+    ctx->stats.tx_packets += (uint64_t)sent;
+    return sent;
+}
+
+int virtio_net_tx_alloc(virtio_net_t *ctx, uint16_t queue, net_tx_slot_t *slot) {
+    if (!ctx || !slot || !ctx->initialized) {
         return -1;
     }
 
-    ctx->tx_desc_in_use[desc_idx] = true;
+    virtio_net_queue_pair_t *qp = virtio_net_get_queue_pair(ctx, queue);
+    if (!qp) {
+        return -1;
+    }
 
-    // Build TX buffer with VirtIO header + packet
-    // Apply alignment offset for ARM64 to ensure consistent buffer layout
-    uint8_t *tx_buffer = ctx->tx_buffers[desc_idx] + VIRTIO_NET_RX_BUFFER_OFFSET;
-    virtio_net_hdr_t *hdr = (virtio_net_hdr_t *)tx_buffer;
-    memset(hdr, 0, sizeof(virtio_net_hdr_t));
+    __sync_synchronize();
+    virtio_net_reclaim_tx(ctx, qp);
 
-    // Copy packet after header
-    for (size_t i = 0; i < length; i++) {
-        tx_buffer[sizeof(virtio_net_hdr_t) + i] = packet[i];
+    int result = virtio_net_tx_claim(ctx, qp, slot);
+    virtio_net_count_tx_result(ctx, result);
+    return result;
+}
+
+int virtio_net_tx_commit(virtio_net_t *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count) {
+    if (!ctx || !slots || !lengths || count < 0 || !ctx->initialized) {
+        return -1;
+    }
+
+    virtio_net_queue_pair_t *qp = virtio_net_get_queue_pair(ctx, queue);
+    if (!qp) {
+        return -1;
+    }
+
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        int result = virtio_net_tx_publish(ctx, qp, slots[i].slot, lengths[i], &slots[i].offload, NULL, 0);
+        if (result == 0) {
+            sent++;
+        }
+        virtio_net_count_tx_result(ctx, result);
     }
 
-    size_t total_len = sizeof(virtio_net_hdr_t) + length;
+    // One kick for the whole batch
+    if (sent > 0) {
+        virtq_kick(&ctx->dev, &qp->tx_vring);
+    }
 
-    // Setup descriptor
-    virtio_net_desc_t *desc = GET_TX_DESC(ctx, desc_idx);
-    desc->addr = (uint64_t)tx_buffer;
-    desc->len = total_len;
-    desc->flags = 0;
-    desc->next = 0;
+    ctx->stats.tx_packets += (uint64_t)sent;
+    return sent;
+}
 
-    // Add to available ring
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        uint16_t avail_idx = ctx->pci_tx_queue.avail.idx % VIRTIO_NET_MAX_QUEUE_SIZE;
-        ctx->pci_tx_queue.avail.ring[avail_idx] = desc_idx;
-        __sync_synchronize();
-        ctx->pci_tx_queue.avail.idx++;
-        __sync_synchronize();
-    } else {
-        uint16_t avail_idx = ctx->mmio_tx_queue.avail.idx % VIRTIO_NET_QUEUE_SIZE;
-        ctx->mmio_tx_queue.avail.ring[avail_idx] = desc_idx;
-        __sync_synchronize();
-        ctx->mmio_tx_queue.avail.idx++;
-        __sync_synchronize();
+int virtio_net_tx_commit_sg(virtio_net_t *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                            const net_tx_frag_t frags[], int frag_count) {
+    if (!ctx || !slot || !ctx->initialized) {
+        return -1;
     }
 
-    // Notify device (kick TX queue - queue 1)
-#if defined(__x86_64__) || defined(__i386__)
-    if (ctx->transport == VIRTIO_NET_TRANSPORT_PCI) {
-        virtio_write16(ctx, VIRTIO_PCI_QUEUE_SEL, 1);
-        virtio_write16(ctx, VIRTIO_PCI_QUEUE_NOTIFY, 1);
-    } else
-#endif
-    {
-        virtio_write32(ctx, VIRTIO_MMIO_QUEUE_NOTIFY, 1);
+    virtio_net_queue_pair_t *qp = virtio_net_get_queue_pair(ctx, queue);
+    if (!qp) {
+        return -1;
     }
 
-    // Fire-and-forget: descriptor will be reclaimed on next transmit call
+    // Completed chains free the descriptors the fragments need
+    __sync_synchronize();
+    virtio_net_reclaim_tx(ctx, qp);
+
+    int result = virtio_net_tx_publish(ctx, qp, slot->slot, length, &slot->offload, frags, frag_count);
+    virtio_net_count_tx_result(ctx, result);
+    if (result != 0) {
+        return result;
+    }
+
+    virtq_kick(&ctx->dev, &qp->tx_vring);
+    ctx->stats.tx_packets++;
+
     return 0;
 }
+
+// netdev_ops_t entry points
+
+static virtio_net_t virtio_net_netdev_contexts[NETDEV_MAX_CONTEXTS];
+
+int virtio_net_netdev_get_mac(void *ctx, uint8_t mac[6]) {
+    return virtio_net_get_mac(ctx, mac);
+}
+
+uint32_t virtio_net_netdev_get_caps(void *ctx) {
+    return virtio_net_get_caps(ctx);
+}
+
+int virtio_net_netdev_get_queue_count(void *ctx) {
+    return virtio_net_get_queue_count(ctx);
+}
+
+int virtio_net_netdev_get_stats(void *ctx, net_stats_t *stats) {
+    return virtio_net_get_stats(ctx, stats);
+}
+
+int virtio_net_netdev_wait(void *ctx, uint16_t queue) {
+    return virtio_net_wait(ctx, queue);
+}
+
+int virtio_net_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length) {
+    return virtio_net_transmit(ctx, queue, packet, length);
+}
+
+int virtio_net_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    return virtio_net_receive(ctx, queue, buffer, buffer_size, received_length);
+}
+
+int virtio_net_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                                    size_t lengths[], int max_packets) {
+    return virtio_net_receive_burst(ctx, queue, buffers, buffer_size, lengths, max_packets);
+}
+
+int virtio_net_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                                     int count) {
+    return virtio_net_transmit_burst(ctx, queue, packets, lengths, count);
+}
+
+int virtio_net_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames) {
+    return virtio_net_rx_acquire(ctx, queue, frames, max_frames);
+}
+
+int virtio_net_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count) {
+    return virtio_net_rx_release(ctx, queue, frames, count);
+}
+
+int virtio_net_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot) {
+    return virtio_net_tx_alloc(ctx, queue, slot);
+}
+
+int virtio_net_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count) {
+    return virtio_net_tx_commit(ctx, queue, slots, lengths, count);
+}
+
+int virtio_net_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                                   const net_tx_frag_t frags[], int frag_count) {
+    return virtio_net_tx_commit_sg(ctx, queue, slot, length, frags, frag_count);
+}
+
+const netdev_ops_t virtio_net_netdev_ops = {
+    .contexts = virtio_net_netdev_contexts,
+    .context_size = sizeof(virtio_net_t),
+    .get_mac = virtio_net_netdev_get_mac,
+    .get_caps = virtio_net_netdev_get_caps,
+    .get_queue_count = virtio_net_netdev_get_queue_count,
+    .get_stats = virtio_net_netdev_get_stats,
+    .wait = virtio_net_netdev_wait,
+    .transmit = virtio_net_netdev_transmit,
+    .receive = virtio_net_netdev_receive,
+    .receive_burst = virtio_net_netdev_receive_burst,
+    .transmit_burst = virtio_net_netdev_transmit_burst,
+    .rx_acquire = virtio_net_netdev_rx_acquire,
+    .rx_release = virtio_net_netdev_rx_release,
+    .tx_alloc = virtio_net_netdev_tx_alloc,
+    .tx_commit = virtio_net_netdev_tx_commit,
+    .tx_commit_sg = virtio_net_netdev_tx_commit_sg
+};
@@ -3,90 +3,72 @@
 #include "../../common/types.h"
 #include "../../common/drivers.h"
 #include "../../kernel/devices/devices.h"
+#include "../../kernel/devices/virtqueue.h"
 
-// VirtIO-Net queue size (actual descriptors we use)
-#define VIRTIO_NET_QUEUE_SIZE 16
-// Maximum queue size for PCI legacy (device advertises 256)
-#define VIRTIO_NET_MAX_QUEUE_SIZE 256
+// Largest virtqueue the driver supports. The ring size is negotiated at init
+// up to the device's limit and can be lowered with virtio-net.queue_size=<n>
+#define VIRTIO_NET_MAX_QUEUE_SIZE VIRTQ_MAX_SIZE
+// Packet buffers per queue. Rings larger than this (e.g. the fixed 256 entries
+// of legacy PCI devices) only get this many buffers posted
+#define VIRTIO_NET_MAX_BUFFERS 128
+#define VIRTIO_NET_MIN_QUEUE_SIZE VIRTQ_MIN_SIZE
 #define VIRTIO_NET_MAX_PACKET_SIZE 2048
 
-// ARM64 alignment offset: VirtIO header (10 bytes) + Ethernet header (14 bytes) = 24 bytes
-// Adding 2-byte offset makes IP header (at +24) land on 4-byte boundary
-#if defined(__aarch64__)
-#define VIRTIO_NET_RX_BUFFER_OFFSET 2
-#else
-#define VIRTIO_NET_RX_BUFFER_OFFSET 0
-#endif
+// Largest number of RX/TX queue pairs the driver uses (VIRTIO_NET_F_MQ): NETDEV_QUEUES,
+// up to two. Each pair has its own rings and buffers; virtio-net.queue_pairs=<n> picks
+// how many of them are used
+#define VIRTIO_NET_MAX_QUEUE_PAIRS (NETDEV_QUEUES < 2 ? NETDEV_QUEUES : 2)
 
-// Virtqueue descriptor flags
-#define VRING_DESC_F_NEXT 1
-#define VRING_DESC_F_WRITE 2
+// Control virtqueue: one command is in flight at a time
+#define VIRTIO_NET_CTRL_QUEUE_SIZE 64
+#define VIRTIO_NET_CTRL_BUF_SIZE 512
 
-// Virtqueue descriptor
-typedef struct {
-    volatile uint64_t addr;
-    volatile uint32_t len;
-    volatile uint16_t flags;
-    volatile uint16_t next;
-} virtio_net_desc_t;
+// RSS indirection table entries and Toeplitz key length the driver programs at most
+#define VIRTIO_NET_RSS_TABLE_SIZE 128
+#define VIRTIO_NET_RSS_KEY_SIZE 40
 
-// Virtqueue available ring
-typedef struct {
-    volatile uint16_t flags;
-    volatile uint16_t idx;
-    volatile uint16_t ring[VIRTIO_NET_QUEUE_SIZE];
-    volatile uint16_t used_event;
-} virtio_net_avail_t;
+// Descriptors in a TX buffer's indirect table (VirtIO header + slot, then fragments)
+#define VIRTIO_NET_MAX_INDIRECT_DESC 16
 
-// Virtqueue used ring element
-typedef struct {
-    volatile uint32_t id;
-    volatile uint32_t len;
-} virtio_net_used_elem_t;
+// VirtIO-Net feature bits
+#define VIRTIO_NET_F_CSUM       (1u << 0)   // Device completes partial TX checksums
+#define VIRTIO_NET_F_GUEST_CSUM (1u << 1)   // Driver accepts RX frames with partial/validated checksums
+#define VIRTIO_NET_F_HOST_TSO4  (1u << 11)  // Device segments TCPv4 super-frames (requires CSUM)
+#define VIRTIO_NET_F_MRG_RXBUF  (1u << 15)  // Device may spread one frame over several RX buffers
+#define VIRTIO_NET_F_CTRL_VQ    (1u << 17)  // Control virtqueue
+#define VIRTIO_NET_F_MQ         (1u << 22)  // Multiple RX/TX queue pairs (requires CTRL_VQ)
+#define VIRTIO_NET_F_RSS        (1ull << 60) // Receive-side scaling configured by the driver (requires MQ)
 
-// Virtqueue used ring
-typedef struct {
-    volatile uint16_t flags;
-    volatile uint16_t idx;
-    virtio_net_used_elem_t ring[VIRTIO_NET_QUEUE_SIZE];
-    volatile uint16_t avail_event;
-} virtio_net_used_t;
-
-// Virtqueue structure (VirtIO legacy split queue layout)
-// This structure must match the VirtIO spec exactly - no extra fields!
-typedef struct {
-    virtio_net_desc_t desc[VIRTIO_NET_QUEUE_SIZE];
-    virtio_net_avail_t avail;
-    uint8_t padding[4096 - (16 * VIRTIO_NET_QUEUE_SIZE) - (6 + 2 * VIRTIO_NET_QUEUE_SIZE)];
-    virtio_net_used_t used;
-} __attribute__((aligned(4096))) virtio_net_queue_t;
-
-// PCI-specific queue structure with max descriptor count
-// PCI legacy virtio expects the full queue size layout
+// Device configuration space offsets (after the MAC address)
+#define VIRTIO_NET_CONFIG_MAX_QUEUE_PAIRS   8   // u16
+#define VIRTIO_NET_CONFIG_RSS_MAX_KEY_SIZE  17  // u8
+#define VIRTIO_NET_CONFIG_RSS_MAX_TABLE_LEN 18  // u16
+#define VIRTIO_NET_CONFIG_HASH_TYPES        20  // u32
+
+// Control virtqueue commands
+#define VIRTIO_NET_CTRL_MQ                  4
+#define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET     0   // Automatic flow steering over N pairs
+#define VIRTIO_NET_CTRL_MQ_RSS_CONFIG       1   // RSS: hash, indirection table and key
+#define VIRTIO_NET_OK                       0
+
+// RSS hash types
+#define VIRTIO_NET_RSS_HASH_TYPE_IPV4       (1u << 0)
+#define VIRTIO_NET_RSS_HASH_TYPE_TCPV4      (1u << 1)
+#define VIRTIO_NET_RSS_HASH_TYPE_UDPV4      (1u << 2)
+
+// Control command header (followed by command data and a device-written ack byte)
 typedef struct {
-    virtio_net_desc_t desc[VIRTIO_NET_MAX_QUEUE_SIZE];
-    // Available ring structure (inline instead of using typedef for sizing)
-    struct {
-        volatile uint16_t flags;
-        volatile uint16_t idx;
-        volatile uint16_t ring[VIRTIO_NET_MAX_QUEUE_SIZE];
-        volatile uint16_t used_event;
-    } avail;
-    // Padding to align used ring to 4096 boundary
-    // desc: 256*16=4096, avail: 4+512+2=518, total=4614
-    // Next 4096 boundary is 8192, so padding = 8192-4614 = 3578
-    uint8_t padding[8192 - (16 * VIRTIO_NET_MAX_QUEUE_SIZE) - (6 + 2 * VIRTIO_NET_MAX_QUEUE_SIZE)];
-    // Used ring structure
-    struct {
-        volatile uint16_t flags;
-        volatile uint16_t idx;
-        struct {
-            volatile uint32_t id;
-            volatile uint32_t len;
-        } ring[VIRTIO_NET_MAX_QUEUE_SIZE];
-        volatile uint16_t avail_event;
-    } used;
-} __attribute__((aligned(4096))) virtio_net_queue_pci_t;
+    uint8_t class;
+    uint8_t command;
+} virtio_net_ctrl_hdr_t;
+
+// VirtIO-Net header flags
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM 1   // Checksum from csum_start must be completed
+#define VIRTIO_NET_HDR_F_DATA_VALID 2   // RX checksum already validated by the device
+
+// VirtIO-Net header GSO types
+#define VIRTIO_NET_HDR_GSO_NONE     0
+#define VIRTIO_NET_HDR_GSO_TCPV4    1
 
 // VirtIO-Net header (legacy)
 typedef struct {
@@ -98,37 +80,52 @@ typedef struct {
     uint16_t csum_offset;
 } virtio_net_hdr_t;
 
+// VirtIO-Net header with VIRTIO_NET_F_MRG_RXBUF or VIRTIO_F_VERSION_1 (used in both directions)
+typedef struct {
+    virtio_net_hdr_t hdr;
+    uint16_t num_buffers;       // RX buffers holding this frame, 0 on TX
+} virtio_net_hdr_mrg_rxbuf_t;
+
 /**
- * VirtIO transport types
+ * How the device wakes a CPU halted in virtio_net_wait()
  */
 typedef enum {
-    VIRTIO_NET_TRANSPORT_MMIO = 0,  // Memory-mapped I/O (ARM64, RISC-V)
-    VIRTIO_NET_TRANSPORT_PCI = 1     // PCI I/O ports (AMD64)
-} virtio_net_transport_t;
+    VIRTIO_NET_IRQ_NONE = 0,                // No usable interrupt, callers keep polling
+    VIRTIO_NET_IRQ_MSIX = 1,                // PCI MSI-X, every queue on table entry 0 (AMD64)
+    VIRTIO_NET_IRQ_WIRED = 2                // MMIO interrupt line through the GIC/PLIC (ARM64, RISC-V)
+} virtio_net_irq_t;
+
+/**
+ * One RX/TX virtqueue pair (RX queue 2n, TX queue 2n+1)
+ */
+typedef struct {
+    uint8_t rx_ring_mem[VIRTQ_RING_MEM_SIZE(VIRTIO_NET_MAX_QUEUE_SIZE)] __attribute__((aligned(4096)));
+    uint8_t tx_ring_mem[VIRTQ_RING_MEM_SIZE(VIRTIO_NET_MAX_QUEUE_SIZE)] __attribute__((aligned(4096)));
+    virtqueue_t rx_vring;
+    virtqueue_t tx_vring;
+    uint8_t rx_buffers[VIRTIO_NET_MAX_BUFFERS][VIRTIO_NET_MAX_PACKET_SIZE];
+    uint8_t tx_buffers[VIRTIO_NET_MAX_BUFFERS][VIRTIO_NET_MAX_PACKET_SIZE];
+    uint16_t tx_chain_len[VIRTIO_NET_MAX_BUFFERS];  // Packed: ring positions taken by each TX buffer
+    virtq_indirect_desc_t tx_indirect[VIRTIO_NET_MAX_BUFFERS][VIRTIO_NET_MAX_INDIRECT_DESC];
+} virtio_net_queue_pair_t;
 
 /**
  * VirtIO network device context
  */
 typedef struct {
-    uint64_t io_base;
+    virtio_dev_t dev;           // Transport registers and negotiated features
     bool initialized;
-    virtio_net_transport_t transport;
     uint8_t mac_addr[6];
-    // Use union to support both MMIO (small queue) and PCI (large queue)
-    union {
-        virtio_net_queue_t mmio_rx_queue;
-        virtio_net_queue_pci_t pci_rx_queue;
-    };
-    union {
-        virtio_net_queue_t mmio_tx_queue;
-        virtio_net_queue_pci_t pci_tx_queue;
-    };
-    uint8_t rx_buffers[VIRTIO_NET_QUEUE_SIZE][VIRTIO_NET_MAX_PACKET_SIZE];
-    uint8_t tx_buffers[VIRTIO_NET_QUEUE_SIZE][VIRTIO_NET_MAX_PACKET_SIZE];
-    bool rx_desc_in_use[VIRTIO_NET_QUEUE_SIZE];
-    bool tx_desc_in_use[VIRTIO_NET_QUEUE_SIZE];
-    uint16_t rx_last_used_idx;
-    uint16_t tx_last_used_idx;
+    uint16_t queue_size;        // Descriptors (and buffers) in use per queue, <= ring size and VIRTIO_NET_MAX_BUFFERS
+    uint16_t hdr_len;           // VirtIO-Net header length: 12 with MRG_RXBUF or VERSION_1, 10 otherwise
+    uint16_t buf_offset;        // Buffer offset placing the IP header on a 4-byte boundary
+    uint16_t num_queue_pairs;   // Queue pairs in use (1 without MQ)
+    virtio_net_irq_t irq_mode;  // Wakeup interrupt used by virtio_net_wait()
+    net_stats_t stats;          // Software counters, the device keeps none
+    uint8_t ctrl_ring_mem[VIRTQ_RING_MEM_SIZE(VIRTIO_NET_CTRL_QUEUE_SIZE)] __attribute__((aligned(4096)));
+    virtqueue_t ctrl_vring;
+    uint8_t ctrl_buf[VIRTIO_NET_CTRL_BUF_SIZE];  // Command header, data and ack
+    virtio_net_queue_pair_t queue_pairs[VIRTIO_NET_MAX_QUEUE_PAIRS];
 } virtio_net_t;
 
 /**
@@ -145,21 +142,177 @@ const driver_t* virtio_net_get_driver(void);
  */
 int virtio_net_get_mac(virtio_net_t *ctx, uint8_t mac[6]);
 
+/**
+ * Get offload capabilities negotiated with virtio-net device
+ * @param ctx Device context from driver initialization
+ * @return NET_CAP_* flags
+ */
+uint32_t virtio_net_get_caps(virtio_net_t *ctx);
+
+/**
+ * Get number of RX/TX queue pairs in use
+ * Each pair can be polled independently; received flows are spread across the
+ * pairs by the device (RSS or automatic steering).
+ * @param ctx Device context from driver initialization
+ * @return Number of queue pairs (1 without VIRTIO_NET_F_MQ), 0 on error
+ */
+int virtio_net_get_queue_count(virtio_net_t *ctx);
+
+/**
+ * Get packet counters of virtio-net device
+ * The driver counts frames itself: rx_dropped covers malformed frames, frames
+ * too large for the caller's buffer and merged frames dropped by
+ * virtio_net_rx_acquire(); tx_dropped counts frames refused with NET_TX_AGAIN.
+ * @param ctx Device context from driver initialization
+ * @param stats Receives the totals since initialization
+ * @return 0 on success, -1 on error
+ */
+int virtio_net_get_stats(virtio_net_t *ctx, net_stats_t *stats);
+
+/**
+ * Halt the CPU until a queue pair receives frames
+ * Enables the RX interrupt of the queue, re-checks the ring and halts until the
+ * device interrupts, then suppresses the interrupt again so polling stays cheap.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index (below virtio_net_get_queue_count())
+ * @return 0 once frames may be available, -1 if the device cannot interrupt
+ *         (the caller keeps polling)
+ */
+int virtio_net_wait(virtio_net_t *ctx, uint16_t queue);
+
 /**
  * Transmit packet through virtio-net device
  * @param ctx Device context from driver initialization
+ * @param queue Queue pair index (below virtio_net_get_queue_count())
  * @param packet Pointer to packet data
  * @param length Packet length in bytes
- * @return 0 on success, -1 on error
+ * @return 0 on success, NET_TX_AGAIN if every TX descriptor is still in flight, -1 on error
  */
-int virtio_net_transmit(virtio_net_t *ctx, const uint8_t *packet, size_t length);
+int virtio_net_transmit(virtio_net_t *ctx, uint16_t queue, const uint8_t *packet, size_t length);
 
 /**
  * Receive packet from virtio-net device (polling)
  * @param ctx Device context from driver initialization
+ * @param queue Queue pair index (below virtio_net_get_queue_count())
  * @param buffer Buffer to store received packet
  * @param buffer_size Size of receive buffer
  * @param received_length Pointer to store received packet length
  * @return 0 on success, -1 on error or no packet available
  */
-int virtio_net_receive(virtio_net_t *ctx, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+int virtio_net_receive(virtio_net_t *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+
+/**
+ * Receive up to max_packets packets from virtio-net device (polling)
+ * Drains the RX used ring and reposts all consumed descriptors with a single kick.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index (below virtio_net_get_queue_count())
+ * @param buffers Array of max_packets receive buffers
+ * @param buffer_size Size of each receive buffer
+ * @param lengths Array receiving the length of each packet
+ * @param max_packets Maximum number of packets to receive
+ * @return Number of packets received (0 if none available), -1 on error
+ */
+int virtio_net_receive_burst(virtio_net_t *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                             size_t lengths[], int max_packets);
+
+/**
+ * Transmit up to count packets through virtio-net device
+ * Enqueues all packets on the TX ring and kicks the device once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index (below virtio_net_get_queue_count())
+ * @param packets Array of packet pointers
+ * @param lengths Array of packet lengths in bytes
+ * @param count Number of packets
+ * @return Number of packets enqueued (may be less than count if the ring is full), -1 on error
+ */
+int virtio_net_transmit_burst(virtio_net_t *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[], int count);
+
+/**
+ * Borrow received frames from virtio-net device without copying (polling)
+ * Frames point into the driver RX buffers and must be returned with
+ * virtio_net_rx_release() in the order they were acquired.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index (below virtio_net_get_queue_count())
+ * @param frames Array receiving up to max_frames frame descriptors
+ * @param max_frames Maximum number of frames to acquire
+ * @return Number of frames acquired (0 if none available), -1 on error
+ */
+int virtio_net_rx_acquire(virtio_net_t *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+
+/**
+ * Return borrowed frames to virtio-net device
+ * Reposts all descriptors and kicks the RX queue once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index (below virtio_net_get_queue_count())
+ * @param frames Frames previously returned by virtio_net_rx_acquire()
+ * @param count Number of frames
+ * @return 0 on success, -1 on error
+ */
+int virtio_net_rx_release(virtio_net_t *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+
+/**
+ * Reserve a TX buffer so a frame can be built in place (zero-copy transmit)
+ * The VirtIO-Net header is reserved in front of slot->data and is filled from
+ * slot->offload on commit.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index (below virtio_net_get_queue_count())
+ * @param slot Filled with the writable frame area
+ * @return 0 on success, NET_TX_AGAIN if no TX descriptor is free, -1 on error
+ */
+int virtio_net_tx_alloc(virtio_net_t *ctx, uint16_t queue, net_tx_slot_t *slot);
+
+/**
+ * Transmit frames built in slots from virtio_net_tx_alloc()
+ * Every allocated slot must be committed exactly once. Kicks the TX queue once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index (below virtio_net_get_queue_count())
+ * @param slots Slots returned by virtio_net_tx_alloc()
+ * @param lengths Frame length written into each slot
+ * @param count Number of slots
+ * @return Number of frames queued (invalid lengths are dropped), -1 on error
+ */
+int virtio_net_tx_commit(virtio_net_t *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count);
+
+/**
+ * Transmit one frame built from a slot followed by caller-owned fragments
+ * The slot holds the first length bytes (at least the headers); the fragments
+ * are read in place by the device, through an indirect descriptor table with
+ * VIRTIO_RING_F_INDIRECT_DESC or one chained descriptor each otherwise. With
+ * slot->offload.gso_size set the frame may be up to NET_TSO_MAX_FRAME_SIZE
+ * bytes and is segmented by the device (VIRTIO_NET_F_HOST_TSO4). Kicks the
+ * TX queue once. The slot is consumed even on failure.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index (below virtio_net_get_queue_count())
+ * @param slot Slot returned by virtio_net_tx_alloc()
+ * @param length Number of bytes written into the slot
+ * @param frags Fragments appended after the slot data
+ * @param frag_count Number of fragments
+ * @return 0 on success, NET_TX_AGAIN if the ring has no room for the fragments,
+ *         -1 on error (frame too large or offload not negotiated)
+ */
+int virtio_net_tx_commit_sg(virtio_net_t *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                            const net_tx_frag_t frags[], int frag_count);
+
+/**
+ * netdev_ops_t entry points, registered as virtio_net_get_driver()->netdev_ops
+ * They wrap the functions above with a void * context and a queue
+ * index.
+ */
+extern const netdev_ops_t virtio_net_netdev_ops;
+int virtio_net_netdev_get_mac(void *ctx, uint8_t mac[6]);
+uint32_t virtio_net_netdev_get_caps(void *ctx);
+int virtio_net_netdev_get_queue_count(void *ctx);
+int virtio_net_netdev_get_stats(void *ctx, net_stats_t *stats);
+int virtio_net_netdev_wait(void *ctx, uint16_t queue);
+int virtio_net_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length);
+int virtio_net_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+int virtio_net_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                                    size_t lengths[], int max_packets);
+int virtio_net_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                                     int count);
+int virtio_net_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+int virtio_net_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+int virtio_net_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot);
+int virtio_net_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count);
+int virtio_net_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                                   const net_tx_frag_t frags[], int frag_count);
@@ -0,0 +1,1016 @@
+#include "vmxnet3.h"
+#include "../../common/common.h"
+#include "../../common/log.h"
+#include "../../common/params.h"
+#include "../../kernel/devices/pci.h"
+#include "../../kernel/platform/platform.h"
+#include "../../apps/network/ethernet/ethernet.h"
+#include "../../apps/network/ipv4/ipv4.h"
+
+static log_tag_t *vmxnet3_log;
+
+// Kernel command line parameter selecting the interrupt moderation level
+// (0: interrupt on every event, 1-7: increasingly coalesced, 8: adaptive)
+#define VMXNET3_IRQ_MODERATION_PARAM "vmxnet3.irq_moderation"
+// Kernel command line parameter: queue pairs that receive traffic. Defaults to
+// one, since the network apps only poll queue 0
+#define VMXNET3_QUEUES_PARAM    "vmxnet3.queues"
+
+// Offset of the header checksum within the IPv4 header
+#define VMXNET3_IPV4_CSUM_OFFSET    10
+
+// Offset of the checksum within the TCP header
+#define VMXNET3_TCP_CSUM_OFFSET     16
+
+// Largest header length the TX descriptor can describe (10 bits)
+#define VMXNET3_TX_MAX_HLEN         0x3FF
+
+// Device ID table for matching
+static const device_id_t vmxnet3_id_table[] = {
+    { NULL, PCI_VENDOR_ID_VMWARE, VMXNET3_DEVICE_ID, "VMware vmxnet3 Ethernet" },
+    { NULL, 0, 0, NULL } // Terminator
+};
+
+// Microsoft's RSS verification key, so hashes can be checked against
+// published test vectors
+static const uint8_t vmxnet3_rss_key[VMXNET3_RSS_KEY_SIZE] = {
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+    0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+    0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+    0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+    0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa
+};
+
+// MMIO register access helpers: BAR0 holds the per-queue and per-vector
+// registers written on the fast path, BAR1 the configuration
+static inline void vmxnet3_write_pt(vmxnet3_t *ctx, uint32_t offset, uint32_t value) {
+    volatile uint32_t *mmio = (volatile uint32_t *)(uintptr_t)(ctx->pt_base + offset);
+    *mmio = value;
+}
+
+static inline uint32_t vmxnet3_read_vd(vmxnet3_t *ctx, uint32_t offset) {
+    volatile uint32_t *mmio = (volatile uint32_t *)(uintptr_t)(ctx->vd_base + offset);
+    return *mmio;
+}
+
+static inline void vmxnet3_write_vd(vmxnet3_t *ctx, uint32_t offset, uint32_t value) {
+    volatile uint32_t *mmio = (volatile uint32_t *)(uintptr_t)(ctx->vd_base + offset);
+    *mmio = value;
+}
+
+// Issue a command and return its result
+static uint32_t vmxnet3_command(vmxnet3_t *ctx, uint32_t command) {
+    vmxnet3_write_vd(ctx, VMXNET3_REG_CMD, command);
+    return vmxnet3_read_vd(ctx, VMXNET3_REG_CMD);
+}
+
+// Move a producer index once the descriptors before it are visible to the device
+static inline void vmxnet3_write_prod(vmxnet3_t *ctx, uint32_t offset, uint32_t value) {
+    __sync_synchronize();
+    vmxnet3_write_pt(ctx, offset, value);
+}
+
+static inline bool vmxnet3_rx_done(const vmxnet3_queue_t *q) {
+    return (q->rx_comp[q->rx_comp_current].csum_gen & VMXNET3_COMP_GEN) == q->rx_comp_gen;
+}
+
+// Read the MAC address the device reports in MACL/MACH
+static void vmxnet3_read_mac_address(vmxnet3_t *ctx) {
+    uint32_t macl = vmxnet3_read_vd(ctx, VMXNET3_REG_MACL);
+    uint32_t mach = vmxnet3_read_vd(ctx, VMXNET3_REG_MACH);
+
+    ctx->mac_addr[0] = (macl >> 0) & 0xFF;
+    ctx->mac_addr[1] = (macl >> 8) & 0xFF;
+    ctx->mac_addr[2] = (macl >> 16) & 0xFF;
+    ctx->mac_addr[3] = (macl >> 24) & 0xFF;
+    ctx->mac_addr[4] = (mach >> 0) & 0xFF;
+    ctx->mac_addr[5] = (mach >> 8) & 0xFF;
+}
+
+// Hand ring 0 descriptors to the device up to (not including) the one before
+// boundary, so one descriptor always stays empty
+// Each descriptor keeps its buffer for good (the device writes completions to
+// a separate ring), so handing one back only writes its length and generation.
+static bool vmxnet3_rx_refill(vmxnet3_queue_t *q, uint16_t boundary) {
+    bool filled = false;
+
+    // Buffer contents are read before the device may reuse them
+    __sync_synchronize();
+    while ((q->rx_fill + 1) % VMXNET3_RING_SIZE != boundary) {
+        q->rx_descs[q->rx_fill].len_gen = VMXNET3_RX_BUFFER_SIZE | VMXNET3_RXD_BTYPE_HEAD | q->rx_fill_gen;
+        q->rx_fill = (q->rx_fill + 1) % VMXNET3_RING_SIZE;
+        if (q->rx_fill == 0) {
+            q->rx_fill_gen ^= VMXNET3_RXD_GEN;
+        }
+        filled = true;
+    }
+
+    return filled;
+}
+
+// Set up the rings of one queue pair and describe them in the queue descriptors
+static void vmxnet3_queue_init(vmxnet3_t *ctx, uint16_t index, uint8_t intr_idx) {
+    vmxnet3_queue_t *q = &ctx->queues[index];
+    q->index = index;
+    q->rx_comp_current = 0;
+    q->rx_comp_gen = VMXNET3_COMP_GEN;
+    q->rx_next = 0;
+    q->rx_fill = 0;
+    q->rx_fill_gen = VMXNET3_RXD_GEN;
+    q->rx_lent = 0;
+    q->rx_unreturned = 0;
+    q->tx_current = 0;
+    q->tx_gen = VMXNET3_TXD_GEN;
+    q->tx_clean = 0;
+    q->tx_inflight = 0;
+    q->tx_comp_current = 0;
+    q->tx_comp_gen = VMXNET3_COMP_GEN;
+    q->tx_buffer_head = 0;
+    q->tx_reserved = 0;
+
+    // Descriptors and completions start with generation 0, which the device
+    // and the driver both read as not yet theirs
+    for (uint16_t i = 0; i < VMXNET3_RING_SIZE; i++) {
+        q->rx_descs[i].addr = (uintptr_t)q->rx_buffers[i];
+        q->rx_descs[i].len_gen = 0;
+        q->rx_descs[i].reserved = 0;
+        q->tx_descs[i].addr = 0;
+        q->tx_descs[i].len_gen_msscof = 0;
+        q->tx_descs[i].hlen_om_flags = 0;
+        q->tx_comp[i].type_gen = 0;
+        q->tx_desc_buffer[i] = VMXNET3_TX_NO_BUFFER;
+        q->tx_buffer_busy[i] = false;
+    }
+    for (uint16_t i = 0; i < VMXNET3_RX_RING2_SIZE; i++) {
+        q->rx_descs2[i].addr = 0;
+        q->rx_descs2[i].len_gen = 0;
+        q->rx_descs2[i].reserved = 0;
+    }
+    for (uint16_t i = 0; i < VMXNET3_RX_COMP_SIZE; i++) {
+        q->rx_comp[i].csum_gen = 0;
+    }
+    vmxnet3_rx_refill(q, 0);
+
+    vmxnet3_tx_queue_desc_t *txq = &ctx->queue_descs.tx[index];
+    txq->tx_num_deferred = 0;
+    txq->tx_threshold = 0;
+    txq->tx_ring_pa = (uintptr_t)q->tx_descs;
+    txq->data_ring_pa = (uintptr_t)q->tx_data;
+    txq->comp_ring_pa = (uintptr_t)q->tx_comp;
+    txq->dd_pa = 0;
+    txq->tx_ring_size = VMXNET3_RING_SIZE;
+    txq->data_ring_size = VMXNET3_RING_SIZE;
+    txq->comp_ring_size = VMXNET3_RING_SIZE;
+    txq->dd_len = 0;
+    txq->intr_idx = intr_idx;
+
+    vmxnet3_rx_queue_desc_t *rxq = &ctx->queue_descs.rx[index];
+    rxq->update_rx_prod = 0;
+    rxq->rx_ring_pa[0] = (uintptr_t)q->rx_descs;
+    rxq->rx_ring_pa[1] = (uintptr_t)q->rx_descs2;
+    rxq->comp_ring_pa = (uintptr_t)q->rx_comp;
+    rxq->dd_pa = 0;
+    rxq->data_ring_pa = 0;
+    rxq->rx_ring_size[0] = VMXNET3_RING_SIZE;
+    rxq->rx_ring_size[1] = VMXNET3_RX_RING2_SIZE;
+    rxq->comp_ring_size = VMXNET3_RX_COMP_SIZE;
+    rxq->dd_len = 0;
+    rxq->intr_idx = intr_idx;
+}
+
+// Spread received flows over the queue pairs: the device hashes IPv4
+// addresses (and TCP ports) with the Toeplitz key and looks the hash up in
+// the indirection table, whose entries hold the queue number
+static void vmxnet3_rss_init(vmxnet3_t *ctx) {
+    vmxnet3_rss_conf_t *rss = &ctx->rss_conf;
+    rss->hash_type = VMXNET3_RSS_HASH_IPV4 | VMXNET3_RSS_HASH_TCP_IPV4;
+    rss->hash_func = VMXNET3_RSS_HASH_TOEPLITZ;
+    rss->hash_key_size = VMXNET3_RSS_KEY_SIZE;
+    rss->ind_table_size = VMXNET3_RSS_IND_TABLE_USED;
+    for (int i = 0; i < VMXNET3_RSS_KEY_SIZE; i++) {
+        rss->hash_key[i] = vmxnet3_rss_key[i];
+    }
+    for (int i = 0; i < VMXNET3_RSS_IND_TABLE_USED; i++) {
+        rss->ind_table[i] = (uint8_t)(i % ctx->num_queues);
+    }
+
+    ctx->shared.upt_features |= VMXNET3_F_RSS;
+    ctx->shared.rss_conf_ver = 1;
+    ctx->shared.rss_conf_len = sizeof(vmxnet3_rss_conf_t);
+    ctx->shared.rss_conf_pa = (uintptr_t)rss;
+}
+
+// Lifecycle hooks
+static int vmxnet3_init_context(void *ctx, device_t *device) {
+    if (!ctx || !device || device->reg_base == 0) {
+        return -1;
+    }
+
+    if (!vmxnet3_log) vmxnet3_log = log_register("vmxnet3", LOG_INFO);
+
+    vmxnet3_t *vmx_ctx = (vmxnet3_t *)ctx;
+    vmx_ctx->pt_base = device->reg_base;
+    vmx_ctx->vd_base = pci_bar_address(device->bus, device->device_num, device->function, 1);
+    if (vmx_ctx->vd_base == 0) {
+        log_error(vmxnet3_log, "BAR1 is not mapped\n");
+        return -1;
+    }
+
+    // Select revision 1 of the device and UPT interfaces
+    if ((vmxnet3_read_vd(vmx_ctx, VMXNET3_REG_VRRS) & VMXNET3_REVISION_1) == 0 ||
+        (vmxnet3_read_vd(vmx_ctx, VMXNET3_REG_UVRS) & VMXNET3_REVISION_1) == 0) {
+        log_error(vmxnet3_log, "Device does not support revision 1\n");
+        return -1;
+    }
+    vmxnet3_write_vd(vmx_ctx, VMXNET3_REG_VRRS, VMXNET3_REVISION_1);
+    vmxnet3_write_vd(vmx_ctx, VMXNET3_REG_UVRS, VMXNET3_REVISION_1);
+    vmxnet3_command(vmx_ctx, VMXNET3_CMD_RESET_DEV);
+
+    vmxnet3_read_mac_address(vmx_ctx);
+
+    // Interrupts only wake vmxnet3_wait(): a vector per queue pair plus one for
+    // device events with MSI-X, otherwise a single vector for everything
+    uint64_t msi_address;
+    uint32_t msi_data;
+    bool have_msi = device->compatible == NULL && platform_msi_get_message(&msi_address, &msi_data) == 0;
+    uint8_t num_intrs = 1;
+    vmx_ctx->irq_mode = VMXNET3_IRQ_NONE;
+    if (have_msi && pci_msix_enable(device->bus, device->device_num, device->function, VMXNET3_NUM_QUEUES + 1,
+                                    msi_address, msi_data, NULL) == 0) {
+        vmx_ctx->irq_mode = VMXNET3_IRQ_MSIX;
+        num_intrs = VMXNET3_NUM_QUEUES + 1;
+    } else if (have_msi && pci_msi_enable(device->bus, device->device_num, device->function,
+                                          msi_address, msi_data) == 0) {
+        vmx_ctx->irq_mode = VMXNET3_IRQ_MSI;
+    } else if (device->irq != 0 && platform_irq_enable(device->irq) == 0) {
+        vmx_ctx->irq_mode = VMXNET3_IRQ_WIRED;
+    }
+
+    for (uint16_t i = 0; i < VMXNET3_NUM_QUEUES; i++) {
+        vmxnet3_queue_init(vmx_ctx, i, vmx_ctx->irq_mode == VMXNET3_IRQ_MSIX ? (uint8_t)i : 0);
+    }
+
+    // The device reads the whole configuration from the shared area when it
+    // is activated; RX checksum validation is the only offload that has to
+    // be requested, TX offloads are asked for per frame
+    vmxnet3_shared_t *shared = &vmx_ctx->shared;
+    shared->magic = VMXNET3_SHARED_MAGIC;
+    shared->driver_version = VMXNET3_DRIVER_VERSION;
+    shared->gos = VMXNET3_GOS_BITS_64;
+    shared->vmxnet3_rev_spt = VMXNET3_REVISION_1;
+    shared->upt_ver_spt = VMXNET3_REVISION_1;
+    shared->upt_features = VMXNET3_F_RXCSUM;
+    shared->queue_desc_pa = (uintptr_t)&vmx_ctx->queue_descs;
+    shared->queue_desc_len = sizeof(vmxnet3_queue_descs_t);
+    shared->mtu = 1500;
+    shared->max_num_rx_sg = 1;
+    shared->num_tx_queues = VMXNET3_NUM_QUEUES;
+    shared->num_rx_queues = VMXNET3_NUM_QUEUES;
+
+    // Vectors stay masked until a wait unmasks one; the device coalesces
+    // interrupts according to the moderation level
+    uint32_t moderation = VMXNET3_IRQ_MODERATION_DEFAULT;
+    params_get_uint(VMXNET3_IRQ_MODERATION_PARAM, &moderation);
+    if (moderation > VMXNET3_IML_ADAPTIVE) {
+        moderation = VMXNET3_IML_ADAPTIVE;
+    }
+    shared->auto_mask = 0;
+    shared->num_intrs = num_intrs;
+    shared->event_intr_idx = num_intrs - 1;
+    for (int i = 0; i < VMXNET3_MAX_INTRS; i++) {
+        shared->mod_levels[i] = (uint8_t)moderation;
+    }
+    shared->intr_ctrl = VMXNET3_IC_DISABLE_ALL;
+
+    shared->rx_mode = VMXNET3_RXM_UCAST | VMXNET3_RXM_BCAST | VMXNET3_RXM_ALL_MULTI | VMXNET3_RXM_PROMISC;
+
+    // All pairs are set up, but without RSS the device delivers every frame
+    // to the first one
+    uint32_t num_queues = 1;
+    params_get_uint(VMXNET3_QUEUES_PARAM, &num_queues);
+    if (num_queues < 1) {
+        num_queues = 1;
+    } else if (num_queues > VMXNET3_NUM_QUEUES) {
+        num_queues = VMXNET3_NUM_QUEUES;
+    }
+    vmx_ctx->num_queues = (uint16_t)num_queues;
+    if (vmx_ctx->num_queues > 1) {
+        vmxnet3_rss_init(vmx_ctx);
+    }
+
+    __sync_synchronize();
+    vmxnet3_write_vd(vmx_ctx, VMXNET3_REG_DSAL, (uint32_t)(uintptr_t)shared);
+    vmxnet3_write_vd(vmx_ctx, VMXNET3_REG_DSAH, (uint32_t)((uintptr_t)shared >> 32));
+    if (vmxnet3_command(vmx_ctx, VMXNET3_CMD_ACTIVATE_DEV) != 0) {
+        log_error(vmxnet3_log, "Device activation failed\n");
+        return -1;
+    }
+
+    for (uint16_t i = 0; i < VMXNET3_NUM_QUEUES; i++) {
+        vmxnet3_write_prod(vmx_ctx, VMXNET3_REG_RXPROD(i), vmx_ctx->queues[i].rx_fill);
+        vmxnet3_write_prod(vmx_ctx, VMXNET3_REG_RXPROD2(i), 0);
+    }
+
+    // Mask every vector, then let interrupts through the global switch
+    for (uint8_t i = 0; i < num_intrs; i++) {
+        vmxnet3_write_pt(vmx_ctx, VMXNET3_REG_IMR(i), 1);
+    }
+    shared->intr_ctrl &= ~VMXNET3_IC_DISABLE_ALL;
+
+    vmx_ctx->initialized = true;
+    log_info(vmxnet3_log, "Driver initialized successfully\n");
+    return 0;
+}
+
+static void vmxnet3_deinit_context(void *ctx) {
+    // TODO: Deinitialize vmxnet3 device context
+    (void)ctx;
+}
+
+// Driver descriptor
+static const driver_t vmxnet3_driver = {
+    .name = "vmxnet3",
+    .version = "0.1.0",
+    .type = DRIVER_TYPE_NETWORK,
+    .id_table = vmxnet3_id_table,
+    .init_context = vmxnet3_init_context,
+    .deinit_context = vmxnet3_deinit_context,
+    .netdev_ops = &vmxnet3_netdev_ops
+};
+
+const driver_t* vmxnet3_get_driver(void) {
+    return &vmxnet3_driver;
+}
+
+// Queue pair for a public call, NULL if the device or queue is not usable
+static inline vmxnet3_queue_t *vmxnet3_queue(vmxnet3_t *ctx, uint16_t queue) {
+    if (!ctx || !ctx->initialized || queue >= ctx->num_queues) {
+        return NULL;
+    }
+    return &ctx->queues[queue];
+}
+
+int vmxnet3_get_mac(vmxnet3_t *ctx, uint8_t mac[6]) {
+    if (!ctx || !mac || !ctx->initialized) {
+        return -1;
+    }
+
+    for (int i = 0; i < 6; i++) {
+        mac[i] = ctx->mac_addr[i];
+    }
+
+    return 0;
+}
+
+uint32_t vmxnet3_get_caps(vmxnet3_t *ctx) {
+    (void)ctx;
+
+    // Checksums and segmentation are requested in the first TX descriptor of
+    // a frame, RX checksum validation through VMXNET3_F_RXCSUM
+    return NET_CAP_TX_CSUM | NET_CAP_RX_CSUM | NET_CAP_TSO4;
+}
+
+int vmxnet3_get_queue_count(vmxnet3_t *ctx) {
+    if (!ctx || !ctx->initialized) {
+        return 1;
+    }
+    return ctx->num_queues;
+}
+
+int vmxnet3_get_stats(vmxnet3_t *ctx, net_stats_t *stats) {
+    if (!ctx || !stats || !ctx->initialized) {
+        return -1;
+    }
+
+    // The device writes its running counters into the queue descriptors
+    vmxnet3_command(ctx, VMXNET3_CMD_GET_STATS);
+    __sync_synchronize();
+
+    *stats = (net_stats_t){0};
+    for (int q = 0; q < VMXNET3_NUM_QUEUES; q++) {
+        const uint64_t *tx = ctx->queue_descs.tx[q].stats;
+        const uint64_t *rx = ctx->queue_descs.rx[q].stats;
+        stats->tx_packets += tx[VMXNET3_STAT_UCAST_PKTS] + tx[VMXNET3_STAT_MCAST_PKTS] + tx[VMXNET3_STAT_BCAST_PKTS];
+        stats->rx_packets += rx[VMXNET3_STAT_UCAST_PKTS] + rx[VMXNET3_STAT_MCAST_PKTS] + rx[VMXNET3_STAT_BCAST_PKTS];
+        stats->rx_dropped += rx[VMXNET3_STAT_RX_OUT_OF_BUF];
+    }
+
+    return 0;
+}
+
+// NET_RX_F_* flags of a received frame: the device verified the IPv4 header
+// and its TCP/UDP checksum
+static inline uint16_t vmxnet3_rx_flags(uint32_t idx_flags, uint32_t csum_gen) {
+    uint32_t valid = VMXNET3_RCD_V4 | VMXNET3_RCD_IPC | VMXNET3_RCD_TUC;
+    if ((idx_flags & VMXNET3_RCD_CNC) == 0 && (csum_gen & valid) == valid &&
+        (csum_gen & (VMXNET3_RCD_TCP | VMXNET3_RCD_UDP)) != 0) {
+        return NET_RX_F_CSUM_VALID;
+    }
+    return 0;
+}
+
+// Take the completion at rx_comp_current
+// Returns 1 with the frame's RX descriptor, length and flags, or -1 if the
+// frame has to be dropped (spans buffers, has errors or came from ring 1).
+static int vmxnet3_rx_take(vmxnet3_queue_t *q, uint16_t *slot, uint16_t *length, uint16_t *flags) {
+    // Read the rest of the completion only after seeing its generation
+    __sync_synchronize();
+
+    const vmxnet3_rx_comp_desc_t *comp = &q->rx_comp[q->rx_comp_current];
+    uint32_t idx_flags = comp->idx_flags;
+    uint32_t len_err = comp->len_err;
+    uint32_t csum_gen = comp->csum_gen;
+
+    q->rx_comp_current = (q->rx_comp_current + 1) % VMXNET3_RX_COMP_SIZE;
+    if (q->rx_comp_current == 0) {
+        q->rx_comp_gen ^= VMXNET3_COMP_GEN;
+    }
+
+    if (((idx_flags >> VMXNET3_RCD_RQID_SHIFT) & VMXNET3_RCD_RQID_MASK) != q->index) {
+        return -1;
+    }
+
+    *slot = (uint16_t)(idx_flags & VMXNET3_RCD_IDX_MASK) % VMXNET3_RING_SIZE;
+    q->rx_next = (*slot + 1) % VMXNET3_RING_SIZE;
+
+    uint32_t whole = VMXNET3_RCD_SOP | VMXNET3_RCD_EOP;
+    if ((idx_flags & whole) != whole || (len_err & VMXNET3_RCD_ERR) != 0) {
+        return -1;
+    }
+
+    *length = (uint16_t)(len_err & VMXNET3_RCD_LEN_MASK);
+    *flags = vmxnet3_rx_flags(idx_flags, csum_gen);
+    return 1;
+}
+
+// Consume the completion at rx_comp_current without handing buffers back
+// Returns 1 if a packet was copied, 0 if no packet is available, -1 if a packet was dropped
+static int vmxnet3_rx_next(vmxnet3_queue_t *q, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    if (!vmxnet3_rx_done(q)) {
+        return 0;
+    }
+
+    uint16_t slot;
+    uint16_t length;
+    uint16_t flags;
+    if (vmxnet3_rx_take(q, &slot, &length, &flags) < 0 || length > buffer_size) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = q->rx_buffers[slot][i];
+    }
+    *received_length = length;
+
+    return 1;
+}
+
+// Hand every consumed RX buffer back, telling the device only if it asked to be
+static void vmxnet3_rx_return(vmxnet3_t *ctx, vmxnet3_queue_t *q, uint16_t boundary) {
+    if (vmxnet3_rx_refill(q, boundary) && ctx->queue_descs.rx[q->index].update_rx_prod) {
+        vmxnet3_write_prod(ctx, VMXNET3_REG_RXPROD(q->index), q->rx_fill);
+    }
+    q->rx_unreturned = 0;
+}
+
+// Complete an interrupt: acknowledge device events and, on INTx, read ICR to
+// drop the line before completing it at the controller
+static void vmxnet3_irq_ack(vmxnet3_t *ctx) {
+    uint32_t events = ctx->shared.ecr;
+    if (events != 0) {
+        vmxnet3_write_vd(ctx, VMXNET3_REG_ECR, events);
+    }
+    if (ctx->irq_mode == VMXNET3_IRQ_WIRED) {
+        vmxnet3_read_vd(ctx, VMXNET3_REG_ICR);
+        platform_irq_ack();
+    }
+}
+
+int vmxnet3_wait(vmxnet3_t *ctx, uint16_t queue) {
+    vmxnet3_queue_t *q = vmxnet3_queue(ctx, queue);
+    if (!q || ctx->irq_mode == VMXNET3_IRQ_NONE) {
+        return -1;
+    }
+
+    // The device can only receive into buffers it owns
+    if (q->rx_unreturned > 0) {
+        vmxnet3_rx_return(ctx, q, q->rx_next);
+    }
+
+    // Drop a wired cause raised while polling so it cannot end the wait right
+    // away; a message raised while masked may still end it early
+    vmxnet3_irq_ack(ctx);
+
+    // Check the ring again after unmasking: a frame completed while the
+    // vector was masked would not interrupt
+    uint32_t imr = VMXNET3_REG_IMR(ctx->irq_mode == VMXNET3_IRQ_MSIX ? q->index : 0);
+    vmxnet3_write_pt(ctx, imr, 0);
+    if (!vmxnet3_rx_done(q)) {
+        platform_irq_wait();
+    }
+    vmxnet3_write_pt(ctx, imr, 1);
+    vmxnet3_irq_ack(ctx);
+
+    return 0;
+}
+
+int vmxnet3_receive(vmxnet3_t *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size,
+                    size_t *received_length) {
+    vmxnet3_queue_t *q = vmxnet3_queue(ctx, queue);
+    if (!q || !buffer || !received_length) {
+        return -1;
+    }
+
+    int result = vmxnet3_rx_next(q, buffer, buffer_size, received_length);
+    if (result == 0) {
+        if (q->rx_unreturned != 0) {
+            vmxnet3_rx_return(ctx, q, q->rx_next);
+        }
+        return -1;
+    }
+
+    // Defer handing buffers back while more frames are waiting
+    q->rx_unreturned++;
+    if (!vmxnet3_rx_done(q) || q->rx_unreturned >= VMXNET3_RX_PROD_BATCH) {
+        vmxnet3_rx_return(ctx, q, q->rx_next);
+    }
+
+    return result > 0 ? 0 : -1;
+}
+
+int vmxnet3_receive_burst(vmxnet3_t *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                          size_t lengths[], int max_packets) {
+    vmxnet3_queue_t *q = vmxnet3_queue(ctx, queue);
+    if (!q || !buffers || !lengths || max_packets < 0) {
+        return -1;
+    }
+
+    int received = 0;
+    bool consumed = false;
+    while (received < max_packets) {
+        int result = vmxnet3_rx_next(q, buffers[received], buffer_size, &lengths[received]);
+        if (result == 0) {
+            break;
+        }
+        consumed = true;
+        if (result > 0) {
+            received++;
+        }
+    }
+
+    // Hand all consumed buffers back in one go
+    if (consumed || q->rx_unreturned != 0) {
+        vmxnet3_rx_return(ctx, q, q->rx_next);
+    }
+
+    return received;
+}
+
+int vmxnet3_rx_acquire(vmxnet3_t *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames) {
+    vmxnet3_queue_t *q = vmxnet3_queue(ctx, queue);
+    if (!q || !frames || max_frames < 0) {
+        return -1;
+    }
+
+    int acquired = 0;
+    while (acquired < max_frames && vmxnet3_rx_done(q)) {
+        uint16_t slot;
+        uint16_t length;
+        uint16_t flags;
+        if (vmxnet3_rx_take(q, &slot, &length, &flags) < 0) {
+            // Give dropped buffers straight back unless lent frames are still
+            // outstanding (release covers them)
+            if (q->rx_lent == 0 && acquired == 0) {
+                vmxnet3_rx_return(ctx, q, q->rx_next);
+            }
+            continue;
+        }
+
+        frames[acquired].data = q->rx_buffers[slot];
+        frames[acquired].length = length;
+        frames[acquired].slot = slot;
+        frames[acquired].flags = flags;
+        acquired++;
+    }
+
+    q->rx_lent += acquired;
+    return acquired;
+}
+
+int vmxnet3_rx_release(vmxnet3_t *ctx, uint16_t queue, const net_rx_frame_t frames[], int count) {
+    vmxnet3_queue_t *q = vmxnet3_queue(ctx, queue);
+    if (!q || !frames || count < 0 || count > q->rx_lent) {
+        return -1;
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    q->rx_lent -= count;
+
+    // Buffers are returned in ring order, so everything up to the last released
+    // slot can go back (or past any dropped ones once nothing is lent)
+    if (q->rx_lent == 0) {
+        vmxnet3_rx_return(ctx, q, q->rx_next);
+    } else {
+        vmxnet3_rx_return(ctx, q, (frames[count - 1].slot + 1) % VMXNET3_RING_SIZE);
+    }
+
+    return 0;
+}
+
+// Reclaim TX descriptors of frames the device reported complete
+static void vmxnet3_tx_reclaim(vmxnet3_queue_t *q) {
+    while ((q->tx_comp[q->tx_comp_current].type_gen & VMXNET3_COMP_GEN) == q->tx_comp_gen) {
+        // Read the descriptor index only after seeing the generation
+        __sync_synchronize();
+        uint16_t last = (uint16_t)(q->tx_comp[q->tx_comp_current].txd_idx & VMXNET3_TCD_IDX_MASK) %
+                        VMXNET3_RING_SIZE;
+
+        uint16_t count = (uint16_t)((last + VMXNET3_RING_SIZE - q->tx_clean) % VMXNET3_RING_SIZE + 1);
+        for (uint16_t i = 0; i < count; i++) {
+            uint16_t buffer = q->tx_desc_buffer[(q->tx_clean + i) % VMXNET3_RING_SIZE];
+            if (buffer != VMXNET3_TX_NO_BUFFER) {
+                q->tx_buffer_busy[buffer] = false;
+            }
+        }
+        q->tx_clean = (last + 1) % VMXNET3_RING_SIZE;
+        q->tx_inflight -= count;
+
+        q->tx_comp_current = (q->tx_comp_current + 1) % VMXNET3_RING_SIZE;
+        if (q->tx_comp_current == 0) {
+            q->tx_comp_gen ^= VMXNET3_COMP_GEN;
+        }
+    }
+}
+
+// Whether count more descriptors fit in the ring next to those in flight and
+// reserved; one descriptor stays unused so a full ring is told from an empty one
+static bool vmxnet3_tx_has_room(vmxnet3_queue_t *q, uint32_t count) {
+    if (q->tx_inflight + (uint32_t)q->tx_reserved + count <= VMXNET3_RING_SIZE - 1u) {
+        return true;
+    }
+    vmxnet3_tx_reclaim(q);
+    return q->tx_inflight + (uint32_t)q->tx_reserved + count <= VMXNET3_RING_SIZE - 1u;
+}
+
+// Reserve the next TX buffer after any already handed out
+static int vmxnet3_tx_claim(vmxnet3_queue_t *q, net_tx_slot_t *slot) {
+    if (!vmxnet3_tx_has_room(q, 1)) {
+        return -1;
+    }
+
+    uint16_t index = (q->tx_buffer_head + q->tx_reserved) % VMXNET3_RING_SIZE;
+    if (q->tx_buffer_busy[index]) {
+        return -1;
+    }
+    q->tx_buffer_busy[index] = true;
+
+    slot->data = &q->tx_buffers[index][VMXNET3_TX_HEADROOM];
+    slot->capacity = VMXNET3_TX_BUFFER_SIZE - VMXNET3_TX_HEADROOM;
+    slot->slot = index;
+    slot->offload.csum_start = 0;
+    slot->offload.csum_offset = 0;
+    slot->offload.gso_size = 0;
+    q->tx_reserved++;
+
+    return 0;
+}
+
+// Write the descriptor at tx_current; buffer (or VMXNET3_TX_NO_BUFFER) is
+// released when the frame completes. The first descriptor of a frame gets the
+// generation the device does not expect yet, so it stays the driver's until
+// vmxnet3_tx_publish() flips it.
+static uint16_t vmxnet3_tx_put(vmxnet3_queue_t *q, uint16_t buffer, uint64_t addr, size_t length,
+                               uint32_t msscof, uint32_t hlen_om_flags, bool first) {
+    uint16_t index = q->tx_current;
+    vmxnet3_tx_desc_t *desc = &q->tx_descs[index];
+
+    desc->addr = addr;
+    desc->hlen_om_flags = hlen_om_flags;
+    desc->len_gen_msscof = ((uint32_t)length % VMXNET3_TX_MAX_DATA_PER_DESC) |
+                           (first ? q->tx_gen ^ VMXNET3_TXD_GEN : q->tx_gen) |
+                           msscof << VMXNET3_TXD_MSSCOF_SHIFT;
+    q->tx_desc_buffer[index] = buffer;
+    q->tx_current = (index + 1) % VMXNET3_RING_SIZE;
+    if (q->tx_current == 0) {
+        q->tx_gen ^= VMXNET3_TXD_GEN;
+    }
+    q->tx_inflight++;
+    return index;
+}
+
+// Descriptors needed for a buffer of the given length
+static inline uint32_t vmxnet3_tx_desc_count(size_t length) {
+    return (uint32_t)((length + VMXNET3_TX_MAX_DATA_PER_DESC - 1) / VMXNET3_TX_MAX_DATA_PER_DESC);
+}
+
+// Hand the oldest reserved slot to the device, followed by one or more
+// descriptors per caller-owned fragment (no TXPROD write)
+// Offload requests go into the first descriptor: the checksum position for a
+// checksum, header length and MSS for segmentation. The last descriptor asks
+// for a completion.
+// The slot is consumed: returns 0 once queued, -1 for an invalid request or
+// NET_TX_AGAIN when the ring has no room for the descriptors
+static int vmxnet3_tx_publish(vmxnet3_queue_t *q, size_t length, const net_tx_offload_t *offload,
+                              const net_tx_frag_t frags[], int frag_count) {
+    uint16_t buffer = q->tx_buffer_head;
+    uint8_t *frame = &q->tx_buffers[buffer][VMXNET3_TX_HEADROOM];
+    size_t capacity = VMXNET3_TX_BUFFER_SIZE - VMXNET3_TX_HEADROOM;
+    bool gso = offload && offload->gso_size != 0;
+    bool csum = offload && offload->csum_start != 0;
+
+    q->tx_buffer_head = (buffer + 1) % VMXNET3_RING_SIZE;
+    q->tx_reserved--;
+
+    size_t frame_len = length;
+    size_t hdr_len = 0;
+    uint32_t descs = 1;
+    bool valid = length > 0 && length <= capacity && frag_count >= 0 && (frag_count == 0 || frags);
+    if (csum && ((size_t)offload->csum_start + offload->csum_offset + 2 > length ||
+                 offload->csum_start > VMXNET3_TX_MAX_HLEN)) {
+        valid = false;
+    }
+    if (valid && gso) {
+        if (!csum || offload->csum_offset != VMXNET3_TCP_CSUM_OFFSET ||
+            offload->csum_start < sizeof(eth_hdr_t) + sizeof(ipv4_hdr_t) ||
+            (size_t)offload->csum_start + 12 >= length || offload->gso_size >= VMXNET3_TX_MAX_DATA_PER_DESC) {
+            valid = false;
+        } else {
+            hdr_len = offload->csum_start + (frame[offload->csum_start + 12] >> 4) * 4;
+            valid = hdr_len <= length && hdr_len <= VMXNET3_TX_MAX_HLEN;
+        }
+    }
+    for (int i = 0; valid && i < frag_count; i++) {
+        if (!frags[i].data || frags[i].length == 0) {
+            valid = false;
+        }
+        frame_len += frags[i].length;
+        descs += vmxnet3_tx_desc_count(frags[i].length);
+    }
+    if (!valid || frame_len > (gso ? NET_TSO_MAX_FRAME_SIZE : capacity)) {
+        q->tx_buffer_busy[buffer] = false;
+        return -1;
+    }
+
+    if (!vmxnet3_tx_has_room(q, descs)) {
+        q->tx_buffer_busy[buffer] = false;
+        return NET_TX_AGAIN;
+    }
+
+    uint32_t msscof = 0;
+    uint32_t hlen_om = 0;
+    if (gso) {
+        // The device adds each segment's length to the TCP pseudo-header sum
+        // and recomputes the IPv4 header checksum per segment, so strip the
+        // length the caller summed in and clear the IPv4 checksum
+        uint8_t *sum = frame + offload->csum_start + offload->csum_offset;
+        uint32_t value = ((uint32_t)sum[0] << 8 | sum[1]) + (uint16_t)~(frame_len - offload->csum_start);
+        value = (value & 0xFFFF) + (value >> 16);
+        sum[0] = (uint8_t)(value >> 8);
+        sum[1] = (uint8_t)value;
+        frame[sizeof(eth_hdr_t) + VMXNET3_IPV4_CSUM_OFFSET] = 0;
+        frame[sizeof(eth_hdr_t) + VMXNET3_IPV4_CSUM_OFFSET + 1] = 0;
+        msscof = offload->gso_size;
+        hlen_om = (uint32_t)hdr_len | VMXNET3_OM_TSO << VMXNET3_TXD_OM_SHIFT;
+    } else if (csum) {
+        msscof = (uint32_t)offload->csum_start + offload->csum_offset;
+        hlen_om = offload->csum_start | VMXNET3_OM_CSUM << VMXNET3_TXD_OM_SHIFT;
+    }
+
+    // Slot data first, then the fragments in pieces of at most
+    // VMXNET3_TX_MAX_DATA_PER_DESC bytes; EOP marks the last descriptor
+    uint32_t last_flags = VMXNET3_TXD_EOP | VMXNET3_TXD_CQ;
+    uint16_t first = vmxnet3_tx_put(q, buffer, (uintptr_t)frame, length, msscof,
+                                    hlen_om | (frag_count == 0 ? last_flags : 0), true);
+    for (int i = 0; i < frag_count; i++) {
+        size_t offset = 0;
+        while (offset < frags[i].length) {
+            size_t chunk = frags[i].length - offset;
+            if (chunk > VMXNET3_TX_MAX_DATA_PER_DESC) {
+                chunk = VMXNET3_TX_MAX_DATA_PER_DESC;
+            }
+            bool last = i + 1 == frag_count && offset + chunk == frags[i].length;
+            vmxnet3_tx_put(q, VMXNET3_TX_NO_BUFFER, (uintptr_t)(frags[i].data + offset), chunk,
+                           0, last ? last_flags : 0, false);
+            offset += chunk;
+        }
+    }
+
+    // Hand the whole frame over at once
+    __sync_synchronize();
+    q->tx_descs[first].len_gen_msscof ^= VMXNET3_TXD_GEN;
+
+    return 0;
+}
+
+// Tell the device about queued frames once as many are deferred as it asks for
+static void vmxnet3_tx_notify(vmxnet3_t *ctx, vmxnet3_queue_t *q, int frames) {
+    vmxnet3_tx_queue_desc_t *txq = &ctx->queue_descs.tx[q->index];
+    txq->tx_num_deferred += (uint32_t)frames;
+    if (txq->tx_num_deferred >= txq->tx_threshold) {
+        txq->tx_num_deferred = 0;
+        vmxnet3_write_prod(ctx, VMXNET3_REG_TXPROD(q->index), q->tx_current);
+    }
+}
+
+// Copy one packet into the next TX buffer without notifying the device
+static int vmxnet3_tx_enqueue(vmxnet3_queue_t *q, const uint8_t *buffer, size_t length) {
+    if (!buffer || length > VMXNET3_TX_BUFFER_SIZE - VMXNET3_TX_HEADROOM) {
+        return -1;
+    }
+
+    // Frames already reserved for zero-copy go out first
+    if (q->tx_reserved != 0) {
+        return -1;
+    }
+
+    net_tx_slot_t slot;
+    if (vmxnet3_tx_claim(q, &slot) != 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        slot.data[i] = buffer[i];
+    }
+
+    return vmxnet3_tx_publish(q, length, NULL, NULL, 0);
+}
+
+int vmxnet3_transmit(vmxnet3_t *ctx, uint16_t queue, const uint8_t *buffer, size_t length) {
+    vmxnet3_queue_t *q = vmxnet3_queue(ctx, queue);
+    if (!q || !buffer) {
+        return -1;
+    }
+
+    if (vmxnet3_tx_enqueue(q, buffer, length) != 0) {
+        return -1;
+    }
+
+    vmxnet3_tx_notify(ctx, q, 1);
+
+    return 0;
+}
+
+int vmxnet3_transmit_burst(vmxnet3_t *ctx, uint16_t queue, const uint8_t *const packets[],
+                           const size_t lengths[], int count) {
+    vmxnet3_queue_t *q = vmxnet3_queue(ctx, queue);
+    if (!q || !packets || !lengths || count < 0) {
+        return -1;
+    }
+
+    int sent = 0;
+    while (sent < count) {
+        if (vmxnet3_tx_enqueue(q, packets[sent], lengths[sent]) != 0) {
+            break;
+        }
+        sent++;
+    }
+
+    // Single notification triggers transmission of the whole batch
+    if (sent > 0) {
+        vmxnet3_tx_notify(ctx, q, sent);
+    }
+
+    return sent;
+}
+
+int vmxnet3_tx_alloc(vmxnet3_t *ctx, uint16_t queue, net_tx_slot_t *slot) {
+    vmxnet3_queue_t *q = vmxnet3_queue(ctx, queue);
+    if (!q || !slot) {
+        return -1;
+    }
+
+    return vmxnet3_tx_claim(q, slot);
+}
+
+int vmxnet3_tx_commit(vmxnet3_t *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[],
+                      int count) {
+    vmxnet3_queue_t *q = vmxnet3_queue(ctx, queue);
+    if (!q || !slots || !lengths || count < 0 || count > q->tx_reserved) {
+        return -1;
+    }
+
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        // Slots come back in allocation order, which is buffer order
+        if (slots[i].slot != q->tx_buffer_head) {
+            break;
+        }
+        // Invalid frames are dropped; their slot is released either way
+        if (vmxnet3_tx_publish(q, lengths[i], &slots[i].offload, NULL, 0) == 0) {
+            sent++;
+        }
+    }
+
+    // Single notification triggers transmission of the whole batch
+    if (sent > 0) {
+        vmxnet3_tx_notify(ctx, q, sent);
+    }
+
+    return sent;
+}
+
+int vmxnet3_tx_commit_sg(vmxnet3_t *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                         const net_tx_frag_t frags[], int frag_count) {
+    vmxnet3_queue_t *q = vmxnet3_queue(ctx, queue);
+    if (!q || !slot || q->tx_reserved == 0) {
+        return -1;
+    }
+
+    if (slot->slot != q->tx_buffer_head) {
+        return -1;
+    }
+
+    int result = vmxnet3_tx_publish(q, length, &slot->offload, frags, frag_count);
+    if (result != 0) {
+        return result;
+    }
+
+    vmxnet3_tx_notify(ctx, q, 1);
+
+    return 0;
+}
+
+// netdev_ops_t entry points
+
+static vmxnet3_t vmxnet3_netdev_contexts[NETDEV_MAX_CONTEXTS];
+
+int vmxnet3_netdev_get_mac(void *ctx, uint8_t mac[6]) {
+    return vmxnet3_get_mac(ctx, mac);
+}
+
+uint32_t vmxnet3_netdev_get_caps(void *ctx) {
+    return vmxnet3_get_caps(ctx);
+}
+
+int vmxnet3_netdev_get_queue_count(void *ctx) {
+    return vmxnet3_get_queue_count(ctx);
+}
+
+int vmxnet3_netdev_get_stats(void *ctx, net_stats_t *stats) {
+    return vmxnet3_get_stats(ctx, stats);
+}
+
+int vmxnet3_netdev_wait(void *ctx, uint16_t queue) {
+    return vmxnet3_wait(ctx, queue);
+}
+
+int vmxnet3_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length) {
+    return vmxnet3_transmit(ctx, queue, packet, length);
+}
+
+int vmxnet3_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length) {
+    return vmxnet3_receive(ctx, queue, buffer, buffer_size, received_length);
+}
+
+int vmxnet3_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                                 size_t lengths[], int max_packets) {
+    return vmxnet3_receive_burst(ctx, queue, buffers, buffer_size, lengths, max_packets);
+}
+
+int vmxnet3_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                                  int count) {
+    return vmxnet3_transmit_burst(ctx, queue, packets, lengths, count);
+}
+
+int vmxnet3_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames) {
+    return vmxnet3_rx_acquire(ctx, queue, frames, max_frames);
+}
+
+int vmxnet3_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count) {
+    return vmxnet3_rx_release(ctx, queue, frames, count);
+}
+
+int vmxnet3_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot) {
+    return vmxnet3_tx_alloc(ctx, queue, slot);
+}
+
+int vmxnet3_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count) {
+    return vmxnet3_tx_commit(ctx, queue, slots, lengths, count);
+}
+
+int vmxnet3_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                                const net_tx_frag_t frags[], int frag_count) {
+    return vmxnet3_tx_commit_sg(ctx, queue, slot, length, frags, frag_count);
+}
+
+const netdev_ops_t vmxnet3_netdev_ops = {
+    .contexts = vmxnet3_netdev_contexts,
+    .context_size = sizeof(vmxnet3_t),
+    .get_mac = vmxnet3_netdev_get_mac,
+    .get_caps = vmxnet3_netdev_get_caps,
+    .get_queue_count = vmxnet3_netdev_get_queue_count,
+    .get_stats = vmxnet3_netdev_get_stats,
+    .wait = vmxnet3_netdev_wait,
+    .transmit = vmxnet3_netdev_transmit,
+    .receive = vmxnet3_netdev_receive,
+    .receive_burst = vmxnet3_netdev_receive_burst,
+    .transmit_burst = vmxnet3_netdev_transmit_burst,
+    .rx_acquire = vmxnet3_netdev_rx_acquire,
+    .rx_release = vmxnet3_netdev_rx_release,
+    .tx_alloc = vmxnet3_netdev_tx_alloc,
+    .tx_commit = vmxnet3_netdev_tx_commit,
+    .tx_commit_sg = vmxnet3_netdev_tx_commit_sg
+};
@@ -0,0 +1,552 @@
+#pragma once
+
+#include "../../common/types.h"
+#include "../../common/drivers.h"
+#include "../../kernel/devices/devices.h"
+
+// VMware vmxnet3 Vendor and Device IDs
+#define PCI_VENDOR_ID_VMWARE        0x15AD
+#define VMXNET3_DEVICE_ID           0x07B0
+
+// BAR0 (pass-through) registers, one per interrupt or queue at a stride of 8
+#define VMXNET3_REG_IMR(n)          (0x000 + 8 * (n))  // Interrupt Mask (1: masked)
+#define VMXNET3_REG_TXPROD(q)       (0x600 + 8 * (q))  // TX ring producer index
+#define VMXNET3_REG_RXPROD(q)       (0x800 + 8 * (q))  // RX ring 0 producer index
+#define VMXNET3_REG_RXPROD2(q)      (0xA00 + 8 * (q))  // RX ring 1 producer index
+
+// BAR1 (virtual device) registers
+#define VMXNET3_REG_VRRS            0x00    // Device revisions supported / selected
+#define VMXNET3_REG_UVRS            0x08    // UPT revisions supported / selected
+#define VMXNET3_REG_DSAL            0x10    // Driver shared area address low
+#define VMXNET3_REG_DSAH            0x18    // Driver shared area address high
+#define VMXNET3_REG_CMD             0x20    // Command, reads back the result
+#define VMXNET3_REG_MACL            0x28    // MAC address low
+#define VMXNET3_REG_MACH            0x30    // MAC address high
+#define VMXNET3_REG_ICR             0x38    // Interrupt Cause (read to deassert INTx)
+#define VMXNET3_REG_ECR             0x40    // Event Cause (write 1 to clear)
+
+// Device and UPT revision 1
+#define VMXNET3_REVISION_1          0x1
+
+// Commands written to VMXNET3_REG_CMD
+#define VMXNET3_CMD_ACTIVATE_DEV    0xCAFE0000
+#define VMXNET3_CMD_RESET_DEV       0xCAFE0002
+#define VMXNET3_CMD_GET_STATS       0xF00D0001  // Refresh the queue descriptor stats
+
+// UPT1 counters in the queue descriptor stats arrays (packet counts)
+#define VMXNET3_STAT_UCAST_PKTS     2
+#define VMXNET3_STAT_MCAST_PKTS     4
+#define VMXNET3_STAT_BCAST_PKTS     6
+#define VMXNET3_STAT_RX_OUT_OF_BUF  8       // RX only: frames dropped for lack of buffers
+
+// Driver shared area
+#define VMXNET3_SHARED_MAGIC        0xBABEFEE1
+#define VMXNET3_GOS_BITS_64         0x2     // 64-bit guest
+#define VMXNET3_DRIVER_VERSION      0x00010000
+#define VMXNET3_MAX_INTRS           25
+#define VMXNET3_VFT_SIZE            128     // VLAN filter words (4096 bits)
+
+// UPT1 features requested in misc.upt_features
+#define VMXNET3_F_RXCSUM            (1 << 0)  // Report RX checksum validation
+#define VMXNET3_F_RSS               (1 << 1)  // Spread RX flows over the queues
+
+// RX filter modes
+#define VMXNET3_RXM_UCAST           (1 << 0)
+#define VMXNET3_RXM_BCAST           (1 << 2)
+#define VMXNET3_RXM_ALL_MULTI       (1 << 3)
+#define VMXNET3_RXM_PROMISC         (1 << 4)
+
+// Interrupt configuration
+#define VMXNET3_IC_DISABLE_ALL      (1 << 0)  // intr_ctrl: no interrupts at all
+#define VMXNET3_IML_NONE            0       // Moderation level: interrupt on every event
+#define VMXNET3_IML_ADAPTIVE        8       // Moderation level chosen by the device from the load
+
+// RSS configuration
+#define VMXNET3_RSS_HASH_IPV4       (1 << 0)  // Addresses of IPv4 packets
+#define VMXNET3_RSS_HASH_TCP_IPV4   (1 << 1)  // Addresses and ports of IPv4/TCP
+#define VMXNET3_RSS_HASH_TOEPLITZ   0x1
+#define VMXNET3_RSS_KEY_SIZE        40
+#define VMXNET3_RSS_IND_TABLE_SIZE  128
+#define VMXNET3_RSS_IND_TABLE_USED  32      // Entries filled in, 4 per possible queue
+
+// TX descriptor: len_gen_msscof
+#define VMXNET3_TXD_GEN             (1u << 14)
+#define VMXNET3_TXD_MSSCOF_SHIFT    18      // MSS (TSO) or checksum position (checksum offload)
+// TX descriptor: hlen_om_flags
+#define VMXNET3_TXD_OM_SHIFT        10
+#define VMXNET3_OM_CSUM             2
+#define VMXNET3_OM_TSO              3
+#define VMXNET3_TXD_EOP             (1u << 12)  // End of Packet
+#define VMXNET3_TXD_CQ              (1u << 13)  // Write a completion descriptor
+
+// RX descriptor: len_gen
+#define VMXNET3_RXD_BTYPE_HEAD      (0u << 14)  // Buffer starts a frame
+#define VMXNET3_RXD_GEN             (1u << 31)
+
+// RX completion descriptor: idx_flags
+#define VMXNET3_RCD_IDX_MASK        0xFFF
+#define VMXNET3_RCD_EOP             (1u << 14)
+#define VMXNET3_RCD_SOP             (1u << 15)
+#define VMXNET3_RCD_RQID_SHIFT      16
+#define VMXNET3_RCD_RQID_MASK       0x3FF
+#define VMXNET3_RCD_CNC             (1u << 30)  // Checksum not calculated
+// RX completion descriptor: len_err
+#define VMXNET3_RCD_LEN_MASK        0x3FFF
+#define VMXNET3_RCD_ERR             (1u << 14)
+// RX completion descriptor: csum_gen
+#define VMXNET3_RCD_TUC             (1u << 16)  // TCP/UDP checksum correct
+#define VMXNET3_RCD_UDP             (1u << 17)
+#define VMXNET3_RCD_TCP             (1u << 18)
+#define VMXNET3_RCD_IPC             (1u << 19)  // IP header checksum correct
+#define VMXNET3_RCD_V4              (1u << 21)
+// Both completion formats: generation bit
+#define VMXNET3_COMP_GEN            (1u << 31)
+// TX completion descriptor: txd_idx
+#define VMXNET3_TCD_IDX_MASK        0xFFF
+
+// Configuration
+// Queue pairs per device: NETDEV_QUEUES, up to two
+#define VMXNET3_MAX_QUEUES          2
+#define VMXNET3_NUM_QUEUES          (NETDEV_QUEUES < VMXNET3_MAX_QUEUES ? NETDEV_QUEUES : VMXNET3_MAX_QUEUES)
+// Ring sizes must be multiples of 32
+#define VMXNET3_RING_SIZE           128
+// RX ring 1 holds body buffers for frames larger than one buffer; it is
+// registered but stays empty since every frame fits a ring 0 buffer
+#define VMXNET3_RX_RING2_SIZE       32
+#define VMXNET3_RX_COMP_SIZE        (VMXNET3_RING_SIZE + VMXNET3_RX_RING2_SIZE)
+// Receive buffers handed back before the device is told (if it asks to be)
+#define VMXNET3_RX_PROD_BATCH       32
+// Largest buffer a single TX descriptor carries (length 0 encodes 16 KB)
+#define VMXNET3_TX_MAX_DATA_PER_DESC 16384
+// TX data ring entry size; the device expects the ring, frames are sent from tx_buffers
+#define VMXNET3_TX_DATA_DESC_SIZE   128
+// Marks a TX descriptor that does not own a driver TX buffer
+#define VMXNET3_TX_NO_BUFFER        0xFFFF
+#define VMXNET3_RX_BUFFER_SIZE      2048
+#define VMXNET3_TX_BUFFER_SIZE      2048
+// Frames start 2 bytes into each TX buffer so the IP header is 4-byte aligned
+#define VMXNET3_TX_HEADROOM         2
+// Default interrupt moderation level (0-8, see vmxnet3.irq_moderation)
+#define VMXNET3_IRQ_MODERATION_DEFAULT VMXNET3_IML_ADAPTIVE
+
+/**
+ * vmxnet3 TX descriptor
+ * The generation bit hands it to the device; the first descriptor of a frame
+ * is flipped last so the device never sees a partial frame.
+ */
+typedef struct {
+    uint64_t addr;
+    uint32_t len_gen_msscof;    // Length (0-13), gen (14), MSS or checksum position (18-31)
+    uint32_t hlen_om_flags;     // Header length (0-9), offload mode (10-11), EOP, CQ
+} vmxnet3_tx_desc_t;
+
+/**
+ * vmxnet3 TX completion descriptor, written by the device per frame
+ */
+typedef struct {
+    uint32_t txd_idx;           // Last TX descriptor of the completed frame (0-11)
+    uint32_t reserved[2];
+    volatile uint32_t type_gen;
+} vmxnet3_tx_comp_desc_t;
+
+/**
+ * vmxnet3 RX descriptor
+ */
+typedef struct {
+    uint64_t addr;
+    uint32_t len_gen;           // Buffer length (0-13), buffer type (14), gen (31)
+    uint32_t reserved;
+} vmxnet3_rx_desc_t;
+
+/**
+ * vmxnet3 RX completion descriptor, written by the device per buffer
+ */
+typedef struct {
+    uint32_t idx_flags;         // RX descriptor (0-11), EOP, SOP, RX ring ID (16-25)
+    uint32_t rss_hash;
+    uint32_t len_err;           // Length (0-13), error (14), VLAN tag (16-31)
+    volatile uint32_t csum_gen; // Checksum flags (16-23), gen (31)
+} vmxnet3_rx_comp_desc_t;
+
+static_assert(sizeof(vmxnet3_tx_desc_t) == 16, "TX descriptor must be 16 bytes");
+static_assert(sizeof(vmxnet3_tx_comp_desc_t) == 16, "TX completion descriptor must be 16 bytes");
+static_assert(sizeof(vmxnet3_rx_desc_t) == 16, "RX descriptor must be 16 bytes");
+static_assert(sizeof(vmxnet3_rx_comp_desc_t) == 16, "RX completion descriptor must be 16 bytes");
+
+/**
+ * Driver shared area, read by the device on activation
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t pad;
+    // Miscellaneous configuration
+    uint32_t driver_version;
+    uint32_t gos;               // Guest OS description (VMXNET3_GOS_*)
+    uint32_t vmxnet3_rev_spt;
+    uint32_t upt_ver_spt;
+    uint64_t upt_features;      // VMXNET3_F_* features requested
+    uint64_t dd_pa;
+    uint64_t queue_desc_pa;     // vmxnet3_queue_descs_t
+    uint32_t dd_len;
+    uint32_t queue_desc_len;
+    uint32_t mtu;
+    uint16_t max_num_rx_sg;
+    uint8_t num_tx_queues;
+    uint8_t num_rx_queues;
+    uint32_t misc_reserved[4];
+    // Interrupt configuration
+    uint8_t auto_mask;          // Device masks a vector when raising it
+    uint8_t num_intrs;
+    uint8_t event_intr_idx;
+    uint8_t mod_levels[VMXNET3_MAX_INTRS];  // Moderation level per vector
+    uint32_t intr_ctrl;
+    uint32_t intr_reserved[2];
+    // RX filter configuration
+    uint32_t rx_mode;           // VMXNET3_RXM_* flags
+    uint16_t mf_table_len;
+    uint16_t mf_pad;
+    uint64_t mf_table_pa;
+    uint32_t vf_table[VMXNET3_VFT_SIZE];    // VLAN filter, all clear in promiscuous mode
+    // Variable length configuration
+    uint32_t rss_conf_ver;
+    uint32_t rss_conf_len;
+    uint64_t rss_conf_pa;       // vmxnet3_rss_conf_t
+    uint32_t pm_conf_ver;
+    uint32_t pm_conf_len;
+    uint64_t pm_conf_pa;
+    uint32_t plugin_conf_ver;
+    uint32_t plugin_conf_len;
+    uint64_t plugin_conf_pa;
+    volatile uint32_t ecr;      // Pending events
+    uint32_t reserved[5];
+} vmxnet3_shared_t;
+
+static_assert(sizeof(vmxnet3_shared_t) == 720, "Driver shared area must be 720 bytes");
+static_assert(__builtin_offsetof(vmxnet3_shared_t, auto_mask) == 80, "Interrupt configuration at byte 80");
+static_assert(__builtin_offsetof(vmxnet3_shared_t, rx_mode) == 120, "RX filter configuration at byte 120");
+static_assert(__builtin_offsetof(vmxnet3_shared_t, rss_conf_ver) == 648, "RSS configuration at byte 648");
+static_assert(__builtin_offsetof(vmxnet3_shared_t, ecr) == 696, "Event cause at byte 696");
+
+/**
+ * TX queue descriptor
+ */
+typedef struct {
+    uint32_t tx_num_deferred;   // Frames queued since the last TXPROD write
+    volatile uint32_t tx_threshold; // Deferred frames after which the device wants TXPROD
+    uint64_t ctrl_reserved;
+    uint64_t tx_ring_pa;
+    uint64_t data_ring_pa;
+    uint64_t comp_ring_pa;
+    uint64_t dd_pa;
+    uint64_t conf_reserved;
+    uint32_t tx_ring_size;
+    uint32_t data_ring_size;
+    uint32_t comp_ring_size;
+    uint32_t dd_len;
+    uint8_t intr_idx;
+    uint8_t conf_pad[7];
+    volatile uint8_t stopped;
+    uint8_t status_pad[3];
+    volatile uint32_t error;
+    uint64_t stats[10];         // UPT1 TX counters, refreshed on request
+    uint8_t pad[88];
+} vmxnet3_tx_queue_desc_t;
+
+/**
+ * RX queue descriptor
+ */
+typedef struct {
+    volatile uint8_t update_rx_prod;    // Device wants RXPROD writes
+    uint8_t ctrl_pad[7];
+    uint64_t ctrl_reserved;
+    uint64_t rx_ring_pa[2];
+    uint64_t comp_ring_pa;
+    uint64_t dd_pa;
+    uint64_t data_ring_pa;
+    uint32_t rx_ring_size[2];
+    uint32_t comp_ring_size;
+    uint32_t dd_len;
+    uint8_t intr_idx;
+    uint8_t conf_pad[7];
+    volatile uint8_t stopped;
+    uint8_t status_pad[3];
+    volatile uint32_t error;
+    uint64_t stats[10];         // UPT1 RX counters, refreshed on request
+    uint8_t pad[88];
+} vmxnet3_rx_queue_desc_t;
+
+static_assert(sizeof(vmxnet3_tx_queue_desc_t) == 256, "TX queue descriptor must be 256 bytes");
+static_assert(sizeof(vmxnet3_rx_queue_desc_t) == 256, "RX queue descriptor must be 256 bytes");
+static_assert(__builtin_offsetof(vmxnet3_tx_queue_desc_t, stopped) == 80, "TX queue status at byte 80");
+static_assert(__builtin_offsetof(vmxnet3_rx_queue_desc_t, stopped) == 80, "RX queue status at byte 80");
+
+/**
+ * Queue descriptor table: all TX queues, then all RX queues
+ */
+typedef struct {
+    vmxnet3_tx_queue_desc_t tx[VMXNET3_NUM_QUEUES];
+    vmxnet3_rx_queue_desc_t rx[VMXNET3_NUM_QUEUES];
+} __attribute__((aligned(128))) vmxnet3_queue_descs_t;
+
+/**
+ * RSS configuration
+ */
+typedef struct {
+    uint16_t hash_type;         // VMXNET3_RSS_HASH_* flags
+    uint16_t hash_func;
+    uint16_t hash_key_size;
+    uint16_t ind_table_size;
+    uint8_t hash_key[VMXNET3_RSS_KEY_SIZE];
+    uint8_t ind_table[VMXNET3_RSS_IND_TABLE_SIZE];
+} vmxnet3_rss_conf_t;
+
+static_assert(sizeof(vmxnet3_rss_conf_t) == 176, "RSS configuration must be 176 bytes");
+
+/**
+ * How the device wakes a CPU halted in vmxnet3_wait()
+ */
+typedef enum {
+    VMXNET3_IRQ_NONE = 0,       // No usable interrupt, callers keep polling
+    VMXNET3_IRQ_MSIX = 1,       // PCI MSI-X, one vector per queue pair (AMD64)
+    VMXNET3_IRQ_MSI = 2,        // PCI MSI shared by all queues (AMD64)
+    VMXNET3_IRQ_WIRED = 3       // INTx through the I/O APIC, GIC or PLIC
+} vmxnet3_irq_t;
+
+/**
+ * One RX/TX queue pair
+ */
+typedef struct {
+    vmxnet3_rx_desc_t rx_descs[VMXNET3_RING_SIZE] __attribute__((aligned(512)));
+    vmxnet3_rx_desc_t rx_descs2[VMXNET3_RX_RING2_SIZE] __attribute__((aligned(512)));
+    vmxnet3_rx_comp_desc_t rx_comp[VMXNET3_RX_COMP_SIZE] __attribute__((aligned(512)));
+    vmxnet3_tx_desc_t tx_descs[VMXNET3_RING_SIZE] __attribute__((aligned(512)));
+    vmxnet3_tx_comp_desc_t tx_comp[VMXNET3_RING_SIZE] __attribute__((aligned(512)));
+    uint8_t tx_data[VMXNET3_RING_SIZE][VMXNET3_TX_DATA_DESC_SIZE] __attribute__((aligned(512)));
+    uint8_t rx_buffers[VMXNET3_RING_SIZE][VMXNET3_RX_BUFFER_SIZE] __attribute__((aligned(16)));
+    uint8_t tx_buffers[VMXNET3_RING_SIZE][VMXNET3_TX_BUFFER_SIZE] __attribute__((aligned(16)));
+    uint16_t index;         // Queue number, selects the producer registers
+    uint16_t rx_comp_current;   // Next RX completion to read
+    uint32_t rx_comp_gen;       // Generation of valid RX completions
+    uint16_t rx_next;       // RX descriptor after the last one consumed
+    uint16_t rx_fill;       // Next RX descriptor to hand to the device
+    uint32_t rx_fill_gen;   // Generation the device expects at rx_fill
+    uint16_t rx_lent;       // RX descriptors lent out by vmxnet3_rx_acquire()
+    uint16_t rx_unreturned; // RX descriptors consumed by vmxnet3_receive() but not yet given back
+    uint16_t tx_current;    // Next TX descriptor to fill
+    uint32_t tx_gen;        // Generation at tx_current
+    uint16_t tx_clean;      // Oldest TX descriptor not yet reclaimed
+    uint16_t tx_inflight;   // TX descriptors handed to the device and not yet reclaimed
+    uint16_t tx_comp_current;   // Next TX completion to read
+    uint32_t tx_comp_gen;       // Generation of valid TX completions
+    uint16_t tx_desc_buffer[VMXNET3_RING_SIZE]; // TX buffer freed with each descriptor
+    uint16_t tx_buffer_head; // Oldest reserved TX buffer (next to be committed)
+    uint16_t tx_reserved;   // TX buffers handed out by vmxnet3_tx_alloc(), not yet committed
+    bool tx_buffer_busy[VMXNET3_RING_SIZE];     // TX buffer reserved or queued
+} __attribute__((aligned(512))) vmxnet3_queue_t;
+
+/**
+ * vmxnet3 device context
+ */
+typedef struct {
+    vmxnet3_shared_t shared __attribute__((aligned(8)));
+    vmxnet3_queue_descs_t queue_descs;
+    vmxnet3_rss_conf_t rss_conf __attribute__((aligned(8)));
+    uint64_t pt_base;       // BAR0: interrupt masks and producer indexes
+    uint64_t vd_base;       // BAR1: configuration and commands
+    bool initialized;
+    uint8_t mac_addr[6];
+    vmxnet3_irq_t irq_mode; // Wakeup interrupt used by vmxnet3_wait()
+    uint16_t num_queues;    // Queue pairs RSS spreads flows over (vmxnet3.queues)
+    vmxnet3_queue_t queues[VMXNET3_NUM_QUEUES];
+} __attribute__((aligned(512))) vmxnet3_t;
+
+/**
+ * Get vmxnet3 driver descriptor
+ * @return Pointer to driver descriptor
+ */
+const driver_t* vmxnet3_get_driver(void);
+
+/**
+ * Get MAC address from vmxnet3 device
+ * @param ctx Device context from driver initialization
+ * @param mac Buffer to store 6-byte MAC address
+ * @return 0 on success, -1 on error
+ */
+int vmxnet3_get_mac(vmxnet3_t *ctx, uint8_t mac[6]);
+
+/**
+ * Get offload capabilities of vmxnet3 device
+ * @param ctx Device context from driver initialization
+ * @return NET_CAP_* flags
+ */
+uint32_t vmxnet3_get_caps(vmxnet3_t *ctx);
+
+/**
+ * Get number of RX/TX queue pairs of vmxnet3 device
+ * RSS spreads received flows over the pairs; each pair is polled on its own.
+ * One unless more are requested with vmxnet3.queues.
+ * @param ctx Device context from driver initialization
+ * @return Number of queue pairs
+ */
+int vmxnet3_get_queue_count(vmxnet3_t *ctx);
+
+/**
+ * Get packet counters of vmxnet3 device, summed over all queues
+ * @param ctx Device context from driver initialization
+ * @param stats Receives the totals since activation
+ * @return 0 on success, -1 on error
+ */
+int vmxnet3_get_stats(vmxnet3_t *ctx, net_stats_t *stats);
+
+/**
+ * Receive a packet from vmxnet3 device
+ * Consumed buffers are handed back once the ring is drained or
+ * VMXNET3_RX_PROD_BATCH of them have built up, not after every packet.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param buffer Buffer to store received packet
+ * @param buffer_size Size of the buffer
+ * @param received_length Pointer to store received packet length
+ * @return 0 on success, -1 on error
+ */
+int vmxnet3_receive(vmxnet3_t *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size,
+                    size_t *received_length);
+
+/**
+ * Transmit a packet to vmxnet3 device
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param buffer Buffer containing packet to transmit
+ * @param length Length of packet to transmit
+ * @return 0 on success, -1 on error
+ */
+int vmxnet3_transmit(vmxnet3_t *ctx, uint16_t queue, const uint8_t *buffer, size_t length);
+
+/**
+ * Receive up to max_packets packets from vmxnet3 device
+ * Drains the RX completion ring and hands the buffers back in one go.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param buffers Array of max_packets receive buffers
+ * @param buffer_size Size of each receive buffer
+ * @param lengths Array receiving the length of each packet
+ * @param max_packets Maximum number of packets to receive
+ * @return Number of packets received (0 if none available), -1 on error
+ */
+int vmxnet3_receive_burst(vmxnet3_t *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                          size_t lengths[], int max_packets);
+
+/**
+ * Transmit up to count packets to vmxnet3 device
+ * Fills consecutive TX descriptors and notifies the device once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param packets Array of packet pointers
+ * @param lengths Array of packet lengths in bytes
+ * @param count Number of packets
+ * @return Number of packets queued (may be less than count if the ring is full), -1 on error
+ */
+int vmxnet3_transmit_burst(vmxnet3_t *ctx, uint16_t queue, const uint8_t *const packets[],
+                           const size_t lengths[], int count);
+
+/**
+ * Borrow received frames from vmxnet3 device without copying
+ * Frames point into the driver RX buffers and must be returned with
+ * vmxnet3_rx_release() in the order they were acquired.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param frames Array receiving up to max_frames frame descriptors
+ * @param max_frames Maximum number of frames to acquire
+ * @return Number of frames acquired (0 if none available), -1 on error
+ */
+int vmxnet3_rx_acquire(vmxnet3_t *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+
+/**
+ * Return borrowed frames to vmxnet3 device
+ * Hands the buffers back to the device with at most one RXPROD write.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param frames Frames previously returned by vmxnet3_rx_acquire()
+ * @param count Number of frames
+ * @return 0 on success, -1 on error
+ */
+int vmxnet3_rx_release(vmxnet3_t *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+
+/**
+ * Halt the CPU until a queue pair of vmxnet3 device receives frames
+ * Unmasks only this pair's MSI-X vector (or the shared one without MSI-X),
+ * re-checks the RX completion ring and halts until the device interrupts,
+ * then masks it again. The device moderates interrupts at the level set by
+ * vmxnet3.irq_moderation.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @return 0 once frames may be available, -1 if the device cannot interrupt
+ *         (the caller keeps polling)
+ */
+int vmxnet3_wait(vmxnet3_t *ctx, uint16_t queue);
+
+/**
+ * Reserve a TX buffer so a frame can be built in place (zero-copy transmit)
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param slot Filled with the writable frame area
+ * @return 0 on success, -1 if no TX descriptor is free
+ */
+int vmxnet3_tx_alloc(vmxnet3_t *ctx, uint16_t queue, net_tx_slot_t *slot);
+
+/**
+ * Transmit frames built in slots from vmxnet3_tx_alloc()
+ * Slots must be committed in the order they were allocated. Checksum and
+ * segmentation requests in slot offload are passed to the device in the
+ * first descriptor of each frame. Notifies the device once.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param slots Slots returned by vmxnet3_tx_alloc()
+ * @param lengths Frame length written into each slot
+ * @param count Number of slots
+ * @return Number of frames queued (invalid frames are dropped, stops at the first out-of-order slot), -1 on error
+ */
+int vmxnet3_tx_commit(vmxnet3_t *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[],
+                      int count);
+
+/**
+ * Transmit one frame built from a slot followed by caller-owned fragments
+ * The slot holds the first length bytes (at least the headers); each fragment
+ * is read in place through its own descriptors. With slot->offload.gso_size
+ * set the frame may be up to NET_TSO_MAX_FRAME_SIZE bytes and is segmented by
+ * the device. Notifies the device once. The slot is consumed even on failure.
+ * @param ctx Device context from driver initialization
+ * @param queue Queue pair index
+ * @param slot Oldest slot returned by vmxnet3_tx_alloc() and not yet committed
+ * @param length Number of bytes written into the slot
+ * @param frags Fragments appended after the slot data
+ * @param frag_count Number of fragments
+ * @return 0 on success, NET_TX_AGAIN if the ring has no room for the fragments,
+ *         -1 on error (invalid frame or offload request)
+ */
+int vmxnet3_tx_commit_sg(vmxnet3_t *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                         const net_tx_frag_t frags[], int frag_count);
+
+/**
+ * netdev_ops_t entry points, registered as vmxnet3_get_driver()->netdev_ops
+ * They wrap the functions above with a void * context and a queue
+ * index.
+ */
+extern const netdev_ops_t vmxnet3_netdev_ops;
+int vmxnet3_netdev_get_mac(void *ctx, uint8_t mac[6]);
+uint32_t vmxnet3_netdev_get_caps(void *ctx);
+int vmxnet3_netdev_get_queue_count(void *ctx);
+int vmxnet3_netdev_get_stats(void *ctx, net_stats_t *stats);
+int vmxnet3_netdev_wait(void *ctx, uint16_t queue);
+int vmxnet3_netdev_transmit(void *ctx, uint16_t queue, const uint8_t *packet, size_t length);
+int vmxnet3_netdev_receive(void *ctx, uint16_t queue, uint8_t *buffer, size_t buffer_size, size_t *received_length);
+int vmxnet3_netdev_receive_burst(void *ctx, uint16_t queue, uint8_t *const buffers[], size_t buffer_size,
+                                 size_t lengths[], int max_packets);
+int vmxnet3_netdev_transmit_burst(void *ctx, uint16_t queue, const uint8_t *const packets[], const size_t lengths[],
+                                  int count);
+int vmxnet3_netdev_rx_acquire(void *ctx, uint16_t queue, net_rx_frame_t frames[], int max_frames);
+int vmxnet3_netdev_rx_release(void *ctx, uint16_t queue, const net_rx_frame_t frames[], int count);
+int vmxnet3_netdev_tx_alloc(void *ctx, uint16_t queue, net_tx_slot_t *slot);
+int vmxnet3_netdev_tx_commit(void *ctx, uint16_t queue, const net_tx_slot_t slots[], const size_t lengths[], int count);
+int vmxnet3_netdev_tx_commit_sg(void *ctx, uint16_t queue, const net_tx_slot_t *slot, size_t length,
+                                const net_tx_frag_t frags[], int frag_count);
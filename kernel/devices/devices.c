@@ -25,6 +25,7 @@ static void add_device_to_registry(const device_t *device, [[maybe_unused]] void
     device_storage[device_count].name = device->name;
     device_storage[device_count].reg_base = device->reg_base;
     device_storage[device_count].reg_size = device->reg_size;
+    device_storage[device_count].irq = device->irq;
     device_storage[device_count].vendor_id = device->vendor_id;
     device_storage[device_count].device_id = device->device_id;
     device_storage[device_count].bus = device->bus;
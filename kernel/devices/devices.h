@@ -20,6 +20,7 @@ struct device {
     const char *name;           // Device node name (from device tree)
     uint64_t reg_base;          // Register base address
     uint64_t reg_size;          // Register region size
+    uint32_t irq;               // Wired interrupt (GIC INTID, PLIC source or I/O APIC input), 0 if none
     uint16_t vendor_id;         // PCI vendor ID (if applicable)
     uint16_t device_id;         // PCI device ID (if applicable)
     uint8_t bus;                // PCI bus number (if applicable)
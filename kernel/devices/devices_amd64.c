@@ -1,4 +1,5 @@
 #include "devices.h"
+#include "pci.h"
 #include "../../common/common.h"
 #include "../../common/log.h"
 
@@ -102,21 +103,26 @@ static void pcie_ecam_write32(uint8_t bus, uint8_t device, uint8_t function, uin
 }
 
 // Unified PCI config access (dispatches to I/O ports or ECAM)
-static uint16_t pci_config_read16(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
+uint8_t pci_config_read8(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
+    uint32_t value = pci_config_read32(bus, device, function, offset & ~3);
+    return (value >> ((offset & 3) * 8)) & 0xFF;
+}
+
+uint16_t pci_config_read16(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
     if (use_ecam) {
         return pcie_ecam_read16(bus, device, function, offset);
     }
     return pci_io_read16(bus, device, function, offset);
 }
 
-static uint32_t pci_config_read32(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
+uint32_t pci_config_read32(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
     if (use_ecam) {
         return pcie_ecam_read32(bus, device, function, offset);
     }
     return pci_io_read32(bus, device, function, offset);
 }
 
-static void pci_config_write16(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset, uint16_t value) {
+void pci_config_write16(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset, uint16_t value) {
     if (use_ecam) {
         pcie_ecam_write16(bus, device, function, offset, value);
     } else {
@@ -124,7 +130,7 @@ static void pci_config_write16(uint8_t bus, uint8_t device, uint8_t function, ui
     }
 }
 
-static void pci_config_write32(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset, uint32_t value) {
+void pci_config_write32(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset, uint32_t value) {
     if (use_ecam) {
         pcie_ecam_write32(bus, device, function, offset, value);
     } else {
@@ -207,6 +213,11 @@ int devices_enumerate(device_callback_t callback, void *context) {
             uint32_t bar0 = pci_config_read32(bus, device, 0, PCI_BAR0_OFFSET);
             uint64_t bar_size = pci_probe_bar_size(bus, device, 0, PCI_BAR0_OFFSET);
 
+            // The firmware routes INTx to an ISA IRQ and records it in the interrupt line
+            uint8_t irq_pin = pci_config_read8(bus, device, 0, PCI_INTERRUPT_PIN_OFFSET);
+            uint8_t irq_line = pci_config_read8(bus, device, 0, PCI_INTERRUPT_LINE_OFFSET);
+            uint32_t irq = (irq_pin != 0 && irq_line < 16) ? irq_line : 0;
+
             // Enable bus mastering and memory access for PCI device
             uint16_t command = pci_config_read16(bus, device, 0, PCI_COMMAND_OFFSET);
             command |= PCI_COMMAND_MEMORY | PCI_COMMAND_MASTER;
@@ -218,6 +229,7 @@ int devices_enumerate(device_callback_t callback, void *context) {
                 .name = NULL,
                 .reg_base = bar0 & 0xFFFFFFF0,
                 .reg_size = bar_size,
+                .irq = irq,
                 .vendor_id = vendor,
                 .device_id = device_val,
                 .bus = bus,
@@ -1,4 +1,5 @@
 #include "devices.h"
+#include "pci.h"
 #include "virtio_mmio.h"
 #include "../platform/fdt_parser.h"
 #include "../../common/common.h"
@@ -65,6 +66,28 @@ static void pcie_ecam_write32(uint8_t bus, uint8_t device, uint8_t function, uin
     *addr = value;
 }
 
+// PCI config access for drivers (ECAM only)
+uint8_t pci_config_read8(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
+    uint32_t value = pcie_ecam_read32(bus, device, function, offset & ~3);
+    return (value >> ((offset & 3) * 8)) & 0xFF;
+}
+
+uint16_t pci_config_read16(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
+    return pcie_ecam_read16(bus, device, function, offset);
+}
+
+uint32_t pci_config_read32(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
+    return pcie_ecam_read32(bus, device, function, offset);
+}
+
+void pci_config_write16(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset, uint16_t value) {
+    pcie_ecam_write16(bus, device, function, offset, value);
+}
+
+void pci_config_write32(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset, uint32_t value) {
+    pcie_ecam_write32(bus, device, function, offset, value);
+}
+
 // Probe BAR size by writing all 1s and reading back
 static uint64_t pci_probe_bar_size(uint8_t bus, uint8_t device, uint8_t function, uint8_t bar_offset) {
     uint32_t original_bar = pcie_ecam_read32(bus, device, function, bar_offset);
@@ -117,6 +140,18 @@ static bool pci_detect_ecam(void) {
     return (vendor != 0x0000 && vendor != 0xFFFF);
 }
 
+// QEMU virt wires INTA-INTD of bus 0 to SPIs 3-6 (INTID 35-38), rotated by slot
+#define PCI_INTX_BASE_INTID     35
+
+// Wired interrupt of a bus 0 device, 0 if it has none or sits behind a bridge
+static uint32_t pci_intx_irq(uint8_t bus, uint8_t device) {
+    uint8_t pin = pci_config_read8(bus, device, 0, PCI_INTERRUPT_PIN_OFFSET);
+    if (bus != 0 || pin == 0 || pin > 4) {
+        return 0;
+    }
+    return PCI_INTX_BASE_INTID + (device + pin - 1) % 4;
+}
+
 // Enumerate PCIe devices via ECAM
 static int pcie_enumerate_devices(device_callback_t callback, void *context) {
     int device_count = 0;
@@ -158,6 +193,7 @@ static int pcie_enumerate_devices(device_callback_t callback, void *context) {
                 .name = NULL,
                 .reg_base = reg_base,
                 .reg_size = reg_size,
+                .irq = pci_intx_irq(bus, device),
                 .vendor_id = vendor,
                 .device_id = device_val,
                 .bus = bus,
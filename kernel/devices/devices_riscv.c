@@ -1,4 +1,5 @@
 #include "devices.h"
+#include "pci.h"
 #include "virtio_mmio.h"
 #include "../platform/fdt_parser.h"
 #include "../../common/common.h"
@@ -76,6 +77,28 @@ static void pcie_ecam_write16(uint8_t bus, uint8_t device, uint8_t function, uin
     *addr = (current & mask) | ((uint32_t)value << shift);
 }
 
+// PCI config access for drivers (ECAM only)
+uint8_t pci_config_read8(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
+    uint32_t value = pcie_ecam_read32(bus, device, function, offset & ~3);
+    return (value >> ((offset & 3) * 8)) & 0xFF;
+}
+
+uint16_t pci_config_read16(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
+    return pcie_ecam_read16(bus, device, function, offset);
+}
+
+uint32_t pci_config_read32(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset) {
+    return pcie_ecam_read32(bus, device, function, offset);
+}
+
+void pci_config_write16(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset, uint16_t value) {
+    pcie_ecam_write16(bus, device, function, offset, value);
+}
+
+void pci_config_write32(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset, uint32_t value) {
+    pcie_ecam_write32(bus, device, function, offset, value);
+}
+
 // Probe BAR size by writing all 1s and reading back
 static uint64_t pci_probe_bar_size(uint8_t bus, uint8_t device, uint8_t function, uint8_t bar_offset) {
     uint32_t original_bar = pcie_ecam_read32(bus, device, function, bar_offset);
@@ -268,6 +291,18 @@ static pci_selected_bar_t pci_select_bar_for_device([[maybe_unused]] uint8_t bus
     };
 }
 
+// QEMU virt wires INTA-INTD of bus 0 to PLIC sources 32-35, rotated by slot
+#define PCI_INTX_BASE_SOURCE    32
+
+// Wired interrupt of a bus 0 device, 0 if it has none or sits behind a bridge
+static uint32_t pci_intx_irq(uint8_t bus, uint8_t device_num) {
+    uint8_t pin = pci_config_read8(bus, device_num, 0, PCI_INTERRUPT_PIN_OFFSET);
+    if (bus != 0 || pin == 0 || pin > 4) {
+        return 0;
+    }
+    return PCI_INTX_BASE_SOURCE + (device_num + pin - 1) % 4;
+}
+
 static device_t pci_create_device_info(uint8_t bus, uint8_t device_num,
                                         uint16_t vendor_id, uint16_t device_id,
                                         uint64_t reg_base, uint64_t reg_size) {
@@ -276,6 +311,7 @@ static device_t pci_create_device_info(uint8_t bus, uint8_t device_num,
         .name = NULL,
         .reg_base = reg_base,
         .reg_size = reg_size,
+        .irq = pci_intx_irq(bus, device_num),
         .vendor_id = vendor_id,
         .device_id = device_id,
         .bus = bus,
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "../../common/types.h"
+
+// PCI configuration space offsets
+#define PCI_STATUS_REG_OFFSET       0x06
+#define PCI_BAR_OFFSET(n)           (0x10 + 4 * (n))
+#define PCI_CAPABILITY_LIST_OFFSET  0x34
+#define PCI_INTERRUPT_LINE_OFFSET   0x3C
+#define PCI_INTERRUPT_PIN_OFFSET    0x3D
+
+// PCI status register bits
+#define PCI_STATUS_CAP_LIST         0x0010
+
+// PCI capability IDs
+#define PCI_CAP_ID_MSI              0x05
+#define PCI_CAP_ID_VENDOR           0x09
+#define PCI_CAP_ID_MSIX             0x11
+
+// MSI capability fields (offsets from the capability); the data register
+// follows a 32-bit or a 64-bit address
+#define PCI_MSI_CTRL                2
+#define PCI_MSI_ADDR_LO             4
+#define PCI_MSI_ADDR_HI             8
+#define PCI_MSI_DATA_32             8
+#define PCI_MSI_DATA_64             12
+#define PCI_MSI_CTRL_ENABLE         0x0001
+#define PCI_MSI_CTRL_MME_MASK       0x0070
+#define PCI_MSI_CTRL_64BIT          0x0080
+
+// MSI-X capability fields (offsets from the capability) and table entry layout
+#define PCI_MSIX_CTRL               2
+#define PCI_MSIX_TABLE              4
+#define PCI_MSIX_CTRL_ENABLE        0x8000
+#define PCI_MSIX_CTRL_MASKALL       0x4000
+#define PCI_MSIX_CTRL_TABLE_SIZE    0x07FF
+#define PCI_MSIX_TABLE_BIR_MASK     0x7
+#define PCI_MSIX_ENTRY_SIZE         16
+#define PCI_MSIX_ENTRY_ADDR_LO      0
+#define PCI_MSIX_ENTRY_ADDR_HI      4
+#define PCI_MSIX_ENTRY_DATA         8
+#define PCI_MSIX_ENTRY_CTRL         12
+#define PCI_MSIX_ENTRY_CTRL_MASKED  0x1
+
+// PCI BAR type bits
+#define PCI_BAR_TYPE_IO             0x1
+#define PCI_BAR_TYPE_MASK           0x6
+#define PCI_BAR_TYPE_64BIT          0x4
+
+// Number of BARs in a type 0 header
+#define PCI_NUM_BARS                6
+
+/**
+ * PCI configuration space accessors (I/O ports or ECAM, per architecture)
+ * @param bus Bus number
+ * @param device Device number
+ * @param function Function number
+ * @param offset Byte offset in configuration space (naturally aligned)
+ */
+uint8_t pci_config_read8(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset);
+uint16_t pci_config_read16(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset);
+uint32_t pci_config_read32(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset);
+void pci_config_write16(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset, uint16_t value);
+void pci_config_write32(uint8_t bus, uint8_t device, uint8_t function, uint16_t offset, uint32_t value);
+
+/**
+ * Find the next capability with the given ID
+ * @param bus Bus number
+ * @param device Device number
+ * @param function Function number
+ * @param cap_id Capability ID to look for
+ * @param after Offset of the capability to continue after, 0 to start at the head of the list
+ * @return Configuration space offset of the capability, 0 if not found
+ */
+static inline uint8_t pci_find_capability(uint8_t bus, uint8_t device, uint8_t function,
+                                          uint8_t cap_id, uint8_t after) {
+    if (!(pci_config_read16(bus, device, function, PCI_STATUS_REG_OFFSET) & PCI_STATUS_CAP_LIST)) {
+        return 0;
+    }
+
+    uint8_t offset = after ? pci_config_read8(bus, device, function, after + 1)
+                           : pci_config_read8(bus, device, function, PCI_CAPABILITY_LIST_OFFSET);
+
+    // Bound the walk in case of a malformed (looping) list
+    for (int i = 0; i < 48 && offset >= 0x40; i++) {
+        offset &= 0xFC;
+        if (pci_config_read8(bus, device, function, offset) == cap_id) {
+            return offset;
+        }
+        offset = pci_config_read8(bus, device, function, offset + 1);
+    }
+
+    return 0;
+}
+
+/**
+ * Get the memory address a BAR is mapped at (64-bit BARs span two registers)
+ * @param bus Bus number
+ * @param device Device number
+ * @param function Function number
+ * @param bar BAR index (0-5)
+ * @return Physical address, 0 for I/O or unassigned BARs
+ */
+static inline uint64_t pci_bar_address(uint8_t bus, uint8_t device, uint8_t function, uint8_t bar) {
+    if (bar >= PCI_NUM_BARS) {
+        return 0;
+    }
+
+    uint32_t low = pci_config_read32(bus, device, function, PCI_BAR_OFFSET(bar));
+    if (low & PCI_BAR_TYPE_IO) {
+        return 0;
+    }
+
+    uint64_t address = low & 0xFFFFFFF0;
+    if ((low & PCI_BAR_TYPE_MASK) == PCI_BAR_TYPE_64BIT && bar + 1 < PCI_NUM_BARS) {
+        address |= (uint64_t)pci_config_read32(bus, device, function, PCI_BAR_OFFSET(bar + 1)) << 32;
+    }
+
+    return address;
+}
+
+/**
+ * Enable MSI with a single vector delivering the given message
+ * @param bus Bus number
+ * @param device Device number
+ * @param function Function number
+ * @param address Message address
+ * @param data Message data
+ * @return 0 on success, -1 if the device has no MSI capability or cannot reach the address
+ */
+static inline int pci_msi_enable(uint8_t bus, uint8_t device, uint8_t function,
+                                 uint64_t address, uint32_t data) {
+    uint8_t cap = pci_find_capability(bus, device, function, PCI_CAP_ID_MSI, 0);
+    if (cap == 0) {
+        return -1;
+    }
+
+    uint16_t control = pci_config_read16(bus, device, function, cap + PCI_MSI_CTRL);
+    bool is_64bit = (control & PCI_MSI_CTRL_64BIT) != 0;
+    if (!is_64bit && (address >> 32) != 0) {
+        return -1;
+    }
+
+    // Program the message while disabled, then enable it with one vector (MME 0)
+    control &= ~(PCI_MSI_CTRL_ENABLE | PCI_MSI_CTRL_MME_MASK);
+    pci_config_write16(bus, device, function, cap + PCI_MSI_CTRL, control);
+    pci_config_write32(bus, device, function, cap + PCI_MSI_ADDR_LO, (uint32_t)address);
+    if (is_64bit) {
+        pci_config_write32(bus, device, function, cap + PCI_MSI_ADDR_HI, (uint32_t)(address >> 32));
+        pci_config_write16(bus, device, function, cap + PCI_MSI_DATA_64, (uint16_t)data);
+    } else {
+        pci_config_write16(bus, device, function, cap + PCI_MSI_DATA_32, (uint16_t)data);
+    }
+    pci_config_write16(bus, device, function, cap + PCI_MSI_CTRL, control | PCI_MSI_CTRL_ENABLE);
+    return 0;
+}
+
+/**
+ * Enable MSI-X with the first table entries all delivering the given message
+ * The remaining entries are left masked.
+ * @param bus Bus number
+ * @param device Device number
+ * @param function Function number
+ * @param vectors Number of table entries to program (at least 1)
+ * @param address Message address
+ * @param data Message data
+ * @param table_addr Receives the address of the MSI-X table (may be NULL)
+ * @return 0 on success, -1 if the device has no MSI-X capability, has fewer than
+ *         vectors entries, or its table is unassigned or above 4 GB
+ */
+static inline int pci_msix_enable(uint8_t bus, uint8_t device, uint8_t function, uint16_t vectors,
+                                  uint64_t address, uint32_t data, uint64_t *table_addr) {
+    uint8_t cap = pci_find_capability(bus, device, function, PCI_CAP_ID_MSIX, 0);
+    if (cap == 0 || vectors == 0) {
+        return -1;
+    }
+
+    uint16_t control = pci_config_read16(bus, device, function, cap + PCI_MSIX_CTRL);
+    if ((control & PCI_MSIX_CTRL_TABLE_SIZE) + 1u < vectors) {
+        return -1;
+    }
+
+    uint32_t table = pci_config_read32(bus, device, function, cap + PCI_MSIX_TABLE);
+    uint64_t bar_addr = pci_bar_address(bus, device, function, table & PCI_MSIX_TABLE_BIR_MASK);
+    if (bar_addr == 0) {
+        return -1;
+    }
+    uint64_t base = bar_addr + (table & ~PCI_MSIX_TABLE_BIR_MASK);
+    // Only the low 4 GB are identity-mapped
+    if (base + (uint64_t)vectors * PCI_MSIX_ENTRY_SIZE > 0x100000000ull) {
+        return -1;
+    }
+
+    // Keep every vector masked while the entries are written
+    pci_config_write16(bus, device, function, cap + PCI_MSIX_CTRL,
+                       control | PCI_MSIX_CTRL_ENABLE | PCI_MSIX_CTRL_MASKALL);
+    for (uint16_t i = 0; i < vectors; i++) {
+        volatile uint32_t *entry = (volatile uint32_t *)(uintptr_t)(base + (uint64_t)i * PCI_MSIX_ENTRY_SIZE);
+        entry[PCI_MSIX_ENTRY_ADDR_LO / 4] = (uint32_t)address;
+        entry[PCI_MSIX_ENTRY_ADDR_HI / 4] = (uint32_t)(address >> 32);
+        entry[PCI_MSIX_ENTRY_DATA / 4] = data;
+        entry[PCI_MSIX_ENTRY_CTRL / 4] = 0;
+    }
+    pci_config_write16(bus, device, function, cap + PCI_MSIX_CTRL,
+                       (control | PCI_MSIX_CTRL_ENABLE) & ~PCI_MSIX_CTRL_MASKALL);
+    if (table_addr != NULL) {
+        *table_addr = base;
+    }
+    return 0;
+}
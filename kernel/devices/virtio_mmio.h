@@ -4,23 +4,37 @@
 #include "../../common/common.h"
 #include "devices.h"
 
-// VirtIO MMIO registers (Legacy/v1)
+// VirtIO MMIO registers (Legacy/v1 and v2)
 #define VIRTIO_MMIO_MAGIC_VALUE           0x000
 #define VIRTIO_MMIO_VERSION               0x004
 #define VIRTIO_MMIO_DEVICE_ID             0x008
 #define VIRTIO_MMIO_VENDOR_ID             0x00c
 #define VIRTIO_MMIO_DEVICE_FEATURES       0x010
+#define VIRTIO_MMIO_DEVICE_FEATURES_SEL   0x014
 #define VIRTIO_MMIO_DRIVER_FEATURES       0x020
+#define VIRTIO_MMIO_DRIVER_FEATURES_SEL   0x024
 #define VIRTIO_MMIO_GUEST_PAGE_SIZE       0x028  // Legacy only (version 1)
 #define VIRTIO_MMIO_QUEUE_SEL             0x030
 #define VIRTIO_MMIO_QUEUE_NUM_MAX         0x034
 #define VIRTIO_MMIO_QUEUE_NUM             0x038
-#define VIRTIO_MMIO_QUEUE_ALIGN           0x03c
-#define VIRTIO_MMIO_QUEUE_PFN             0x040
+#define VIRTIO_MMIO_QUEUE_ALIGN           0x03c  // Legacy only (version 1)
+#define VIRTIO_MMIO_QUEUE_PFN             0x040  // Legacy only (version 1)
+#define VIRTIO_MMIO_QUEUE_READY           0x044  // Version 2 only
 #define VIRTIO_MMIO_QUEUE_NOTIFY          0x050
 #define VIRTIO_MMIO_INTERRUPT_STATUS      0x060
 #define VIRTIO_MMIO_INTERRUPT_ACK         0x064
 #define VIRTIO_MMIO_STATUS                0x070
+#define VIRTIO_MMIO_QUEUE_DESC_LOW        0x080  // Version 2 only: 64-bit ring addresses
+#define VIRTIO_MMIO_QUEUE_DESC_HIGH       0x084
+#define VIRTIO_MMIO_QUEUE_DRIVER_LOW      0x090
+#define VIRTIO_MMIO_QUEUE_DRIVER_HIGH     0x094
+#define VIRTIO_MMIO_QUEUE_DEVICE_LOW      0x0a0
+#define VIRTIO_MMIO_QUEUE_DEVICE_HIGH     0x0a4
+#define VIRTIO_MMIO_CONFIG                0x100  // Device-specific configuration
+
+// VirtIO MMIO register layout versions
+#define VIRTIO_MMIO_VERSION_LEGACY        1
+#define VIRTIO_MMIO_VERSION_MODERN        2
 
 // VirtIO-PCI legacy I/O space register offsets (different from MMIO!)
 #define VIRTIO_PCI_DEVICE_FEATURES        0x00
@@ -31,6 +45,47 @@
 #define VIRTIO_PCI_QUEUE_NOTIFY           0x10
 #define VIRTIO_PCI_STATUS                 0x12
 #define VIRTIO_PCI_ISR_STATUS             0x13
+#define VIRTIO_PCI_MSI_CONFIG_VECTOR      0x14  // Only present while MSI-X is enabled
+#define VIRTIO_PCI_MSI_QUEUE_VECTOR       0x16  // Only present while MSI-X is enabled
+#define VIRTIO_PCI_CONFIG                 0x14  // Device-specific configuration
+#define VIRTIO_PCI_CONFIG_MSIX            0x18  // Device-specific configuration while MSI-X is enabled
+
+// VirtIO-PCI modern (1.0) vendor capability fields (offsets from the capability)
+#define VIRTIO_PCI_CAP_CFG_TYPE           3
+#define VIRTIO_PCI_CAP_BAR                4
+#define VIRTIO_PCI_CAP_OFFSET             8
+#define VIRTIO_PCI_CAP_LENGTH             12
+#define VIRTIO_PCI_NOTIFY_CAP_MULT        16  // notify_off_multiplier (notify capability only)
+
+// VirtIO-PCI modern capability configuration types
+#define VIRTIO_PCI_CAP_COMMON_CFG         1
+#define VIRTIO_PCI_CAP_NOTIFY_CFG         2
+#define VIRTIO_PCI_CAP_ISR_CFG            3
+#define VIRTIO_PCI_CAP_DEVICE_CFG         4
+
+// VirtIO-PCI modern common configuration structure (memory-mapped)
+#define VIRTIO_PCI_COMMON_DFSELECT        0x00
+#define VIRTIO_PCI_COMMON_DF              0x04
+#define VIRTIO_PCI_COMMON_GFSELECT        0x08
+#define VIRTIO_PCI_COMMON_GF              0x0C
+#define VIRTIO_PCI_COMMON_MSIX            0x10
+#define VIRTIO_PCI_COMMON_NUM_QUEUES      0x12
+#define VIRTIO_PCI_COMMON_STATUS          0x14
+#define VIRTIO_PCI_COMMON_Q_SELECT        0x16
+#define VIRTIO_PCI_COMMON_Q_SIZE          0x18
+#define VIRTIO_PCI_COMMON_Q_MSIX          0x1A
+#define VIRTIO_PCI_COMMON_Q_ENABLE        0x1C
+#define VIRTIO_PCI_COMMON_Q_NOFF          0x1E
+#define VIRTIO_PCI_COMMON_Q_DESCLO        0x20
+#define VIRTIO_PCI_COMMON_Q_DESCHI        0x24
+#define VIRTIO_PCI_COMMON_Q_AVAILLO       0x28
+#define VIRTIO_PCI_COMMON_Q_AVAILHI       0x2C
+#define VIRTIO_PCI_COMMON_Q_USEDLO        0x30
+#define VIRTIO_PCI_COMMON_Q_USEDHI        0x34
+#define VIRTIO_PCI_COMMON_CFG_SIZE        0x38
+
+// MSI-X vector value meaning "no interrupt"
+#define VIRTIO_MSI_NO_VECTOR              0xFFFF
 
 // VirtIO status bits
 #define VIRTIO_STATUS_ACKNOWLEDGE         1
@@ -94,6 +149,26 @@ static inline uint32_t mmio_read32(uint64_t addr) {
     return *(volatile uint32_t *)(uintptr_t)addr;
 }
 
+/**
+ * Narrow MMIO accessors for registers that must be accessed at their own width
+ * (VirtIO-PCI modern configuration structures)
+ */
+static inline void mmio_write16(uint64_t addr, uint16_t value) {
+    *(volatile uint16_t *)(uintptr_t)addr = value;
+}
+
+static inline uint16_t mmio_read16(uint64_t addr) {
+    return *(volatile uint16_t *)(uintptr_t)addr;
+}
+
+static inline void mmio_write8(uint64_t addr, uint8_t value) {
+    *(volatile uint8_t *)(uintptr_t)addr = value;
+}
+
+static inline uint8_t mmio_read8(uint64_t addr) {
+    return *(volatile uint8_t *)(uintptr_t)addr;
+}
+
 // VirtIO-PCI uses I/O ports for register access
 #if defined(__x86_64__) || defined(__i386__)
 static inline uint32_t virtio_pci_read32(uint16_t iobase, uint16_t offset) {
@@ -0,0 +1,662 @@
+#include "virtqueue.h"
+#include "pci.h"
+#include "../../common/common.h"
+#include "../../common/log.h"
+#include "../platform/platform.h"
+
+static log_tag_t *virtio_log;
+
+uint16_t virtq_pow2_floor(uint32_t value) {
+    uint16_t result = 0;
+    for (uint32_t size = 1; size <= value && size <= VIRTQ_MAX_SIZE; size <<= 1) {
+        result = (uint16_t)size;
+    }
+    return result;
+}
+
+// Locate the VirtIO 1.0 configuration regions through the vendor-specific PCI
+// capabilities. Returns 0 when the common, notify and device regions all live in
+// memory BARs the kernel can reach, -1 to fall back to the legacy transport
+static int virtio_pci_modern_probe(virtio_dev_t *vdev, const device_t *device) {
+    uint8_t bus = device->bus;
+    uint8_t dev = device->device_num;
+    uint8_t fn = device->function;
+    uint64_t common_cfg = 0;
+    uint64_t common_len = 0;
+
+    for (uint8_t cap = pci_find_capability(bus, dev, fn, PCI_CAP_ID_VENDOR, 0); cap != 0;
+         cap = pci_find_capability(bus, dev, fn, PCI_CAP_ID_VENDOR, cap)) {
+        uint8_t cfg_type = pci_config_read8(bus, dev, fn, cap + VIRTIO_PCI_CAP_CFG_TYPE);
+        uint8_t bar = pci_config_read8(bus, dev, fn, cap + VIRTIO_PCI_CAP_BAR);
+        uint32_t offset = pci_config_read32(bus, dev, fn, cap + VIRTIO_PCI_CAP_OFFSET);
+        uint32_t length = pci_config_read32(bus, dev, fn, cap + VIRTIO_PCI_CAP_LENGTH);
+
+        uint64_t bar_addr = pci_bar_address(bus, dev, fn, bar);
+        if (bar_addr == 0) {
+            continue;
+        }
+        // Only the low 4 GB are identity-mapped
+        if (bar_addr + offset + length > 0x100000000ull) {
+            continue;
+        }
+        uint64_t addr = bar_addr + offset;
+
+        // Use the first usable capability of each type
+        if (cfg_type == VIRTIO_PCI_CAP_COMMON_CFG && common_cfg == 0) {
+            common_cfg = addr;
+            common_len = length;
+        } else if (cfg_type == VIRTIO_PCI_CAP_NOTIFY_CFG && vdev->notify_base == 0) {
+            vdev->notify_base = addr;
+            vdev->notify_off_multiplier = pci_config_read32(bus, dev, fn, cap + VIRTIO_PCI_NOTIFY_CAP_MULT);
+        } else if (cfg_type == VIRTIO_PCI_CAP_ISR_CFG && vdev->isr_cfg == 0) {
+            vdev->isr_cfg = addr;
+        } else if (cfg_type == VIRTIO_PCI_CAP_DEVICE_CFG && vdev->device_cfg == 0) {
+            vdev->device_cfg = addr;
+        }
+    }
+
+    if (common_cfg == 0 || common_len < VIRTIO_PCI_COMMON_CFG_SIZE ||
+        vdev->notify_base == 0 || vdev->device_cfg == 0) {
+        return -1;
+    }
+
+    vdev->io_base = common_cfg;
+    return 0;
+}
+
+void virtio_dev_init(virtio_dev_t *dev, const device_t *device, bool modern) {
+    if (!virtio_log) virtio_log = log_register("virtio", LOG_INFO);
+
+    memset(dev, 0, sizeof(*dev));
+    dev->io_base = device->reg_base;
+    dev->transport = VIRTIO_TRANSPORT_MMIO;
+
+    if (!VIRTIO_HAS_PCI || device->compatible != NULL) {
+        // Version 2 replaces the page frame queue registers with 64-bit ring
+        // addresses and pages the feature bits like modern PCI
+        if (virtio_read32(dev, VIRTIO_MMIO_VERSION) == VIRTIO_MMIO_VERSION_MODERN) {
+            dev->transport = VIRTIO_TRANSPORT_MMIO_MODERN;
+            log_debug(virtio_log, "Using MMIO version 2 transport\n");
+        }
+        return;
+    }
+    if (dev->io_base < 0x10000) {
+        dev->transport = VIRTIO_TRANSPORT_PCI;
+    }
+
+    // PCI devices exposing the VirtIO 1.0 capabilities use the modern transport:
+    // memory-mapped registers, per-queue MMIO doorbells and 64-bit ring addresses
+    if (modern && virtio_pci_modern_probe(dev, device) == 0) {
+        dev->transport = VIRTIO_TRANSPORT_PCI_MODERN;
+        log_debug(virtio_log, "Using modern PCI transport\n");
+    } else {
+        dev->notify_base = 0;
+        dev->isr_cfg = 0;
+        dev->device_cfg = 0;
+    }
+}
+
+int virtio_dev_enable_msix(virtio_dev_t *dev, const device_t *device) {
+    uint8_t bus = device->bus;
+    uint8_t devnum = device->device_num;
+    uint8_t fn = device->function;
+    uint64_t address;
+    uint32_t data;
+
+    if (!VIRTIO_HAS_PCI || device->compatible != NULL) {
+        return -1;
+    }
+
+    if (platform_msi_get_message(&address, &data) != 0) {
+        return -1;
+    }
+
+    // Every queue signals through entry 0
+    uint64_t table;
+    if (pci_msix_enable(bus, devnum, fn, 1, address, data, &table) != 0) {
+        return -1;
+    }
+
+    dev->msix_table = table;
+    return 0;
+}
+
+// Status register offset for the transport in use
+static uint16_t virtio_status_reg(const virtio_dev_t *dev) {
+    if (virtio_is_modern_pci(dev)) {
+        return VIRTIO_PCI_COMMON_STATUS;
+    }
+    if (virtio_is_legacy_pci(dev)) {
+        return VIRTIO_PCI_STATUS;
+    }
+    return VIRTIO_MMIO_STATUS;
+}
+
+void virtio_dev_set_status(virtio_dev_t *dev, uint8_t status) {
+    virtio_write8(dev, virtio_status_reg(dev), status);
+}
+
+void virtio_dev_reset(virtio_dev_t *dev) {
+    uint16_t status_reg = virtio_status_reg(dev);
+
+    // A modern device reports the end of the reset by reading back 0
+    virtio_write8(dev, status_reg, 0);
+    if (virtio_is_modern(dev)) {
+        for (int i = 0; i < 1000000 && virtio_read8(dev, status_reg) != 0; i++) {
+        }
+    }
+
+    virtio_write8(dev, status_reg, VIRTIO_STATUS_ACKNOWLEDGE);
+    virtio_write8(dev, status_reg, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+}
+
+// Modern transports expose all 64 feature bits, one 32-bit window at a time
+static uint64_t virtio_read_features64(virtio_dev_t *dev, uint16_t select_reg, uint16_t value_reg) {
+    virtio_write32(dev, select_reg, 0);
+    uint64_t features = virtio_read32(dev, value_reg);
+    virtio_write32(dev, select_reg, 1);
+    return features | (uint64_t)virtio_read32(dev, value_reg) << 32;
+}
+
+static void virtio_write_features64(virtio_dev_t *dev, uint16_t select_reg, uint16_t value_reg,
+                                    uint64_t features) {
+    virtio_write32(dev, select_reg, 0);
+    virtio_write32(dev, value_reg, (uint32_t)features);
+    virtio_write32(dev, select_reg, 1);
+    virtio_write32(dev, value_reg, (uint32_t)(features >> 32));
+}
+
+uint64_t virtio_dev_get_features(virtio_dev_t *dev) {
+    if (virtio_is_modern_pci(dev)) {
+        return virtio_read_features64(dev, VIRTIO_PCI_COMMON_DFSELECT, VIRTIO_PCI_COMMON_DF);
+    }
+    if (virtio_is_modern_mmio(dev)) {
+        return virtio_read_features64(dev, VIRTIO_MMIO_DEVICE_FEATURES_SEL, VIRTIO_MMIO_DEVICE_FEATURES);
+    }
+    if (virtio_is_legacy_pci(dev)) {
+        return virtio_read32(dev, VIRTIO_PCI_DEVICE_FEATURES);
+    }
+    return virtio_read32(dev, VIRTIO_MMIO_DEVICE_FEATURES);
+}
+
+int virtio_dev_set_features(virtio_dev_t *dev, uint64_t features) {
+    if (virtio_is_modern_pci(dev)) {
+        virtio_write_features64(dev, VIRTIO_PCI_COMMON_GFSELECT, VIRTIO_PCI_COMMON_GF, features);
+    } else if (virtio_is_modern_mmio(dev)) {
+        virtio_write_features64(dev, VIRTIO_MMIO_DRIVER_FEATURES_SEL, VIRTIO_MMIO_DRIVER_FEATURES, features);
+    } else {
+        // Legacy transports only carry the low 32 feature bits
+        features &= 0xFFFFFFFFu;
+        virtio_write32(dev, virtio_is_legacy_pci(dev) ? VIRTIO_PCI_DRIVER_FEATURES : VIRTIO_MMIO_DRIVER_FEATURES,
+                       (uint32_t)features);
+    }
+    dev->features = features;
+
+    uint16_t status_reg = virtio_status_reg(dev);
+    virtio_write8(dev, status_reg, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_FEATURES_OK);
+    if (!(virtio_read8(dev, status_reg) & VIRTIO_STATUS_FEATURES_OK)) {
+        virtio_write8(dev, status_reg, VIRTIO_STATUS_FAILED);
+        return -1;
+    }
+
+    // Legacy MMIO rings are addressed by page frame number
+    if (dev->transport == VIRTIO_TRANSPORT_MMIO) {
+        virtio_write32(dev, VIRTIO_MMIO_GUEST_PAGE_SIZE, 4096);
+    }
+
+    return 0;
+}
+
+int virtio_dev_driver_ok(virtio_dev_t *dev) {
+    uint16_t status_reg = virtio_status_reg(dev);
+
+    // Legacy PCI has no FEATURES_OK
+    uint8_t status = VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK;
+    if (!virtio_is_legacy_pci(dev)) {
+        status |= VIRTIO_STATUS_FEATURES_OK;
+    }
+    virtio_write8(dev, status_reg, status);
+
+    return (virtio_read8(dev, status_reg) & VIRTIO_STATUS_DRIVER_OK) ? 0 : -1;
+}
+
+uint8_t virtio_dev_config_read8(const virtio_dev_t *dev, uint16_t offset) {
+    if (virtio_is_modern_pci(dev)) {
+        return mmio_read8(dev->device_cfg + offset);
+    }
+    if (virtio_is_legacy_pci(dev)) {
+        uint16_t config = dev->msix_table ? VIRTIO_PCI_CONFIG_MSIX : VIRTIO_PCI_CONFIG;
+        return virtio_read8(dev, config + offset);
+    }
+    return mmio_read8(dev->io_base + VIRTIO_MMIO_CONFIG + offset);
+}
+
+uint16_t virtio_dev_config_read16(const virtio_dev_t *dev, uint16_t offset) {
+    if (virtio_is_modern_pci(dev)) {
+        return mmio_read16(dev->device_cfg + offset);
+    }
+    return virtio_dev_config_read8(dev, offset) | (uint16_t)(virtio_dev_config_read8(dev, offset + 1) << 8);
+}
+
+uint32_t virtio_dev_config_read32(const virtio_dev_t *dev, uint16_t offset) {
+    return virtio_dev_config_read16(dev, offset) | ((uint32_t)virtio_dev_config_read16(dev, offset + 2) << 16);
+}
+
+// Lay out an empty split or packed virtqueue of the given size in ring memory
+static void virtq_init(virtqueue_t *vq, uint8_t *ring_mem, uint16_t size, bool packed) {
+    memset(ring_mem, 0, VIRTQ_RING_MEM_SIZE(size));
+    memset(vq, 0, sizeof(*vq));
+    vq->size = size;
+    vq->num_free = size;
+    virtq_desc_init(vq, size);
+
+    if (packed) {
+        // Both wrap counters start at 1; zeroed descriptors belong to the driver
+        vq->packed = true;
+        vq->packed_desc = (virtq_packed_desc_t *)ring_mem;
+        vq->driver_event = (virtq_event_t *)(ring_mem + 16 * size);
+        vq->device_event = (virtq_event_t *)(ring_mem + 16 * size + sizeof(virtq_event_t));
+        vq->avail_wrap = true;
+        vq->used_wrap = true;
+        return;
+    }
+
+    vq->desc = (virtq_desc_t *)ring_mem;
+    vq->avail = (virtq_avail_t *)(ring_mem + 16 * size);
+    vq->used = (virtq_used_t *)(ring_mem + VIRTQ_RING_USED_OFFSET(size));
+}
+
+// Route the selected queue's interrupts to MSI-X table entry 0
+// A device without a free vector answers NO_VECTOR; the driver then only polls
+static void virtq_bind_vector(virtio_dev_t *dev, uint16_t vector_reg) {
+    if (dev->msix_table == 0) {
+        return;
+    }
+
+    virtio_write16(dev, vector_reg, 0);
+    if (virtio_read16(dev, vector_reg) == VIRTIO_MSI_NO_VECTOR) {
+        dev->msix_rejected = true;
+    }
+}
+
+// Configure a queue through the modern common configuration: the driver picks
+// the ring size up to the device maximum and passes full 64-bit ring addresses
+static int virtq_setup_modern(virtio_dev_t *dev, virtqueue_t *vq, uint8_t *ring_mem,
+                              uint16_t index, uint16_t requested_size) {
+    virtio_write16(dev, VIRTIO_PCI_COMMON_Q_SELECT, index);
+
+    uint16_t device_max = virtio_read16(dev, VIRTIO_PCI_COMMON_Q_SIZE);
+    if (device_max < VIRTQ_MIN_SIZE) {
+        return -1;
+    }
+    uint16_t size = virtq_pow2_floor(device_max < requested_size ? device_max : requested_size);
+    virtio_write16(dev, VIRTIO_PCI_COMMON_Q_SIZE, size);
+
+    virtq_init(vq, ring_mem, size, (dev->features & VIRTIO_F_RING_PACKED) != 0);
+    vq->index = index;
+
+    // Packed rings pass the event suppression areas as the driver and device areas
+    uint64_t desc_addr = (uint64_t)ring_mem;
+    uint64_t avail_addr = vq->packed ? (uint64_t)vq->driver_event : (uint64_t)vq->avail;
+    uint64_t used_addr = vq->packed ? (uint64_t)vq->device_event : (uint64_t)vq->used;
+    virtio_write32(dev, VIRTIO_PCI_COMMON_Q_DESCLO, (uint32_t)desc_addr);
+    virtio_write32(dev, VIRTIO_PCI_COMMON_Q_DESCHI, (uint32_t)(desc_addr >> 32));
+    virtio_write32(dev, VIRTIO_PCI_COMMON_Q_AVAILLO, (uint32_t)avail_addr);
+    virtio_write32(dev, VIRTIO_PCI_COMMON_Q_AVAILHI, (uint32_t)(avail_addr >> 32));
+    virtio_write32(dev, VIRTIO_PCI_COMMON_Q_USEDLO, (uint32_t)used_addr);
+    virtio_write32(dev, VIRTIO_PCI_COMMON_Q_USEDHI, (uint32_t)(used_addr >> 32));
+
+    // Each queue has its own doorbell inside the notification region
+    uint16_t notify_off = virtio_read16(dev, VIRTIO_PCI_COMMON_Q_NOFF);
+    vq->notify = dev->notify_base + (uint64_t)notify_off * dev->notify_off_multiplier;
+
+    if (log_enabled(virtio_log, LOG_DEBUG)) {
+        log_prefix(virtio_log, LOG_DEBUG);
+        puts("Queue desc: 0x");
+        put_hex64(desc_addr);
+        puts(" notify: 0x");
+        put_hex64(vq->notify);
+        puts(" size: 0x");
+        put_hex16(size);
+        puts("\n");
+    }
+
+    virtq_bind_vector(dev, VIRTIO_PCI_COMMON_Q_MSIX);
+    virtio_write16(dev, VIRTIO_PCI_COMMON_Q_ENABLE, 1);
+
+    return 0;
+}
+
+// Configure a queue through the VirtIO MMIO version 2 registers: like modern PCI,
+// the descriptor, driver and device areas are passed as separate 64-bit
+// addresses, so nothing ties the ring to a guest page frame
+static int virtq_setup_mmio_modern(virtio_dev_t *dev, virtqueue_t *vq, uint8_t *ring_mem,
+                                   uint16_t index, uint16_t requested_size) {
+    virtio_write32(dev, VIRTIO_MMIO_QUEUE_SEL, index);
+
+    // A queue that is already live cannot be reconfigured
+    if (virtio_read32(dev, VIRTIO_MMIO_QUEUE_READY) != 0) {
+        return -1;
+    }
+    uint32_t device_max = virtio_read32(dev, VIRTIO_MMIO_QUEUE_NUM_MAX);
+    if (device_max < VIRTQ_MIN_SIZE) {
+        return -1;
+    }
+    uint16_t size = virtq_pow2_floor(device_max < requested_size ? device_max : requested_size);
+    virtio_write32(dev, VIRTIO_MMIO_QUEUE_NUM, size);
+
+    virtq_init(vq, ring_mem, size, (dev->features & VIRTIO_F_RING_PACKED) != 0);
+    vq->index = index;
+
+    uint64_t desc_addr = (uint64_t)ring_mem;
+    uint64_t driver_addr = vq->packed ? (uint64_t)vq->driver_event : (uint64_t)vq->avail;
+    uint64_t device_addr = vq->packed ? (uint64_t)vq->device_event : (uint64_t)vq->used;
+    virtio_write32(dev, VIRTIO_MMIO_QUEUE_DESC_LOW, (uint32_t)desc_addr);
+    virtio_write32(dev, VIRTIO_MMIO_QUEUE_DESC_HIGH, (uint32_t)(desc_addr >> 32));
+    virtio_write32(dev, VIRTIO_MMIO_QUEUE_DRIVER_LOW, (uint32_t)driver_addr);
+    virtio_write32(dev, VIRTIO_MMIO_QUEUE_DRIVER_HIGH, (uint32_t)(driver_addr >> 32));
+    virtio_write32(dev, VIRTIO_MMIO_QUEUE_DEVICE_LOW, (uint32_t)device_addr);
+    virtio_write32(dev, VIRTIO_MMIO_QUEUE_DEVICE_HIGH, (uint32_t)(device_addr >> 32));
+
+    if (log_enabled(virtio_log, LOG_DEBUG)) {
+        log_prefix(virtio_log, LOG_DEBUG);
+        puts("Queue desc: 0x");
+        put_hex64(desc_addr);
+        puts(" driver: 0x");
+        put_hex64(driver_addr);
+        puts(" device: 0x");
+        put_hex64(device_addr);
+        puts(" size: 0x");
+        put_hex16(size);
+        puts("\n");
+    }
+
+    virtio_write32(dev, VIRTIO_MMIO_QUEUE_READY, 1);
+    return virtio_read32(dev, VIRTIO_MMIO_QUEUE_READY) == 1 ? 0 : -1;
+}
+
+int virtq_setup(virtio_dev_t *dev, virtqueue_t *vq, uint8_t *ring_mem, uint16_t index,
+                uint16_t requested_size, uint16_t max_size) {
+    uint16_t pfn_reg = VIRTIO_MMIO_QUEUE_PFN;
+    uint16_t size;
+
+    if (max_size > VIRTQ_MAX_SIZE) {
+        max_size = VIRTQ_MAX_SIZE;
+    }
+    if (requested_size > max_size) {
+        requested_size = max_size;
+    }
+
+    if (virtio_is_modern_pci(dev)) {
+        return virtq_setup_modern(dev, vq, ring_mem, index, requested_size);
+    }
+    if (virtio_is_modern_mmio(dev)) {
+        return virtq_setup_mmio_modern(dev, vq, ring_mem, index, requested_size);
+    }
+
+    if (virtio_is_legacy_pci(dev)) {
+        virtio_write16(dev, VIRTIO_PCI_QUEUE_SEL, index);
+
+        // The ring size is fixed by a legacy PCI device; the driver may still
+        // post fewer buffers than the ring holds
+        uint32_t device_size = virtio_read16(dev, VIRTIO_PCI_QUEUE_NUM);
+        if (device_size < VIRTQ_MIN_SIZE || device_size > max_size ||
+            virtq_pow2_floor(device_size) != device_size) {
+            return -1;
+        }
+        size = (uint16_t)device_size;
+        pfn_reg = VIRTIO_PCI_QUEUE_PFN;
+        virtq_bind_vector(dev, VIRTIO_PCI_MSI_QUEUE_VECTOR);
+    } else {
+        // Legacy MMIO transport: the driver picks the ring size up to the device maximum
+        virtio_write32(dev, VIRTIO_MMIO_QUEUE_SEL, index);
+
+        uint32_t device_max = virtio_read32(dev, VIRTIO_MMIO_QUEUE_NUM_MAX);
+        if (device_max < VIRTQ_MIN_SIZE) {
+            return -1;
+        }
+        size = virtq_pow2_floor(device_max < requested_size ? device_max : requested_size);
+
+        virtio_write32(dev, VIRTIO_MMIO_QUEUE_NUM, size);
+        virtio_write32(dev, VIRTIO_MMIO_QUEUE_ALIGN, VIRTQ_RING_ALIGN);
+    }
+
+    virtq_init(vq, ring_mem, size, (dev->features & VIRTIO_F_RING_PACKED) != 0);
+    vq->index = index;
+
+    uint64_t queue_addr = (uint64_t)ring_mem;
+    uint32_t queue_pfn = queue_addr >> 12;
+
+    if (log_enabled(virtio_log, LOG_DEBUG)) {
+        log_prefix(virtio_log, LOG_DEBUG);
+        puts("Queue addr: 0x");
+        put_hex64(queue_addr);
+        puts(" PFN: 0x");
+        put_hex32(queue_pfn);
+        puts(" size: 0x");
+        put_hex16(size);
+        puts("\n");
+    }
+
+    virtio_write32(dev, pfn_reg, queue_pfn);
+
+    uint32_t readback_pfn = virtio_read32(dev, pfn_reg);
+    if (readback_pfn != queue_pfn) {
+        if (log_enabled(virtio_log, LOG_ERROR)) {
+            log_prefix(virtio_log, LOG_ERROR);
+            puts("PFN mismatch! Expected: 0x");
+            put_hex32(queue_pfn);
+            puts(" Got: 0x");
+            put_hex32(readback_pfn);
+            puts("\n");
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+// avail_event is stored right after the used ring entries
+static inline volatile uint16_t *virtq_avail_event(const virtqueue_t *vq) {
+    return (volatile uint16_t *)&vq->used->ring[vq->size];
+}
+
+// Modern PCI doorbells are plain MMIO writes, which a hypervisor can route
+// straight to the backend (KVM ioeventfd) instead of emulating a port access
+void virtq_notify(const virtio_dev_t *dev, const virtqueue_t *vq) {
+    if (virtio_is_modern_pci(dev)) {
+        mmio_write16(vq->notify, vq->index);
+    } else if (virtio_is_legacy_pci(dev)) {
+        virtio_write16(dev, VIRTIO_PCI_QUEUE_SEL, vq->index);
+        virtio_write16(dev, VIRTIO_PCI_QUEUE_NOTIFY, vq->index);
+    } else {
+        virtio_write32(dev, VIRTIO_MMIO_QUEUE_NOTIFY, vq->index);
+    }
+}
+
+void virtq_kick(const virtio_dev_t *dev, virtqueue_t *vq) {
+    // Make avail.idx visible before reading the device's suppression state
+    __sync_synchronize();
+
+    uint16_t new_idx = vq->packed ? vq->avail_idx : vq->avail->idx;
+    uint16_t old_idx = vq->kicked_idx;
+    vq->kicked_idx = new_idx;
+    vq->unkicked = 0;
+
+    if (new_idx == old_idx) {
+        return;
+    }
+
+    bool needed;
+    if (vq->packed) {
+        // The device event area holds either a plain enable/disable flag or, with
+        // EVENT_IDX, the ring position (and wrap counter) it wants a kick at
+        uint16_t event_flags = vq->device_event->flags;
+        if (event_flags == VRING_PACKED_EVENT_FLAG_DESC && (dev->features & VIRTIO_RING_F_EVENT_IDX)) {
+            uint16_t off_wrap = vq->device_event->off_wrap;
+            uint16_t event_idx = off_wrap & 0x7FFF;
+            if ((bool)(off_wrap >> 15) != vq->avail_wrap) {
+                event_idx -= vq->size;
+            }
+            uint16_t new_pos = vq->next_avail;
+            needed = vring_need_event(event_idx, new_pos, (uint16_t)(new_pos - (uint16_t)(new_idx - old_idx)));
+        } else {
+            needed = event_flags != VRING_PACKED_EVENT_FLAG_DISABLE;
+        }
+    } else {
+        uint16_t event_idx = *virtq_avail_event(vq);
+        uint16_t used_flags = vq->used->flags;
+        needed = (dev->features & VIRTIO_RING_F_EVENT_IDX) ? vring_need_event(event_idx, new_idx, old_idx)
+                                 : (used_flags & VRING_USED_F_NO_NOTIFY) == 0;
+    }
+    if (needed) {
+        virtq_notify(dev, vq);
+    }
+}
+
+void virtq_desc_init(virtqueue_t *vq, uint16_t num_desc) {
+    if (num_desc > vq->size) {
+        num_desc = vq->size;
+    }
+    vq->num_desc = num_desc;
+
+    // Stack the IDs so that the first allocations return 0, 1, 2, ...
+    for (uint16_t i = 0; i < num_desc; i++) {
+        vq->free_desc[i] = num_desc - 1 - i;
+        vq->desc_in_use[i] = false;
+    }
+    vq->free_top = num_desc;
+}
+
+int virtq_desc_alloc(virtqueue_t *vq) {
+    if (vq->free_top == 0) {
+        return -1;
+    }
+    uint16_t id = vq->free_desc[--vq->free_top];
+    vq->desc_in_use[id] = true;
+    return id;
+}
+
+void virtq_desc_free(virtqueue_t *vq, uint16_t id) {
+    // The in-use flag keeps a double release from stacking an ID twice
+    if (id < vq->num_desc && vq->desc_in_use[id]) {
+        vq->desc_in_use[id] = false;
+        vq->free_desc[vq->free_top++] = id;
+    }
+}
+
+void virtq_desc_free_chain(virtqueue_t *vq, uint16_t head) {
+    uint16_t id = head;
+    for (uint16_t i = 0; id < vq->num_desc && i < vq->num_desc; i++) {
+        virtq_desc_free(vq, id);
+        const virtq_desc_t *desc = &vq->desc[id];
+        if (!(desc->flags & VRING_DESC_F_NEXT)) {
+            break;
+        }
+        id = desc->next;
+    }
+}
+
+void virtq_push(virtqueue_t *vq, uint16_t head) {
+    vq->avail->ring[vq->avail->idx % vq->size] = head;
+    __sync_synchronize();
+    vq->avail->idx++;
+    __sync_synchronize();
+}
+
+int virtq_pop(virtqueue_t *vq, uint32_t *id, uint32_t *len) {
+    __sync_synchronize();
+
+    if (vq->packed) {
+        if (!virtq_packed_has_used(vq)) {
+            return -1;
+        }
+
+        // Read the ID and length only after seeing the used flags
+        __sync_synchronize();
+        const virtq_packed_desc_t *desc = &vq->packed_desc[vq->next_used];
+        *id = desc->id;
+        *len = desc->len;
+        virtq_packed_consume(vq, 1);
+        vq->last_used++;
+        return 0;
+    }
+
+    if (vq->used->idx == vq->last_used) {
+        return -1;
+    }
+
+    // Read the element only after seeing the used index
+    __sync_synchronize();
+    const virtq_used_elem_t *elem = &vq->used->ring[vq->last_used % vq->size];
+    *id = elem->id;
+    *len = elem->len;
+    vq->last_used++;
+
+    return 0;
+}
+
+bool virtq_has_used(virtqueue_t *vq) {
+    __sync_synchronize();
+    if (vq->packed) {
+        return virtq_packed_has_used(vq);
+    }
+    return vq->used->idx != vq->last_used;
+}
+
+void virtq_set_interrupt(const virtio_dev_t *dev, virtqueue_t *vq, bool enable) {
+    if (vq->packed) {
+        vq->driver_event->flags = enable ? VRING_PACKED_EVENT_FLAG_ENABLE : VRING_PACKED_EVENT_FLAG_DISABLE;
+    } else {
+        vq->avail->flags = enable ? 0 : VRING_AVAIL_F_NO_INTERRUPT;
+
+        // With EVENT_IDX the flags are ignored and used_event (after the
+        // available ring) names the used index to interrupt at; a disabled
+        // queue parks it a full lap behind
+        if (dev->features & VIRTIO_RING_F_EVENT_IDX) {
+            volatile uint16_t *used_event = &vq->avail->ring[vq->size];
+            *used_event = enable ? vq->last_used : (uint16_t)(vq->last_used - 1);
+        }
+    }
+    __sync_synchronize();
+}
+
+uint16_t virtq_packed_fill(virtqueue_t *vq, uint64_t addr, uint32_t len, uint16_t id,
+                           uint16_t flags, bool defer_flags, uint16_t *out_flags) {
+    uint16_t pos = vq->next_avail;
+    virtq_packed_desc_t *desc = &vq->packed_desc[pos];
+
+    flags |= vq->avail_wrap ? VRING_PACKED_DESC_F_AVAIL : VRING_PACKED_DESC_F_USED;
+    desc->addr = addr;
+    desc->len = len;
+    desc->id = id;
+    if (!defer_flags) {
+        desc->flags = flags;
+    }
+    *out_flags = flags;
+
+    if (++vq->next_avail == vq->size) {
+        vq->next_avail = 0;
+        vq->avail_wrap = !vq->avail_wrap;
+    }
+    vq->num_free--;
+
+    return pos;
+}
+
+void virtq_packed_publish(virtqueue_t *vq, uint16_t head, uint16_t head_flags, uint16_t count) {
+    vq->avail_idx += count;
+    __sync_synchronize();
+    vq->packed_desc[head].flags = head_flags;
+    __sync_synchronize();
+}
+
+void virtq_packed_consume(virtqueue_t *vq, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        if (++vq->next_used == vq->size) {
+            vq->next_used = 0;
+            vq->used_wrap = !vq->used_wrap;
+        }
+    }
+    vq->num_free += count;
+}
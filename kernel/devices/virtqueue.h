@@ -0,0 +1,499 @@
+#pragma once
+
+#include "../../common/types.h"
+#include "devices.h"
+#include "virtio_mmio.h"
+
+// VirtIO over PCI is only driven on x86. The ARM64 and RISC-V kernels reach
+// their devices through VirtIO MMIO, so every PCI branch below folds away at
+// compile time there
+#if defined(__x86_64__) || defined(__i386__)
+#define VIRTIO_HAS_PCI 1
+#else
+#define VIRTIO_HAS_PCI 0
+#endif
+
+// Ring size limits supported by the virtqueue code
+#define VIRTQ_MAX_SIZE 256
+#define VIRTQ_MIN_SIZE 2
+
+// Legacy split queue layout: descriptors and available ring, then the used ring
+// on the next 4096-byte boundary. A packed queue (descriptor ring followed by the
+// driver and device event suppression areas) fits in the same memory
+#define VIRTQ_RING_ALIGN 4096
+#define VIRTQ_RING_ALIGN_UP(x) (((x) + VIRTQ_RING_ALIGN - 1) & ~(VIRTQ_RING_ALIGN - 1))
+#define VIRTQ_RING_USED_OFFSET(n) VIRTQ_RING_ALIGN_UP(16 * (n) + 6 + 2 * (n))
+#define VIRTQ_RING_MEM_SIZE(n) (VIRTQ_RING_USED_OFFSET(n) + VIRTQ_RING_ALIGN_UP(6 + 8 * (n)))
+
+// Virtqueue descriptor flags
+#define VRING_DESC_F_NEXT 1
+#define VRING_DESC_F_WRITE 2
+#define VRING_DESC_F_INDIRECT 4         // Buffer holds a table of descriptors
+
+// Virtqueue ring flags
+#define VRING_AVAIL_F_NO_INTERRUPT 1    // Driver polls, device need not interrupt
+#define VRING_USED_F_NO_NOTIFY 1        // Device polls, driver need not kick
+
+// Packed virtqueue descriptor flags (ownership bits, compared against the wrap counters)
+#define VRING_PACKED_DESC_F_AVAIL (1u << 7)
+#define VRING_PACKED_DESC_F_USED  (1u << 15)
+
+// Packed virtqueue event suppression flags
+#define VRING_PACKED_EVENT_FLAG_ENABLE  0   // Notify on every buffer
+#define VRING_PACKED_EVENT_FLAG_DISABLE 1   // Never notify
+#define VRING_PACKED_EVENT_FLAG_DESC    2   // Notify at off_wrap (requires EVENT_IDX)
+
+// Virtqueue feature bits
+#define VIRTIO_RING_F_INDIRECT_DESC (1u << 28)  // Descriptors may point to descriptor tables
+#define VIRTIO_RING_F_EVENT_IDX (1u << 29)  // used_event/avail_event notification thresholds
+
+// Transport feature bits
+#define VIRTIO_F_VERSION_1      (1ull << 32) // VirtIO 1.0 device (required by the modern transports)
+#define VIRTIO_F_RING_PACKED    (1ull << 34) // Packed virtqueue layout (requires VERSION_1)
+
+/**
+ * Check whether moving a ring index from old_idx to new_idx crosses event_idx
+ * (VirtIO spec 2.7.10: vring_need_event)
+ */
+static inline bool vring_need_event(uint16_t event_idx, uint16_t new_idx, uint16_t old_idx) {
+    return (uint16_t)(new_idx - event_idx - 1) < (uint16_t)(new_idx - old_idx);
+}
+
+// Virtqueue descriptor
+typedef struct {
+    volatile uint64_t addr;
+    volatile uint32_t len;
+    volatile uint16_t flags;
+    volatile uint16_t next;
+} virtq_desc_t;
+
+// Virtqueue available ring (ring[size] is followed by used_event)
+typedef struct {
+    volatile uint16_t flags;
+    volatile uint16_t idx;
+    volatile uint16_t ring[];
+} virtq_avail_t;
+
+// Virtqueue used ring element
+typedef struct {
+    volatile uint32_t id;
+    volatile uint32_t len;
+} virtq_used_elem_t;
+
+// Virtqueue used ring (ring[size] is followed by avail_event)
+typedef struct {
+    volatile uint16_t flags;
+    volatile uint16_t idx;
+    virtq_used_elem_t ring[];
+} virtq_used_t;
+
+// Packed virtqueue descriptor: driver and device share one ring and hand
+// entries back and forth through the AVAIL/USED flag bits
+typedef struct {
+    volatile uint64_t addr;
+    volatile uint32_t len;
+    volatile uint16_t id;       // Buffer ID, echoed back by the device when used
+    volatile uint16_t flags;
+} virtq_packed_desc_t;
+
+// Packed virtqueue event suppression area (one for each side)
+typedef struct {
+    volatile uint16_t off_wrap; // Ring offset (bits 0-14) and wrap counter (bit 15) to notify at
+    volatile uint16_t flags;    // VRING_PACKED_EVENT_FLAG_*
+} virtq_event_t;
+
+// Indirect descriptor table entry, in the format of the ring it is used with
+typedef union {
+    virtq_desc_t split;
+    virtq_packed_desc_t packed;
+} virtq_indirect_desc_t;
+
+// Virtqueue laid out in ring memory for the negotiated size
+typedef struct {
+    virtq_desc_t *desc;
+    virtq_avail_t *avail;
+    virtq_used_t *used;
+    uint16_t size;              // Ring entries (power of two)
+    uint16_t index;             // Virtqueue index on the device
+    uint64_t notify;            // Modern PCI: doorbell address
+    uint16_t last_used;         // Used entries consumed by the driver (free-running)
+    uint16_t kicked_idx;        // avail index at the last notification check
+    uint16_t unkicked;          // Buffers reposted since the last notification check
+
+    // Descriptor (split) or buffer ID (packed) allocation, see virtq_desc_alloc()
+    uint16_t num_desc;          // IDs handed out, <= size (defaults to size)
+    uint16_t free_top;          // Entries on the free stack
+    uint16_t free_desc[VIRTQ_MAX_SIZE]; // Free IDs, the most recently released on top
+    bool desc_in_use[VIRTQ_MAX_SIZE];
+
+    // Packed layout (VIRTIO_F_RING_PACKED); the split fields above are unused
+    bool packed;
+    virtq_packed_desc_t *packed_desc;
+    virtq_event_t *driver_event;    // Written by the driver
+    virtq_event_t *device_event;    // Written by the device
+    uint16_t avail_idx;         // Descriptors made available (free-running, like avail->idx)
+    uint16_t next_avail;        // Ring position of the next descriptor to make available
+    uint16_t next_used;         // Ring position of the next descriptor to be used
+    uint16_t num_free;          // Ring positions not owned by the device
+    bool avail_wrap;            // Driver ring wrap counter
+    bool used_wrap;             // Device ring wrap counter
+} virtqueue_t;
+
+/**
+ * VirtIO transport types
+ */
+typedef enum {
+    VIRTIO_TRANSPORT_MMIO = 0,          // Memory-mapped I/O (ARM64, RISC-V)
+    VIRTIO_TRANSPORT_PCI = 1,           // Legacy PCI I/O ports (AMD64)
+    VIRTIO_TRANSPORT_PCI_MODERN = 2,    // VirtIO 1.0 PCI capabilities, memory-mapped
+    VIRTIO_TRANSPORT_MMIO_MODERN = 3    // VirtIO MMIO version 2 (ARM64, RISC-V)
+} virtio_transport_t;
+
+/**
+ * VirtIO device registers and negotiated state, shared by the virtqueues of a device
+ */
+typedef struct {
+    virtio_transport_t transport;
+    uint64_t io_base;           // Register base (common configuration for modern PCI)
+    uint64_t notify_base;       // Modern PCI: notification region
+    uint32_t notify_off_multiplier;
+    uint64_t isr_cfg;           // Modern PCI: ISR status region
+    uint64_t device_cfg;        // Modern PCI: device-specific configuration
+    uint64_t msix_table;        // MSI-X table entry 0 once enabled by the driver, 0 otherwise
+    bool msix_rejected;         // A queue refused MSI-X vector 0 (virtq_setup())
+    uint64_t features;          // Negotiated feature bits
+} virtio_dev_t;
+
+/**
+ * Whether the device uses the legacy PCI (I/O port) transport
+ * Constant false on architectures without VirtIO PCI support.
+ */
+static inline bool virtio_is_legacy_pci(const virtio_dev_t *dev) {
+    return VIRTIO_HAS_PCI && dev->transport == VIRTIO_TRANSPORT_PCI;
+}
+
+/**
+ * Whether the device uses the VirtIO 1.0 PCI transport
+ * Constant false on architectures without VirtIO PCI support.
+ */
+static inline bool virtio_is_modern_pci(const virtio_dev_t *dev) {
+    return VIRTIO_HAS_PCI && dev->transport == VIRTIO_TRANSPORT_PCI_MODERN;
+}
+
+/**
+ * Whether the device uses the VirtIO MMIO version 2 register layout
+ */
+static inline bool virtio_is_modern_mmio(const virtio_dev_t *dev) {
+    return dev->transport == VIRTIO_TRANSPORT_MMIO_MODERN;
+}
+
+/**
+ * Whether the device uses a VirtIO 1.0 transport (modern PCI or MMIO version 2)
+ * Such devices offer 64 feature bits and expect VERSION_1 to be negotiated.
+ */
+static inline bool virtio_is_modern(const virtio_dev_t *dev) {
+    return virtio_is_modern_pci(dev) || virtio_is_modern_mmio(dev);
+}
+
+// Transport-agnostic register access helpers: I/O ports for legacy PCI,
+// accesses at register width for modern PCI, 32-bit MMIO accesses otherwise
+static inline uint32_t virtio_read32(const virtio_dev_t *dev, uint16_t offset) {
+#if VIRTIO_HAS_PCI
+    if (virtio_is_legacy_pci(dev)) {
+        return io_inl((uint16_t)dev->io_base + offset);
+    }
+#endif
+    return mmio_read32(dev->io_base + offset);
+}
+
+static inline uint16_t virtio_read16(const virtio_dev_t *dev, uint16_t offset) {
+#if VIRTIO_HAS_PCI
+    if (virtio_is_legacy_pci(dev)) {
+        return io_inw((uint16_t)dev->io_base + offset);
+    }
+#endif
+    if (virtio_is_modern_pci(dev)) {
+        return mmio_read16(dev->io_base + offset);
+    }
+    return (uint16_t)mmio_read32(dev->io_base + offset);
+}
+
+static inline uint8_t virtio_read8(const virtio_dev_t *dev, uint16_t offset) {
+#if VIRTIO_HAS_PCI
+    if (virtio_is_legacy_pci(dev)) {
+        return io_inb((uint16_t)dev->io_base + offset);
+    }
+#endif
+    if (virtio_is_modern_pci(dev)) {
+        return mmio_read8(dev->io_base + offset);
+    }
+    return (uint8_t)mmio_read32(dev->io_base + offset);
+}
+
+static inline void virtio_write32(const virtio_dev_t *dev, uint16_t offset, uint32_t value) {
+#if VIRTIO_HAS_PCI
+    if (virtio_is_legacy_pci(dev)) {
+        io_outl((uint16_t)dev->io_base + offset, value);
+        return;
+    }
+#endif
+    mmio_write32(dev->io_base + offset, value);
+}
+
+static inline void virtio_write16(const virtio_dev_t *dev, uint16_t offset, uint16_t value) {
+#if VIRTIO_HAS_PCI
+    if (virtio_is_legacy_pci(dev)) {
+        io_outw((uint16_t)dev->io_base + offset, value);
+        return;
+    }
+#endif
+    if (virtio_is_modern_pci(dev)) {
+        mmio_write16(dev->io_base + offset, value);
+        return;
+    }
+    mmio_write32(dev->io_base + offset, value);
+}
+
+static inline void virtio_write8(const virtio_dev_t *dev, uint16_t offset, uint8_t value) {
+#if VIRTIO_HAS_PCI
+    if (virtio_is_legacy_pci(dev)) {
+        io_outb((uint16_t)dev->io_base + offset, value);
+        return;
+    }
+#endif
+    if (virtio_is_modern_pci(dev)) {
+        mmio_write8(dev->io_base + offset, value);
+        return;
+    }
+    mmio_write32(dev->io_base + offset, value);
+}
+
+/**
+ * Pick the transport of a matched VirtIO device
+ * PCI devices below port 0x10000 use the legacy I/O transport, or the modern
+ * one when modern is set and the VirtIO 1.0 capabilities are reachable; all
+ * other devices are VirtIO MMIO, version 1 or 2 as reported by the device.
+ * @param dev Device state to fill (cleared first)
+ * @param device Matched device
+ * @param modern Allow the VirtIO 1.0 PCI transport (the driver negotiates VERSION_1)
+ */
+void virtio_dev_init(virtio_dev_t *dev, const device_t *device, bool modern);
+
+/**
+ * Point MSI-X table entry 0 at the platform wakeup message and enable MSI-X
+ * Queues set up afterwards are routed to the entry. Must be called before the
+ * legacy PCI device configuration is read, since enabling MSI-X moves it.
+ * @param dev Device state from virtio_dev_init()
+ * @param device Matched PCI device
+ * @return 0 if MSI-X is enabled, -1 if the device or platform lacks it
+ */
+int virtio_dev_enable_msix(virtio_dev_t *dev, const device_t *device);
+
+/**
+ * Reset the device and announce the driver (ACKNOWLEDGE, DRIVER)
+ * @param dev Device state from virtio_dev_init()
+ */
+void virtio_dev_reset(virtio_dev_t *dev);
+
+/**
+ * Read the feature bits offered by the device
+ * Legacy transports offer 32 bits, modern PCI and MMIO version 2 all 64.
+ * @param dev Device state from virtio_dev_init()
+ * @return Device feature bits
+ */
+uint64_t virtio_dev_get_features(virtio_dev_t *dev);
+
+/**
+ * Accept features and confirm them with FEATURES_OK
+ * Stores the accepted bits in dev->features. Marks the device FAILED when it
+ * refuses them.
+ * @param dev Device state from virtio_dev_init()
+ * @param features Feature bits to accept (a subset of the offered ones)
+ * @return 0 on success, -1 if the device refused the features
+ */
+int virtio_dev_set_features(virtio_dev_t *dev, uint64_t features);
+
+/**
+ * Set DRIVER_OK once every queue is set up
+ * @param dev Device state from virtio_dev_init()
+ * @return 0 on success, -1 if the device did not accept it
+ */
+int virtio_dev_driver_ok(virtio_dev_t *dev);
+
+/**
+ * Write the device status register (0 resets the device)
+ * @param dev Device state from virtio_dev_init()
+ * @param status VIRTIO_STATUS_* bits
+ */
+void virtio_dev_set_status(virtio_dev_t *dev, uint8_t status);
+
+/**
+ * Read the device-specific configuration space
+ * @param dev Device state from virtio_dev_init()
+ * @param offset Offset inside the device configuration
+ * @return Configuration value
+ */
+uint8_t virtio_dev_config_read8(const virtio_dev_t *dev, uint16_t offset);
+uint16_t virtio_dev_config_read16(const virtio_dev_t *dev, uint16_t offset);
+uint32_t virtio_dev_config_read32(const virtio_dev_t *dev, uint16_t offset);
+
+/**
+ * Set up a virtqueue of the device in ring memory
+ * The ring size is the requested size (rounded down to a power of two) capped
+ * by the device maximum; legacy PCI devices impose their own size, which must
+ * not exceed max_size. The layout is packed when VIRTIO_F_RING_PACKED was
+ * negotiated. With dev->msix_table set the queue is routed to MSI-X entry 0;
+ * a device without a free vector sets dev->msix_rejected.
+ * @param dev Device state after feature negotiation
+ * @param vq Virtqueue to initialize
+ * @param ring_mem 4096-byte aligned memory of VIRTQ_RING_MEM_SIZE(max_size) bytes
+ * @param index Virtqueue index on the device
+ * @param requested_size Ring size the driver would like
+ * @param max_size Largest ring size ring_mem holds (at most VIRTQ_MAX_SIZE)
+ * @return 0 on success, -1 if the device rejected the queue
+ */
+int virtq_setup(virtio_dev_t *dev, virtqueue_t *vq, uint8_t *ring_mem, uint16_t index,
+                uint16_t requested_size, uint16_t max_size);
+
+/**
+ * Largest power of two not above value, capped at VIRTQ_MAX_SIZE
+ * @param value Upper bound
+ * @return Power of two, 0 for 0
+ */
+uint16_t virtq_pow2_floor(uint32_t value);
+
+/**
+ * Notify the device about new available buffers unconditionally
+ * @param dev Device the queue belongs to
+ * @param vq Virtqueue
+ */
+void virtq_notify(const virtio_dev_t *dev, const virtqueue_t *vq);
+
+/**
+ * Notify the device about new available buffers only if it asked for it:
+ * with EVENT_IDX when the available index crosses the device's event index,
+ * otherwise unless the device suppressed notifications
+ * @param dev Device the queue belongs to
+ * @param vq Virtqueue
+ */
+void virtq_kick(const virtio_dev_t *dev, virtqueue_t *vq);
+
+/**
+ * Limit descriptor allocation to the first num_desc IDs and mark them all free
+ * virtq_setup() hands out every ring entry; a driver with fewer buffers than
+ * ring entries lowers the limit before claiming any descriptor.
+ * @param vq Virtqueue
+ * @param num_desc Number of IDs (at most vq->size)
+ */
+void virtq_desc_init(virtqueue_t *vq, uint16_t num_desc);
+
+/**
+ * Claim a free descriptor (split) or buffer ID (packed) below vq->num_desc
+ * Pops the free stack in constant time. The most recently released ID comes
+ * back first, so its buffer is likely still cached.
+ * @param vq Virtqueue
+ * @return Descriptor index, -1 if all are in use
+ */
+int virtq_desc_alloc(virtqueue_t *vq);
+
+/**
+ * Number of descriptors or buffer IDs virtq_desc_alloc() can still hand out
+ */
+static inline uint16_t virtq_desc_available(const virtqueue_t *vq) {
+    return vq->free_top;
+}
+
+/**
+ * Release a descriptor or buffer ID from virtq_desc_alloc()
+ * @param vq Virtqueue
+ * @param id Descriptor index (out of range or already free values are ignored)
+ */
+void virtq_desc_free(virtqueue_t *vq, uint16_t id);
+
+/**
+ * Release a split descriptor chain, following VRING_DESC_F_NEXT from head
+ * @param vq Split virtqueue
+ * @param head First descriptor of the chain
+ */
+void virtq_desc_free_chain(virtqueue_t *vq, uint16_t head);
+
+/**
+ * Whether a descriptor or buffer ID is claimed
+ */
+static inline bool virtq_desc_in_use(const virtqueue_t *vq, uint16_t id) {
+    return id < vq->num_desc && vq->desc_in_use[id];
+}
+
+/**
+ * Make a filled split descriptor chain available to the device
+ * The caller is responsible for the kick.
+ * @param vq Split virtqueue
+ * @param head First descriptor of the chain
+ */
+void virtq_push(virtqueue_t *vq, uint16_t head);
+
+/**
+ * Pop the next used buffer (one ring position on a packed queue)
+ * @param vq Virtqueue
+ * @param id Receives the head descriptor index or buffer ID
+ * @param len Receives the number of bytes the device wrote
+ * @return 0 on success, -1 if the device has not used another buffer
+ */
+int virtq_pop(virtqueue_t *vq, uint32_t *id, uint32_t *len);
+
+/**
+ * Whether the device has used buffers the driver has not popped yet
+ * @param vq Virtqueue
+ * @return true if virtq_pop() would succeed
+ */
+bool virtq_has_used(virtqueue_t *vq);
+
+/**
+ * Ask the device to interrupt on the next used buffer, or to stay quiet
+ * @param dev Device the queue belongs to
+ * @param vq Virtqueue
+ * @param enable true to request an interrupt
+ */
+void virtq_set_interrupt(const virtio_dev_t *dev, virtqueue_t *vq, bool enable);
+
+/**
+ * Fill the descriptor at the packed ring's next available position and advance it
+ * The AVAIL/USED bits for the current wrap are added to flags. The head of a
+ * chain is filled with defer_flags set and made visible by virtq_packed_publish().
+ * @param vq Packed virtqueue with a free ring position
+ * @param addr Buffer address
+ * @param len Buffer length
+ * @param id Buffer ID reported back when the chain is used
+ * @param flags VRING_DESC_F_* flags
+ * @param defer_flags Leave the flags for virtq_packed_publish() to write
+ * @param out_flags Receives the complete flags of the descriptor
+ * @return Ring position that was filled
+ */
+uint16_t virtq_packed_fill(virtqueue_t *vq, uint64_t addr, uint32_t len, uint16_t id,
+                           uint16_t flags, bool defer_flags, uint16_t *out_flags);
+
+/**
+ * Hand a filled chain of count descriptors to the device by writing its head flags last
+ * @param vq Packed virtqueue
+ * @param head Ring position of the chain head (from virtq_packed_fill())
+ * @param head_flags Flags of the chain head (from virtq_packed_fill())
+ * @param count Descriptors in the chain
+ */
+void virtq_packed_publish(virtqueue_t *vq, uint16_t head, uint16_t head_flags, uint16_t count);
+
+/**
+ * Whether the device has marked the packed ring's next used position as used
+ */
+static inline bool virtq_packed_has_used(const virtqueue_t *vq) {
+    uint16_t flags = vq->packed_desc[vq->next_used].flags;
+    bool avail = (flags & VRING_PACKED_DESC_F_AVAIL) != 0;
+    bool used = (flags & VRING_PACKED_DESC_F_USED) != 0;
+    return avail == used && used == vq->used_wrap;
+}
+
+/**
+ * Return count ring positions (one used chain) from the device to the driver
+ * @param vq Packed virtqueue
+ * @param count Ring positions the used chain took
+ */
+void virtq_packed_consume(virtqueue_t *vq, uint16_t count);
@@ -8,6 +8,9 @@
 #include "../apps/http-hello/http_hello.h"
 #include "../drivers/virtio_net/virtio_net.h"
 #include "../drivers/e1000/e1000.h"
+#include "../drivers/e1000e/e1000e.h"
+#include "../drivers/igb/igb.h"
+#include "../drivers/vmxnet3/vmxnet3.h"
 #include "../drivers/rtl8139/rtl8139.h"
 #include "resources/resources.h"
 
@@ -76,20 +79,48 @@ void init_apps(const char* cmdline) {
             }
         }
 
+        // A make NETDEV_DRIVER=<driver> build only has the mac app of that driver
+#if !defined(NETDEV_SINGLE_DRIVER) || defined(NETDEV_SINGLE_DRIVER_virtio_net)
         // Check for app=mac-virtio-net
         if (param_has_value(app_param, "mac-virtio-net")) {
             app_mac_virtio_net();
         }
+#endif
 
+#if !defined(NETDEV_SINGLE_DRIVER) || defined(NETDEV_SINGLE_DRIVER_e1000)
         // Check for app=mac-e1000
         if (param_has_value(app_param, "mac-e1000")) {
             app_mac_e1000();
         }
+#endif
 
+#if !defined(NETDEV_SINGLE_DRIVER) || defined(NETDEV_SINGLE_DRIVER_e1000e)
+        // Check for app=mac-e1000e
+        if (param_has_value(app_param, "mac-e1000e")) {
+            app_mac_e1000e();
+        }
+#endif
+
+#if !defined(NETDEV_SINGLE_DRIVER) || defined(NETDEV_SINGLE_DRIVER_igb)
+        // Check for app=mac-igb
+        if (param_has_value(app_param, "mac-igb")) {
+            app_mac_igb();
+        }
+#endif
+
+#if !defined(NETDEV_SINGLE_DRIVER) || defined(NETDEV_SINGLE_DRIVER_vmxnet3)
+        // Check for app=mac-vmxnet3
+        if (param_has_value(app_param, "mac-vmxnet3")) {
+            app_mac_vmxnet3();
+        }
+#endif
+
+#if !defined(NETDEV_SINGLE_DRIVER) || defined(NETDEV_SINGLE_DRIVER_rtl8139)
         // Check for app=mac-rtl8139
         if (param_has_value(app_param, "mac-rtl8139")) {
             app_mac_rtl8139();
         }
+#endif
 
         // Check for app=mac-all
         if (param_has_value(app_param, "mac-all")) {
@@ -1,5 +1,6 @@
 #include "common.h"
 #include "log.h"
+#include "params.h"
 #include "platform/platform.h"
 #include "devices/devices.h"
 #include "resources/resources.h"
@@ -20,6 +21,7 @@ static log_tag_t *kernel_log;
 
     // Get kernel command line and initialize logging
     const char *cmdline = platform_get_cmdline(boot_param);
+    params_init(cmdline);
     log_init(cmdline);
     kernel_log = log_register("kernel", LOG_INFO);
 
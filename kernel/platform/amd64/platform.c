@@ -241,3 +241,152 @@ static void platform_setup_exception_handlers(void) {
 
     puts("[AMD64] Exception handlers installed\n");
 }
+
+// Local APIC (xAPIC, identity-mapped below 4 GB)
+#define IA32_APIC_BASE_MSR  0x1B
+#define LAPIC_BASE_MASK     0xFFFFF000ull
+#define LAPIC_ID            0x020
+#define LAPIC_EOI           0x0B0
+#define LAPIC_SVR           0x0F0
+#define LAPIC_SVR_ENABLE    0x100
+
+// MSI messages target the local APIC through this address window
+#define MSI_ADDRESS_BASE    0xFEE00000ull
+
+// I/O APIC at its fixed address (QEMU pc/q35), registers accessed through a select/window pair
+#define IOAPIC_BASE         0xFEC00000ull
+#define IOAPIC_REGSEL       0x00
+#define IOAPIC_WINDOW       0x10
+#define IOAPIC_VERSION      0x01
+#define IOAPIC_REDTBL(n)    (0x10 + 2 * (n))
+#define IOAPIC_ISA_IRQS     16
+
+// Vectors for the device wakeup interrupt and the APIC spurious interrupt
+#define WAKEUP_VECTOR       0x40
+#define SPURIOUS_VECTOR     0xFF
+
+// Legacy 8259 PIC data ports
+#define PIC_MASTER_DATA     0x21
+#define PIC_SLAVE_DATA      0xA1
+
+static uint64_t lapic_base;
+
+// Wakeup interrupt: signal EOI and return into platform_irq_wait()
+// The EOI register address is patched in by platform_msi_get_message()
+__asm__(
+    ".global irq_stub_wakeup\n"
+    ".align 16\n"
+    "irq_stub_wakeup:\n"
+    "    pushq %rax\n"
+    "    movq lapic_eoi_addr(%rip), %rax\n"
+    "    movl $0, (%rax)\n"
+    "    popq %rax\n"
+    "    iretq\n"
+    ".global irq_stub_spurious\n"
+    ".align 16\n"
+    "irq_stub_spurious:\n"
+    "    iretq\n"
+);
+
+extern void irq_stub_wakeup(void);
+extern void irq_stub_spurious(void);
+
+// Referenced by irq_stub_wakeup
+uint64_t lapic_eoi_addr;
+
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t low, high;
+    __asm__ __volatile__("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+    return ((uint64_t)high << 32) | low;
+}
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return *(volatile uint32_t *)(uintptr_t)(lapic_base + reg);
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    *(volatile uint32_t *)(uintptr_t)(lapic_base + reg) = value;
+}
+
+static inline uint32_t ioapic_read(uint32_t reg) {
+    *(volatile uint32_t *)(uintptr_t)(IOAPIC_BASE + IOAPIC_REGSEL) = reg;
+    return *(volatile uint32_t *)(uintptr_t)(IOAPIC_BASE + IOAPIC_WINDOW);
+}
+
+static inline void ioapic_write(uint32_t reg, uint32_t value) {
+    *(volatile uint32_t *)(uintptr_t)(IOAPIC_BASE + IOAPIC_REGSEL) = reg;
+    *(volatile uint32_t *)(uintptr_t)(IOAPIC_BASE + IOAPIC_WINDOW) = value;
+}
+
+// Enable the local APIC and install the wakeup vector on first use
+// Returns 0 on success, -1 if the APIC is not reachable
+static int lapic_init(void) {
+    if (lapic_base != 0) {
+        return 0;
+    }
+
+    // Only the low 4 GB are identity-mapped
+    uint64_t base = rdmsr(IA32_APIC_BASE_MSR) & LAPIC_BASE_MASK;
+    if (base == 0 || base >= 0x100000000ull) {
+        return -1;
+    }
+
+    // Mask the legacy PIC: its timer would otherwise fire into the
+    // exception vectors whenever interrupts are enabled
+    outb(PIC_MASTER_DATA, 0xFF);
+    outb(PIC_SLAVE_DATA, 0xFF);
+
+    // Type 0x8E: Present, DPL=0, Interrupt Gate (same selector as exceptions)
+    idt_set_entry(WAKEUP_VECTOR, (uint64_t)(uintptr_t)irq_stub_wakeup, 0x18, 0x8E);
+    idt_set_entry(SPURIOUS_VECTOR, (uint64_t)(uintptr_t)irq_stub_spurious, 0x18, 0x8E);
+
+    lapic_base = base;
+    lapic_eoi_addr = base + LAPIC_EOI;
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | SPURIOUS_VECTOR);
+    return 0;
+}
+
+int platform_msi_get_message(uint64_t *address, uint32_t *data) {
+    if (!address || !data || lapic_init() != 0) {
+        return -1;
+    }
+
+    // Fixed delivery, edge-triggered, to this CPU's APIC ID
+    uint32_t apic_id = lapic_read(LAPIC_ID) >> 24;
+    *address = MSI_ADDRESS_BASE | ((uint64_t)apic_id << 12);
+    *data = WAKEUP_VECTOR;
+    return 0;
+}
+
+int platform_irq_enable(uint32_t irq) {
+    // PCI interrupt lines are ISA IRQs, which the firmware leaves identity-mapped
+    // to I/O APIC inputs; IRQ 0 (the PIT) is remapped and never a device line
+    if (irq == 0 || irq >= IOAPIC_ISA_IRQS || lapic_init() != 0) {
+        return -1;
+    }
+
+    uint32_t entries = ((ioapic_read(IOAPIC_VERSION) >> 16) & 0xFF) + 1;
+    if (irq >= entries) {
+        return -1;
+    }
+
+    // Fixed delivery to this CPU, active-high, edge-triggered. The wakeup
+    // vector only signals EOI, so a level-triggered entry would be delivered
+    // again and again until the driver acknowledges the device; an edge is
+    // delivered once and the next one follows when the line rises again
+    uint32_t apic_id = lapic_read(LAPIC_ID) >> 24;
+    ioapic_write(IOAPIC_REDTBL(irq) + 1, apic_id << 24);
+    ioapic_write(IOAPIC_REDTBL(irq), WAKEUP_VECTOR);
+    return 0;
+}
+
+void platform_irq_wait(void) {
+    // Interrupts stay disabled outside this window. STI takes effect after the
+    // next instruction, so an interrupt already pending wakes the HLT instead
+    // of being taken before it
+    __asm__ __volatile__("sti\n\thlt\n\tcli" ::: "memory");
+}
+
+void platform_irq_ack(void) {
+    // EOI was already signalled by the wakeup vector
+}
@@ -209,3 +209,69 @@ static void platform_setup_exception_handlers(void) {
 
     puts("[ARM64] Exception handlers installed\n");
 }
+
+// GICv2 on the QEMU virt machine
+#define GICD_BASE           0x08000000UL
+#define GICC_BASE           0x08010000UL
+#define GICD_CTLR           0x000
+#define GICD_ISENABLER      0x100
+#define GICD_IPRIORITYR     0x400
+#define GICD_ITARGETSR      0x800
+#define GICD_ICFGR          0xC00
+#define GICC_CTLR           0x000
+#define GICC_PMR            0x004
+
+// Highest INTID of the GICv2 (SPIs end at 1019)
+#define GIC_MAX_INTID       1019
+
+static bool gic_initialized;
+
+static inline void gic_write32(uintptr_t addr, uint32_t value) {
+    *(volatile uint32_t *)addr = value;
+}
+
+static inline uint32_t gic_read32(uintptr_t addr) {
+    return *(volatile uint32_t *)addr;
+}
+
+static inline void gic_write8(uintptr_t addr, uint8_t value) {
+    *(volatile uint8_t *)addr = value;
+}
+
+int platform_msi_get_message([[maybe_unused]] uint64_t *address, [[maybe_unused]] uint32_t *data) {
+    // GICv2 has no MSI frame here; PCI devices are polled
+    return -1;
+}
+
+int platform_irq_enable(uint32_t irq) {
+    if (irq < 32 || irq > GIC_MAX_INTID) {
+        return -1;
+    }
+
+    if (!gic_initialized) {
+        // IRQs stay masked in PSTATE: a pending interrupt still ends WFI, but
+        // is never taken as an exception
+        __asm__ volatile("msr daifset, #2" ::: "memory");
+        gic_write32(GICD_BASE + GICD_CTLR, 1);
+        gic_write32(GICC_BASE + GICC_PMR, 0xFF);
+        gic_write32(GICC_BASE + GICC_CTLR, 1);
+        gic_initialized = true;
+    }
+
+    // Level-sensitive: the pending state follows the device line, which drops
+    // once the device is acknowledged, so the GIC needs no acknowledge of its own
+    uintptr_t icfgr = GICD_BASE + GICD_ICFGR + (irq / 16) * 4;
+    gic_write32(icfgr, gic_read32(icfgr) & ~(2u << ((irq % 16) * 2)));
+    gic_write8(GICD_BASE + GICD_IPRIORITYR + irq, 0xA0);
+    gic_write8(GICD_BASE + GICD_ITARGETSR + irq, 0x01);
+    gic_write32(GICD_BASE + GICD_ISENABLER + (irq / 32) * 4, 1u << (irq % 32));
+    return 0;
+}
+
+void platform_irq_wait(void) {
+    __asm__ volatile("dsb sy\n\twfi" ::: "memory");
+}
+
+void platform_irq_ack(void) {
+    // Nothing to complete: see platform_irq_enable()
+}
@@ -352,6 +352,17 @@ int fdt_enumerate_devices(uintptr_t fdt_addr, device_callback_t callback, void *
                         current_device.compatible = (const char*)prop_data;
                         has_compatible = true;
                     }
+                } else if (str_equal(prop_name, "interrupts")) {
+                    // First interrupt only. Three cells are a GIC specifier
+                    // (type, number, flags): SPIs start at INTID 32, PPIs at 16.
+                    // One cell is a plain source number (RISC-V PLIC)
+                    if (prop_len >= 12 && (uintptr_t)prop_data + 12 <= struct_end) {
+                        uint32_t type = read_be32_unaligned(prop_data);
+                        uint32_t number = read_be32_unaligned(prop_data + 4);
+                        current_device.irq = number + (type == 0 ? 32 : 16);
+                    } else if (prop_len >= 4 && (uintptr_t)prop_data + 4 <= struct_end) {
+                        current_device.irq = read_be32_unaligned(prop_data);
+                    }
                 }
 
                 // Advance past property data (aligned to 4 bytes)
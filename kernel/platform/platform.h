@@ -8,3 +8,32 @@ void platform_putchar(char ch);
 void platform_puts(const char* s);
 void platform_halt(void);
 const char* platform_get_cmdline(uintptr_t boot_param);
+
+// Device wakeup interrupts (must be implemented per arch)
+// Interrupts are only used to wake the CPU from platform_irq_wait(); the caller
+// polls the device afterwards, so no handler runs driver code
+
+/**
+ * Get the MSI/MSI-X message that wakes this CPU from platform_irq_wait()
+ * @param address Output message address
+ * @param data Output message data
+ * @return 0 on success, -1 if devices cannot signal with MSI on this platform
+ */
+int platform_msi_get_message(uint64_t *address, uint32_t *data);
+
+/**
+ * Route a wired device interrupt to this CPU so that it ends platform_irq_wait()
+ * @param irq Interrupt number (GIC INTID, PLIC source, or I/O APIC input on amd64)
+ * @return 0 on success, -1 if the interrupt cannot be routed on this platform
+ */
+int platform_irq_enable(uint32_t irq);
+
+/**
+ * Halt the CPU until an enabled device interrupt is pending
+ */
+void platform_irq_wait(void);
+
+/**
+ * Complete wired interrupts at the interrupt controller once the device was acknowledged
+ */
+void platform_irq_ack(void);
@@ -107,3 +107,54 @@ static void platform_setup_exception_handlers(void) {
 
     puts("[RISC-V] Exception handlers installed\n");
 }
+
+// PLIC on the QEMU virt machine; hart 0 supervisor mode is context 1
+#define PLIC_BASE           0x0C000000UL
+#define PLIC_PRIORITY(src)  (PLIC_BASE + 4 * (src))
+#define PLIC_ENABLE(src)    (PLIC_BASE + 0x2000 + 0x80 * PLIC_CONTEXT + 4 * ((src) / 32))
+#define PLIC_THRESHOLD      (PLIC_BASE + 0x200000 + 0x1000 * PLIC_CONTEXT)
+#define PLIC_CLAIM          (PLIC_THRESHOLD + 4)
+#define PLIC_CONTEXT        1
+#define PLIC_MAX_SOURCE     1023
+
+// sie.SEIE: supervisor external interrupt enable
+#define SIE_SEIE            (1UL << 9)
+
+int platform_msi_get_message([[maybe_unused]] uint64_t *address, [[maybe_unused]] uint32_t *data) {
+    // No IMSIC: PCI devices are polled
+    return -1;
+}
+
+int platform_irq_enable(uint32_t irq) {
+    if (irq == 0 || irq > PLIC_MAX_SOURCE) {
+        return -1;
+    }
+
+    *(volatile uint32_t *)PLIC_PRIORITY(irq) = 1;
+    *(volatile uint32_t *)PLIC_ENABLE(irq) |= 1u << (irq % 32);
+    *(volatile uint32_t *)PLIC_THRESHOLD = 0;
+
+    // sstatus.SIE stays clear: a pending interrupt still ends WFI, but no
+    // trap is taken
+    unsigned long seie = SIE_SEIE;
+    __asm__ volatile(
+        ".option push\n"
+        ".option arch, +zicsr\n"
+        "csrs sie, %0\n"
+        ".option pop\n"
+        : : "r"(seie) : "memory"
+    );
+    return 0;
+}
+
+void platform_irq_wait(void) {
+    __asm__ volatile("fence\n\twfi" ::: "memory");
+}
+
+void platform_irq_ack(void) {
+    // Claiming clears the pending bit; completing lets the source raise again
+    uint32_t source;
+    while ((source = *(volatile uint32_t *)PLIC_CLAIM) != 0) {
+        *(volatile uint32_t *)PLIC_CLAIM = source;
+    }
+}
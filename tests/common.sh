@@ -209,7 +209,7 @@ COLOR_CYAN='\033[0;36m'
 #   -v: verbose mode
 #   --arch=riscv|arm64|amd64: specify architecture (default: all, comma-separated supported)
 #   --boot=kernel|image|iso: specify boot type (default: all, comma-separated supported)
-#   --netdev=e1000|rtl8139|virtio-net: specify network device (default: all, comma-separated supported)
+#   --netdev=e1000|e1000e|igb|vmxnet3|rtl8139|virtio-net: specify network device (default: all, comma-separated supported)
 # Optionally displays a custom message before parsing
 init_test_matrix() {
     local message=""
@@ -256,7 +256,7 @@ init_test_matrix() {
             *)
                 # Any remaining unknown argument is an error
                 echo "Error: Unknown argument '$arg'" >&2
-                echo "Usage: [-v] [--arch=riscv,arm64,amd64] [--boot=kernel,image,iso] [--netdev=e1000,rtl8139,virtio-net]" >&2
+                echo "Usage: [-v] [--arch=riscv,arm64,amd64] [--boot=kernel,image,iso] [--netdev=e1000,e1000e,igb,vmxnet3,rtl8139,virtio-net]" >&2
                 exit 1
                 ;;
         esac
@@ -326,7 +326,7 @@ get_net_devices_for_arch() {
     local arch="$1"
     local net_device_arg="$2"
     local virtio_device=$([ "$arch" = "amd64" ] && echo "virtio-net-pci" || echo "virtio-net-device")
-    local all_devices="e1000 rtl8139 $virtio_device"
+    local all_devices="e1000 e1000e igb vmxnet3 rtl8139 $virtio_device"
 
     # If empty or not specified, return all devices
     if [ -z "$net_device_arg" ]; then
@@ -347,6 +347,15 @@ get_net_devices_for_arch() {
             e1000)
                 result="$result e1000"
                 ;;
+            e1000e)
+                result="$result e1000e"
+                ;;
+            igb)
+                result="$result igb"
+                ;;
+            vmxnet3)
+                result="$result vmxnet3"
+                ;;
             rtl8139)
                 result="$result rtl8139"
                 ;;
@@ -354,7 +363,7 @@ get_net_devices_for_arch() {
                 result="$result $virtio_device"
                 ;;
             *)
-                echo "Error: Invalid network device '$dev'. Use --netdev=e1000,rtl8139,virtio-net" >&2
+                echo "Error: Invalid network device '$dev'. Use --netdev=e1000,e1000e,igb,vmxnet3,rtl8139,virtio-net" >&2
                 dev_error=1
                 ;;
         esac